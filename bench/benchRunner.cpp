@@ -0,0 +1,354 @@
+// Runs the scripts in bench/scripts through a Funcy executable and reports how long they take.
+// Usage: bench_runner <funcy_executable> <bench_directory> [--runs N] [--baseline file] [--save-baseline file]
+//                     [--output file] [--tolerance fraction] [-- flags passed to funcy]
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+namespace fs = std::filesystem;
+
+struct RunResult {
+    bool started = false;
+    int exit_code = 0;
+    double milliseconds = 0;
+    long peak_rss_kb = 0;
+};
+
+struct BenchResult {
+    std::string name;
+    double median_ms = 0;
+    double p95_ms = 0;
+    long peak_rss_kb = 0;
+    bool output_matches = false;
+};
+
+#ifdef _WIN32
+static std::string quoteArgument(const std::string& argument) {
+    std::string quoted = "\"";
+    for (char character : argument) {
+        if (character == '"') {
+            quoted += '\\';
+        }
+        quoted += character;
+    }
+    return quoted + "\"";
+}
+
+static RunResult runProcess(const std::vector<std::string>& command, const fs::path& output_path) {
+    RunResult result;
+    std::string command_line;
+    for (const auto& argument : command) {
+        command_line += quoteArgument(argument) + " ";
+    }
+
+    SECURITY_ATTRIBUTES security{sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE};
+    HANDLE output = CreateFileW(output_path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, &security,
+                                CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    HANDLE input = CreateFileW(L"NUL", GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, &security,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    STARTUPINFOA startup{};
+    startup.cb = sizeof(startup);
+    startup.dwFlags = STARTF_USESTDHANDLES;
+    startup.hStdInput = input;
+    startup.hStdOutput = output;
+    startup.hStdError = output;
+    PROCESS_INFORMATION process{};
+
+    auto start = std::chrono::steady_clock::now();
+    if (CreateProcessA(nullptr, command_line.data(), nullptr, nullptr, TRUE, 0, nullptr, nullptr, &startup, &process)) {
+        WaitForSingleObject(process.hProcess, INFINITE);
+        auto end = std::chrono::steady_clock::now();
+        result.started = true;
+        result.milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+        DWORD exit_code = 0;
+        GetExitCodeProcess(process.hProcess, &exit_code);
+        result.exit_code = static_cast<int>(exit_code);
+        PROCESS_MEMORY_COUNTERS memory{};
+        if (GetProcessMemoryInfo(process.hProcess, &memory, sizeof(memory))) {
+            result.peak_rss_kb = static_cast<long>(memory.PeakWorkingSetSize / 1024);
+        }
+        CloseHandle(process.hThread);
+        CloseHandle(process.hProcess);
+    }
+    CloseHandle(output);
+    CloseHandle(input);
+    return result;
+}
+#else
+static RunResult runProcess(const std::vector<std::string>& command, const fs::path& output_path) {
+    RunResult result;
+    std::vector<char*> arguments;
+    for (const auto& argument : command) {
+        arguments.push_back(const_cast<char*>(argument.c_str()));
+    }
+    arguments.push_back(nullptr);
+
+    // Scripts that read input get an empty stdin, stdout and stderr both go to the output file
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+
+    pid_t pid;
+    auto start = std::chrono::steady_clock::now();
+    int error = posix_spawn(&pid, arguments[0], &actions, nullptr, arguments.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (error != 0) {
+        return result;
+    }
+
+    int status = 0;
+    rusage usage{};
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        return result;
+    }
+    auto end = std::chrono::steady_clock::now();
+    result.started = true;
+    result.milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    result.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#ifdef __APPLE__
+    result.peak_rss_kb = usage.ru_maxrss / 1024; // Bytes on macOS
+#else
+    result.peak_rss_kb = usage.ru_maxrss;
+#endif
+    return result;
+}
+#endif
+
+static std::string readFile(const fs::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+// The interpreter colors its output, expected outputs are stored as plain text
+static std::string stripColors(const std::string& text) {
+    std::string plain;
+    plain.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '\x1b' && i + 1 < text.size() && text[i + 1] == '[') {
+            i += 2;
+            while (i < text.size() && !std::isalpha(static_cast<unsigned char>(text[i]))) {
+                i++;
+            }
+            continue;
+        }
+        if (text[i] != '\r') {
+            plain += text[i];
+        }
+    }
+    return plain;
+}
+
+// Nearest rank percentile of already sorted times
+static double percentile(const std::vector<double>& sorted, double fraction) {
+    size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+static double median(const std::vector<double>& sorted) {
+    size_t middle = sorted.size() / 2;
+    return sorted.size() % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+}
+
+static std::string escapeJson(const std::string& text) {
+    std::string escaped;
+    for (char character : text) {
+        if (character == '"' || character == '\\') {
+            escaped += '\\';
+        }
+        escaped += character;
+    }
+    return escaped;
+}
+
+// Reads the median of each benchmark back out of a file this program wrote
+static std::map<std::string, double> readBaseline(const fs::path& path) {
+    std::map<std::string, double> medians;
+    std::string text = readFile(path);
+    size_t position = 0;
+    while ((position = text.find("\"name\": \"", position)) != std::string::npos) {
+        position += 9;
+        size_t name_end = text.find('"', position);
+        size_t median_start = text.find("\"median_ms\": ", name_end);
+        if (name_end == std::string::npos || median_start == std::string::npos) {
+            break;
+        }
+        medians[text.substr(position, name_end - position)] = std::stod(text.substr(median_start + 13));
+        position = median_start;
+    }
+    return medians;
+}
+
+static std::string formatNumber(double number) {
+    std::ostringstream stream;
+    stream.setf(std::ios::fixed);
+    stream.precision(3);
+    stream << number;
+    return stream.str();
+}
+
+static std::string toJson(const std::vector<BenchResult>& results, int runs, const std::string& flags,
+                          const std::map<std::string, double>& baseline) {
+    std::ostringstream json;
+    json << "{\n  \"runs\": " << runs << ",\n  \"flags\": \"" << escapeJson(flags) << "\",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& result = results[i];
+        json << "    {\"name\": \"" << escapeJson(result.name) << "\", \"median_ms\": " << formatNumber(result.median_ms)
+             << ", \"p95_ms\": " << formatNumber(result.p95_ms) << ", \"peak_rss_kb\": " << result.peak_rss_kb
+             << ", \"output_matches\": " << (result.output_matches ? "true" : "false");
+        auto base = baseline.find(result.name);
+        if (base != baseline.end() && base->second > 0) {
+            json << ", \"baseline_median_ms\": " << formatNumber(base->second)
+                 << ", \"change\": " << formatNumber(result.median_ms / base->second - 1);
+        }
+        json << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+    return json.str();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: bench_runner <funcy_executable> <bench_directory> [--runs N] [--baseline file] "
+                     "[--save-baseline file] [--output file] [--tolerance fraction] [-- funcy flags]\n";
+        return 1;
+    }
+    fs::path funcy = fs::absolute(argv[1]);
+    fs::path bench_directory = argv[2];
+    int runs = 5;
+    double tolerance = 0.10;
+    fs::path baseline_path, save_baseline_path, output_path;
+    std::vector<std::string> funcy_flags;
+
+    for (int i = 3; i < argc; i++) {
+        std::string flag = argv[i];
+        if (flag == "--") {
+            funcy_flags.assign(argv + i + 1, argv + argc);
+            break;
+        } else if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << flag << "\n";
+            return 1;
+        } else if (flag == "--runs") {
+            runs = std::max(1, std::stoi(argv[++i]));
+        } else if (flag == "--baseline") {
+            baseline_path = argv[++i];
+        } else if (flag == "--save-baseline") {
+            save_baseline_path = argv[++i];
+        } else if (flag == "--output") {
+            output_path = argv[++i];
+        } else if (flag == "--tolerance") {
+            tolerance = std::stod(argv[++i]);
+        } else {
+            std::cerr << "Unrecognized flag " << flag << "\n";
+            return 1;
+        }
+    }
+
+    std::vector<fs::path> scripts;
+    for (const auto& entry : fs::directory_iterator(bench_directory / "scripts")) {
+        if (entry.path().extension() == ".fy") {
+            scripts.push_back(entry.path());
+        }
+    }
+    std::sort(scripts.begin(), scripts.end());
+    if (scripts.empty()) {
+        std::cerr << "No benchmarks found in " << (bench_directory / "scripts").string() << "\n";
+        return 1;
+    }
+
+    std::map<std::string, double> baseline;
+    if (!baseline_path.empty() && fs::exists(baseline_path)) {
+        baseline = readBaseline(baseline_path);
+    }
+
+    std::string flags;
+    for (const auto& flag : funcy_flags) {
+        flags += (flags.empty() ? "" : " ") + flag;
+    }
+
+    fs::path capture = fs::temp_directory_path() / "funcy_bench_output.txt";
+    std::vector<BenchResult> results;
+    bool all_ok = true;
+    for (const auto& script : scripts) {
+        BenchResult result;
+        result.name = script.stem().string();
+        std::string expected = readFile(bench_directory / "expected" / (result.name + ".out"));
+
+        std::vector<std::string> command{funcy.string(), script.string()};
+        command.insert(command.end(), funcy_flags.begin(), funcy_flags.end());
+
+        std::vector<double> times;
+        result.output_matches = true;
+        // One untimed run first, which also writes the script's parse cache
+        for (int run = 0; run <= runs; run++) {
+            RunResult run_result = runProcess(command, capture);
+            if (!run_result.started) {
+                std::cerr << "Unable to run " << funcy.string() << "\n";
+                return 1;
+            }
+            if (run_result.exit_code != 0 || stripColors(readFile(capture)) != expected) {
+                result.output_matches = false;
+            }
+            if (run > 0) {
+                times.push_back(run_result.milliseconds);
+                result.peak_rss_kb = std::max(result.peak_rss_kb, run_result.peak_rss_kb);
+            }
+        }
+        std::sort(times.begin(), times.end());
+        result.median_ms = median(times);
+        result.p95_ms = percentile(times, 0.95);
+
+        std::cerr << result.name << ": median " << formatNumber(result.median_ms) << " ms, p95 "
+                  << formatNumber(result.p95_ms) << " ms, peak " << result.peak_rss_kb << " KB";
+        if (!result.output_matches) {
+            std::cerr << ", OUTPUT DIFFERS FROM expected/" << result.name << ".out";
+            all_ok = false;
+        }
+        auto base = baseline.find(result.name);
+        if (base != baseline.end() && base->second > 0) {
+            double change = result.median_ms / base->second - 1;
+            std::cerr << ", " << (change >= 0 ? "+" : "") << formatNumber(change * 100) << "% vs baseline";
+            if (change > tolerance) {
+                std::cerr << " (slower)";
+            }
+        }
+        std::cerr << "\n";
+        results.push_back(result);
+    }
+    fs::remove(capture);
+
+    std::string json = toJson(results, runs, flags, baseline);
+    std::cout << json;
+    if (!output_path.empty()) {
+        std::ofstream{output_path} << json;
+    }
+    if (!save_baseline_path.empty()) {
+        std::ofstream{save_baseline_path} << toJson(results, runs, flags, {});
+    }
+    return all_ok ? 0 : 1;
+}
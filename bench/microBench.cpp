@@ -0,0 +1,298 @@
+// Times interpreter primitives in isolation, to tell which subsystem a change in the script benchmarks comes from.
+// Usage: funcy_microbench [name_filter]
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include "lexer.h"
+#include "parser.h"
+#include "library.h"
+#include "context.h"
+#include "resolver.h"
+#include "values.h"
+
+// Every allocation in the process goes through here so a benchmark can report how many it caused
+static size_t allocation_count = 0;
+
+void* operator new(size_t size) {
+    allocation_count++;
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+namespace {
+
+std::string name_filter;
+
+// Keeps the optimizer from discarding a result that is never used
+template <typename T>
+void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Runs body(iterations) once to warm up, then times it. Body performs 'iterations' operations.
+template <typename Body>
+void benchmark(const std::string& name, size_t iterations, Body body) {
+    if (!name_filter.empty() && name.find(name_filter) == std::string::npos) {
+        return;
+    }
+    body(std::max<size_t>(iterations / 10, 1));
+
+    size_t allocations_before = allocation_count;
+    auto start = std::chrono::steady_clock::now();
+    body(iterations);
+    auto end = std::chrono::steady_clock::now();
+    size_t allocations = allocation_count - allocations_before;
+
+    double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << std::left << std::setw(40) << name << std::right << std::fixed
+              << std::setw(12) << std::setprecision(1) << nanoseconds / iterations << " ns/op"
+              << std::setw(10) << std::setprecision(2) << static_cast<double>(allocations) / iterations << " allocs/op\n";
+}
+
+std::string syntheticSource(int functions) {
+    std::string source;
+    for (int i = 0; i < functions; i++) {
+        std::string n = std::to_string(i);
+        source += "func f" + n + "(a, b=" + n + ") {\n"
+                  "    total = 0;\n"
+                  "    for i = 0, i < a, i += 1 {\n"
+                  "        if i % 2 == 0 and b > 1 { total += i * b; } else { total -= 1.5; }\n"
+                  "    }\n"
+                  "    values = [a, b, \"text " + n + "\", {\"key\": total}];\n"
+                  "    return values[0:2];\n"
+                  "}\n";
+    }
+    return source;
+}
+
+void environmentBenchmarks() {
+    // A chain of frames, each one the closure of the next, like nested function definitions
+    std::vector<Symbol> layout{internSymbol("a"), internSymbol("b")};
+    Environment env = buildStartingEnvironment();
+    for (int i = 0; i < 16; i++) {
+        env.pushFrame(layout);
+    }
+    for (int depth : {0, 4, 15}) {
+        benchmark("Environment::setLocal depth " + std::to_string(depth), 10'000'000, [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                env.setLocal(depth, 1, Value(static_cast<int>(i)));
+            }
+        });
+        benchmark("Environment::getLocal depth " + std::to_string(depth), 10'000'000, [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                keep(env.getLocal(depth, 1));
+            }
+        });
+    }
+
+    Symbol symbol = internSymbol("bench_global");
+    benchmark("Environment::setGlobal", 10'000'000, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            env.setGlobal(symbol, Value(static_cast<int>(i)));
+        }
+    });
+    benchmark("Environment::getGlobal", 10'000'000, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            keep(env.getGlobal(symbol));
+        }
+    });
+    // The by name lookups used by builtins such as globals() intern the name on every call
+    benchmark("Environment::set by name", 2'000'000, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            env.set("bench_global", Value(static_cast<int>(i)));
+        }
+    });
+    benchmark("Environment::get by name", 2'000'000, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            keep(env.get("bench_global"));
+        }
+    });
+}
+
+void valueBenchmarks() {
+    benchmark("Value int construct", 20'000'000, [](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            Value value{static_cast<int>(i)};
+            keep(value);
+        }
+    });
+    benchmark("Value string construct", 5'000'000, [](size_t n) {
+        std::string text = "a string longer than the small buffer";
+        for (size_t i = 0; i < n; i++) {
+            Value value{text};
+            keep(value);
+        }
+    });
+    Value shared{std::string("shared")};
+    benchmark("Value heap copy", 20'000'000, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            Value copy = shared;
+            keep(copy);
+        }
+    });
+    benchmark("Value list construct", 2'000'000, [](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            Value value{std::make_shared<List>()};
+            keep(value);
+        }
+    });
+}
+
+void containerBenchmarks() {
+    // Inserts go into a fresh dictionary every 1024 keys, so growth is part of the cost
+    benchmark("Dictionary insert int keys", 2'000'000, [](size_t n) {
+        std::shared_ptr<Dictionary> dict;
+        for (size_t i = 0; i < n; i++) {
+            if ((i & 1023) == 0) {
+                dict = std::make_shared<Dictionary>();
+            }
+            (*dict)[Value(static_cast<int>(i & 1023))] = Value(static_cast<int>(i));
+        }
+    });
+    {
+        auto dict = std::make_shared<Dictionary>();
+        for (int i = 0; i < 1024; i++) {
+            (*dict)[Value(i)] = Value(i);
+        }
+        benchmark("Dictionary find int keys", 10'000'000, [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                keep(dict->find(Value(static_cast<int>(i & 1023))));
+            }
+        });
+    }
+    {
+        std::vector<Value> keys;
+        auto dict = std::make_shared<Dictionary>();
+        for (int i = 0; i < 1024; i++) {
+            keys.emplace_back("key" + std::to_string(i));
+            (*dict)[keys.back()] = Value(i);
+        }
+        benchmark("Dictionary insert string keys", 2'000'000, [&](size_t n) {
+            std::shared_ptr<Dictionary> fresh;
+            for (size_t i = 0; i < n; i++) {
+                if ((i & 1023) == 0) {
+                    fresh = std::make_shared<Dictionary>();
+                }
+                (*fresh)[keys[i & 1023]] = Value(static_cast<int>(i));
+            }
+        });
+        benchmark("Dictionary find string keys", 10'000'000, [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                keep(dict->find(keys[i & 1023]));
+            }
+        });
+    }
+
+    benchmark("List::push_back", 10'000'000, [](size_t n) {
+        auto list = std::make_shared<List>();
+        for (size_t i = 0; i < n; i++) {
+            list->push_back(Value(static_cast<int>(i)));
+        }
+    });
+    benchmark("List::pop(0) of 1000", 1'000'000, [](size_t n) {
+        auto list = std::make_shared<List>();
+        for (size_t i = 0; i < n; i++) {
+            if (list->empty()) {
+                for (int j = 0; j < 1000; j++) {
+                    list->push_back(Value(j));
+                }
+            }
+            keep(list->pop(0));
+        }
+    });
+}
+
+void frontEndBenchmarks() {
+    std::string source = syntheticSource(200);
+    Lexer counter{source};
+    size_t token_count = counter.tokenize().size();
+
+    // Reported per token so inputs of different sizes compare
+    benchmark("Lexer::tokenize per token", 100 * token_count, [&](size_t n) {
+        for (size_t done = 0; done < n; done += token_count) {
+            Lexer lexer{source};
+            keep(lexer.tokenize());
+        }
+    });
+
+    Lexer lexer{source};
+    std::vector<Token> tokens = lexer.tokenize();
+    pushParsingContext("<microbench>");
+    benchmark("Parser::parse per token", 100 * token_count, [&](size_t n) {
+        for (size_t done = 0; done < n; done += token_count) {
+            auto mark = active_arena->mark();
+            Parser parser{tokens};
+            keep(parser.parse());
+            active_arena->release(mark);
+        }
+    });
+    popParsingContext();
+}
+
+void callBenchmarks() {
+    std::string source = "func add(a, b) { return a + b; }\n"
+                         "func empty() {}\n";
+    pushParsingContext("<microbench>");
+    pushExecutionContext("<microbench>");
+    Lexer lexer{source};
+    std::vector<Token> tokens = lexer.tokenize();
+    Parser parser{tokens};
+    auto statements = parser.parse();
+    std::vector<Symbol> layout = resolveProgram(statements);
+
+    Environment env = buildStartingEnvironment();
+    env.pushFrame(layout);
+    for (const auto& statement : statements) {
+        statement->execute(env);
+    }
+    auto add = std::static_pointer_cast<FuncNode>(env.get("add").get<std::shared_ptr<ASTNode>>());
+    auto empty = std::static_pointer_cast<FuncNode>(env.get("empty").get<std::shared_ptr<ASTNode>>());
+
+    benchmark("FuncNode::callFunc no arguments", 2'000'000, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            keep(empty->callFunc({}, {}, env));
+        }
+    });
+    benchmark("FuncNode::callFunc add(a, b)", 2'000'000, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            keep(add->callFunc({Value(1), Value(static_cast<int>(i))}, {}, env));
+        }
+    });
+    popExecutionContext();
+    popParsingContext();
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        name_filter = argv[1];
+    }
+    try {
+        environmentBenchmarks();
+        valueBenchmarks();
+        containerBenchmarks();
+        frontEndBenchmarks();
+        callBenchmarks();
+    }
+    catch (const ErrorException& e) {
+        std::cerr << e.message;
+        return 1;
+    }
+    return 0;
+}
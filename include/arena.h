@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+#include <type_traits>
+
+class ASTNode;
+
+using NodeIndex = uint32_t;
+
+struct SourcePosition {
+    int line = 0;
+    int column = 0;
+};
+
+/*
+Owns every AST node. Nodes are constructed into large blocks and numbered as they are made, so a
+child is a 32 bit index instead of a shared_ptr and source positions sit in a side table instead of
+on every node. Everything is released together when the program ends, or back to a mark for a
+throwaway parse. Index 0 is never used so it can stand for a missing child. Each interpreter has an
+arena of its own, nodes are made in and looked up through the one bound to the thread (see runtime.h).
+*/
+class ASTArena {
+public:
+    struct Mark {
+        NodeIndex next_index;
+        size_t block_count;
+        size_t block_used;
+    };
+
+    constexpr ASTArena() = default;
+    ~ASTArena();
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        void* memory = allocate(sizeof(T), alignof(T));
+        T* node = new (memory) T(std::forward<Args>(args)...);
+        segments[node->index >> SEGMENT_BITS]->nodes[node->index & SEGMENT_MASK] = node;
+        return node;
+    }
+
+    ASTNode* node(NodeIndex index) const {
+        return segments[index >> SEGMENT_BITS]->nodes[index & SEGMENT_MASK];
+    }
+    const SourcePosition& position(NodeIndex index) const {
+        return segments[index >> SEGMENT_BITS]->positions[index & SEGMENT_MASK];
+    }
+    // Numbers a node being constructed and records where it came from
+    NodeIndex addPosition(int line, int column);
+
+    Mark mark() const;
+    // Destroys every node made after the mark
+    void release(const Mark& mark);
+
+private:
+    static constexpr int SEGMENT_BITS = 12;
+    static constexpr NodeIndex SEGMENT_MASK = (1 << SEGMENT_BITS) - 1;
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    struct Segment {
+        ASTNode* nodes[1 << SEGMENT_BITS];
+        SourcePosition positions[1 << SEGMENT_BITS];
+    };
+
+    void* allocate(size_t size, size_t align);
+
+    std::vector<Segment*> segments; // Added as indices reach them
+    std::vector<char*> blocks;
+    size_t block_used = BLOCK_SIZE;
+    NodeIndex next_index = 1;
+};
+
+extern thread_local constinit ASTArena* active_arena;
+
+// A 32 bit reference to a node in the arena
+template <typename T = ASTNode>
+class NodeRef {
+public:
+    NodeRef() = default;
+    NodeRef(std::nullptr_t) {}
+    NodeRef(T* node) : index{node ? node->index : 0} {}
+    template <typename U, typename = std::enable_if_t<std::is_base_of_v<T, U>>>
+    NodeRef(const NodeRef<U>& other) : index{other.getIndex()} {}
+
+    T* get() const {
+        return index ? static_cast<T*>(active_arena->node(index)) : nullptr;
+    }
+    T* operator->() const {
+        return static_cast<T*>(active_arena->node(index));
+    }
+    T& operator*() const {
+        return *operator->();
+    }
+    explicit operator bool() const {
+        return index != 0;
+    }
+    bool operator==(std::nullptr_t) const {
+        return index == 0;
+    }
+    NodeIndex getIndex() const {
+        return index;
+    }
+
+private:
+    NodeIndex index = 0;
+};
+
+template <typename T, typename... Args>
+T* makeNode(Args&&... args) {
+    return active_arena->make<T>(std::forward<Args>(args)...);
+}
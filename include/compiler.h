@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "nodes.h"
+
+// Bytecode instruction set. Operands are jump targets, argument counts or constant indexes.
+// Anything the compiler does not lower is run through Evaluate, which tree-walks the node.
+enum class OpCode : uint8_t {
+    LoadConst,          // push constants[operand]
+    LoadName,           // push the value of an IdentifierNode
+    StoreName,          // pop into the identifier on the left of an assignment
+    LoadLocal,          // push slot operand of the frame depth levels out, names still unassigned fall back to LoadName
+    StoreLocal,         // pop into slot operand of the frame depth levels out, unassigned slots fall back to StoreName
+    LoadGlobal,         // push the global with symbol operand, falling back to LoadName when it's unset
+    StoreGlobal,        // pop into the global with symbol operand
+    Pop,
+    UnaryOp,
+    BinaryOp,
+    In,
+    And,                // short-circuit, jumps to operand when the left side is falsy
+    Or,                 // short-circuit, jumps to operand when the left side is truthy
+    ToBool,
+    Jump,
+    JumpIfFalse,
+    ForCondition,       // like JumpIfFalse, but classic for loops require a boolean
+    PushScope,          // clears the slots of scopes[operand] on entry
+    PopScope,           // clears them again on exit
+    EnterLoop,
+    ExitLoop,
+    IterStart,
+    IterNext,           // assigns the next item to the loop variables or jumps to operand when done
+    IterEnd,
+    Call,               // operand is the number of arguments
+    CallMember,
+    GetMember,
+    Index,
+    StoreIndex,         // pops the indexes and container above the value to assign, in the order Index pushes them
+    BuildList,
+    BuildDictionary,
+    Return,             // operand is 1 when a value is returned
+    Evaluate            // operand is a loop index for break/continue thrown by the tree walker, or -1
+};
+
+struct Instruction {
+    OpCode op;
+    uint16_t depth; // Frames out of LoadLocal and StoreLocal
+    int operand;
+    ASTNode* node;
+};
+
+struct LoopInfo {
+    int break_target;
+    int continue_target;
+};
+
+struct Chunk {
+    std::vector<Instruction> code;
+    std::vector<Value> constants;
+    std::vector<LoopInfo> loops;
+    std::vector<SlotRange> scopes;
+    bool function_body = false;
+};
+
+Chunk compileBlock(const std::vector<NodeRef<>>& statements, bool function_body = false);
@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <stack>
+#include <vector>
 #include <thread>
 #include <memory>
 #include <map>
@@ -10,7 +11,7 @@ class Value;
 // Thread-local storage for execution context
 extern thread_local std::stack<std::string> parsing_context; // File where the currently parsing code is from
 extern thread_local std::stack<std::string> execution_context; // File where the currently executing code is from
-extern thread_local std::stack<std::pair<std::string, std::string>> function_context; // Function that the currently executing code is inside
+extern thread_local std::vector<std::pair<std::string, std::string>> function_context; // Functions the currently executing code is inside, innermost last
 
 extern thread_local int debug_tabs;
 
@@ -30,4 +31,27 @@ std::string currentParsingContext();
 
 std::string currentExecutionContext();
 
-std::pair<std::string, std::string> currentFunctionContext();
\ No newline at end of file
+std::pair<std::string, std::string> currentFunctionContext();
+
+// The file and functions code is running in, so work moved to another thread reports errors from the same place
+struct ExecutionContextSnapshot {
+    std::string execution_file;
+    std::vector<std::pair<std::string, std::string>> functions;
+};
+
+ExecutionContextSnapshot captureExecutionContext();
+
+// Gives the thread it's created on a snapshot's context, restoring the thread's own when destroyed
+class ExecutionContextScope {
+public:
+    explicit ExecutionContextScope(const ExecutionContextSnapshot& snapshot);
+    ~ExecutionContextScope();
+    ExecutionContextScope(const ExecutionContextScope&) = delete;
+    ExecutionContextScope& operator=(const ExecutionContextScope&) = delete;
+
+private:
+    std::vector<std::pair<std::string, std::string>> saved_functions;
+};
+
+// The same file gives the same path however it was reached, through '..', './' or a link
+std::string resolveModulePath(const std::string& filename);
\ No newline at end of file
@@ -5,96 +5,161 @@
 #include <memory>
 #include <vector>
 #include <optional>
+#include <chrono>
+#include "valueDefs.h"
+#include "gc.h"
+#include "symbols.h"
 
-class Value;
-class Instance;
-enum class ValueType;
-
-extern bool DETECT_RECURSION;
-
-class Scope {
+class Scope : public GCObject {
 public:
     Scope();
-    void set(std::string name, std::shared_ptr<Value> value);
-    std::shared_ptr<Value> get(std::string name) const;
-    void remove(std::string name);
-    bool contains(std::string name) const;
-    const std::vector<std::pair<std::string, std::shared_ptr<Value>>> getPairs() const;
+    void trace(GCVisitor& visitor) const override;
+    void clearReferences() override;
+    size_t memoryUsage() const override;
+    void set(const std::string& name, Value value);
+    Value get(const std::string& name) const;
+    void remove(const std::string& name);
+    bool contains(const std::string& name) const;
+    const std::vector<std::pair<std::string, Value>> getPairs() const;
     void display() const;
 private:
-    std::unordered_map<std::string, std::shared_ptr<Value>> variables;
+    std::unordered_map<std::string, Value> variables;
+};
+
+// The slots of a block within its frame, including the slots of any blocks nested inside it
+struct SlotRange {
+    int begin = 0;
+    int end = 0;
+};
+
+// Flat storage for the variables of one function call, class body or module, indexed by resolved slot.
+// The layout names each slot and belongs to the node that owns the frame. The closure is the frame the
+// function or class was defined in, which resolved depths greater than zero walk out to.
+struct Frame : public GCObject {
+    std::vector<Value> slots;
+    const std::vector<Symbol>* layout = nullptr;
+    std::shared_ptr<Frame> closure;
+
+    Frame() : GCObject{GCKind::Environment} {}
+
+    void trace(GCVisitor& visitor) const override;
+    void clearReferences() override;
+    size_t memoryUsage() const override;
+};
+
+enum class ModuleState {
+    Loading,
+    Loaded
+};
+
+// How an interpreter runs its programs, fixed once it's created
+struct InterpreterOptions {
+    bool use_vm_engine = false;
+    bool use_module_cache = true;
+    bool detect_recursion = true; // Stop functions recursing more than 1000 deep
+};
+
+// State shared by every environment of a running program
+struct Globals {
+    InterpreterOptions options;
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    std::vector<Value> values; // Indexed by Symbol
+    std::vector<Value> built_in_functions; // Indexed by Symbol
+    std::unordered_map<ValueType, std::unordered_map<std::string, Value>> member_functions;
+    std::vector<Value> member_table; // The member functions again, indexed by Symbol * VALUE_TYPE_COUNT + ValueType
+    std::unordered_map<std::string, ModuleState> modules; // Keyed by resolved path
+    std::vector<std::string> import_chain; // Files whose top level is running, outermost first
 };
 
 class Environment {
 public:
-    Environment();
+    explicit Environment(const InterpreterOptions& options = {});
     Environment(const Environment& other);
+    Environment(Environment&& other) = default;
+    Environment& operator=(const Environment& other) = default;
+    Environment& operator=(Environment&& other) = default;
+    Environment(const Environment& caller, std::shared_ptr<Frame> closure);
     void setClassEnv();
     bool isClassEnv() const;
-    void set(std::string name, std::shared_ptr<Value> value, bool is_member_var = false);
-    bool contains(std::string name, bool is_member_var = false) const;
-    std::shared_ptr<Value> get(std::string name, bool is_member_var = false) const;
+    void set(const std::string& name, Value value, bool is_member_var = false);
+    bool contains(const std::string& name, bool is_member_var = false) const;
+    Value get(const std::string& name, bool is_member_var = false) const;
+
+    Value getLocal(int depth, int slot) const;
+    // The variable a frame further out than depth holds under the name, or nothing
+    Value getEnclosing(int depth, Symbol symbol) const;
+    void setLocal(int depth, int slot, Value value);
+    Value getGlobal(Symbol symbol) const;
+    void setGlobal(Symbol symbol, Value value);
+    bool hasGlobal(Symbol symbol) const;
+    std::vector<std::pair<std::string, Value>> getGlobalPairs() const;
+    std::vector<std::pair<std::string, Value>> getLocalPairs() const;
+
+    void pushFrame(const std::vector<Symbol>& layout);
+    void popFrame();
+    std::shared_ptr<Frame> getFrame() const;
+    void clearSlots(const SlotRange& range);
 
-    int scopeDepth() const;
-    void addScope();
-    void addScope(Scope& scope);
     void addClassScope();
-    Scope getScope();
+    void removeClassScope(std::shared_ptr<Scope> previous_attrs);
     int classDepth();
-    void removeScope();
-    void removeClassScope(Scope& previous_attrs);
-    std::vector<Scope> copyScopes() const;
     void addLoop();
     void removeLoop();
     bool inLoop() const;
     void resetLoop();
 
-    void addFunction(const std::string& name, std::shared_ptr<Value> func);
-    std::shared_ptr<Value> getFunction(const std::string& name) const;
+    void addFunction(const std::string& name, Value func);
+    Value getFunction(const std::string& name) const;
+    Value getFunction(Symbol symbol) const;
     bool hasFunction(const std::string& name) const;
 
-    void addMember(ValueType type, const std::string& name, std::shared_ptr<Value> func);
-    void addMember(const std::string& name, std::shared_ptr<Value> value);
-    std::shared_ptr<Value> getMember(ValueType type, const std::string& name) const;
-    std::shared_ptr<Value> getMember(const std::string& name) const;
+    void addMember(ValueType type, const std::string& name, Value func);
+    void addMember(const std::string& name, Value value);
+    Value getMember(ValueType type, const std::string& name) const;
+    Value getMember(const std::string& name) const;
     bool hasMember(ValueType type, const std::string& name) const;
     bool hasMember(const std::string& name) const;
     void delMember(const std::string& name);
+    // The builtin member function of a type with the given name, or nothing
+    Value getBuiltinMember(ValueType type, Symbol symbol) const;
+
+    const InterpreterOptions& options() const;
+    std::chrono::steady_clock::time_point getStartTime() const;
 
-    void addGlobal(std::string name);
-    void resetGlobals();
-    void removeGlobalScope();
-    bool isGlobal(std::string name) const;
-    void setGlobalValue(std::string name, std::shared_ptr<Value> value);
-    Scope& getClassAttrs();
-    void setClassAttrs(Scope& scope);
+    // Registers a file whose top level is about to run and returns nothing, or returns the state of a file
+    // this program already imported. A file that's still Loading is being imported circularly.
+    std::optional<ModuleState> beginModule(const std::string& filename);
+    // Ends the innermost module. One that failed can be imported again.
+    void endModule(bool succeeded);
+    std::string getImportChain() const;
 
-    void setThis(std::shared_ptr<Value> inst_ref);
-    std::shared_ptr<Value> getThis();
+    std::shared_ptr<Scope> getClassAttrs() const;
+    void copyClassAttrs();
+    // Gives an instance its own copy of the variables its class body declared, and the functions defined
+    // there a closure over the copy. Call after copyClassAttrs().
+    void copyClassFrame();
+    // Gives the environment a snapshot of the globals, so later assignments elsewhere don't reach it
+    void copyGlobals();
+
+    void setThis(Value inst_ref);
+    Value getThis();
 
     void display(bool show_attrs = false) const;
 
+    // References the environment holds for an instance or class that owns it
+    void trace(GCVisitor& visitor) const;
+    void clearReferences();
+
     bool is_top_scope = false;
-    bool detect_recursion = DETECT_RECURSION;
+    bool if_chain_taken = false; // Whether the last if/elif run in this block was entered, so the rest of its chain is skipped
 private:
-    std::vector<Scope> scopes;
-    Scope class_attrs;
-    std::shared_ptr<Value> this_ref = nullptr;
+    std::shared_ptr<Globals> globals;
+    std::shared_ptr<Frame> frame;
+    std::shared_ptr<Scope> class_attrs; // Shared with the instance whose member function is running
+    Value this_ref = nullptr;
     bool class_env;
     int class_depth = 0;
     int loop_depth = 0;
-    std::unordered_map<std::string, std::shared_ptr<Value>> built_in_functions;
-    std::unordered_map<ValueType, std::unordered_map<std::string, std::shared_ptr<Value>>> member_functions;
-    std::unordered_map<int, std::vector<std::string>> scoped_globals;
 };
 
-class BreakException : public std::exception {};
-class ContinueException : public std::exception {};
-class ReturnException : public std::exception {
-public:
-    ReturnException(std::optional<std::shared_ptr<Value>> value)
-        : value{value} {}
-
-    std::optional<std::shared_ptr<Value>> value;
-};
 class StackOverflowException : public std::exception {};
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+class Interpreter;
+
+/*
+The embedding API, the one header a program linking the funcy library includes. A Funcy object is an
+interpreter of its own that scripts are loaded into, after which the host calls the functions they
+defined and reads or changes their globals. Values cross between the two as NativeValues.
+
+    Funcy funcy;
+    funcy.registerFunction("log", [](const std::vector<NativeValue>& args) { ...; return NativeValue{}; });
+    funcy.loadString("func score(x) { return x * 2; }");
+    int score = funcy.call("score", 21).get<int>();
+
+A Funcy object is used by one thread at a time, separate objects can run on separate threads.
+*/
+
+// Null, Bool, Int, Float, String, or a List of those
+struct NativeValue {
+    using List = std::vector<NativeValue>;
+
+    NativeValue() : value{nullptr} {}
+    NativeValue(std::nullptr_t) : value{nullptr} {}
+    NativeValue(bool v) : value{v} {}
+    NativeValue(int v) : value{v} {}
+    NativeValue(double v) : value{v} {}
+    NativeValue(const char* v) : value{std::string(v)} {}
+    NativeValue(std::string v) : value{std::move(v)} {}
+    NativeValue(List v) : value{std::move(v)} {}
+
+    bool isNull() const {
+        return std::holds_alternative<std::nullptr_t>(value);
+    }
+    template <typename T>
+    bool is() const {
+        return std::holds_alternative<T>(value);
+    }
+    // Throws std::bad_variant_access when it holds another type
+    template <typename T>
+    const T& get() const {
+        return std::get<T>(value);
+    }
+
+    std::variant<std::nullptr_t, bool, int, double, std::string, List> value;
+};
+
+// A builtin the host gives scripts. Scripts using pmap() or spawn() can call it from several threads at once.
+using NativeFunction = std::function<NativeValue(const std::vector<NativeValue>& args)>;
+
+// Thrown when a script fails, what() is the error as Funcy prints it
+class FuncyError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+struct FuncyOptions {
+    bool use_vm_engine = false;
+    bool use_module_cache = false; // Caches the files loaded and imported as .fyc files beside them
+    bool detect_recursion = true;
+};
+
+class Funcy {
+public:
+    explicit Funcy(const FuncyOptions& options = {});
+    ~Funcy();
+    Funcy(Funcy&&) noexcept;
+    Funcy& operator=(Funcy&&) noexcept;
+
+    // Runs the script, defining its functions and globals for the calls after. Scripts loaded later see
+    // what earlier ones defined.
+    void loadFile(const std::string& filename);
+    // Imports in the source are relative to the directory the name is in
+    void loadString(const std::string& source_code, const std::string& name = "<string>");
+
+    // Calls a function a script defined, or a builtin
+    template <typename... Args>
+    NativeValue call(const std::string& function, Args&&... args) {
+        return apply(function, {NativeValue(std::forward<Args>(args))...});
+    }
+    NativeValue apply(const std::string& function, const std::vector<NativeValue>& args);
+    // Builtins have to be registered before the scripts calling them are loaded
+    void registerFunction(const std::string& name, NativeFunction function);
+
+    bool hasGlobal(const std::string& name) const;
+    NativeValue getGlobal(const std::string& name) const;
+    void setGlobal(const std::string& name, const NativeValue& value);
+
+private:
+    std::unique_ptr<Interpreter> interpreter;
+};
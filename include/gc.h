@@ -0,0 +1,112 @@
+#pragma once
+#include <memory>
+#include <cstddef>
+#include <array>
+#include <functional>
+#include <climits>
+#include <mutex>
+#include "valueDefs.h"
+
+class GCObject;
+class GarbageCollector;
+
+// What a tracked object is, so the live objects of each kind can be counted
+enum class GCKind {
+    List,
+    Dictionary,
+    Function,
+    Class,
+    Instance,
+    Environment // Frames and class scopes
+};
+constexpr size_t GC_KIND_COUNT = 6;
+
+// Walks the references one container holds to other values and containers
+class GCVisitor {
+public:
+    virtual ~GCVisitor() = default;
+    virtual void visit(const Value& value) = 0;
+    virtual void visit(const GCObject* object) = 0;
+};
+
+/*
+Base of every heap object that can hold Values and so take part in a reference cycle.
+Objects register themselves on construction. The collector finds cycles by trial deletion: anything
+whose reference count is not fully explained by references from other tracked objects is held from
+outside (an environment, the call stack or a temporary) and is a root. Whatever the roots can't
+reach is garbage, and clearing its references lets the reference counts free it.
+*/
+class GCObject : public std::enable_shared_from_this<GCObject> {
+public:
+    explicit GCObject(GCKind kind);
+    GCObject(const GCObject& other);
+    GCObject& operator=(const GCObject& other);
+    virtual ~GCObject();
+
+    virtual void trace(GCVisitor& visitor) const = 0;
+    virtual void clearReferences() = 0;
+    // Approximate bytes the object and the storage it owns take up, not counting the values it holds
+    virtual size_t memoryUsage() const = 0;
+
+    GCKind getKind() const;
+
+private:
+    friend class GarbageCollector;
+    GarbageCollector* collector = nullptr; // The one tracking the object, it's unregistered from the same one
+    GCObject* prev = nullptr;
+    GCObject* next = nullptr;
+    GCKind kind;
+};
+
+struct GCStats {
+    size_t collections = 0;
+    size_t tracked = 0; // Objects currently registered
+    size_t freed = 0; // Objects released by breaking cycles, over all collections
+    std::array<MemoryCount, GC_KIND_COUNT> by_kind; // Counts only, bytes are measured by walking the objects
+};
+
+// Tracks the containers of one runtime and frees the cycles among them
+class GarbageCollector {
+public:
+    constexpr GarbageCollector() = default;
+    // Objects that outlive the collector are left untracked
+    ~GarbageCollector();
+    GarbageCollector(const GarbageCollector&) = delete;
+    GarbageCollector& operator=(const GarbageCollector&) = delete;
+
+    void track(GCObject* object);
+    void untrack(GCObject* object);
+    size_t collect();
+    void maybeCollect();
+    void forEach(const std::function<void(const GCObject&)>& visit) const;
+
+    GCStats stats;
+    // Tasks of this runtime running on other threads, collections wait until there are none
+    std::atomic<size_t> threaded_work{0};
+
+private:
+    // Held while objects are registered from several threads
+    std::unique_lock<std::mutex> lockWhenThreaded() const;
+
+    static constexpr size_t MIN_THRESHOLD = 10000;
+    static constexpr long ROOT = LONG_MAX / 2;
+
+    static const HeapObject* heapOf(const Value& value);
+    static const GCObject* heapTarget(const HeapObject* heap);
+
+    GCObject* head = nullptr;
+    size_t allocations = 0;
+    size_t threshold = MIN_THRESHOLD;
+    bool collecting = false;
+    mutable std::mutex mutex;
+};
+
+// The collector of the runtime bound to this thread, which new objects are tracked by
+extern thread_local constinit GarbageCollector* active_collector;
+
+// Runs a collection now
+size_t collectGarbage();
+// Runs a collection when enough objects were allocated since the last one, called at safe points
+void maybeCollectGarbage();
+const GCStats& getGCStats();
+void forEachTrackedObject(const std::function<void(const GCObject&)>& visit);
@@ -0,0 +1,38 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "environment.h"
+#include "symbols.h"
+
+struct Runtime;
+
+/*
+Runs Funcy programs with builtins, globals, imported modules and a runtime of its own, so interpreters on
+different threads never share anything they change. Programs run one after another share the globals
+and imports of the earlier ones. An interpreter is used by one thread at a time.
+*/
+class Interpreter {
+public:
+    explicit Interpreter(const InterpreterOptions& options = {});
+    // Waits for the tasks its programs spawned, then frees everything they made
+    ~Interpreter();
+    Interpreter(const Interpreter&) = delete;
+    Interpreter& operator=(const Interpreter&) = delete;
+
+    // Throws an ErrorException when the file can't be read or the program fails
+    void runFile(const std::string& filename);
+    // Runs source code as the file it was read from, which errors and imports are relative to. Source that
+    // wasn't read from the file is never cached beside it.
+    void runSource(const std::string& source_code, const std::string& filename, bool read_from_file = true);
+
+    Environment& getEnvironment();
+    Runtime& getRuntime();
+
+private:
+    std::unique_ptr<Runtime> runtime;
+    std::optional<Environment> env;
+    std::deque<std::vector<Symbol>> program_layouts; // Frames of functions the programs defined still name their slots with these
+};
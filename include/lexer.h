@@ -1,22 +1,30 @@
 #pragma once
 #include <variant>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "token.h"
 
 class Lexer {
 public:
-    Lexer(const std::string& source_code);
+    // The tokens point into source_code, it must outlive them
+    Lexer(std::string_view source_code);
 
     std::vector<Token> tokenize();
     [[noreturn]] void lexerError(std::string message, int line, int column) const;
 
 private:
-    std::string source_code;
-    int current_position = 0;
+    std::string_view source_code;
+    size_t current_position = 0;
     int line = 1;
     int column = 0;
 
     char grabNextCharacter();
     char peekNextCharacter(int ahead = 0);
-};
\ No newline at end of file
+    // Moves past characters on the current line that match
+    template <typename Predicate>
+    void skipWhile(Predicate predicate);
+};
+
+// Resolves the escape sequences of a string token, which the lexer has already checked
+std::string unescapeString(std::string_view literal);
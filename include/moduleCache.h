@@ -0,0 +1,12 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "nodes.h"
+
+/*
+Lexes and parses the source of a script or import. The parsed statements are saved beside the file
+(program.fy -> program.fyc) and loaded from there on later runs, as long as the source hashes the
+same and the cache was written by a compatible interpreter, unless use_cache is off. Must be called
+with the file as the current parsing context.
+*/
+std::vector<NodeRef<>> parseModule(const std::string& path, const std::string& source_code, bool use_cache);
@@ -2,27 +2,57 @@
 #include <variant>
 #include <string>
 #include <memory>
+#include <array>
 #include "token.h"
 #include <optional>
 #include "environment.h"
 #include "values.h"
+#include "arena.h"
 
 
 class ASTNode;
-using ASTList = std::vector<std::shared_ptr<ASTNode>>;
-using ASTDictionary = std::vector<std::pair<std::shared_ptr<ASTNode>, std::shared_ptr<ASTNode>>>;
+struct Chunk;
+using ASTList = std::vector<NodeRef<>>;
+using ASTDictionary = std::vector<std::pair<NodeRef<>, NodeRef<>>>;
 
 bool checkTruthy(const Value& value);
+bool checkConditionTruthy(const Value& value);
 
+enum class CompletionType { Normal, Break, Continue, Return };
+
+// How a statement finished. Break, continue and return are handed back to the enclosing loop or call
+// instead of being thrown, the value is the statement's result or the returned value.
+struct Completion {
+    CompletionType type = CompletionType::Normal;
+    std::optional<Value> value;
+};
+
+Completion executeBlock(const ASTList& statements, Environment& env);
+
+template <typename T, typename U>
+T* nodeCast(const NodeRef<U>& node) {
+    return dynamic_cast<T*>(node.get());
+}
+
+// Nodes don't change once the program is parsed and resolved. Whatever one run of them has to remember is
+// kept in its Environment and frames, so the same tree can run on many threads at once.
 class ASTNode {
 public:
-    bool debug = false;
-    int line, column;
+    static constexpr bool debug = false;
+    NodeIndex index; // Position in the arena, copies of a node share it
 
     ASTNode(int line, int column);
     virtual ~ASTNode() = default;
 
-    virtual std::optional<std::shared_ptr<Value>> evaluate(Environment&) = 0;
+    int line() const {
+        return active_arena->position(index).line;
+    }
+    int column() const {
+        return active_arena->position(index).column;
+    }
+
+    virtual std::optional<Value> evaluate(Environment&) = 0;
+    virtual Completion execute(Environment& env);
     virtual void debugPrint(ValueList values) = 0;
     virtual std::string getPrintable() = 0;
 };
@@ -35,7 +65,7 @@ private:
 public:
     AtomNode(std::variant<int, double, bool, std::string, SpecialIndex> value, int line, int column);
 
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env) override;
+    std::optional<Value> evaluate(Environment& env) override;
     void debugPrint(ValueList values) override;
     std::string getPrintable() override;
 
@@ -54,38 +84,43 @@ public:
 
 class UnaryOpNode : public ASTNode {
 public:
-    std::shared_ptr<ASTNode> right;
+    NodeRef<> right;
     TokenType op;
 
-    UnaryOpNode(TokenType op, std::shared_ptr<ASTNode> right, int line, int column);
+    UnaryOpNode(TokenType op, NodeRef<> right, int line, int column);
 
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env) override;
+    std::optional<Value> evaluate(Environment& env) override;
     void debugPrint(ValueList values) override;
     std::string getPrintable() override;
+
+    Value applyOperation(Value value);
 };
 
 class BinaryOpNode : public ASTNode {
 public:
-    std::shared_ptr<ASTNode> left, right;
+    NodeRef<> left, right;
     TokenType op;
 
-    BinaryOpNode(std::shared_ptr<ASTNode> left, TokenType op, std::shared_ptr<ASTNode> right, int line, int column);
+    BinaryOpNode(NodeRef<> left, TokenType op, NodeRef<> right, int line, int column);
 
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env) override;
+    std::optional<Value> evaluate(Environment& env) override;
     void debugPrint(ValueList values) override;
     std::string getPrintable() override;
 
-    std::optional<std::shared_ptr<Value>> performOperation(std::shared_ptr<Value> left_value,
-                                                            std::shared_ptr<Value>(right_value), TokenType* custom_op = nullptr);
+    std::optional<Value> performOperation(const Value& left_value,
+                                            const Value& right_value, TokenType* custom_op = nullptr);
+    Value applyOperation(const Value& left_value, const Value& right_value);
+    Value containsValue(Value left_value, Value right_value);
+    std::optional<Value> getMember(Environment& env, Value left_value);
 };
 
 class ParenthesisOpNode : public ASTNode {
 public:
-    std::shared_ptr<ASTNode> expr;
+    NodeRef<> expr;
 
-    ParenthesisOpNode(std::shared_ptr<ASTNode> expr, int line, int column);
+    ParenthesisOpNode(NodeRef<> expr, int line, int column);
 
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env) override;
+    std::optional<Value> evaluate(Environment& env) override;
     void debugPrint(ValueList values) override;
     std::string getPrintable() override;
 };
@@ -93,12 +128,18 @@ public:
 class IdentifierNode : public ASTNode {
 public:
     std::string name;
+    Symbol symbol;
     bool member_variable = false;
+    // Set by the resolver. A depth of -1 is a global lookup, otherwise the slot is in the frame 'depth' levels out
+    int depth = -1;
+    int slot = -1;
 
     IdentifierNode(std::string name, int line, int column);
+    IdentifierNode(Symbol symbol, int line, int column);
 
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env) override;
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env, ValueType member_type);
+    std::optional<Value> evaluate(Environment& env) override;
+    std::optional<Value> evaluate(Environment& env, ValueType member_type);
+    void assign(Environment& env, Value value);
     void debugPrint(ValueList values) override;
     std::string getPrintable() override;
 };
@@ -106,54 +147,58 @@ public:
 class ScopedNode : public ASTNode {
 public:
     TokenType keyword;
-    const std::shared_ptr<ScopedNode> if_link;
-    std::shared_ptr<ASTNode> comparison;
-    bool last_comparison_result;
-    std::vector<std::shared_ptr<ASTNode>> statements_block;
+    const NodeRef<ScopedNode> if_link;
+    NodeRef<> comparison;
+    ASTList statements_block;
+    SlotRange slots;
 
-    ScopedNode(TokenType keyword, std::shared_ptr<ScopedNode> if_link, std::shared_ptr<ASTNode> comparison,
-                std::vector<std::shared_ptr<ASTNode>> statements_block, int line, int column);
+    ScopedNode(TokenType keyword, NodeRef<ScopedNode> if_link, NodeRef<> comparison,
+                ASTList statements_block, int line, int column);
 
     ~ScopedNode() noexcept override = default;
 
     bool getComparisonValue(Environment& env) const;
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env) override;
+    std::optional<Value> evaluate(Environment& env) override;
+    Completion execute(Environment& env) override;
     void debugPrint(ValueList values) override;
     std::string getPrintable() override;
 };
 
 class ForNode : public ASTNode {
 public:
-    ForNode(TokenType keyword, std::shared_ptr<ASTNode> initialization,
-            std::shared_ptr<ASTNode> condition_value, std::shared_ptr<ASTNode> increment,
-            std::vector<std::shared_ptr<ASTNode>> block, int line, int column);
+    ForNode(TokenType keyword, NodeRef<> initialization,
+            NodeRef<> condition_value, NodeRef<> increment,
+            ASTList block, int line, int column);
     
     ~ForNode() noexcept override = default;
 
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env) override;
+    std::optional<Value> evaluate(Environment& env) override;
+    Completion execute(Environment& env) override;
     void debugPrint(ValueList values) override;
     std::string getPrintable() override;
     
     TokenType keyword;
-    std::shared_ptr<ASTNode> initialization;
-    std::shared_ptr<ASTNode> condition_value;
-    std::shared_ptr<ASTNode> increment;
-    std::vector<std::shared_ptr<ASTNode>> block;
+    NodeRef<> initialization;
+    NodeRef<> condition_value;
+    NodeRef<> increment;
+    ASTList block;
+    SlotRange slots;
 };
 
 class KeywordNode : public ASTNode {
 public:
-    KeywordNode(TokenType keyword, std::shared_ptr<ASTNode> right, int line, int column)
+    KeywordNode(TokenType keyword, NodeRef<> right, int line, int column)
         : ASTNode{line, column}, keyword{keyword}, right{right} {}
     
     ~KeywordNode() noexcept override = default;
 
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env) override;
+    std::optional<Value> evaluate(Environment& env) override;
+    Completion execute(Environment& env) override;
     void debugPrint(ValueList values) override;
     std::string getPrintable() override;
 
     TokenType keyword;
-    std::shared_ptr<ASTNode> right;
+    NodeRef<> right;
 };
 
 class ListNode : public ASTNode {
@@ -162,7 +207,7 @@ public:
         : ASTNode{line, column}, list{list} {}
     ~ListNode() noexcept override = default;
 
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env) override;
+    std::optional<Value> evaluate(Environment& env) override;
     void debugPrint(ValueList values) override;
     std::string getPrintable() override;
 
@@ -171,72 +216,93 @@ public:
 
 class IndexNode : public ASTNode {
 public:
-    IndexNode(std::shared_ptr<ASTNode> container, std::shared_ptr<ASTNode> start_index, std::shared_ptr<ASTNode> end_index,
+    IndexNode(NodeRef<> container, NodeRef<> start_index, NodeRef<> end_index,
                 int line, int column)
         : ASTNode{line, column}, container{container}, start_index{start_index}, end_index{end_index} {}
     ~IndexNode() noexcept override = default;
 
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env) override;
+    std::optional<Value> evaluate(Environment& env) override;
     void debugPrint(ValueList values) override;
     std::string getPrintable() override;
-    std::optional<std::shared_ptr<Value>> getIndex(Environment& env,
-                                                    std::variant<std::shared_ptr<std::string>,
-                                                                std::shared_ptr<List>,
-                                                                std::shared_ptr<Dictionary>> distr);
-    void assignIndex(Environment& env, std::shared_ptr<Value> value);
-
-    std::shared_ptr<ASTNode> container;
-    std::shared_ptr<ASTNode> start_index;
-    std::shared_ptr<ASTNode> end_index;
+    std::optional<Value> getIndex(Value container_value,
+                                                    Value start_value,
+                                                    Value end_value);
+    void assignIndex(Environment& env, Value value);
+    // The assignment once the container and indexes are evaluated, end_value is only used by a slice
+    void setIndex(Value container_value, Value start_value, Value end_value, Value value);
+
+    NodeRef<> container;
+    NodeRef<> start_index;
+    NodeRef<> end_index;
 };
 
-class FuncNode : public ASTNode {
+class FuncNode : public ASTNode, public GCObject {
 public:
-    FuncNode(bool member_func, std::shared_ptr<std::string> func_name, std::vector<std::shared_ptr<ASTNode>> args,
-            std::map<std::string, std::shared_ptr<ASTNode>> default_arg_values, std::vector<std::shared_ptr<ASTNode>> block,
+    FuncNode(bool member_func, std::shared_ptr<std::string> func_name, ASTList args,
+            std::vector<std::pair<std::string, NodeRef<>>> default_arg_values, ASTList block,
             int line, int column, std::string file_context)
-        : ASTNode{line, column}, member_func{member_func}, func_name{func_name}, args{args}, default_arg_nodes{default_arg_values}, block{block}, file_context{file_context} {}
+        : ASTNode{line, column}, GCObject{GCKind::Function}, member_func{member_func}, func_name{func_name}, args{args}, default_arg_nodes{default_arg_values}, block{block}, file_context{file_context} {}
     
     ~FuncNode() noexcept override = default;
 
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env) override;
+    void trace(GCVisitor& visitor) const override;
+    void clearReferences() override;
+    size_t memoryUsage() const override;
+
+    std::optional<Value> evaluate(Environment& env) override;
     void debugPrint(ValueList values) override;
     std::string getPrintable() override;
-    void setArgs(ValueList values, std::map<std::string, std::shared_ptr<Value>> pairs, Scope& local_scope);
-    std::optional<std::shared_ptr<Value>> callFunc(ValueList values,
-                                                    std::map<std::string, std::shared_ptr<Value>> pairs,
-                                                    Environment& global_env, bool member_func = false);
+    void setArgs(ValueList values, std::map<std::string, Value> pairs, Environment& call_env);
+    std::optional<Value> callFunc(ValueList values,
+                                                    std::map<std::string, Value> pairs,
+                                                    Environment& caller_env, bool member_func = false);
+    // The VM's call of a compiled function given exactly one value per argument. They're moved from
+    // values straight into the new frame.
+    std::optional<Value> callCompiled(Value* values, Environment& caller_env);
     
-    Environment local_env;
+    // Evaluating the definition copies it into a function value, which alone gets a closure and default values
+    std::shared_ptr<Frame> closure; // Frame the function was defined in
     bool member_func;
     std::shared_ptr<std::string> func_name;
-    std::vector<std::shared_ptr<ASTNode>> args;
-    std::map<std::string, std::shared_ptr<ASTNode>> default_arg_nodes;
-    std::map<std::string, std::shared_ptr<Value>> default_arg_values;
-    std::vector<std::shared_ptr<ASTNode>> block;
+    ASTList args;
+    std::vector<std::pair<std::string, NodeRef<>>> default_arg_nodes;
+    std::map<std::string, Value> default_arg_values;
+    ASTList block;
+    std::vector<Symbol> frame_layout; // Arguments take the first slots
     std::string file_context;
-    int recursion = 0;
-    bool detect_recursion_limit = local_env.detect_recursion;
+    std::shared_ptr<Chunk> chunk; // Bytecode for the block when running on the VM engine, compiled when resolved
 };
 
 class MethodCallNode : public ASTNode {
 public:
-    MethodCallNode(std::shared_ptr<ASTNode> stored_func, std::vector<std::shared_ptr<ASTNode>> values, int line, int column)
-        : ASTNode{line, column}, stored_func{stored_func}, values{values} {}
+    MethodCallNode(NodeRef<> stored_func, ASTList values, int line, int column)
+        : ASTNode{line, column}, stored_func{stored_func}, values{values} {
+        if (auto ident = nodeCast<IdentifierNode>(stored_func)) {
+            member_symbol = ident->symbol;
+        }
+    }
     
     ~MethodCallNode() noexcept override = default;
 
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env) override;
+    std::optional<Value> evaluate(Environment& env) override;
     void debugPrint(ValueList values) override;
     std::string getPrintable() override;
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env, ValueType member_type);
+    std::optional<Value> evaluate(Environment& env, const Value& receiver);
     void evaluateArgs(ValueList& args,
-                    std::map<std::string, std::shared_ptr<Value>>& pairs, Environment& env);
-
-    std::shared_ptr<ASTNode> stored_func;
-    std::vector<std::shared_ptr<ASTNode>> values;
-    std::shared_ptr<Value> member_value;
-    std::shared_ptr<Environment> parent_env = nullptr;
+                    std::map<std::string, Value>& pairs, Environment& env);
+    bool hasLabeledArgs() const;
+    std::optional<Value> callValue(Environment& env, Value mapped_value,
+                                                    ValueList& args, std::map<std::string, Value>& pairs);
+    Value resolveMember(Value receiver, Environment& environment);
+    std::optional<Value> callMember(Environment& env, Environment& environment,
+                                                    Value receiver, Value mapped_value,
+                                                    ValueList& args, std::map<std::string, Value>& pairs);
+    Value builtinMember(Environment& env, ValueType member_type);
+    std::optional<Value> callBuiltinMember(Environment& env, const Value& func, const ValueList& args);
+
+    NodeRef<> stored_func;
+    ASTList values;
+    Symbol member_symbol = -1; // The name called when stored_func is an identifier
 };
 
 class DictionaryNode : public ASTNode {
@@ -245,7 +311,7 @@ public:
         : ASTNode{line, column}, dictionary{dictionary} {}
     ~DictionaryNode() noexcept override = default;
 
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env) override;
+    std::optional<Value> evaluate(Environment& env) override;
     void debugPrint(ValueList values) override;
     std::string getPrintable() override;
 
@@ -254,15 +320,15 @@ public:
 
 class ClassNode : public ASTNode {
 public:
-    ClassNode(std::shared_ptr<std::string> name, std::vector<std::shared_ptr<ASTNode>> block, int line, int column, std::string file_context)
+    ClassNode(std::shared_ptr<std::string> name, ASTList block, int line, int column, std::string file_context)
         : ASTNode{line, column}, name{*name}, block{block}, file_context{file_context} {}
 
-    std::optional<std::shared_ptr<Value>> evaluate(Environment& env) override;
+    std::optional<Value> evaluate(Environment& env) override;
     void debugPrint(ValueList values) override;
     std::string getPrintable() override;
 
     std::string name;
-    std::vector<std::shared_ptr<ASTNode>> block;
-    Scope local_scope;
+    ASTList block;
+    std::vector<Symbol> frame_layout;
     std::string file_context;
 };
\ No newline at end of file
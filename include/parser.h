@@ -7,47 +7,54 @@
 
 
 class Parser {
+public:
+    // Binding strength of binary operators, from loosest to tightest
+    enum class Precedence {
+        None,
+        Or,
+        And,
+        Equality,
+        Relation,
+        Sum,
+        Product
+    };
+
 private:
     bool debug = false;
     const std::vector<Token>& tokens;
     size_t current_index;
-    std::vector<std::shared_ptr<ScopedNode>> last_if_else{nullptr};
+    std::vector<NodeRef<ScopedNode>> last_if_else{nullptr};
 
     std::optional<const Token*> peekToken(int ahead = 1) const;
     const Token& getToken() const;
     const Token& consumeToken();
     void backUp();
     std::string getTokenStr() const;
-    bool tokenIs(std::string str) const;
-    bool nextTokenIs(std::string str, int ahead = 1) const;
-    void expect(std::string expected) const;
+    bool tokenIs(TokenType type) const;
+    bool nextTokenIs(TokenType type, int ahead = 1) const;
+    void expect(TokenType expected) const;
 
-    std::shared_ptr<ASTNode> parseFoundation();
-    std::shared_ptr<ASTNode> parseControlFlowStatement();
-    std::shared_ptr<ASTNode> parseKeyword();
-    std::shared_ptr<ASTNode> parseStatement(std::shared_ptr<std::string> varString = nullptr);
-    std::shared_ptr<ASTNode> parseLogicalOr();
-    std::shared_ptr<ASTNode> parseLogicalAnd();
-    std::shared_ptr<ASTNode> parseEquality();
-    std::shared_ptr<ASTNode> parseRelation();
-    std::shared_ptr<ASTNode> parseExpression();
-    std::shared_ptr<ASTNode> parseTerm();
-    std::shared_ptr<ASTNode> parseFactor();
-    std::shared_ptr<ASTNode> parsePower();
-    std::shared_ptr<ASTNode> parseLogicalNot();
-    std::shared_ptr<ASTNode> parseMemberAccess(std::shared_ptr<std::string> var_string = nullptr);
-    std::shared_ptr<ASTNode> parseIndexing(std::shared_ptr<ASTNode> = nullptr);
-    std::shared_ptr<ASTNode> parseCollection();
-    std::shared_ptr<ASTNode> parseAtom();
-    std::shared_ptr<ASTNode> parseFuncCall(std::shared_ptr<ASTNode> identifier = nullptr);
-    std::shared_ptr<ASTNode> parseIdentifier(std::shared_ptr<std::string> varString = nullptr);
+    NodeRef<> parseFoundation();
+    NodeRef<> parseControlFlowStatement();
+    NodeRef<> parseKeyword();
+    NodeRef<> parseStatement(std::shared_ptr<std::string> varString = nullptr);
+    NodeRef<> parseExpression(Precedence min_precedence = Precedence::Or);
+    NodeRef<> parseFactor();
+    NodeRef<> parsePower();
+    NodeRef<> parseLogicalNot();
+    NodeRef<> parseMemberAccess(std::shared_ptr<std::string> var_string = nullptr);
+    NodeRef<> parseIndexing(NodeRef<> = nullptr);
+    NodeRef<> parseCollection();
+    NodeRef<> parseAtom();
+    NodeRef<> parseFuncCall(NodeRef<> identifier = nullptr);
+    NodeRef<> parseIdentifier(std::shared_ptr<std::string> varString = nullptr);
 public:
     explicit Parser(const std::vector<Token>& tokens);
     [[noreturn]] void parsingError(std::string message, int line, int column) const;
     // noreturn used so compiler doesn't complain about functions not returning when
     // calling this error function
 
-    std::vector<std::shared_ptr<ASTNode>> parse();
+    std::vector<NodeRef<>> parse();
 
     void addIfElseScope();
     void removeIfElseScope();
@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <thread>
+
+class ASTNode;
+
+// Ticks of the sampling thread not yet taken, the interpreter takes them at its next safe point. Ticks that
+// fire while one builtin runs pile up here, so they're still each counted.
+extern std::atomic<size_t> profile_samples_due;
+
+// Records the running Funcy call stack with the line of the node being executed, once for every tick due
+void recordProfileSample(const ASTNode* node);
+
+inline void profileSafePoint(const ASTNode* node) {
+    if (profile_samples_due.load(std::memory_order_relaxed) != 0) [[unlikely]] {
+        recordProfileSample(node);
+    }
+}
+
+/*
+Samples the program at the given rate for as long as it exists. Afterwards the samples are written as
+folded stacks (program.fy -> program.fy.folded), the input format of flamegraph tools, and a table of
+the time spent in each function is printed.
+*/
+class ProfileSession {
+public:
+    ProfileSession(const std::string& program, int hz);
+    ~ProfileSession();
+
+private:
+    std::string program;
+    int hz;
+    std::atomic<bool> running{true};
+    std::thread sampler;
+};
@@ -0,0 +1,11 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include "nodes.h"
+
+// Binds every identifier in a parsed program to a frame slot or a global symbol.
+// Names assigned at the top level of the program are globals, names first assigned inside a block,
+// function or class body get a slot in that body's frame. Returns the layout of the program's own frame,
+// which holds the variables of blocks at the top level. With compile_functions every function body is also
+// compiled for the VM engine, so the tree isn't changed again once the program runs.
+std::vector<Symbol> resolveProgram(const std::vector<NodeRef<>>& statements, bool compile_functions = false);
@@ -0,0 +1,43 @@
+#pragma once
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include "arena.h"
+#include "gc.h"
+#include "valueDefs.h"
+
+/*
+Everything an interpreter allocates into: the nodes it parses, the containers its collector tracks and
+the counts memStats() reports. Code uses the runtime bound to the thread it runs on, so interpreters on
+different threads share none of it. Tasks an interpreter starts are bound to its runtime.
+*/
+struct Runtime {
+    MemoryCounts memory;
+    GarbageCollector collector;
+    size_t spawned_threads = 0; // Started by spawn() and still running, guarded by the thread pool
+    std::array<size_t, GC_KIND_COUNT> peak_container_bytes{}; // Highest memStats() has measured
+    std::mutex sources_mutex;
+    std::vector<std::pair<std::string, std::string>> sources; // Name and code of programs run from a string, for the lines errors show
+
+    // Keeps source code that isn't in a file under the name it runs as, replacing code run under that name before
+    void addSource(const std::string& name, const std::string& source_code);
+    std::optional<std::string> findSource(const std::string& name);
+    ASTArena arena; // Last so it's destroyed first, the values its nodes hold are still counted and tracked
+};
+
+// The runtime of every thread nothing bound another to
+Runtime& processRuntime();
+Runtime& activeRuntime();
+
+// Binds a runtime to the thread it's created on, restoring the previous one when destroyed
+class RuntimeScope {
+public:
+    explicit RuntimeScope(Runtime& runtime);
+    ~RuntimeScope();
+    RuntimeScope(const RuntimeScope&) = delete;
+    RuntimeScope& operator=(const RuntimeScope&) = delete;
+
+private:
+    Runtime* previous;
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Set by --stats. The counters below are only compiled in when FUNCY_STATS is defined.
+extern bool COLLECT_STATS;
+
+enum class Phase {
+    Lex,
+    Parse, // Includes loading a cached parse
+    Compile, // Resolving slots and compiling bytecode
+    Execute
+};
+
+struct ExecutionStats {
+    std::unordered_map<const char*, uint64_t> node_evaluations; // Keyed by node type name
+    uint64_t vm_instructions = 0;
+    uint64_t function_calls = 0;
+    uint64_t builtin_calls = 0;
+    uint64_t environment_copies = 0;
+    uint64_t value_allocations = 0; // Values that needed a HeapObject
+    uint64_t exceptions = 0;
+    uint64_t dictionary_lookups = 0;
+    uint64_t imports = 0;
+    std::chrono::steady_clock::duration phase_times[4]{};
+};
+
+// Counted by each thread on its own, worker threads merge theirs into the totals as they finish a task
+extern thread_local ExecutionStats execution_stats;
+
+#ifdef FUNCY_STATS
+#define COUNT_STAT(counter) \
+    do { if (COLLECT_STATS) [[unlikely]] { execution_stats.counter++; } } while (false)
+#define ADD_STAT(counter, amount) \
+    do { if (COLLECT_STATS) [[unlikely]] { execution_stats.counter += (amount); } } while (false)
+#define COUNT_NODE_STAT(type_name) \
+    do { if (COLLECT_STATS) [[unlikely]] { execution_stats.node_evaluations[type_name]++; } } while (false)
+#else
+#define COUNT_STAT(counter) do {} while (false)
+#define ADD_STAT(counter, amount) do {} while (false)
+#define COUNT_NODE_STAT(type_name) do {} while (false)
+#endif
+
+// Charges the time until it's destroyed to a phase, time spent in a nested PhaseTimer goes to the nested phase
+class PhaseTimer {
+public:
+    explicit PhaseTimer(Phase phase);
+    ~PhaseTimer();
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    Phase previous = Phase::Execute;
+    bool active;
+};
+
+// Adds the counters of the calling thread to the totals and resets them
+void mergeThreadStats();
+
+// Prints the counters, phase times and peak memory to the error stream
+void printExecutionStats(const std::string& program);
@@ -0,0 +1,9 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+using Symbol = int;
+
+// Identifier names are interned once so variables can be looked up by index instead of by string
+Symbol internSymbol(std::string_view name);
+const std::string& symbolName(Symbol symbol);
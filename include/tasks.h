@@ -0,0 +1,54 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include "valueDefs.h"
+
+/*
+Values that let scripts run functions concurrently. spawn() starts a function on a thread of its own and
+returns a Future for its result. A Channel is a bounded queue any number of tasks can send to and receive
+from, blocking senders while it's full and receivers while it's empty.
+*/
+
+// The result of a spawned function, set once by the thread that ran it
+class Future {
+public:
+    // Reports an error nothing joined to see
+    ~Future();
+
+    // Stores what the function returned, or the error it ended with, and wakes every thread joining it
+    void finish(std::optional<Value> result, std::exception_ptr error);
+    // Blocks until the function is done, then returns its result or rethrows its error. Can be called again.
+    Value join();
+    bool done();
+
+private:
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool is_done = false;
+    bool joined = false;
+    Value result = Value::none();
+    std::exception_ptr error;
+};
+
+class Channel {
+public:
+    explicit Channel(size_t capacity);
+
+    // Blocks while the channel is full. Returns false if the channel is closed before the value is queued.
+    bool send(Value value);
+    // Blocks while the channel is empty. Returns nothing once it's closed and every value was received.
+    std::optional<Value> recv();
+    // Wakes every blocked sender and receiver. Values already queued can still be received.
+    void close();
+
+private:
+    std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+    std::deque<Value> buffer;
+    size_t capacity;
+    bool closed = false;
+};
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+// Threads that run parallel work, counting the thread waiting on it. Set by --threads, 0 uses one per core.
+extern int THREAD_COUNT;
+
+/*
+Runs tasks on worker threads started the first time parallel work is submitted and kept for the rest of
+the program. Every thread has its own queue and takes work from the back of another thread's queue once
+its own is empty. A thread waiting for its tasks runs queued tasks instead of blocking, so a task can
+start parallel work of its own.
+*/
+
+// Calls task(i) for every i below count and returns once all of them are done. When tasks throw, the ones
+// after the lowest failing index are skipped and that task's exception is rethrown, as a plain loop would.
+void parallelFor(size_t count, const std::function<void(size_t)>& task);
+// Threads parallelFor spreads tasks over
+size_t parallelThreadCount();
+// True on a thread while it runs a task, where the program's globals can't be changed
+bool inParallelTask();
+
+// Runs task on a thread of its own, bound to the caller's runtime, which counts as a parallel task for as
+// long as it runs. The task must not throw. A thread of its own lets it block, on a channel for example, without holding up the pool.
+void startThread(std::function<void()> task);
+// Blocks until every thread startThread started in the caller's runtime has finished
+void waitForThreads();
+// Threads startThread started in any runtime that haven't finished yet
+size_t runningThreads();
@@ -1,9 +1,13 @@
 #pragma once
 #include <variant>
 #include <string>
+#include <string_view>
+#include <optional>
 #include <unordered_map>
+#include "symbols.h"
 
-using TokenValue = std::variant<int, double, bool, std::string>;
+// Names and string literals are views into the source code, which has to outlive the tokens
+using TokenValue = std::variant<int, double, bool, std::string_view>;
 
 enum class TokenType{
     _Integer,
@@ -78,15 +82,17 @@ enum class TokenType{
 
 std::string getTokenTypeLabel(TokenType type);
 
-extern std::unordered_map<char, TokenType> char_tokens;
-
-extern std::unordered_map<std::string, TokenType> keyword_tokens;
+// The single character token for a character, if it starts one
+std::optional<TokenType> findCharToken(char character);
+// The keyword a word spells, true and false are _Boolean
+std::optional<TokenType> findKeyword(std::string_view word);
 
 class Token {
 public:
     TokenType type;
     TokenValue value;
     int line, column;
+    Symbol symbol = -1; // Interned name of an identifier
 
     Token(TokenType type, TokenValue value, int line, int column);
     Token(TokenType type, int line, int column);
@@ -0,0 +1,326 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <string>
+#include <memory>
+#include <variant>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <type_traits>
+#include "errorDefs.h"
+
+// Set while tasks run on more than one thread, reference counts and counters are only atomic then.
+// It's read with acquire ordering, so a thread that sees it cleared also sees the other threads' last updates.
+extern std::atomic<bool> THREADS_ACTIVE;
+
+enum class SpecialIndex {
+    Front,
+    Back
+};
+
+enum class ValueType {
+    Integer,
+    Boolean,
+    String,
+    Float,
+    List,
+    Dictionary,
+    None,
+    Function,
+    Index,
+    BuiltInFunction,
+    Class,
+    Instance,
+    Type,
+    Range,
+    Future,
+    Channel
+};
+constexpr size_t VALUE_TYPE_COUNT = 16;
+
+class Value;
+class List;
+class ASTNode;
+class Class;
+class Instance;
+class Environment;
+class Dictionary;
+class Future;
+class Channel;
+
+// The integers from start up to (or down to) stop, produced lazily by range()
+struct Range {
+    int start;
+    int stop;
+    int step;
+
+    int size() const {
+        int64_t distance = step > 0 ? int64_t{stop} - start : int64_t{start} - stop;
+        int64_t stride = step > 0 ? step : -int64_t{step};
+        return distance > 0 ? static_cast<int>((distance + stride - 1) / stride) : 0;
+    }
+    int at(int index) const {
+        return static_cast<int>(start + int64_t{index} * step);
+    }
+    bool contains(int64_t value) const {
+        int64_t offset = value - start;
+        return offset % step == 0 && offset / step >= 0 && offset / step < size();
+    }
+};
+
+using BuiltInFunction = std::function<std::optional<Value>(
+    const std::vector<Value>& args, Environment& env
+)>;
+
+// Live objects of one type with their approximate size, and the most there have been at once
+struct MemoryCount {
+    size_t count = 0;
+    size_t bytes = 0;
+    size_t peak_count = 0;
+    size_t peak_bytes = 0;
+
+    void add(size_t size) {
+        if (THREADS_ACTIVE.load(std::memory_order_acquire)) [[unlikely]] {
+            raisePeak(peak_count, std::atomic_ref(count).fetch_add(1, std::memory_order_relaxed) + 1);
+            raisePeak(peak_bytes, std::atomic_ref(bytes).fetch_add(size, std::memory_order_relaxed) + size);
+            return;
+        }
+        count++;
+        bytes += size;
+        peak_count = std::max(peak_count, count);
+        peak_bytes = std::max(peak_bytes, bytes);
+    }
+    void remove(size_t size) {
+        if (THREADS_ACTIVE.load(std::memory_order_acquire)) [[unlikely]] {
+            std::atomic_ref(count).fetch_sub(1, std::memory_order_relaxed);
+            std::atomic_ref(bytes).fetch_sub(size, std::memory_order_relaxed);
+            return;
+        }
+        count--;
+        bytes -= size;
+    }
+
+private:
+    static void raisePeak(size_t& peak, size_t value) {
+        std::atomic_ref shared{peak};
+        size_t current = shared.load(std::memory_order_relaxed);
+        while (current < value && !shared.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+    }
+};
+
+// Live HeapObjects of each ValueType and of every type together
+struct MemoryCounts {
+    std::array<MemoryCount, VALUE_TYPE_COUNT> by_type;
+    MemoryCount total;
+};
+
+// The counts of the runtime bound to this thread, HeapObjects are counted where they're made and freed
+extern thread_local constinit MemoryCounts* active_memory_counts;
+
+// Out of line storage for the values that don't fit in a Value word
+struct HeapObject {
+    using Storage = std::variant<std::string, std::shared_ptr<List>, std::shared_ptr<ASTNode>,
+                                std::shared_ptr<BuiltInFunction>, std::shared_ptr<Dictionary>,
+                                std::shared_ptr<Class>, std::shared_ptr<Instance>, Range,
+                                std::shared_ptr<Future>, std::shared_ptr<Channel>>;
+
+    template <typename T>
+    HeapObject(ValueType type, T&& value)
+        : type{type}, value{std::forward<T>(value)} {
+        size_t size = memoryUsage();
+        active_memory_counts->by_type[static_cast<size_t>(type)].add(size);
+        active_memory_counts->total.add(size);
+    }
+    ~HeapObject() {
+        size_t size = memoryUsage();
+        active_memory_counts->by_type[static_cast<size_t>(type)].remove(size);
+        active_memory_counts->total.remove(size);
+    }
+
+    // The HeapObject and the characters of a string, which never change once stored
+    size_t memoryUsage() const;
+
+    uint32_t refs = 1;
+    ValueType type;
+    Storage value;
+};
+
+/*
+A Value is a single 64 bit word.
+    0x0000 prefix: a HeapObject pointer, or an immediate when the low 3 bits are set (0 is an empty value)
+    0xFFFE prefix: a 32 bit integer in the low bits
+    anything else: a double, offset by 2^49 so it never lands in the other two ranges
+Copying a Value only touches a reference count when it points at a HeapObject.
+*/
+class Value {
+public:
+    Value() = default;
+    Value(std::nullptr_t) {}
+    explicit Value(int v) : bits{INT_TAG | static_cast<uint32_t>(v)} {}
+    explicit Value(double v);
+    explicit Value(bool v) : bits{immediate(BOOL_TAG, v)} {}
+    explicit Value(const std::string& v);
+    explicit Value(std::shared_ptr<List> v);
+    explicit Value(SpecialIndex v) : bits{immediate(INDEX_TAG, static_cast<uint64_t>(v))} {}
+    explicit Value(std::shared_ptr<ASTNode> v);
+    explicit Value(std::shared_ptr<BuiltInFunction> v);
+    explicit Value(ValueType v) : bits{immediate(TYPE_TAG, static_cast<uint64_t>(v))} {}
+    explicit Value(std::shared_ptr<Dictionary> v);
+    explicit Value(std::shared_ptr<Class> v);
+    explicit Value(std::shared_ptr<Instance> v);
+    explicit Value(Range v);
+    explicit Value(std::shared_ptr<Future> v);
+    explicit Value(std::shared_ptr<Channel> v);
+
+    static Value none() {
+        Value value;
+        value.bits = immediate(NONE_TAG, 0);
+        return value;
+    }
+
+    Value(const Value& other) : bits{other.bits} {
+        if (isHeap()) {
+            retain();
+        }
+    }
+    Value(Value&& other) noexcept : bits{other.bits} {
+        other.bits = 0;
+    }
+    Value& operator=(const Value& other) {
+        if (other.isHeap()) {
+            other.retain();
+        }
+        release();
+        bits = other.bits;
+        return *this;
+    }
+    Value& operator=(Value&& other) noexcept {
+        if (this != &other) {
+            release();
+            bits = other.bits;
+            other.bits = 0;
+        }
+        return *this;
+    }
+    ~Value() {
+        release();
+    }
+
+    explicit operator bool() const {
+        return bits != 0;
+    }
+    bool operator==(std::nullptr_t) const {
+        return bits == 0;
+    }
+
+    ValueType getType() const {
+        if ((bits >> 48) == INT_PREFIX) {
+            return ValueType::Integer;
+        }
+        if ((bits >> 48) != 0) {
+            return ValueType::Float;
+        }
+        switch (bits & TAG_MASK) {
+            case 0: return bits ? heap()->type : ValueType::None;
+            case BOOL_TAG: return ValueType::Boolean;
+            case TYPE_TAG: return ValueType::Type;
+            case INDEX_TAG: return ValueType::Index;
+            default: return ValueType::None;
+        }
+    }
+
+    // Scalars are returned by value, heap values by reference into the shared HeapObject
+    template <typename T>
+    decltype(auto) get() const {
+        if constexpr (std::is_same_v<T, int>) {
+            checkType(ValueType::Integer);
+            return static_cast<int>(static_cast<uint32_t>(bits));
+        } else if constexpr (std::is_same_v<T, double>) {
+            checkType(ValueType::Float);
+            uint64_t raw = bits - DOUBLE_OFFSET;
+            double v;
+            std::memcpy(&v, &raw, sizeof(v));
+            return v;
+        } else if constexpr (std::is_same_v<T, bool>) {
+            checkType(ValueType::Boolean);
+            return static_cast<bool>(bits >> 3);
+        } else if constexpr (std::is_same_v<T, ValueType>) {
+            checkType(ValueType::Type);
+            return static_cast<ValueType>(bits >> 3);
+        } else if constexpr (std::is_same_v<T, SpecialIndex>) {
+            checkType(ValueType::Index);
+            return static_cast<SpecialIndex>(bits >> 3);
+        } else {
+            if (!isHeap() || !std::holds_alternative<T>(heap()->value)) {
+                throwError(ErrorType::Runtime, "Incorrect type access in value");
+            }
+            return static_cast<const T&>(std::get<T>(heap()->value));
+        }
+    }
+
+    std::string getPrintable(int tabs=0, bool error=false) const;
+
+    // Identity of the value, heap values compare by object
+    uint64_t getBits() const {
+        return bits;
+    }
+
+private:
+    friend class GarbageCollector;
+
+    static constexpr uint64_t INT_PREFIX = 0xFFFE;
+    static constexpr uint64_t INT_TAG = INT_PREFIX << 48;
+    static constexpr uint64_t DOUBLE_OFFSET = uint64_t{1} << 49;
+    static constexpr uint64_t TAG_MASK = 0x7;
+    static constexpr uint64_t NONE_TAG = 1;
+    static constexpr uint64_t BOOL_TAG = 2;
+    static constexpr uint64_t TYPE_TAG = 3;
+    static constexpr uint64_t INDEX_TAG = 4;
+
+    static constexpr uint64_t immediate(uint64_t tag, uint64_t payload) {
+        return (payload << 3) | tag;
+    }
+
+    bool isHeap() const {
+        return bits != 0 && (bits >> 48) == 0 && (bits & TAG_MASK) == 0;
+    }
+    HeapObject* heap() const {
+        return reinterpret_cast<HeapObject*>(bits);
+    }
+    void setHeap(HeapObject* object) {
+        bits = reinterpret_cast<uint64_t>(object);
+    }
+    void retain() const {
+        if (THREADS_ACTIVE.load(std::memory_order_acquire)) [[unlikely]] {
+            std::atomic_ref(heap()->refs).fetch_add(1, std::memory_order_relaxed);
+        } else {
+            heap()->refs++;
+        }
+    }
+    void release() {
+        if (!isHeap()) {
+            return;
+        }
+        if (THREADS_ACTIVE.load(std::memory_order_acquire)) [[unlikely]] {
+            if (std::atomic_ref(heap()->refs).fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete heap();
+            }
+        } else if (--heap()->refs == 0) {
+            delete heap();
+        }
+    }
+    void checkType(ValueType type) const {
+        if (getType() != type) {
+            throwError(ErrorType::Runtime, "Incorrect type access in value");
+        }
+    }
+
+    uint64_t bits = 0;
+};
+
+static_assert(sizeof(Value) == 8, "Value must stay a single word");
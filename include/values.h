@@ -8,14 +8,13 @@
 #include <functional>
 #include <optional>
 #include <map>
+#include <cstdint>
+#include <type_traits>
+#include <iterator>
+#include "valueDefs.h"
 #include "environment.h"
 #include "errorDefs.h"
 
-enum class SpecialIndex {
-    Front,
-    Back
-};
-
 class FuncNode;
 class Value;
 class ASTNode;
@@ -24,124 +23,191 @@ class Scope;
 class Class;
 class Instance;
 
-struct ValueCompare {
-    bool operator()(const std::shared_ptr<Value>& lhs, const std::shared_ptr<Value>& rhs) const;
+// Dictionary key semantics. Keys of different types are never equal, lists and dictionaries compare
+// by contents and functions, classes, instances, futures and channels by identity.
+struct ValueHash {
+    size_t operator()(const Value& value) const;
+};
+
+struct ValueEqual {
+    bool operator()(const Value& lhs, const Value& rhs) const;
 };
 
-using Dictionary = std::map<std::shared_ptr<Value>, std::shared_ptr<Value>, ValueCompare>;
-using BuiltInFunction = std::function<std::optional<std::shared_ptr<Value>>(
-    const std::vector<std::shared_ptr<Value>>& args, Environment& env
-)>;
-using ValueList = std::vector<std::shared_ptr<Value>>;
+using ValueList = std::vector<Value>;
 
-class List {
+class List : public GCObject {
 private:
-    std::vector<std::shared_ptr<Value>> elements;
+    std::vector<Value> elements;
 
 public:
-    List() {}
-    List(std::vector<std::shared_ptr<Value>> elements);
+    List() : GCObject{GCKind::List} {}
+    List(std::vector<Value> elements);
+
+    void trace(GCVisitor& visitor) const override;
+    void clearReferences() override;
+    size_t memoryUsage() const override;
 
-    void push_back(std::shared_ptr<Value> value);
-    std::shared_ptr<Value> pop(int index);
-    void insert(size_t index, std::shared_ptr<Value> value);
+    void push_back(Value value);
+    Value pop(int index);
+    void insert(size_t index, Value value);
     void insert(const std::shared_ptr<List>& other); // Overload for inserting a List directly
-    void set(size_t index, std::shared_ptr<Value> value);
-    void erase(const std::shared_ptr<Value> value);
-    int index(const std::shared_ptr<Value> value, int start, int end) const;
-    std::shared_ptr<Value> at(size_t index) const;
-    std::vector<std::shared_ptr<Value>> getElements();
+    void set(size_t index, Value value);
+    void erase(const Value value);
+    int index(const Value value, int start, int end) const;
+    Value at(size_t index) const;
+    std::vector<Value> getElements();
     size_t size() const;
     bool empty() const;
     void clear();
 
 };
 
+/*
+Insertion ordered hash map. Entries are kept densely in the order they were added and an open
+addressing table of entry indices is probed by hash. Erasing an entry leaves a hole that is dropped
+the next time the table grows.
+*/
+class Dictionary : public GCObject {
+public:
+    using value_type = std::pair<Value, Value>;
+
+    template <bool Const>
+    class Iterator {
+    public:
+        using Owner = std::conditional_t<Const, const Dictionary, Dictionary>;
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Dictionary::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+
+        Iterator() = default;
+        Iterator(Owner* dict, size_t position) : dict{dict}, position{position} {
+            skipHoles();
+        }
+        operator Iterator<true>() const {
+            return Iterator<true>{dict, position};
+        }
+
+        reference operator*() const {
+            return dict->entries[position];
+        }
+        pointer operator->() const {
+            return &dict->entries[position];
+        }
+        Iterator& operator++() {
+            position++;
+            skipHoles();
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+        // Any two iterators past the last entry are equal, so entries added during a loop are still visited
+        bool operator==(const Iterator& other) const {
+            return position == other.position || (atEnd() && other.atEnd());
+        }
+        size_t getPosition() const {
+            return position;
+        }
+
+    private:
+        bool atEnd() const {
+            return !dict || position >= dict->entries.size();
+        }
+        void skipHoles() {
+            while (!atEnd() && !dict->entries[position].first) {
+                position++;
+            }
+        }
+
+        Owner* dict = nullptr;
+        size_t position = 0;
+    };
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    Dictionary() : GCObject{GCKind::Dictionary} {}
+
+    void trace(GCVisitor& visitor) const override;
+    void clearReferences() override;
+    size_t memoryUsage() const override;
+
+    iterator begin() { return iterator{this, 0}; }
+    iterator end() { return iterator{this, entries.size()}; }
+    const_iterator begin() const { return const_iterator{this, 0}; }
+    const_iterator end() const { return const_iterator{this, entries.size()}; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear();
+
+    iterator find(const Value& key);
+    const_iterator find(const Value& key) const;
+    bool contains(const Value& key) const;
+    // Adds the pair unless the key is already present, like std::map::insert
+    std::pair<iterator, bool> insert(const value_type& pair);
+    Value& operator[](const Value& key);
+    iterator erase(const_iterator position);
+    size_t erase(const Value& key);
+
+private:
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+    size_t findIndex(const Value& key, size_t hash) const;
+    size_t insertIndex(const Value& key, bool& inserted);
+    void rehash();
+
+    std::vector<value_type> entries; // In insertion order, a hole has an empty key
+    std::vector<size_t> hashes; // Parallel to entries
+    std::vector<uint32_t> slots; // Power of two sized, indices into entries
+    size_t count = 0;
+};
+
 /*
 Add instance comparison
 */
 
-class Class {
+class Class : public GCObject {
 private:
     std::string name;
     Environment class_env;
 
 public:
     Class(std::string name, Environment& class_env);
+
+    void trace(GCVisitor& visitor) const override;
+    void clearReferences() override;
+    size_t memoryUsage() const override;
     
     std::shared_ptr<Instance> createInstance();
     std::string getName() const;
 };
 
-class Instance {
+class Instance : public GCObject {
 private:
     std::string class_name;
     Environment instance_env;
 
 public:
     Instance(std::string class_name, Environment instance_env)
-        : class_name{class_name}, instance_env{instance_env} {}
+        : GCObject{GCKind::Instance}, class_name{class_name}, instance_env{instance_env} {}
+
+    void trace(GCVisitor& visitor) const override;
+    void clearReferences() override;
+    size_t memoryUsage() const override;
     
-    std::shared_ptr<Value> getConstructor(std::shared_ptr<Instance> this_reference);
+    Value getConstructor(std::shared_ptr<Instance> this_reference);
     Environment& getEnvironment();
     Environment copyEnvironment();
     std::string getClassName() const;
 };
 
-enum class ValueType {
-    Integer,
-    Boolean,
-    String,
-    Float,
-    List,
-    Dictionary,
-    None,
-    Function,
-    Index,
-    BuiltInFunction,
-    Class,
-    Instance,
-    Type
-};
-
-class Value {
-private:
-    std::variant<std::monostate, int, double, bool, std::string, std::shared_ptr<List>,
-                SpecialIndex, std::shared_ptr<ASTNode>, std::shared_ptr<BuiltInFunction>, ValueType,
-                std::shared_ptr<Dictionary>, std::shared_ptr<Class>, std::shared_ptr<Instance>> value;
-    ValueType value_type;
-
-public:
-    Value();
-    Value(int v);
-    Value(double v);
-    Value(bool v);
-    Value(const std::string& v);
-    Value(std::shared_ptr<List> v);
-    Value(SpecialIndex v);
-    Value(std::shared_ptr<ASTNode> v);
-    Value(std::shared_ptr<BuiltInFunction> v);
-    Value(ValueType v);
-    Value(std::shared_ptr<Dictionary> v);
-    Value(std::shared_ptr<Class> v);
-    Value(std::shared_ptr<Instance> v);
-
-    ValueType getType() const;
-
-    // Templated getter function
-    template <typename T>
-    const T& get() const {
-        if (!std::holds_alternative<T>(value)) {
-            throwError(ErrorType::Runtime, "Incorrect type access in value");
-        }
-        return std::get<T>(value);
-    }
-
-    std::string getPrintable(int tabs=0, bool error=false);
-
-};
-
-
-std::string getValueStr(std::shared_ptr<Value> value);
 std::string getValueStr(Value value);
-std::string getTypeStr(ValueType type);
\ No newline at end of file
+std::string getTypeStr(ValueType type);
+std::string getRangeStr(const Range& range);
+// Whether two ranges produce the same integers
+bool sameRange(const Range& lhs, const Range& rhs);
\ No newline at end of file
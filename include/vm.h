@@ -0,0 +1,6 @@
+#pragma once
+#include <optional>
+#include <memory>
+#include "compiler.h"
+
+std::optional<Value> executeChunk(const Chunk& chunk, Environment& env);
@@ -0,0 +1,52 @@
+#include "arena.h"
+#include "nodes.h"
+
+ASTArena::~ASTArena() {
+    release(Mark{1, 0, BLOCK_SIZE});
+    for (Segment* segment : segments) {
+        delete segment;
+    }
+}
+
+NodeIndex ASTArena::addPosition(int line, int column) {
+    NodeIndex index = next_index++;
+    if ((index >> SEGMENT_BITS) >= segments.size()) {
+        segments.push_back(nullptr);
+    }
+    Segment*& segment = segments[index >> SEGMENT_BITS];
+    if (!segment) {
+        segment = new Segment{};
+    }
+    segment->nodes[index & SEGMENT_MASK] = nullptr;
+    segment->positions[index & SEGMENT_MASK] = SourcePosition{line, column};
+    return index;
+}
+
+void* ASTArena::allocate(size_t size, size_t align) {
+    block_used = (block_used + align - 1) & ~(align - 1);
+    if (block_used + size > BLOCK_SIZE) {
+        blocks.push_back(static_cast<char*>(::operator new(BLOCK_SIZE)));
+        block_used = 0;
+    }
+    void* memory = blocks.back() + block_used;
+    block_used += size;
+    return memory;
+}
+
+ASTArena::Mark ASTArena::mark() const {
+    return Mark{next_index, blocks.size(), block_used};
+}
+
+void ASTArena::release(const Mark& mark) {
+    for (NodeIndex index = next_index; index-- > mark.next_index;) {
+        if (ASTNode* node = this->node(index)) {
+            node->~ASTNode();
+        }
+    }
+    next_index = mark.next_index;
+    while (blocks.size() > mark.block_count) {
+        ::operator delete(blocks.back());
+        blocks.pop_back();
+    }
+    block_used = mark.block_used;
+}
@@ -0,0 +1,455 @@
+#include "compiler.h"
+#include "values.h"
+#include "stats.h"
+
+namespace {
+
+class Compiler {
+public:
+    explicit Compiler(Chunk& chunk)
+        : chunk{chunk} {}
+
+    void compileBlock(const ASTList& statements);
+
+private:
+    struct LoopContext {
+        int info;
+        std::vector<int> breaks;
+        std::vector<int> continues;
+    };
+
+    Chunk& chunk;
+    std::vector<int> scopes;
+    std::vector<LoopContext> loops;
+
+    int emit(OpCode op, ASTNode* node = nullptr, int operand = 0, uint16_t depth = 0);
+    void emitLoad(IdentifierNode* ident);
+    void emitStore(BinaryOpNode* assignment, IdentifierNode* ident);
+    int here() const;
+    void patch(int instruction);
+    void pushScope(const SlotRange& slots);
+    void popScope();
+    void beginLoop();
+    void endLoop(int continue_target, int break_target);
+
+    void compileStatement(const NodeRef<>& statement);
+    void compileExpression(const NodeRef<>& expression);
+    void compileFallback(ASTNode* node, bool statement);
+    void compileIfChain(const ASTList& statements, size_t begin, size_t end);
+    void compileWhile(ScopedNode* node);
+    void compileFor(ForNode* node);
+    void compileJump(KeywordNode* node);
+    void compileIndexTarget(IndexNode* index);
+    bool compileAssignment(BinaryOpNode* node);
+    bool compileCall(MethodCallNode* node, bool member);
+};
+
+int Compiler::emit(OpCode op, ASTNode* node, int operand, uint16_t depth) {
+    chunk.code.push_back(Instruction{op, depth, operand, node});
+    return static_cast<int>(chunk.code.size()) - 1;
+}
+
+void Compiler::emitLoad(IdentifierNode* ident) {
+    if (ident->member_variable || ident->depth > UINT16_MAX) {
+        emit(OpCode::LoadName, ident);
+    } else if (ident->depth < 0) {
+        emit(OpCode::LoadGlobal, ident, ident->symbol);
+    } else {
+        emit(OpCode::LoadLocal, ident, ident->slot, static_cast<uint16_t>(ident->depth));
+    }
+}
+
+void Compiler::emitStore(BinaryOpNode* assignment, IdentifierNode* ident) {
+    if (ident->member_variable || ident->depth > UINT16_MAX) {
+        emit(OpCode::StoreName, assignment);
+    } else if (ident->depth < 0) {
+        emit(OpCode::StoreGlobal, assignment, ident->symbol);
+    } else {
+        emit(OpCode::StoreLocal, assignment, ident->slot, static_cast<uint16_t>(ident->depth));
+    }
+}
+
+int Compiler::here() const {
+    return static_cast<int>(chunk.code.size());
+}
+
+void Compiler::patch(int instruction) {
+    chunk.code[instruction].operand = here();
+}
+
+void Compiler::pushScope(const SlotRange& slots) {
+    chunk.scopes.push_back(slots);
+    scopes.push_back(static_cast<int>(chunk.scopes.size()) - 1);
+    emit(OpCode::PushScope, nullptr, scopes.back());
+}
+
+void Compiler::popScope() {
+    emit(OpCode::PopScope, nullptr, scopes.back());
+    scopes.pop_back();
+}
+
+void Compiler::beginLoop() {
+    chunk.loops.push_back(LoopInfo{0, 0});
+    loops.push_back(LoopContext{static_cast<int>(chunk.loops.size()) - 1, {}, {}});
+}
+
+void Compiler::endLoop(int continue_target, int break_target) {
+    LoopContext& loop = loops.back();
+    for (int jump : loop.breaks) {
+        chunk.code[jump].operand = break_target;
+    }
+    for (int jump : loop.continues) {
+        chunk.code[jump].operand = continue_target;
+    }
+    chunk.loops[loop.info].break_target = break_target;
+    chunk.loops[loop.info].continue_target = continue_target;
+    loops.pop_back();
+}
+
+void Compiler::compileBlock(const ASTList& statements) {
+    // An elif/else separated from its 'if' relies on the environment's if chain flag, which the tree
+    // walker keeps per block. The whole block is walked so nested blocks can't change it in between.
+    bool detached_links = false;
+    for (size_t i = 0; i < statements.size(); i++) {
+        auto scoped = dynamic_cast<ScopedNode*>(statements[i].get());
+        if (scoped && scoped->if_link && (i == 0 || statements[i - 1].get() != scoped->if_link.get())) {
+            detached_links = true;
+        }
+    }
+
+    for (size_t i = 0; i < statements.size(); i++) {
+        if (detached_links) {
+            compileFallback(statements[i].get(), true);
+            continue;
+        }
+        auto scoped = dynamic_cast<ScopedNode*>(statements[i].get());
+        if (scoped && (scoped->keyword == TokenType::_If || scoped->if_link)) {
+            size_t end = i + 1;
+            while (end < statements.size()) {
+                auto next = dynamic_cast<ScopedNode*>(statements[end].get());
+                if (!next || next->if_link.get() != statements[end - 1].get()) {
+                    break;
+                }
+                end++;
+            }
+            compileIfChain(statements, i, end);
+            i = end - 1;
+            continue;
+        }
+        compileStatement(statements[i]);
+    }
+}
+
+void Compiler::compileStatement(const NodeRef<>& statement) {
+    ASTNode* node = statement.get();
+    if (auto scoped = dynamic_cast<ScopedNode*>(node)) {
+        if (scoped->keyword == TokenType::_While && scoped->comparison) {
+            compileWhile(scoped);
+        } else {
+            compileFallback(node, true);
+        }
+    } else if (auto for_node = dynamic_cast<ForNode*>(node)) {
+        compileFor(for_node);
+    } else if (auto keyword = dynamic_cast<KeywordNode*>(node)) {
+        if (keyword->keyword == TokenType::_Break || keyword->keyword == TokenType::_Continue) {
+            compileJump(keyword);
+        } else if (keyword->keyword == TokenType::_Return) {
+            if (keyword->right) {
+                compileExpression(keyword->right);
+                emit(OpCode::Return, keyword, 1);
+            } else {
+                emit(OpCode::Return, keyword, 0);
+            }
+        } else {
+            compileFallback(node, true);
+        }
+    } else {
+        auto binary = dynamic_cast<BinaryOpNode*>(node);
+        if (!binary || !compileAssignment(binary)) {
+            compileExpression(statement);
+            emit(OpCode::Pop);
+        }
+    }
+}
+
+void Compiler::compileFallback(ASTNode* node, bool statement) {
+    int loop = (statement && !loops.empty()) ? loops.back().info : -1;
+    emit(OpCode::Evaluate, node, loop);
+    if (statement) {
+        emit(OpCode::Pop);
+    }
+}
+
+void Compiler::compileIfChain(const ASTList& statements, size_t begin, size_t end) {
+    std::vector<int> exits;
+    for (size_t i = begin; i < end; i++) {
+        auto member = static_cast<ScopedNode*>(statements[i].get());
+        int skip = -1;
+        if (member->comparison) {
+            compileExpression(member->comparison);
+            skip = emit(OpCode::JumpIfFalse, member);
+        }
+        pushScope(member->slots);
+        compileBlock(member->statements_block);
+        popScope();
+        if (i + 1 < end) {
+            exits.push_back(emit(OpCode::Jump));
+        }
+        if (skip >= 0) {
+            patch(skip);
+        }
+    }
+    for (int exit : exits) {
+        patch(exit);
+    }
+}
+
+void Compiler::compileWhile(ScopedNode* node) {
+    // The condition is checked once before the loop scope is entered, matching ScopedNode::evaluate
+    compileExpression(node->comparison);
+    int skip = emit(OpCode::JumpIfFalse, node);
+    pushScope(node->slots);
+    emit(OpCode::EnterLoop);
+
+    int top = here();
+    compileExpression(node->comparison);
+    int exit = emit(OpCode::JumpIfFalse, node);
+    beginLoop();
+    compileBlock(node->statements_block);
+    emit(OpCode::Jump, node, top);
+
+    patch(exit);
+    endLoop(top, here());
+    emit(OpCode::ExitLoop);
+    popScope();
+    patch(skip);
+}
+
+void Compiler::compileFor(ForNode* node) {
+    pushScope(node->slots);
+    emit(OpCode::EnterLoop);
+
+    auto init_node = dynamic_cast<BinaryOpNode*>(node->initialization.get());
+    if (!init_node || init_node->op != TokenType::_In) {
+        compileStatement(node->initialization);
+        int top = here();
+        compileExpression(node->condition_value);
+        int exit = emit(OpCode::ForCondition, node);
+        beginLoop();
+        compileBlock(node->block);
+        int increment = here();
+        compileStatement(node->increment);
+        emit(OpCode::Jump, node, top);
+
+        patch(exit);
+        endLoop(increment, here());
+    } else {
+        compileExpression(init_node->right);
+        emit(OpCode::IterStart, node);
+        int top = here();
+        int exit = emit(OpCode::IterNext, node);
+        beginLoop();
+        compileBlock(node->block);
+        emit(OpCode::Jump, node, top);
+
+        patch(exit);
+        endLoop(top, here());
+        emit(OpCode::IterEnd);
+    }
+
+    popScope();
+    emit(OpCode::ExitLoop);
+}
+
+void Compiler::compileJump(KeywordNode* node) {
+    if (loops.empty()) {
+        // Let the tree walker decide whether this is an error or escapes to an enclosing call's loop
+        compileFallback(node, true);
+        return;
+    }
+    // Blocks left early keep their slots until they are next entered, the loop's own exit clears them
+    LoopContext& loop = loops.back();
+    int jump = emit(OpCode::Jump);
+    if (node->keyword == TokenType::_Break) {
+        loop.breaks.push_back(jump);
+    } else {
+        loop.continues.push_back(jump);
+    }
+}
+
+void Compiler::compileIndexTarget(IndexNode* index) {
+    compileExpression(index->container);
+    compileExpression(index->start_index);
+    if (index->end_index) {
+        compileExpression(index->end_index);
+    }
+}
+
+bool Compiler::compileAssignment(BinaryOpNode* node) {
+    bool compound = node->op == TokenType::_PlusEquals || node->op == TokenType::_MinusEquals ||
+                    node->op == TokenType::_MultiplyEquals || node->op == TokenType::_DivideEquals;
+    if (auto index = dynamic_cast<IndexNode*>(node->left.get()); index && index->container) {
+        if (node->op != TokenType::_Equals && !compound) {
+            return false;
+        }
+        // Like the tree walker, a compound assignment evaluates the container and indexes again to store
+        if (compound) {
+            compileIndexTarget(index);
+            emit(OpCode::Index, index);
+            compileExpression(node->right);
+            emit(OpCode::BinaryOp, node);
+        } else {
+            compileExpression(node->right);
+        }
+        compileIndexTarget(index);
+        emit(OpCode::StoreIndex, node);
+        return true;
+    }
+    auto ident = dynamic_cast<IdentifierNode*>(node->left.get());
+    if (!ident) {
+        return false;
+    }
+    if (node->op == TokenType::_Equals) {
+        compileExpression(node->right);
+        emitStore(node, ident);
+        return true;
+    }
+    if (compound) {
+        emitLoad(ident);
+        compileExpression(node->right);
+        emit(OpCode::BinaryOp, node);
+        emitStore(node, ident);
+        return true;
+    }
+    return false;
+}
+
+bool Compiler::compileCall(MethodCallNode* node, bool member) {
+    if (node->hasLabeledArgs()) {
+        return false;
+    }
+    if (!member) {
+        compileExpression(node->stored_func);
+    }
+    for (const auto& arg : node->values) {
+        compileExpression(arg);
+    }
+    emit(member ? OpCode::CallMember : OpCode::Call, node, static_cast<int>(node->values.size()));
+    return true;
+}
+
+void Compiler::compileExpression(const NodeRef<>& expression) {
+    ASTNode* node = expression.get();
+    if (auto atom = dynamic_cast<AtomNode*>(node)) {
+        Value constant;
+        if (atom->isInt()) {
+            constant = Value(atom->getInt());
+        } else if (atom->isFloat()) {
+            constant = Value(atom->getFloat());
+        } else if (atom->isBool()) {
+            constant = Value(atom->getBool());
+        } else if (atom->isString()) {
+            constant = Value(atom->getString());
+        } else {
+            constant = Value(atom->getIndex());
+        }
+        chunk.constants.push_back(constant);
+        emit(OpCode::LoadConst, node, static_cast<int>(chunk.constants.size()) - 1);
+    }
+    else if (auto ident = dynamic_cast<IdentifierNode*>(node)) {
+        emitLoad(ident);
+    }
+    else if (auto parenthesis = dynamic_cast<ParenthesisOpNode*>(node)) {
+        compileExpression(parenthesis->expr);
+    }
+    else if (auto unary = dynamic_cast<UnaryOpNode*>(node)) {
+        compileExpression(unary->right);
+        emit(OpCode::UnaryOp, node);
+    }
+    else if (auto binary = dynamic_cast<BinaryOpNode*>(node)) {
+        switch (binary->op) {
+            case TokenType::_And:
+            case TokenType::_Or: {
+                compileExpression(binary->left);
+                int jump = emit(binary->op == TokenType::_And ? OpCode::And : OpCode::Or, node);
+                compileExpression(binary->right);
+                emit(OpCode::ToBool, node);
+                patch(jump);
+                break;
+            }
+            case TokenType::_In: {
+                compileExpression(binary->left);
+                compileExpression(binary->right);
+                emit(OpCode::In, node);
+                break;
+            }
+            case TokenType::_Dot: {
+                auto method = dynamic_cast<MethodCallNode*>(binary->right.get());
+                if (method && !method->hasLabeledArgs()) {
+                    compileExpression(binary->left);
+                    compileCall(method, true);
+                } else if (dynamic_cast<IdentifierNode*>(binary->right.get())) {
+                    compileExpression(binary->left);
+                    emit(OpCode::GetMember, node);
+                } else {
+                    compileFallback(node, false);
+                }
+                break;
+            }
+            case TokenType::_Equals:
+            case TokenType::_PlusEquals:
+            case TokenType::_MinusEquals:
+            case TokenType::_MultiplyEquals:
+            case TokenType::_DivideEquals: {
+                compileFallback(node, false);
+                break;
+            }
+            default: {
+                compileExpression(binary->left);
+                compileExpression(binary->right);
+                emit(OpCode::BinaryOp, node);
+                break;
+            }
+        }
+    }
+    else if (auto call = dynamic_cast<MethodCallNode*>(node)) {
+        if (!compileCall(call, false)) {
+            compileFallback(node, false);
+        }
+    }
+    else if (auto list = dynamic_cast<ListNode*>(node)) {
+        for (const auto& element : list->list) {
+            compileExpression(element);
+        }
+        emit(OpCode::BuildList, node, static_cast<int>(list->list.size()));
+    }
+    else if (auto dict = dynamic_cast<DictionaryNode*>(node)) {
+        for (const auto& pair : dict->dictionary) {
+            compileExpression(pair.first);
+            compileExpression(pair.second);
+        }
+        emit(OpCode::BuildDictionary, node, static_cast<int>(dict->dictionary.size()));
+    }
+    else if (auto index = dynamic_cast<IndexNode*>(node); index && index->container) {
+        compileExpression(index->container);
+        compileExpression(index->start_index);
+        if (index->end_index) {
+            compileExpression(index->end_index);
+        }
+        emit(OpCode::Index, node);
+    }
+    else {
+        compileFallback(node, false);
+    }
+}
+
+}
+
+Chunk compileBlock(const std::vector<NodeRef<>>& statements, bool function_body) {
+    PhaseTimer timer{Phase::Compile};
+    Chunk chunk;
+    chunk.function_body = function_body;
+    Compiler compiler{chunk};
+    compiler.compileBlock(statements);
+    return chunk;
+}
@@ -1,10 +1,11 @@
 #include "context.h"
+#include <filesystem>
 #include "values.h"
 
 // Thread-local storage for execution context
 thread_local std::stack<std::string> parsing_context;
 thread_local std::stack<std::string> execution_context;
-thread_local std::stack<std::pair<std::string, std::string>> function_context;
+thread_local std::vector<std::pair<std::string, std::string>> function_context;
 
 thread_local int debug_tabs = 0;
 
@@ -17,7 +18,7 @@ void pushExecutionContext(std::string filename) {
 }
 
 void pushFunctionContext(std::string func_name, std::string filename) {
-    function_context.push(std::make_pair(func_name, filename));
+    function_context.push_back(std::make_pair(func_name, filename));
     pushExecutionContext(filename);
 }
 
@@ -35,7 +36,7 @@ void popExecutionContext() {
 
 void popFunctionContext() {
     if (!function_context.empty()) {
-        function_context.pop();
+        function_context.pop_back();
     }
     popExecutionContext();
 }
@@ -49,5 +50,29 @@ std::string currentExecutionContext() {
 }
 
 std::pair<std::string, std::string> currentFunctionContext() {
-    return function_context.empty() ? std::make_pair("", "") : function_context.top();
-}
\ No newline at end of file
+    return function_context.empty() ? std::make_pair("", "") : function_context.back();
+}
+
+ExecutionContextSnapshot captureExecutionContext() {
+    return ExecutionContextSnapshot{currentExecutionContext(), function_context};
+}
+
+ExecutionContextScope::ExecutionContextScope(const ExecutionContextSnapshot& snapshot)
+    : saved_functions{std::move(function_context)} {
+    function_context = snapshot.functions;
+    pushExecutionContext(snapshot.execution_file);
+}
+
+ExecutionContextScope::~ExecutionContextScope() {
+    popExecutionContext();
+    function_context = std::move(saved_functions);
+}
+
+std::string resolveModulePath(const std::string& filename) {
+    std::error_code error;
+    auto path = std::filesystem::weakly_canonical(filename, error);
+    if (error) {
+        return std::filesystem::path(filename).lexically_normal().string();
+    }
+    return path.string();
+}
@@ -4,43 +4,63 @@
 #include <iostream>
 #include "errorDefs.h"
 #include "values.h"
+#include "nodes.h"
+#include "context.h"
+#include "stats.h"
+#include "threadPool.h"
 
-bool DETECT_RECURSION;
+Scope::Scope()
+    : GCObject{GCKind::Environment} {}
 
-Scope::Scope() {}
+void Scope::trace(GCVisitor& visitor) const {
+    for (const auto& pair : variables) {
+        visitor.visit(pair.second);
+    }
+}
+
+void Scope::clearReferences() {
+    variables.clear();
+}
+
+size_t Scope::memoryUsage() const {
+    // Each entry is a separately allocated node holding the pair and a link
+    return sizeof(Scope) + variables.bucket_count() * sizeof(void*)
+           + variables.size() * (sizeof(std::pair<const std::string, Value>) + sizeof(void*));
+}
 
-void Scope::set(std::string name, std::shared_ptr<Value> value) {
+void Scope::set(const std::string& name, Value value) {
     variables[name] = value;
 }
 
-bool Scope::contains(std::string name) const {
+bool Scope::contains(const std::string& name) const {
     return static_cast<bool>(variables.count(name));
 }
 
-void Scope::remove(std::string name) {
+void Scope::remove(const std::string& name) {
     variables.erase(name);
 }
 
-const std::vector<std::pair<std::string, std::shared_ptr<Value>>> Scope::getPairs() const {
-    std::vector<std::pair<std::string, std::shared_ptr<Value>>> pairs;
+const std::vector<std::pair<std::string, Value>> Scope::getPairs() const {
+    std::vector<std::pair<std::string, Value>> pairs;
     for (const auto& pair : variables) {
         pairs.push_back(pair);
     }
     return pairs;
 }
 
-std::shared_ptr<Value> Scope::get(std::string name) const {
-    if (contains(name)) {
-        return variables.at(name);
+Value Scope::get(const std::string& name) const {
+    auto found = variables.find(name);
+    if (found != variables.end()) {
+        return found->second;
     } else {
         throwError(ErrorType::Runtime, std::format("Bad environment access with key '{}'", name));
     }
 }
 
 void Scope::display() const {
-    for (const std::pair<const std::string, std::shared_ptr<Value>> pair : variables) {
+    for (const std::pair<const std::string, Value> pair : variables) {
         const std::string& name = pair.first;
-        std::shared_ptr<Value> value = pair.second;
+        Value value = pair.second;
 
         std::cout << name << " = ";
         printValue(value);
@@ -49,15 +69,39 @@ void Scope::display() const {
 }
 
 
-Environment::Environment() {
+void Frame::trace(GCVisitor& visitor) const {
+    for (const auto& slot : slots) {
+        visitor.visit(slot);
+    }
+    visitor.visit(closure.get());
+}
+
+void Frame::clearReferences() {
+    slots.clear();
+    closure = nullptr;
+}
+
+size_t Frame::memoryUsage() const {
+    return sizeof(Frame) + slots.capacity() * sizeof(Value);
+}
+
+
+Environment::Environment(const InterpreterOptions& options)
+    : globals(std::make_shared<Globals>()), class_attrs(std::make_shared<Scope>()) {
+    globals->options = options;
     class_env = false;
 }
 
 Environment::Environment(const Environment& other)
-    : scopes(other.scopes), class_env(other.class_env),
-      loop_depth(other.loop_depth), built_in_functions(other.built_in_functions),
-      member_functions(other.member_functions), scoped_globals(other.scoped_globals),
-      class_depth(other.class_depth), class_attrs(other.class_attrs), is_top_scope(other.is_top_scope) {}
+    : is_top_scope(other.is_top_scope), if_chain_taken(other.if_chain_taken), globals(other.globals),
+      frame(other.frame), class_attrs(other.class_attrs), this_ref(other.this_ref), class_env(other.class_env),
+      class_depth(other.class_depth), loop_depth(other.loop_depth) {
+    COUNT_STAT(environment_copies);
+}
+
+Environment::Environment(const Environment& caller, std::shared_ptr<Frame> closure)
+    : globals(caller.globals), frame(std::move(closure)), class_attrs(caller.class_attrs),
+      this_ref(caller.this_ref), class_env(caller.class_env), class_depth(caller.class_depth) {}
 
 void Environment::setClassEnv() {
     class_env = true;
@@ -67,79 +111,134 @@ bool Environment::isClassEnv() const {
     return class_env;
 }
 
-void Environment::set(std::string name, std::shared_ptr<Value> value, bool is_member_var) {
-    if (scopes.empty()) {
-        throwError(ErrorType::Runtime, "Attempted to access empty environment");
-    } else {
-        if (is_member_var && class_depth == 0 && class_env == false) {
-            throwError(ErrorType::Runtime, "Unable to set class attribute '" + name + "' outside of class");
-        } else if (is_member_var) {
-            class_attrs.set(name, value);
-            return;
-        }
-        if (isGlobal(name)) {
-            setGlobalValue(name, value);
-            return;
-        }
-        for (int i = scopes.size() - 1; i > -1; i--) {
-            if (scopes.at(i).contains(name)) {
-                scopes.at(i).set(name, value);
-                return;
-            }
-        }
-
-        scopes.back().set(name, value);
+void Environment::set(const std::string& name, Value value, bool is_member_var) {
+    if (is_member_var && class_depth == 0 && class_env == false) {
+        throwError(ErrorType::Runtime, "Unable to set class attribute '" + name + "' outside of class");
+    } else if (is_member_var) {
+        class_attrs->set(name, value);
+        return;
     }
+    setGlobal(internSymbol(name), value);
 }
 
-std::shared_ptr<Value> Environment::get(std::string name, bool is_member_var) const {
-    if (scopes.empty()) {
-        throwError(ErrorType::Runtime, "Attempted to access empty environment");
-    }
+Value Environment::get(const std::string& name, bool is_member_var) const {
     if (is_member_var && class_depth == 0 && class_env == false) {
         throwError(ErrorType::Runtime, "Unable to get class attribute '" + name + "' outside of class");
     } else if (is_member_var) {
-        return class_attrs.get(name);
+        return class_attrs->get(name);
     }
-    if (isGlobal(name)) {
-        if (scopes.front().contains(name)) {
-            return scopes.front().get(name);
-        } else {
-            throwError(ErrorType::Runtime, "Unrecognized variable " + name);
-        }
+    auto value = getGlobal(internSymbol(name));
+    if (!value) {
+        throwError(ErrorType::Runtime, "Unrecognized variable " + name);
+    }
+    return value;
+}
+
+bool Environment::contains(const std::string& name, bool is_member_var) const {
+    if (is_member_var) {
+        return (class_env == true || class_depth != 0) && class_attrs->contains(name);
+    }
+    return hasGlobal(internSymbol(name));
+}
+
+Value Environment::getLocal(int depth, int slot) const {
+    Frame* current = frame.get();
+    for (; depth > 0; depth--) {
+        current = current->closure.get();
     }
-    
-    for (int i = scopes.size() - 1; i >= 0; i--) {
-        const auto& scope = scopes.at(i);
-        if (scope.contains(name)) {
-            return scope.get(name);
+    return current->slots[slot];
+}
+
+Value Environment::getEnclosing(int depth, Symbol symbol) const {
+    Frame* current = frame.get();
+    for (; depth >= 0 && current; depth--) {
+        current = current->closure.get();
+    }
+    for (; current; current = current->closure.get()) {
+        for (size_t slot = 0; slot < current->slots.size(); slot++) {
+            if (current->slots[slot] && (*current->layout)[slot] == symbol) {
+                return current->slots[slot];
+            }
         }
     }
+    return nullptr;
+}
 
-    throwError(ErrorType::Runtime, "Unrecognized variable " + name);
+void Environment::setLocal(int depth, int slot, Value value) {
+    Frame* current = frame.get();
+    for (; depth > 0; depth--) {
+        current = current->closure.get();
+    }
+    current->slots[slot] = std::move(value);
 }
 
+Value Environment::getGlobal(Symbol symbol) const {
+    if (symbol < globals->values.size()) {
+        return globals->values[symbol];
+    }
+    return nullptr;
+}
 
-bool Environment::contains(std::string name, bool is_member_var) const {
-    if (scopes.empty()) {
-        throwError(ErrorType::Runtime, "Attempted to access emtpy environment");
+void Environment::setGlobal(Symbol symbol, Value value) {
+    if (inParallelTask()) [[unlikely]] {
+        // Every thread reads the same globals, so they stay fixed until the parallel work is done
+        throwError(ErrorType::Runtime, "Global variable '" + symbolName(symbol) + "' cannot be assigned inside a parallel task");
+    }
+    if (symbol >= globals->values.size()) {
+        globals->values.resize(symbol + 1);
     }
-    if (class_env == true || class_depth != 0) {
-        if (is_member_var) {
-            return class_attrs.contains(name);
+    globals->values[symbol] = std::move(value);
+}
+
+bool Environment::hasGlobal(Symbol symbol) const {
+    return symbol < globals->values.size() && globals->values[symbol] != nullptr;
+}
+
+std::vector<std::pair<std::string, Value>> Environment::getGlobalPairs() const {
+    std::vector<std::pair<std::string, Value>> pairs;
+    const auto& values = globals->values;
+    for (Symbol symbol = 0; symbol < values.size(); symbol++) {
+        if (values[symbol]) {
+            pairs.emplace_back(symbolName(symbol), values[symbol]);
         }
     }
-    for (const auto scope : scopes) {
-        if (scope.contains(name)) {
-            return true;
+    return pairs;
+}
+
+std::vector<std::pair<std::string, Value>> Environment::getLocalPairs() const {
+    std::vector<std::pair<std::string, Value>> pairs;
+    if (!frame || !frame->layout) {
+        return pairs;
+    }
+    for (size_t slot = 0; slot < frame->slots.size(); slot++) {
+        if (frame->slots[slot]) {
+            pairs.emplace_back(symbolName(frame->layout->at(slot)), frame->slots[slot]);
         }
     }
+    return pairs;
+}
 
-    return false;
+void Environment::pushFrame(const std::vector<Symbol>& layout) {
+    auto next = std::make_shared<Frame>();
+    next->slots.resize(layout.size());
+    next->layout = &layout;
+    next->closure = std::move(frame);
+    frame = std::move(next);
+}
+
+void Environment::popFrame() {
+    frame = frame->closure;
 }
 
-int Environment::scopeDepth() const {
-    return scopes.size();
+std::shared_ptr<Frame> Environment::getFrame() const {
+    return frame;
+}
+
+void Environment::clearSlots(const SlotRange& range) {
+    auto& slots = frame->slots;
+    for (int slot = range.begin; slot < range.end; slot++) {
+        slots[slot] = nullptr;
+    }
 }
 
 void Environment::addLoop() {
@@ -158,75 +257,65 @@ void Environment::resetLoop() {
     loop_depth = 0;
 }
 
-void Environment::addScope() {
-    scopes.push_back(Scope());
-    resetGlobals();
-}
-
-void Environment::addScope(Scope& scope) {
-    scopes.push_back(scope);
-    resetGlobals();
-}
-
 void Environment::addClassScope() {
     class_depth += 1;
-    scopes.push_back(Scope());
-    resetGlobals();
-}
-
-Scope Environment::getScope() {
-    return scopes.back();
+    class_attrs = std::make_shared<Scope>(*class_attrs);
 }
 
 int Environment::classDepth() {
     return class_depth;
 }
 
-void Environment::removeScope() {
-    scopes.pop_back();
-    removeGlobalScope();
-}
-
-void Environment::removeClassScope(Scope& previous_attrs) {
+void Environment::removeClassScope(std::shared_ptr<Scope> previous_attrs) {
     class_depth -= 1;
-    class_attrs = previous_attrs;
-    scopes.pop_back();
-    removeGlobalScope();
-}
-
-std::vector<Scope> Environment::copyScopes() const {
-    return scopes;
+    class_attrs = std::move(previous_attrs);
 }
 
-void Environment::addFunction(const std::string& name, std::shared_ptr<Value> func) {
-    built_in_functions[name] = func;
+void Environment::addFunction(const std::string& name, Value func) {
+    Symbol symbol = internSymbol(name);
+    auto& functions = globals->built_in_functions;
+    if (symbol >= functions.size()) {
+        functions.resize(symbol + 1);
+    }
+    functions[symbol] = func;
 }
 
-std::shared_ptr<Value> Environment::getFunction(const std::string& name) const {
-    auto func = built_in_functions.find(name);
-    if (func != built_in_functions.end()) {
-        return func->second;
+Value Environment::getFunction(const std::string& name) const {
+    auto func = getFunction(internSymbol(name));
+    if (func) {
+        return func;
     }
 
     throwError(ErrorType::Runtime, "Unrecognized built-in function '" + name + "'");
 }
 
+Value Environment::getFunction(Symbol symbol) const {
+    if (symbol < globals->built_in_functions.size()) {
+        return globals->built_in_functions[symbol];
+    }
+    return nullptr;
+}
+
 bool Environment::hasFunction(const std::string& name) const {
-    auto func = built_in_functions.find(name);
-    return func != built_in_functions.end();
+    return getFunction(internSymbol(name)) != nullptr;
 }
 
-void Environment::addMember(ValueType type, const std::string& name, std::shared_ptr<Value> func) {
-    member_functions[type][name] = func;
+void Environment::addMember(ValueType type, const std::string& name, Value func) {
+    globals->member_functions[type][name] = func;
+    size_t index = internSymbol(name) * VALUE_TYPE_COUNT + static_cast<size_t>(type);
+    if (index >= globals->member_table.size()) {
+        globals->member_table.resize(index + 1);
+    }
+    globals->member_table[index] = func;
 }
 
-void Environment::addMember(const std::string& name, std::shared_ptr<Value> value) {
-    class_attrs.set(name, value);
+void Environment::addMember(const std::string& name, Value value) {
+    class_attrs->set(name, value);
 }
 
-std::shared_ptr<Value> Environment::getMember(ValueType type, const std::string& name) const {
-    auto members = member_functions.find(type);
-    if (members != member_functions.end()) {
+Value Environment::getMember(ValueType type, const std::string& name) const {
+    auto members = globals->member_functions.find(type);
+    if (members != globals->member_functions.end()) {
         auto func = members->second.find(name);
         if (func != members->second.end()) {
             return func->second;
@@ -236,13 +325,13 @@ std::shared_ptr<Value> Environment::getMember(ValueType type, const std::string&
     throwError(ErrorType::Runtime, "Unrecognized member function '" + name + "'");
 }
 
-std::shared_ptr<Value> Environment::getMember(const std::string& name) const {
-    return class_attrs.get(name);
+Value Environment::getMember(const std::string& name) const {
+    return class_attrs->get(name);
 }
 
 bool Environment::hasMember(ValueType type, const std::string& name) const {
-    auto members = member_functions.find(type);
-    if (members != member_functions.end()) {
+    auto members = globals->member_functions.find(type);
+    if (members != globals->member_functions.end()) {
         auto func = members->second.find(name);
         return func != members->second.end();
     }
@@ -250,58 +339,106 @@ bool Environment::hasMember(ValueType type, const std::string& name) const {
 }
 
 bool Environment::hasMember(const std::string& name) const {
-    return class_attrs.contains(name);
+    return class_attrs->contains(name);
 }
 
 void Environment::delMember(const std::string& name) {
-    class_attrs.remove(name);
+    class_attrs->remove(name);
 }
 
-void Environment::addGlobal(std::string name) {
-    scoped_globals[scopeDepth()].push_back(name);
+Value Environment::getBuiltinMember(ValueType type, Symbol symbol) const {
+    size_t index = symbol * VALUE_TYPE_COUNT + static_cast<size_t>(type);
+    if (index < globals->member_table.size()) {
+        return globals->member_table[index];
+    }
+    return nullptr;
 }
 
-void Environment::resetGlobals() {
-    scoped_globals[scopeDepth()].clear();
+const InterpreterOptions& Environment::options() const {
+    return globals->options;
 }
 
-void Environment::removeGlobalScope() {
-    scoped_globals.erase(scopeDepth() + 1);
+std::chrono::steady_clock::time_point Environment::getStartTime() const {
+    return globals->start_time;
 }
 
-bool Environment::isGlobal(std::string name) const {
-    for (int i = scopeDepth(); i > 0; i--) {
-        if (scoped_globals.find(i) != scoped_globals.end()) {
-            for (const auto& str : scoped_globals.at(i)) {
-                if (str == name) {
-                    return true;
-                }
-            }
-        }
+std::optional<ModuleState> Environment::beginModule(const std::string& filename) {
+    auto [module, inserted] = globals->modules.try_emplace(resolveModulePath(filename), ModuleState::Loading);
+    if (!inserted) {
+        return module->second;
     }
-    return false;
+    globals->import_chain.push_back(filename);
+    return std::nullopt;
 }
 
-void Environment::setGlobalValue(std::string name, std::shared_ptr<Value> value) {
-    scopes.at(0).set(name, value);
+void Environment::endModule(bool succeeded) {
+    std::string path = resolveModulePath(globals->import_chain.back());
+    globals->import_chain.pop_back();
+    if (succeeded) {
+        globals->modules[path] = ModuleState::Loaded;
+    } else {
+        globals->modules.erase(path);
+    }
 }
 
-Scope& Environment::getClassAttrs() {
+std::string Environment::getImportChain() const {
+    std::string chain;
+    for (const auto& filename : globals->import_chain) {
+        chain += filename + " -> ";
+    }
+    return chain;
+}
+
+std::shared_ptr<Scope> Environment::getClassAttrs() const {
     return class_attrs;
 }
 
-void Environment::setClassAttrs(Scope& scope) {
-    class_attrs = scope;
+void Environment::copyClassAttrs() {
+    class_attrs = std::make_shared<Scope>(*class_attrs);
 }
 
-void Environment::setThis(std::shared_ptr<Value> inst_ref) {
+void Environment::copyClassFrame() {
+    if (!frame || frame->slots.empty()) {
+        return;
+    }
+    auto class_frame = frame;
+    frame = std::make_shared<Frame>(*class_frame);
+    auto rebind = [&](const Value& value) -> std::optional<Value> {
+        if (!value || value.getType() != ValueType::Function) {
+            return std::nullopt;
+        }
+        auto func = std::dynamic_pointer_cast<FuncNode>(value.get<std::shared_ptr<ASTNode>>());
+        if (!func || func->closure != class_frame) {
+            return std::nullopt;
+        }
+        auto bound = std::make_shared<FuncNode>(*func);
+        bound->closure = frame;
+        return Value(bound);
+    };
+    for (auto& slot : frame->slots) {
+        if (auto bound = rebind(slot)) {
+            slot = *bound;
+        }
+    }
+    for (const auto& [name, value] : class_attrs->getPairs()) {
+        if (auto bound = rebind(value)) {
+            class_attrs->set(name, *bound);
+        }
+    }
+}
+
+void Environment::copyGlobals() {
+    globals = std::make_shared<Globals>(*globals);
+}
+
+void Environment::setThis(Value inst_ref) {
     this_ref = inst_ref;
 }
 
-std::shared_ptr<Value> Environment::getThis() {
+Value Environment::getThis() {
     if (!this_ref) {
         throwError(ErrorType::Runtime, "'this' may only be used inside a member function");
-        return std::make_shared<Value>();
+        return Value::none();
     }
     return this_ref;
 }
@@ -309,13 +446,31 @@ std::shared_ptr<Value> Environment::getThis() {
 void Environment::display(bool show_attrs) const {
     if (class_env || show_attrs) {
         std::cout << "ATTRS\n";
-        class_attrs.display();
+        class_attrs->display();
+    }
+    std::cout << "Globals" << std::endl;
+    for (const auto& pair : getGlobalPairs()) {
+        std::cout << pair.first << " = ";
+        printValue(pair.second);
+        std::cout << std::endl;
     }
-    int i = 1;
-    for (auto scope : scopes) {
-        std::cout << "Scope:" << i << std::endl;
-        scope.display();
-        i += 1;
+    std::cout << "Locals" << std::endl;
+    for (const auto& pair : getLocalPairs()) {
+        std::cout << pair.first << " = ";
+        printValue(pair.second);
+        std::cout << std::endl;
     }
     std::cout << std::endl;
-}
\ No newline at end of file
+}
+
+void Environment::trace(GCVisitor& visitor) const {
+    visitor.visit(frame.get());
+    visitor.visit(class_attrs.get());
+    visitor.visit(this_ref);
+}
+
+void Environment::clearReferences() {
+    frame = nullptr;
+    class_attrs = std::make_shared<Scope>();
+    this_ref = nullptr;
+}
@@ -2,19 +2,30 @@
 #include <string>
 #include <format>
 #include "context.h"
+#include "stats.h"
 #include <fstream>
+#include <sstream>
+#include "runtime.h"
 
 
 std::string getLine(const std::string& filename, int line) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        throwError(ErrorType::Runtime, "Could not open file: " + filename);
+    std::ifstream file;
+    std::istringstream loaded;
+    std::istream* source = &file;
+    if (std::optional<std::string> source_code = activeRuntime().findSource(filename)) {
+        loaded.str(std::move(*source_code));
+        source = &loaded;
+    } else {
+        file.open(filename);
+        if (!file.is_open()) {
+            return "<Could not open file: " + filename + ">";
+        }
     }
 
     std::string currentLine;
     int currentLineNum = 1;
 
-    while (std::getline(file, currentLine)) {
+    while (std::getline(*source, currentLine)) {
         if (currentLineNum == line) {
             return currentLine;
         }
@@ -94,6 +105,7 @@ std::string buildError(ErrorType error_type, std::string message, int line, int
 }
 
 void throwError(ErrorType error_type, std::string message, int line, int column) {
+    COUNT_STAT(exceptions);
     std::string error_message = buildError(error_type, message, line, column);
     throw ErrorException(error_type, error_message);
 }
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "funcy.h"
+#include <type_traits>
+#include "interpreter.h"
+#include "runtime.h"
+#include "errorDefs.h"
+#include "values.h"
+#include "nodes.h"
+#include "threadPool.h"
+#include "context.h"
+
+namespace {
+
+Value toValue(const NativeValue& native) {
+    return std::visit([](const auto& v) -> Value {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, std::nullptr_t>) {
+            return Value::none();
+        } else if constexpr (std::is_same_v<T, NativeValue::List>) {
+            auto list = std::make_shared<List>();
+            for (const NativeValue& element : v) {
+                list->push_back(toValue(element));
+            }
+            return Value(list);
+        } else {
+            return Value(v);
+        }
+    }, native.value);
+}
+
+NativeValue toNative(const Value& value) {
+    switch (value.getType()) {
+        case ValueType::None:
+            return NativeValue{};
+        case ValueType::Boolean:
+            return NativeValue{value.get<bool>()};
+        case ValueType::Integer:
+            return NativeValue{value.get<int>()};
+        case ValueType::Float:
+            return NativeValue{value.get<double>()};
+        case ValueType::String:
+            return NativeValue{value.get<std::string>()};
+        case ValueType::List: {
+            NativeValue::List elements;
+            for (const Value& element : value.get<std::shared_ptr<List>>()->getElements()) {
+                elements.push_back(toNative(element));
+            }
+            return NativeValue{std::move(elements)};
+        }
+        default:
+            throwError(ErrorType::Runtime, "A value of " + getTypeStr(value.getType()) + " can't be passed to the host program");
+    }
+}
+
+}
+
+Funcy::Funcy(const FuncyOptions& options)
+    : interpreter{std::make_unique<Interpreter>(InterpreterOptions{options.use_vm_engine, options.use_module_cache, options.detect_recursion})} {}
+
+Funcy::~Funcy() = default;
+Funcy::Funcy(Funcy&&) noexcept = default;
+Funcy& Funcy::operator=(Funcy&&) noexcept = default;
+
+void Funcy::loadFile(const std::string& filename) {
+    try {
+        interpreter->runFile(filename);
+    }
+    catch (const ErrorException& e) {
+        throw FuncyError(e.message);
+    }
+}
+
+void Funcy::loadString(const std::string& source_code, const std::string& name) {
+    try {
+        interpreter->runSource(source_code, name, false);
+    }
+    catch (const ErrorException& e) {
+        throw FuncyError(e.message);
+    }
+}
+
+NativeValue Funcy::apply(const std::string& function, const std::vector<NativeValue>& args) {
+    RuntimeScope scope{interpreter->getRuntime()};
+    Environment& env = interpreter->getEnvironment();
+    try {
+        Symbol symbol = internSymbol(function);
+        Value func = env.hasGlobal(symbol) ? env.getGlobal(symbol) : env.getFunction(symbol);
+        std::vector<Value> values;
+        for (const NativeValue& arg : args) {
+            values.push_back(toValue(arg));
+        }
+
+        std::optional<Value> result;
+        if (func.getType() == ValueType::Function) {
+            auto func_node = std::dynamic_pointer_cast<FuncNode>(func.get<std::shared_ptr<ASTNode>>());
+            pushExecutionContext(func_node->file_context);
+            struct ContextRestore {
+                ~ContextRestore() {
+                    popExecutionContext();
+                }
+            } context_restore;
+            result = func_node->callFunc(values, std::map<std::string, Value>{}, env);
+        } else if (func.getType() == ValueType::BuiltInFunction) {
+            result = (*func.get<std::shared_ptr<BuiltInFunction>>())(values, env);
+        } else {
+            throwError(ErrorType::Runtime, "There is no function named '" + function + "'");
+        }
+        NativeValue native = result ? toNative(*result) : NativeValue{};
+        waitForThreads();
+        return native;
+    }
+    catch (const ErrorException& e) {
+        throw FuncyError(e.message);
+    }
+    catch (const StackOverflowException&) {
+        throw FuncyError(buildError(ErrorType::StackOverflow, "Excessive recursion depth reached", 0, 0));
+    }
+}
+
+void Funcy::registerFunction(const std::string& name, NativeFunction function) {
+    RuntimeScope scope{interpreter->getRuntime()};
+    BuiltInFunction built_in_func = [name, function = std::move(function)](const std::vector<Value>& args, Environment& env) -> std::optional<Value> {
+        std::vector<NativeValue> native_args;
+        for (const Value& arg : args) {
+            native_args.push_back(toNative(arg));
+        }
+        NativeValue result;
+        try {
+            result = function(native_args);
+        }
+        catch (const FuncyError& e) {
+            // A script the function called back into failed, its message is already built
+            throw ErrorException(ErrorType::Runtime, e.what());
+        }
+        catch (const std::exception& e) {
+            throwError(ErrorType::Runtime, name + "() failed: " + e.what());
+        }
+        return toValue(result);
+    };
+    interpreter->getEnvironment().addFunction(name, Value(std::make_shared<BuiltInFunction>(std::move(built_in_func))));
+}
+
+bool Funcy::hasGlobal(const std::string& name) const {
+    return interpreter->getEnvironment().hasGlobal(internSymbol(name));
+}
+
+NativeValue Funcy::getGlobal(const std::string& name) const {
+    RuntimeScope scope{interpreter->getRuntime()};
+    try {
+        Value value = interpreter->getEnvironment().getGlobal(internSymbol(name));
+        if (!value) {
+            throwError(ErrorType::Runtime, "There is no global variable named '" + name + "'");
+        }
+        return toNative(value);
+    }
+    catch (const ErrorException& e) {
+        throw FuncyError(e.message);
+    }
+}
+
+void Funcy::setGlobal(const std::string& name, const NativeValue& value) {
+    RuntimeScope scope{interpreter->getRuntime()};
+    interpreter->getEnvironment().setGlobal(internSymbol(name), toValue(value));
+}
@@ -0,0 +1,217 @@
+#include "gc.h"
+#include <unordered_map>
+#include <vector>
+#include "values.h"
+#include "nodes.h"
+
+GarbageCollector::~GarbageCollector() {
+    for (GCObject* object = head; object; object = object->next) {
+        object->collector = nullptr;
+    }
+}
+
+std::unique_lock<std::mutex> GarbageCollector::lockWhenThreaded() const {
+    std::unique_lock lock{mutex, std::defer_lock};
+    if (THREADS_ACTIVE.load(std::memory_order_relaxed)) {
+        lock.lock();
+    }
+    return lock;
+}
+
+void GarbageCollector::track(GCObject* object) {
+    auto lock = lockWhenThreaded();
+    object->collector = this;
+    object->next = head;
+    if (head) {
+        head->prev = object;
+    }
+    head = object;
+    stats.tracked++;
+    stats.by_kind[static_cast<size_t>(object->kind)].add(0);
+    allocations++;
+}
+
+void GarbageCollector::untrack(GCObject* object) {
+    auto lock = lockWhenThreaded();
+    if (object->prev) {
+        object->prev->next = object->next;
+    } else {
+        head = object->next;
+    }
+    if (object->next) {
+        object->next->prev = object->prev;
+    }
+    stats.tracked--;
+    stats.by_kind[static_cast<size_t>(object->kind)].remove(0);
+}
+
+const HeapObject* GarbageCollector::heapOf(const Value& value) {
+    return value.isHeap() ? value.heap() : nullptr;
+}
+
+const GCObject* GarbageCollector::heapTarget(const HeapObject* heap) {
+    switch (heap->type) {
+        case ValueType::List:
+            return std::get<std::shared_ptr<List>>(heap->value).get();
+        case ValueType::Dictionary:
+            return std::get<std::shared_ptr<Dictionary>>(heap->value).get();
+        case ValueType::Function:
+            return dynamic_cast<const GCObject*>(std::get<std::shared_ptr<ASTNode>>(heap->value).get());
+        case ValueType::Class:
+            return std::get<std::shared_ptr<Class>>(heap->value).get();
+        case ValueType::Instance:
+            return std::get<std::shared_ptr<Instance>>(heap->value).get();
+        default:
+            return nullptr;
+    }
+}
+
+size_t GarbageCollector::collect() {
+    if (collecting || threaded_work.load(std::memory_order_acquire) > 0) {
+        return 0;
+    }
+    collecting = true;
+
+    // Start every object at its reference count, objects not owned through a shared_ptr are always roots
+    std::unordered_map<const GCObject*, long> refs;
+    refs.reserve(stats.tracked);
+    for (GCObject* object = head; object; object = object->next) {
+        long count = object->weak_from_this().use_count();
+        refs[object] = count > 0 ? count : ROOT;
+    }
+
+    // Take away every reference held by another tracked object. A Value only counts as such a
+    // reference when all of its HeapObject's owners are tracked objects.
+    class Subtract : public GCVisitor {
+    public:
+        Subtract(std::unordered_map<const GCObject*, long>& refs) : refs{refs} {}
+        void visit(const Value& value) override {
+            auto heap = heapOf(value);
+            if (heap && heapTarget(heap)) {
+                heap_refs[heap]++;
+            }
+        }
+        void visit(const GCObject* object) override {
+            auto found = refs.find(object);
+            if (found != refs.end()) {
+                found->second--;
+            }
+        }
+        std::unordered_map<const GCObject*, long>& refs;
+        std::unordered_map<const HeapObject*, uint32_t> heap_refs;
+    };
+    Subtract subtract{refs};
+    for (GCObject* object = head; object; object = object->next) {
+        object->trace(subtract);
+    }
+    for (const auto& [heap, count] : subtract.heap_refs) {
+        if (count == heap->refs) {
+            subtract.visit(heapTarget(heap));
+        }
+    }
+
+    // Anything still referenced from outside is a root, mark everything reachable from the roots
+    class Mark : public GCVisitor {
+    public:
+        Mark(std::unordered_map<const GCObject*, long>& refs) : refs{refs} {}
+        void visit(const Value& value) override {
+            auto heap = heapOf(value);
+            if (heap) {
+                visit(heapTarget(heap));
+            }
+        }
+        void visit(const GCObject* object) override {
+            auto found = refs.find(object);
+            if (found != refs.end() && found->second <= 0) {
+                found->second = 1;
+                pending.push_back(object);
+            }
+        }
+        std::unordered_map<const GCObject*, long>& refs;
+        std::vector<const GCObject*> pending;
+    };
+    Mark mark{refs};
+    for (auto& [object, count] : refs) {
+        if (count > 0) {
+            mark.pending.push_back(object);
+        }
+    }
+    while (!mark.pending.empty()) {
+        const GCObject* object = mark.pending.back();
+        mark.pending.pop_back();
+        object->trace(mark);
+    }
+
+    // Hold the garbage alive while its references are cleared so nothing is freed mid sweep
+    std::vector<std::shared_ptr<GCObject>> garbage;
+    for (const auto& [object, count] : refs) {
+        if (count <= 0) {
+            garbage.push_back(const_cast<GCObject*>(object)->shared_from_this());
+        }
+    }
+    for (const auto& object : garbage) {
+        object->clearReferences();
+    }
+    size_t freed = garbage.size();
+    garbage.clear();
+
+    stats.collections++;
+    stats.freed += freed;
+    allocations = 0;
+    threshold = std::max(MIN_THRESHOLD, stats.tracked);
+    collecting = false;
+    return freed;
+}
+
+void GarbageCollector::forEach(const std::function<void(const GCObject&)>& visit) const {
+    auto lock = lockWhenThreaded();
+    for (const GCObject* object = head; object; object = object->next) {
+        visit(*object);
+    }
+}
+
+void GarbageCollector::maybeCollect() {
+    if (threaded_work.load(std::memory_order_acquire) == 0 && allocations >= threshold) {
+        collect();
+    }
+}
+
+GCObject::GCObject(GCKind kind)
+    : kind{kind} {
+    active_collector->track(this);
+}
+
+GCObject::GCObject(const GCObject& other)
+    : std::enable_shared_from_this<GCObject>{}, kind{other.kind} {
+    active_collector->track(this);
+}
+
+GCObject& GCObject::operator=(const GCObject&) {
+    return *this;
+}
+
+GCObject::~GCObject() {
+    if (collector) {
+        collector->untrack(this);
+    }
+}
+
+GCKind GCObject::getKind() const {
+    return kind;
+}
+
+size_t collectGarbage() {
+    return active_collector->collect();
+}
+
+void maybeCollectGarbage() {
+    active_collector->maybeCollect();
+}
+
+const GCStats& getGCStats() {
+    return active_collector->stats;
+}
+
+void forEachTrackedObject(const std::function<void(const GCObject&)>& visit) {
+    active_collector->forEach(visit);
+}
@@ -0,0 +1,103 @@
+#include "interpreter.h"
+#include "runtime.h"
+#include "library.h"
+#include "context.h"
+#include "errorDefs.h"
+#include "compiler.h"
+#include "vm.h"
+#include "resolver.h"
+#include "moduleCache.h"
+#include "threadPool.h"
+
+Interpreter::Interpreter(const InterpreterOptions& options)
+    : runtime{std::make_unique<Runtime>()} {
+    RuntimeScope scope{*runtime};
+    env.emplace(buildStartingEnvironment(options));
+}
+
+Interpreter::~Interpreter() {
+    RuntimeScope scope{*runtime};
+    waitForThreads();
+    env.reset();
+    collectGarbage(); // Cycles the programs left behind
+    runtime.reset(); // While it's still bound, so the values the nodes hold are released into it
+}
+
+void Interpreter::runFile(const std::string& filename) {
+    std::string source_code = readSourceCodeFromFile(filename);
+    if (source_code.empty()) {
+        throwError(ErrorType::Runtime, "File " + filename + " is empty or could not be read");
+    }
+    runSource(source_code, filename);
+}
+
+void Interpreter::runSource(const std::string& source_code, const std::string& filename, bool read_from_file) {
+    RuntimeScope scope{*runtime};
+    const InterpreterOptions& options = env->options();
+
+    pushExecutionContext(filename); // Keeps the current running code's file on top of the stack
+    pushParsingContext(filename);
+    struct ContextRestore {
+        ~ContextRestore() {
+            popParsingContext();
+            popExecutionContext();
+        }
+    } context_restore;
+
+    if (!read_from_file) {
+        runtime->addSource(filename, source_code);
+    }
+    std::vector<NodeRef<>> statements = parseModule(filename, source_code, read_from_file && options.use_module_cache);
+    std::vector<Symbol>& program_layout = program_layouts.emplace_back(resolveProgram(statements, options.use_vm_engine));
+
+    // So a file that imports the program back is caught as circular. A file run again is already loaded.
+    bool began_module = !env->beginModule(filename);
+    env->pushFrame(program_layout);
+    try {
+        Chunk program;
+        if (options.use_vm_engine) {
+            program = compileBlock(statements);
+        }
+        for (size_t i = 0; i < (options.use_vm_engine ? 1 : statements.size()); i++) {
+            Completion completion;
+            try {
+                if (options.use_vm_engine) {
+                    executeChunk(program, *env);
+                } else {
+                    completion = statements[i]->execute(*env);
+                }
+            }
+            catch (const StackOverflowException&) {
+                throwError(ErrorType::StackOverflow, "Excessive recursion depth reached. (Add the -IgnoreOverflow flag to the end of \
+the program execution to ignore this warning)");
+            }
+            if (completion.type == CompletionType::Return) {
+                throwError(ErrorType::Runtime, "Return was used outside of function");
+            } else if (completion.type == CompletionType::Break) {
+                throwError(ErrorType::Runtime, "Break was used outside of loop");
+            } else if (completion.type == CompletionType::Continue) {
+                throwError(ErrorType::Runtime, "Continue was used outside of loop");
+            }
+        }
+    }
+    catch (...) {
+        env->popFrame();
+        if (began_module) {
+            env->endModule(false);
+        }
+        throw;
+    }
+    env->popFrame();
+    if (began_module) {
+        env->endModule(true);
+    }
+    waitForThreads();
+}
+
+Environment& Interpreter::getEnvironment() {
+    return *env;
+}
+
+Runtime& Interpreter::getRuntime() {
+    return *runtime;
+}
@@ -1,12 +1,61 @@
 #include "lexer.h"
 #include <iostream>
 #include <format>
+#include <charconv>
 #include "token.h"
 #include "library.h"
 #include "errorDefs.h"
 
 
-Lexer::Lexer(const std::string& source_code)
+// Source files are treated as ASCII, so these don't depend on the locale
+static bool isSpace(char character) {
+    return character == ' ' || (character >= '\t' && character <= '\r');
+}
+
+static bool isDigit(char character) {
+    return character >= '0' && character <= '9';
+}
+
+static bool isWordStart(char character) {
+    return (character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z') || character == '_';
+}
+
+static bool isWordCharacter(char character) {
+    return isWordStart(character) || isDigit(character);
+}
+
+// What the character after a backslash stands for
+static std::optional<char> escapedCharacter(char character) {
+    switch (character) {
+        case 'n': return '\n';    // Newline
+        case 't': return '\t';    // Tab
+        case 'r': return '\r';    // Carriage return
+        case 'b': return '\b';    // Backspace
+        case 'f': return '\f';    // Formfeed
+        case '\\': return '\\';   // Backslash
+        case '\"': return '\"';   // Double quote
+        case '\'': return '\'';   // Single quote
+        case '0': return '\0';    // Null character
+        case 'e': return '\x1b';  // ESC (ANSI escape)
+        default: return std::nullopt;
+    }
+}
+
+std::string unescapeString(std::string_view literal) {
+    std::string string;
+    string.reserve(literal.size());
+    for (size_t i = 0; i < literal.size(); i++) {
+        if (literal[i] == '\\' && i + 1 < literal.size()) {
+            string += escapedCharacter(literal[++i]).value_or('\\');
+        } else {
+            string += literal[i];
+        }
+    }
+    return string;
+}
+
+
+Lexer::Lexer(std::string_view source_code)
     : source_code{source_code} {}
 
 char Lexer::grabNextCharacter() {
@@ -21,9 +70,22 @@ char Lexer::grabNextCharacter() {
 }
 
 char Lexer::peekNextCharacter(int ahead) {
+    if (current_position + ahead >= source_code.length()) {
+        return '\0';
+    }
     return source_code[current_position + ahead];
 }
 
+template <typename Predicate>
+void Lexer::skipWhile(Predicate predicate) {
+    size_t end = current_position;
+    while (end < source_code.length() && predicate(source_code[end])) {
+        end++;
+    }
+    column += static_cast<int>(end - current_position);
+    current_position = end;
+}
+
 void Lexer::lexerError(std::string message, int line, int column) const {
     throwError(ErrorType::Syntax, message, line, column);
 }
@@ -34,11 +96,12 @@ std::vector<Token> Lexer::tokenize() {
     column = 0;
 
     std::vector<Token> tokens;
+    tokens.reserve(source_code.length() / 4);
 
     while (current_position < source_code.length()) {
         char character = grabNextCharacter();
 
-        if (iswspace(character)) { // Ignore whitespace
+        if (isSpace(character)) { // Ignore whitespace
             continue;
         }
         else if (character == '#') { // Ignore line after comment sign
@@ -53,127 +116,101 @@ std::vector<Token> Lexer::tokenize() {
             }
         }
         else if (character == '/' && peekNextCharacter() == '*') { // Block comments
+            int l = line;
+            int c = column;
             grabNextCharacter();
-            while (grabNextCharacter() != '*' || peekNextCharacter() != '/') {
+            while (current_position < source_code.length() && (grabNextCharacter() != '*' || peekNextCharacter() != '/')) {
                 continue;
             }
+            if (current_position >= source_code.length()) {
+                lexerError("Expected '*/' to close the comment", l, c);
+            }
             grabNextCharacter();
         }
-        else if (isalpha(character) || character == '_') {
+        else if (isWordStart(character)) {
             // Keyword or Identifier
             int l = line;
             int c = column;
-            std::string literal;
-            literal += character;
-
-            // Get the entire word
-            while (current_position < source_code.length()) {
-                char next = peekNextCharacter();
+            size_t start = current_position - 1;
+            skipWhile(isWordCharacter);
+            std::string_view word = source_code.substr(start, current_position - start);
 
-                if (isalnum(next) || next == '_') {
-                    literal += grabNextCharacter();
+            // Check if it's a keyword/true/false
+            if (auto keyword = findKeyword(word)) {
+                if (keyword.value() == TokenType::_Boolean) {
+                    tokens.push_back(Token{TokenType::_Boolean, word == "true", l, c});
                 } else {
-                    break;
+                    tokens.push_back(Token{keyword.value(), l, c});
                 }
-            }
-
-            // Check if it's a keyword/true/false
-            if (keyword_tokens.contains(literal)) {
-                Token token{keyword_tokens[literal], l, c};
-                tokens.push_back(token);
-            }
-            else if (literal == "true") {
-                tokens.push_back(Token{TokenType::_Boolean, true, l, c});
-            } else if (literal == "false") {
-                tokens.push_back(Token{TokenType::_Boolean, false, l, c});
             } else {
-                tokens.push_back(Token{TokenType::_Identifier, literal, l, c});
+                Token token{TokenType::_Identifier, word, l, c};
+                token.symbol = internSymbol(word);
+                tokens.push_back(token);
             }
         }
 
         else if (character == '"' || character == '\'') {
-            // It's a string literal
-
-            std::string literal = "";
+            // It's a string literal, escapes are checked here and resolved by the parser
             int l = line;
             int c = column;
+            size_t start = current_position;
 
             char starting_char = character;
-            char next = peekNextCharacter();
             while (current_position < source_code.length()) {
+                char next = peekNextCharacter();
                 if (next == '\\') {
                     grabNextCharacter(); // Consume the backslash
                     if (current_position >= source_code.length()) break; // Avoid out of bounds
                     char escape_char = grabNextCharacter(); // Get the escaped character
-
-                    // Handle escape sequences
-                    switch (escape_char) {
-                        case 'n': literal += '\n'; break;    // Newline
-                        case 't': literal += '\t'; break;    // Tab
-                        case 'r': literal += '\r'; break;    // Carriage return
-                        case 'b': literal += '\b'; break;    // Backspace
-                        case 'f': literal += '\f'; break;    // Formfeed
-                        case '\\': literal += '\\'; break;   // Backslash
-                        case '\"': literal += '\"'; break;   // Double quote
-                        case '\'': literal += '\''; break;   // Single quote
-                        case '0': literal += '\0'; break;    // Null character
-                        case 'e': literal += '\x1b'; break;  // ESC (ANSI escape)
-                        default:
-                            // Invalid escape sequence
-                            lexerError("Unknown escape sequence \\" + std::string(1, escape_char), l, c);
-                            break;
+                    if (!escapedCharacter(escape_char)) {
+                        lexerError("Unknown escape sequence \\" + std::string(1, escape_char), l, c);
                     }
                 } else if (next == starting_char) {
                     break;
                 } else {
-                    literal += grabNextCharacter();
+                    grabNextCharacter();
                 }
-                next = peekNextCharacter();
             }
 
             if (current_position >= source_code.length()) {
                 lexerError("Expected closing quotes", l, c);
             }
 
+            std::string_view literal = source_code.substr(start, current_position - start);
             grabNextCharacter();
-            Token token{TokenType::_String, literal, l, c};
-            tokens.push_back(token);
+            tokens.push_back(Token{TokenType::_String, literal, l, c});
         }
 
-        else if (isdigit(character)) { // Integer or float
+        else if (isDigit(character)) { // Integer or float
             int l = line;
             int c = column;
-            bool found_decimal = false;
-            std::string literal;
-            literal += character;
-
-            while (current_position < source_code.length()) {
-                char next = peekNextCharacter();
-                
-                if (isdigit(next)) {
-                    literal += grabNextCharacter();
-                }
-                else if (next == '.' && !found_decimal) { // First decimal point
-                    found_decimal = true;
-                    literal += grabNextCharacter();
-                }
-                else if (next == '.' && found_decimal) { // Second decimal point
+            size_t start = current_position - 1;
+            skipWhile(isDigit);
+            bool found_decimal = peekNextCharacter() == '.';
+            if (found_decimal) { // First decimal point
+                grabNextCharacter();
+                skipWhile(isDigit);
+                if (peekNextCharacter() == '.') { // Second decimal point
                     lexerError("Invalid number format: multiple decimal points", line, column + 1);
-                    break;
-                }
-                else {
-                    break;
                 }
             }
+            std::string_view literal = source_code.substr(start, current_position - start);
 
             // Push token based on whether a decimal point was found
             if (found_decimal) {
-                tokens.push_back(Token(TokenType::_Float, std::stod(literal), l, c));
+                double number = 0;
+                std::from_chars(literal.data(), literal.data() + literal.size(), number);
+                tokens.push_back(Token(TokenType::_Float, number, l, c));
             } else {
-                tokens.push_back(Token(TokenType::_Integer, std::stoi(literal), l, c));
+                int number = 0;
+                auto result = std::from_chars(literal.data(), literal.data() + literal.size(), number);
+                if (result.ec == std::errc::result_out_of_range) {
+                    lexerError("Integer " + std::string(literal) + " is too large", l, c);
+                }
+                tokens.push_back(Token(TokenType::_Integer, number, l, c));
             }
         }
-        else if (char_tokens.find(character) != char_tokens.end()) {
+        else if (auto single_token = findCharToken(character)) {
             // Find any single character tokens + , - etc
             if (character == '*' && peekNextCharacter() == '*') {
                 tokens.push_back(Token(TokenType::_DoubleMultiply, line, column));
@@ -219,8 +256,7 @@ std::vector<Token> Lexer::tokenize() {
                 tokens.push_back(token);
             }
             else {
-                Token token{char_tokens[character], line, column};
-                tokens.push_back(token);
+                tokens.push_back(Token{single_token.value(), line, column});
             }
         }
         else {
@@ -230,4 +266,4 @@ std::vector<Token> Lexer::tokenize() {
 
     tokens.push_back(Token{TokenType::_EOF, line, column});
     return tokens;
-}
\ No newline at end of file
+}
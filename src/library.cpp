@@ -11,16 +11,20 @@
 #include <cmath>
 #include <cctype>
 #include <random>
+#include <mutex>
+#include <system_error>
 #include "errorDefs.h"
 #include "values.h"
 #include "nodes.h"
 #include "context.h"
 #include "parser.h"
 #include "lexer.h"
+#include "threadPool.h"
+#include "tasks.h"
+#include "runtime.h"
 
-static const auto appStartTime = std::chrono::steady_clock::now();
 
-bool debuggingAST = AtomNode{"temp", 0, 0}.debug;
+bool debuggingAST = ASTNode::debug;
 
 std::string readSourceCodeFromFile(const std::string& filename) {
     if (filename.size() < 3 || filename.substr(filename.size() - 3) != ".fy") {
@@ -40,11 +44,11 @@ std::string readSourceCodeFromFile(const std::string& filename) {
     return buffer.str(); // Return the contents as a std::string
 }
 
-void printValue(const std::shared_ptr<Value> value, bool error) {
+void printValue(const Value value, bool error) {
     Style style{};
-    switch(value->getType()) {
+    switch(value.getType()) {
         case ValueType::Integer: {
-            int int_value = value->get<int>();
+            int int_value = value.get<int>();
             if (error) {
                 std::cout << style.red << int_value << style.reset;
             } else {
@@ -53,7 +57,7 @@ void printValue(const std::shared_ptr<Value> value, bool error) {
             return;
         }
         case ValueType::Float: {
-            double float_value = value->get<double>();
+            double float_value = value.get<double>();
             if (float_value == static_cast<int>(float_value)) {
                 if (error) {
                     std::cout << style.red << float_value << ".0" << style.reset;
@@ -70,7 +74,7 @@ void printValue(const std::shared_ptr<Value> value, bool error) {
             return;
         }
         case ValueType::Boolean: {
-            bool bool_value = value->get<bool>();
+            bool bool_value = value.get<bool>();
             if (error) {
                 std::cout << style.red << std::boolalpha << bool_value << style.reset;
             } else {
@@ -79,7 +83,7 @@ void printValue(const std::shared_ptr<Value> value, bool error) {
             return;
         }
         case ValueType::String: {
-            std::string string_value = value->get<std::string>();
+            std::string string_value = value.get<std::string>();
             if (error) {
                 std::cout << style.red << string_value << style.reset;
             } else {
@@ -112,7 +116,7 @@ void printValue(const std::shared_ptr<Value> value, bool error) {
             return;
         }
         case ValueType::List: {
-            std::shared_ptr<List> list_value = value->get<std::shared_ptr<List>>();
+            std::shared_ptr<List> list_value = value.get<std::shared_ptr<List>>();
             if (error) {
                 std::cout << style.red;
             }
@@ -135,7 +139,7 @@ void printValue(const std::shared_ptr<Value> value, bool error) {
             return;
         }
         case ValueType::Dictionary: {
-            auto dict_value = value->get<std::shared_ptr<Dictionary>>();
+            auto dict_value = value.get<std::shared_ptr<Dictionary>>();
             if (error) {
                 std::cout << style.red;
             }
@@ -170,7 +174,7 @@ void printValue(const std::shared_ptr<Value> value, bool error) {
             return;
         }
         case ValueType::Function: {
-            auto node = value->get<std::shared_ptr<ASTNode>>();
+            auto node = value.get<std::shared_ptr<ASTNode>>();
             auto func_node = std::static_pointer_cast<FuncNode>(node);
             if (error) {
                 std::cout << style.red << "Function:" << *func_node->func_name << style.reset;
@@ -188,7 +192,7 @@ void printValue(const std::shared_ptr<Value> value, bool error) {
             return;
         }
         case ValueType::Class: {
-            auto node = value->get<std::shared_ptr<Class>>();
+            auto node = value.get<std::shared_ptr<Class>>();
             if (error) {
                 std::cout << style.red << "Class:" << node->getName() << style.reset;
             } else {
@@ -197,7 +201,7 @@ void printValue(const std::shared_ptr<Value> value, bool error) {
             return;
         }
         case ValueType::Instance: {
-            auto node = value->get<std::shared_ptr<Instance>>();
+            auto node = value.get<std::shared_ptr<Instance>>();
             if (error) {
                 std::cout << style.red << node->getClassName() << ":Instance" << style.reset;
             } else {
@@ -207,9 +211,26 @@ void printValue(const std::shared_ptr<Value> value, bool error) {
         }
         case ValueType::Type: {
             if (error) {
-                std::cout << style.red << getTypeStr(value->get<ValueType>()) << style.reset;
+                std::cout << style.red << getTypeStr(value.get<ValueType>()) << style.reset;
             } else {
-                std::cout << style.blue << getTypeStr(value->get<ValueType>()) << style.reset;
+                std::cout << style.blue << getTypeStr(value.get<ValueType>()) << style.reset;
+            }
+            return;
+        }
+        case ValueType::Range: {
+            if (error) {
+                std::cout << style.red << getRangeStr(value.get<Range>()) << style.reset;
+            } else {
+                std::cout << style.blue << getRangeStr(value.get<Range>()) << style.reset;
+            }
+            return;
+        }
+        case ValueType::Future:
+        case ValueType::Channel: {
+            if (error) {
+                std::cout << style.red << getTypeStr(value.getType()) << style.reset;
+            } else {
+                std::cout << style.blue << getTypeStr(value.getType()) << style.reset;
             }
             return;
         }
@@ -218,146 +239,130 @@ void printValue(const std::shared_ptr<Value> value, bool error) {
     }
 }
 
-std::vector<std::variant<int, double>> transformNums(std::shared_ptr<Value> first, std::shared_ptr<Value> second) {
-    // Takes any combination of bool/int/double and turns them into the same type for adding, dividing, etc
-
-    // Check if either Value contains a string
-    if (first->getType() == ValueType::String || second->getType() == ValueType::String) {
-        throwError(ErrorType::Runtime, "Attempted to transformNum with a string");
-    }
-
-    std::variant<int, double> first_num, second_num;
-
-    // Transform the first Value into int or double
-    switch (first->getType()) {
-        case ValueType::Boolean:
-            first_num = first->get<bool>() ? 1 : 0;
-            break;
-        case ValueType::Integer:
-            first_num = first->get<int>();
-            break;
-        case ValueType::Float:
-            first_num = first->get<double>();
-            break;
-        default:
-            throwError(ErrorType::Runtime, "Unsupported type in transformNums for the first value");
-    }
-
-    // Transform the second Value into int or double
-    switch (second->getType()) {
-        case ValueType::Boolean:
-            second_num = second->get<bool>() ? 1 : 0;
-            break;
-        case ValueType::Integer:
-            second_num = second->get<int>();
-            break;
-        case ValueType::Float:
-            second_num = second->get<double>();
-            break;
-        default:
-            throwError(ErrorType::Runtime, "Unsupported type in transformNums for the second value");
+Value rangeToList(const Range& range) {
+    std::vector<Value> elements;
+    elements.reserve(range.size());
+    for (int i = 0; i < range.size(); i++) {
+        elements.push_back(Value(range.at(i)));
     }
+    return Value(std::make_shared<List>(std::move(elements)));
+}
 
-    // Check if either number is a double, promoting integers to doubles if necessary
-    if (std::holds_alternative<double>(first_num) || std::holds_alternative<double>(second_num)) {
-        if (std::holds_alternative<int>(first_num)) {
-            return {static_cast<double>(std::get<int>(first_num)), std::get<double>(second_num)};
-        } else if (std::holds_alternative<int>(second_num)) {
-            return {std::get<double>(first_num), static_cast<double>(std::get<int>(second_num))};
-        } else {
-            return {std::get<double>(first_num), std::get<double>(second_num)};
+// Lets a builtin that walks a list also take a range, which is only materialized for the call
+BuiltInFunction acceptRanges(BuiltInFunction function) {
+    return [function](const std::vector<Value>& args, Environment& env) -> std::optional<Value> {
+        for (size_t i = 0; i < args.size(); i++) {
+            if (args[i].getType() == ValueType::Range) {
+                std::vector<Value> converted = args;
+                for (auto& arg : converted) {
+                    if (arg.getType() == ValueType::Range) {
+                        arg = rangeToList(arg.get<Range>());
+                    }
+                }
+                return function(converted, env);
+            }
         }
-    } else {
-        // Both are integers
-        return {std::get<int>(first_num), std::get<int>(second_num)};
-    }
-}
-
-Environment buildStartingEnvironment() {
-    Environment env;
-    env.addScope();
-
-    env.addFunction("abs", std::make_shared<Value>(std::make_shared<BuiltInFunction>(absoluteValue)));
-    env.addFunction("all", std::make_shared<Value>(std::make_shared<BuiltInFunction>(all)));
-    env.addFunction("any", std::make_shared<Value>(std::make_shared<BuiltInFunction>(any)));
-    env.addFunction("appendFile", std::make_shared<Value>(std::make_shared<BuiltInFunction>(appendFile)));
-    env.addFunction("bool", std::make_shared<Value>(std::make_shared<BuiltInFunction>(boolConverter)));
-    env.addFunction("callable", std::make_shared<Value>(std::make_shared<BuiltInFunction>(callable)));
-    env.addFunction("dict", std::make_shared<Value>(std::make_shared<BuiltInFunction>(dictConverter)));
-    env.addFunction("divMod", std::make_shared<Value>(std::make_shared<BuiltInFunction>(divMod)));
-    env.addFunction("enumerate", std::make_shared<Value>(std::make_shared<BuiltInFunction>(enumerate)));
-    env.addFunction("float", std::make_shared<Value>(std::make_shared<BuiltInFunction>(floatConverter)));
-    env.addFunction("globals", std::make_shared<Value>(std::make_shared<BuiltInFunction>(globals)));
-    env.addFunction("input", std::make_shared<Value>(std::make_shared<BuiltInFunction>(input)));
-    env.addFunction("int", std::make_shared<Value>(std::make_shared<BuiltInFunction>(intConverter)));
-    env.addFunction("length", std::make_shared<Value>(std::make_shared<BuiltInFunction>(length)));
-    env.addFunction("list", std::make_shared<Value>(std::make_shared<BuiltInFunction>(listConverter)));
-    env.addFunction("locals", std::make_shared<Value>(std::make_shared<BuiltInFunction>(locals)));
-    env.addFunction("map", std::make_shared<Value>(std::make_shared<BuiltInFunction>(map)));
-    env.addFunction("max", std::make_shared<Value>(std::make_shared<BuiltInFunction>(max)));
-    env.addFunction("min", std::make_shared<Value>(std::make_shared<BuiltInFunction>(min)));
-    env.addFunction("print", std::make_shared<Value>(std::make_shared<BuiltInFunction>(print)));
-    env.addFunction("randChoice", std::make_shared<Value>(std::make_shared<BuiltInFunction>(randChoice)));
-    env.addFunction("randInt", std::make_shared<Value>(std::make_shared<BuiltInFunction>(randInt)));
-    env.addFunction("range", std::make_shared<Value>(std::make_shared<BuiltInFunction>(range)));
-    env.addFunction("readFile", std::make_shared<Value>(std::make_shared<BuiltInFunction>(readFile)));
-    env.addFunction("reversed", std::make_shared<Value>(std::make_shared<BuiltInFunction>(reversed)));
-    env.addFunction("round", std::make_shared<Value>(std::make_shared<BuiltInFunction>(roundVal)));
-    env.addFunction("str", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringConverter)));
-    env.addFunction("sum", std::make_shared<Value>(std::make_shared<BuiltInFunction>(sum)));
-    env.addFunction("time", std::make_shared<Value>(std::make_shared<BuiltInFunction>(currentTime)));
-    env.addFunction("type", std::make_shared<Value>(std::make_shared<BuiltInFunction>(getType)));
-    env.addFunction("writeFile", std::make_shared<Value>(std::make_shared<BuiltInFunction>(writeFile)));
-    env.addFunction("zip", std::make_shared<Value>(std::make_shared<BuiltInFunction>(zip)));
+        return function(args, env);
+    };
+}
+
+Environment buildStartingEnvironment(const InterpreterOptions& options) {
+    Environment env{options};
+
+    env.addFunction("abs", Value(std::make_shared<BuiltInFunction>(absoluteValue)));
+    env.addFunction("all", Value(std::make_shared<BuiltInFunction>(acceptRanges(all))));
+    env.addFunction("any", Value(std::make_shared<BuiltInFunction>(acceptRanges(any))));
+    env.addFunction("appendFile", Value(std::make_shared<BuiltInFunction>(appendFile)));
+    env.addFunction("bool", Value(std::make_shared<BuiltInFunction>(boolConverter)));
+    env.addFunction("callable", Value(std::make_shared<BuiltInFunction>(callable)));
+    env.addFunction("channel", Value(std::make_shared<BuiltInFunction>(channel)));
+    env.addFunction("dict", Value(std::make_shared<BuiltInFunction>(dictConverter)));
+    env.addFunction("divMod", Value(std::make_shared<BuiltInFunction>(divMod)));
+    env.addFunction("enumerate", Value(std::make_shared<BuiltInFunction>(acceptRanges(enumerate))));
+    env.addFunction("float", Value(std::make_shared<BuiltInFunction>(floatConverter)));
+    env.addFunction("globals", Value(std::make_shared<BuiltInFunction>(globals)));
+    env.addFunction("input", Value(std::make_shared<BuiltInFunction>(input)));
+    env.addFunction("int", Value(std::make_shared<BuiltInFunction>(intConverter)));
+    env.addFunction("length", Value(std::make_shared<BuiltInFunction>(length)));
+    env.addFunction("list", Value(std::make_shared<BuiltInFunction>(listConverter)));
+    env.addFunction("locals", Value(std::make_shared<BuiltInFunction>(locals)));
+    env.addFunction("map", Value(std::make_shared<BuiltInFunction>(acceptRanges(map))));
+    env.addFunction("max", Value(std::make_shared<BuiltInFunction>(acceptRanges(max))));
+    env.addFunction("memStats", Value(std::make_shared<BuiltInFunction>(memStats)));
+    env.addFunction("min", Value(std::make_shared<BuiltInFunction>(acceptRanges(min))));
+    env.addFunction("pmap", Value(std::make_shared<BuiltInFunction>(acceptRanges(pmap))));
+    env.addFunction("print", Value(std::make_shared<BuiltInFunction>(print)));
+    env.addFunction("randChoice", Value(std::make_shared<BuiltInFunction>(acceptRanges(randChoice))));
+    env.addFunction("randInt", Value(std::make_shared<BuiltInFunction>(randInt)));
+    env.addFunction("range", Value(std::make_shared<BuiltInFunction>(range)));
+    env.addFunction("readFile", Value(std::make_shared<BuiltInFunction>(readFile)));
+    env.addFunction("reversed", Value(std::make_shared<BuiltInFunction>(acceptRanges(reversed))));
+    env.addFunction("round", Value(std::make_shared<BuiltInFunction>(roundVal)));
+    env.addFunction("spawn", Value(std::make_shared<BuiltInFunction>(spawn)));
+    env.addFunction("str", Value(std::make_shared<BuiltInFunction>(stringConverter)));
+    env.addFunction("sum", Value(std::make_shared<BuiltInFunction>(acceptRanges(sum))));
+    env.addFunction("time", Value(std::make_shared<BuiltInFunction>(currentTime)));
+    env.addFunction("type", Value(std::make_shared<BuiltInFunction>(getType)));
+    env.addFunction("writeFile", Value(std::make_shared<BuiltInFunction>(writeFile)));
+    env.addFunction("zip", Value(std::make_shared<BuiltInFunction>(acceptRanges(zip))));
 
     // ValueType::Float Members
-    env.addMember(ValueType::Float, "isInt", std::make_shared<Value>(std::make_shared<BuiltInFunction>(floatIsInt)));
+    env.addMember(ValueType::Float, "isInt", Value(std::make_shared<BuiltInFunction>(floatIsInt)));
 
     // ValueType::List Members
-    env.addMember(ValueType::List, "append", std::make_shared<Value>(std::make_shared<BuiltInFunction>(listAppend)));
-    env.addMember(ValueType::List, "clear", std::make_shared<Value>(std::make_shared<BuiltInFunction>(listClear)));
-    env.addMember(ValueType::List, "copy", std::make_shared<Value>(std::make_shared<BuiltInFunction>(listCopy)));
-    env.addMember(ValueType::List, "index", std::make_shared<Value>(std::make_shared<BuiltInFunction>(listIndex)));
-    env.addMember(ValueType::List, "insert", std::make_shared<Value>(std::make_shared<BuiltInFunction>(listInsert)));
-    env.addMember(ValueType::List, "pop", std::make_shared<Value>(std::make_shared<BuiltInFunction>(listPop)));
-    env.addMember(ValueType::List, "remove", std::make_shared<Value>(std::make_shared<BuiltInFunction>(listRemove)));
-    env.addMember(ValueType::List, "size", std::make_shared<Value>(std::make_shared<BuiltInFunction>(listSize)));
+    env.addMember(ValueType::List, "append", Value(std::make_shared<BuiltInFunction>(listAppend)));
+    env.addMember(ValueType::List, "clear", Value(std::make_shared<BuiltInFunction>(listClear)));
+    env.addMember(ValueType::List, "copy", Value(std::make_shared<BuiltInFunction>(listCopy)));
+    env.addMember(ValueType::List, "index", Value(std::make_shared<BuiltInFunction>(listIndex)));
+    env.addMember(ValueType::List, "insert", Value(std::make_shared<BuiltInFunction>(listInsert)));
+    env.addMember(ValueType::List, "pop", Value(std::make_shared<BuiltInFunction>(listPop)));
+    env.addMember(ValueType::List, "remove", Value(std::make_shared<BuiltInFunction>(listRemove)));
+    env.addMember(ValueType::List, "size", Value(std::make_shared<BuiltInFunction>(listSize)));
 
     // ValueType::Dictionary Members
-    env.addMember(ValueType::Dictionary, "clear", std::make_shared<Value>(std::make_shared<BuiltInFunction>(dictClear)));
-    env.addMember(ValueType::Dictionary, "copy", std::make_shared<Value>(std::make_shared<BuiltInFunction>(dictCopy)));
-    env.addMember(ValueType::Dictionary, "get", std::make_shared<Value>(std::make_shared<BuiltInFunction>(dictGet)));
-    env.addMember(ValueType::Dictionary, "items", std::make_shared<Value>(std::make_shared<BuiltInFunction>(dictItems)));
-    env.addMember(ValueType::Dictionary, "keys", std::make_shared<Value>(std::make_shared<BuiltInFunction>(dictKeys)));
-    env.addMember(ValueType::Dictionary, "pop", std::make_shared<Value>(std::make_shared<BuiltInFunction>(dictPop)));
-    env.addMember(ValueType::Dictionary, "setDefault", std::make_shared<Value>(std::make_shared<BuiltInFunction>(dictSetDefault)));
-    env.addMember(ValueType::Dictionary, "size", std::make_shared<Value>(std::make_shared<BuiltInFunction>(dictSize)));
-    env.addMember(ValueType::Dictionary, "update", std::make_shared<Value>(std::make_shared<BuiltInFunction>(dictUpdate)));
-    env.addMember(ValueType::Dictionary, "values", std::make_shared<Value>(std::make_shared<BuiltInFunction>(dictValues)));
+    env.addMember(ValueType::Dictionary, "clear", Value(std::make_shared<BuiltInFunction>(dictClear)));
+    env.addMember(ValueType::Dictionary, "copy", Value(std::make_shared<BuiltInFunction>(dictCopy)));
+    env.addMember(ValueType::Dictionary, "get", Value(std::make_shared<BuiltInFunction>(dictGet)));
+    env.addMember(ValueType::Dictionary, "items", Value(std::make_shared<BuiltInFunction>(dictItems)));
+    env.addMember(ValueType::Dictionary, "keys", Value(std::make_shared<BuiltInFunction>(dictKeys)));
+    env.addMember(ValueType::Dictionary, "pop", Value(std::make_shared<BuiltInFunction>(dictPop)));
+    env.addMember(ValueType::Dictionary, "setDefault", Value(std::make_shared<BuiltInFunction>(dictSetDefault)));
+    env.addMember(ValueType::Dictionary, "size", Value(std::make_shared<BuiltInFunction>(dictSize)));
+    env.addMember(ValueType::Dictionary, "update", Value(std::make_shared<BuiltInFunction>(dictUpdate)));
+    env.addMember(ValueType::Dictionary, "values", Value(std::make_shared<BuiltInFunction>(dictValues)));
 
     // ValueType::String Members
-    env.addMember(ValueType::String, "capitalize", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringCapitalize)));
-    env.addMember(ValueType::String, "endsWith", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringEndsWith)));
-    env.addMember(ValueType::String, "find", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringFind)));
-    env.addMember(ValueType::String, "isAlpha", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringIsAlpha)));
-    env.addMember(ValueType::String, "isAlphaNum", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringIsAlphaNum)));
-    env.addMember(ValueType::String, "isDigit", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringIsDigit)));
-    env.addMember(ValueType::String, "isSpace", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringIsSpace)));
-    env.addMember(ValueType::String, "isWhitespace", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringIsWhitespace)));
-    env.addMember(ValueType::String, "join", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringJoin)));
-    env.addMember(ValueType::String, "length", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringLength)));
-    env.addMember(ValueType::String, "lower", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringLower)));
-    env.addMember(ValueType::String, "replace", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringReplace)));
-    env.addMember(ValueType::String, "split", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringSplit)));
-    env.addMember(ValueType::String, "strip", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringStrip)));
-    env.addMember(ValueType::String, "toJson", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringToJson)));
-    env.addMember(ValueType::String, "upper", std::make_shared<Value>(std::make_shared<BuiltInFunction>(stringUpper)));
+    env.addMember(ValueType::String, "capitalize", Value(std::make_shared<BuiltInFunction>(stringCapitalize)));
+    env.addMember(ValueType::String, "endsWith", Value(std::make_shared<BuiltInFunction>(stringEndsWith)));
+    env.addMember(ValueType::String, "find", Value(std::make_shared<BuiltInFunction>(stringFind)));
+    env.addMember(ValueType::String, "isAlpha", Value(std::make_shared<BuiltInFunction>(stringIsAlpha)));
+    env.addMember(ValueType::String, "isAlphaNum", Value(std::make_shared<BuiltInFunction>(stringIsAlphaNum)));
+    env.addMember(ValueType::String, "isDigit", Value(std::make_shared<BuiltInFunction>(stringIsDigit)));
+    env.addMember(ValueType::String, "isSpace", Value(std::make_shared<BuiltInFunction>(stringIsSpace)));
+    env.addMember(ValueType::String, "isWhitespace", Value(std::make_shared<BuiltInFunction>(stringIsWhitespace)));
+    env.addMember(ValueType::String, "join", Value(std::make_shared<BuiltInFunction>(stringJoin)));
+    env.addMember(ValueType::String, "length", Value(std::make_shared<BuiltInFunction>(stringLength)));
+    env.addMember(ValueType::String, "lower", Value(std::make_shared<BuiltInFunction>(stringLower)));
+    env.addMember(ValueType::String, "replace", Value(std::make_shared<BuiltInFunction>(stringReplace)));
+    env.addMember(ValueType::String, "split", Value(std::make_shared<BuiltInFunction>(stringSplit)));
+    env.addMember(ValueType::String, "strip", Value(std::make_shared<BuiltInFunction>(stringStrip)));
+    env.addMember(ValueType::String, "toJson", Value(std::make_shared<BuiltInFunction>(stringToJson)));
+    env.addMember(ValueType::String, "upper", Value(std::make_shared<BuiltInFunction>(stringUpper)));
 
     // ValueType::Instance Members
-    env.addMember(ValueType::Instance, "delAttr", std::make_shared<Value>(std::make_shared<BuiltInFunction>(instanceDel)));
-    env.addMember(ValueType::Instance, "getAttr", std::make_shared<Value>(std::make_shared<BuiltInFunction>(instanceGet)));
-    env.addMember(ValueType::Instance, "hasAttr", std::make_shared<Value>(std::make_shared<BuiltInFunction>(instanceHas)));
-    env.addMember(ValueType::Instance, "setAttr", std::make_shared<Value>(std::make_shared<BuiltInFunction>(instanceSet)));
+    env.addMember(ValueType::Instance, "delAttr", Value(std::make_shared<BuiltInFunction>(instanceDel)));
+    env.addMember(ValueType::Instance, "getAttr", Value(std::make_shared<BuiltInFunction>(instanceGet)));
+    env.addMember(ValueType::Instance, "hasAttr", Value(std::make_shared<BuiltInFunction>(instanceHas)));
+    env.addMember(ValueType::Instance, "setAttr", Value(std::make_shared<BuiltInFunction>(instanceSet)));
+
+    // ValueType::Future Members
+    env.addMember(ValueType::Future, "done", Value(std::make_shared<BuiltInFunction>(futureDone)));
+    env.addMember(ValueType::Future, "join", Value(std::make_shared<BuiltInFunction>(futureJoin)));
+
+    // ValueType::Channel Members
+    env.addMember(ValueType::Channel, "close", Value(std::make_shared<BuiltInFunction>(channelClose)));
+    env.addMember(ValueType::Channel, "recv", Value(std::make_shared<BuiltInFunction>(channelRecv)));
+    env.addMember(ValueType::Channel, "send", Value(std::make_shared<BuiltInFunction>(channelSend)));
 
     return env;
 }
@@ -366,154 +371,171 @@ Environment buildStartingEnvironment() {
 ///  MEMBER FUNCTIONS  ///
 
 
-BuiltInFunctionReturn absoluteValue(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn absoluteValue(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "abs() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    switch (args[0]->getType()) {
+    switch (args[0].getType()) {
         case ValueType::Integer:
-            return std::make_shared<Value>(std::abs(args[0]->get<int>()));
+            return Value(std::abs(args[0].get<int>()));
         case ValueType::Float:
-            return std::make_shared<Value>(std::abs(args[0]->get<double>()));
+            return Value(std::abs(args[0].get<double>()));
         default:
-            throwError(ErrorType::Runtime, "abs() expected an argument of Type:Integer or Type:Float but got " + getTypeStr(args[0]->getType()));
+            throwError(ErrorType::Runtime, "abs() expected an argument of Type:Integer or Type:Float but got " + getTypeStr(args[0].getType()));
     }
     return std::nullopt;
 }
 
-BuiltInFunctionReturn all(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn all(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "all() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    if (args[0]->getType() != ValueType::List) {
-        throwError(ErrorType::Runtime, "all() expected an argument of Type:List but got " + getTypeStr(args[0]->getType()));
+    if (args[0].getType() != ValueType::List) {
+        throwError(ErrorType::Runtime, "all() expected an argument of Type:List but got " + getTypeStr(args[0].getType()));
     }
 
-    auto list = args[0]->get<std::shared_ptr<List>>();
+    auto list = args[0].get<std::shared_ptr<List>>();
     for (int i = 0; i < list->size(); i++) {
         auto item = list->at(i);
-        auto result = boolConverter(std::vector<std::shared_ptr<Value>>{item}, env);
+        auto result = boolConverter(std::vector<Value>{item}, env);
         if (result.has_value()) {
-            bool bool_result = result.value()->get<bool>();
+            bool bool_result = result.value().get<bool>();
             if (!bool_result) {
-                return std::make_shared<Value>(false);
+                return Value(false);
             }
         }
     }
-    return std::make_shared<Value>(true);
+    return Value(true);
 }
 
-BuiltInFunctionReturn any(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn any(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "any() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    if (args[0]->getType() != ValueType::List) {
-        throwError(ErrorType::Runtime, "any() expected an argument of Type:List but got " + getTypeStr(args[0]->getType()));
+    if (args[0].getType() != ValueType::List) {
+        throwError(ErrorType::Runtime, "any() expected an argument of Type:List but got " + getTypeStr(args[0].getType()));
     }
 
-    auto list = args[0]->get<std::shared_ptr<List>>();
+    auto list = args[0].get<std::shared_ptr<List>>();
     for (int i = 0; i < list->size(); i++) {
         auto item = list->at(i);
-        auto result = boolConverter(std::vector<std::shared_ptr<Value>>{item}, env);
+        auto result = boolConverter(std::vector<Value>{item}, env);
         if (result.has_value()) {
-            bool bool_result = result.value()->get<bool>();
+            bool bool_result = result.value().get<bool>();
             if (bool_result) {
-                return std::make_shared<Value>(true);
+                return Value(true);
             }
         }
     }
-    return std::make_shared<Value>(false);
+    return Value(false);
 }
 
-BuiltInFunctionReturn appendFile(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn appendFile(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 2) {
         throwError(ErrorType::Runtime, "appendFile() takes exactly 2 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    if (args[0]->getType() != ValueType::String) {
-        throwError(ErrorType::Runtime, "appendFile() expected an argument 1 of Type:String but got " + getTypeStr(args[0]->getType()));
+    if (args[0].getType() != ValueType::String) {
+        throwError(ErrorType::Runtime, "appendFile() expected an argument 1 of Type:String but got " + getTypeStr(args[0].getType()));
     }
 
-    if (args[1]->getType() != ValueType::String) {
-        throwError(ErrorType::Runtime, "appendFile() expected an argument 2 of Type:String but got " + getTypeStr(args[1]->getType()));
+    if (args[1].getType() != ValueType::String) {
+        throwError(ErrorType::Runtime, "appendFile() expected an argument 2 of Type:String but got " + getTypeStr(args[1].getType()));
     }
 
-    std::shared_ptr<Value> filename = args[0];
-    std::string contents_to_add = args[1]->get<std::string>();
+    Value filename = args[0];
+    std::string contents_to_add = args[1].get<std::string>();
 
     std::string orig_contents = "";
     try {
-        auto contents = readFile(std::vector<std::shared_ptr<Value>>{filename}, env);
+        auto contents = readFile(std::vector<Value>{filename}, env);
         if (contents) {
-            orig_contents = contents.value()->get<std::string>();
+            orig_contents = contents.value().get<std::string>();
         }
     }
     catch (const std::exception& e) {
     }
 
-    auto new_contents = std::make_shared<Value>(orig_contents + contents_to_add);
-    writeFile(std::vector<std::shared_ptr<Value>>{filename, new_contents}, env);
-    return std::make_shared<Value>();
+    auto new_contents = Value(orig_contents + contents_to_add);
+    writeFile(std::vector<Value>{filename, new_contents}, env);
+    return Value::none();
 }
 
-BuiltInFunctionReturn boolConverter(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn boolConverter(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "bool() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
     auto arg = args[0];
 
-    switch (arg->getType()) {
+    switch (arg.getType()) {
         case ValueType::Boolean:
             return arg; // Already a bool
         case ValueType::Integer:
-            return std::make_shared<Value>(arg->get<int>() != 0);
+            return Value(arg.get<int>() != 0);
         case ValueType::Float:
-            return std::make_shared<Value>(arg->get<double>() != 0.0);
+            return Value(arg.get<double>() != 0.0);
         case ValueType::String: {
-            const std::string& strValue = arg->get<std::string>();
-            return std::make_shared<Value>(!strValue.empty() && strValue != "false");
+            const std::string& strValue = arg.get<std::string>();
+            return Value(!strValue.empty() && strValue != "false");
         }
         case ValueType::List:
-            return std::make_shared<Value>(!arg->get<std::shared_ptr<List>>()->empty());
+            return Value(!arg.get<std::shared_ptr<List>>()->empty());
+        case ValueType::Range:
+            return Value(arg.get<Range>().size() != 0);
         default:
-            throwError(ErrorType::Runtime, "Unsupported type for bool conversion: " + getTypeStr(arg->getType()));
+            throwError(ErrorType::Runtime, "Unsupported type for bool conversion: " + getTypeStr(arg.getType()));
     }
 }
 
-BuiltInFunctionReturn callable(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn callable(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "callable() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    auto type = args[0]->getType();
+    auto type = args[0].getType();
     switch (type) {
         case ValueType::Function:
-            return std::make_shared<Value>(true);
+            return Value(true);
         case ValueType::BuiltInFunction:
-            return std::make_shared<Value>(true);
+            return Value(true);
         case ValueType::Class:
-            return std::make_shared<Value>(true);
+            return Value(true);
         default:
-            return std::make_shared<Value>(false);
+            return Value(false);
     }
 }
 
-BuiltInFunctionReturn currentTime(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn channel(const std::vector<Value>& args, Environment& env) {
+    if (args.size() > 1) {
+        throwError(ErrorType::Runtime, "channel() takes 0 or 1 arguments. " + std::to_string(args.size()) + " were given");
+    }
+
+    int capacity = 1;
+    if (args.size() == 1) {
+        if (args[0].getType() != ValueType::Integer || args[0].get<int>() < 1) {
+            throwError(ErrorType::Runtime, "channel() expected an argument of a positive Type:Int but got " + args[0].getPrintable());
+        }
+        capacity = args[0].get<int>();
+    }
+    return Value(std::make_shared<Channel>(capacity));
+}
+
+BuiltInFunctionReturn currentTime(const std::vector<Value>& args, Environment& env) {
     using namespace std::chrono;
 
-    // Get the current time since the application started in milliseconds
+    // Get the current time since the interpreter started in milliseconds
     auto now = steady_clock::now();
-    auto elapsed = duration_cast<milliseconds>(now - appStartTime).count();
+    auto elapsed = duration_cast<milliseconds>(now - env.getStartTime()).count();
 
     // Return it as an int
-    return std::make_shared<Value>(static_cast<int>(elapsed));
+    return Value(static_cast<int>(elapsed));
 }
 
-BuiltInFunctionReturn dictConverter(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn dictConverter(const std::vector<Value>& args, Environment& env) {
     auto dict = std::make_shared<Dictionary>();
 
     if (args.size() != 1 && args.size() != 0) {
@@ -521,24 +543,24 @@ BuiltInFunctionReturn dictConverter(const std::vector<std::shared_ptr<Value>>& a
     }
 
     if (args.size() == 0) {
-        return std::make_shared<Value>(dict);
+        return Value(dict);
     }
 
     auto arg = args[0];
-    switch (arg->getType()) {
+    switch (arg.getType()) {
         case ValueType::Dictionary: {
-            auto orig_dict = arg->get<std::shared_ptr<Dictionary>>();
+            auto orig_dict = arg.get<std::shared_ptr<Dictionary>>();
             for (const auto& pair : *orig_dict) {
                 dict->insert(pair);
             }
-            return std::make_shared<Value>(dict); // Already a dictionary
+            return Value(dict); // Already a dictionary
         }
         case ValueType::List: {
-            auto list = arg->get<std::shared_ptr<List>>();
+            auto list = arg.get<std::shared_ptr<List>>();
             for (int i = 0; i < list->size(); i++) {
                 auto element = list->at(i);
-                if (element->getType() == ValueType::List) {
-                    auto k_v = element->get<std::shared_ptr<List>>();
+                if (element.getType() == ValueType::List) {
+                    auto k_v = element.get<std::shared_ptr<List>>();
                     if (k_v->size() == 2) {
                         dict->insert(std::make_pair(k_v->at(0), k_v->at(1)));
                     } else {
@@ -555,77 +577,77 @@ BuiltInFunctionReturn dictConverter(const std::vector<std::shared_ptr<Value>>& a
             break;
         }
     }
-    return std::make_shared<Value>(dict);
+    return Value(dict);
 }
 
-BuiltInFunctionReturn divMod(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn divMod(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 2) {
         throwError(ErrorType::Runtime, "divMod() takes exactly 2 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    if (args[0]->getType() != ValueType::Integer) {
-        throwError(ErrorType::Runtime, "divMod() expected an argument 1 of Type:Integer but got " + getTypeStr(args[0]->getType()));
+    if (args[0].getType() != ValueType::Integer) {
+        throwError(ErrorType::Runtime, "divMod() expected an argument 1 of Type:Integer but got " + getTypeStr(args[0].getType()));
     }
-    if (args[1]->getType() != ValueType::Integer) {
-        throwError(ErrorType::Runtime, "divMod() expected an argument 2 of Type:Integer but got " + getTypeStr(args[1]->getType()));
+    if (args[1].getType() != ValueType::Integer) {
+        throwError(ErrorType::Runtime, "divMod() expected an argument 2 of Type:Integer but got " + getTypeStr(args[1].getType()));
     }
 
-    int dividend = args[0]->get<int>();
-    int divisor = args[1]->get<int>();
+    int dividend = args[0].get<int>();
+    int divisor = args[1].get<int>();
 
     int result = dividend / divisor;
     int remainder = dividend % divisor;
 
     List list;
-    list.push_back(std::make_shared<Value>(result));
-    list.push_back(std::make_shared<Value>(remainder));
-    return std::make_shared<Value>(std::make_shared<List>(list));
+    list.push_back(Value(result));
+    list.push_back(Value(remainder));
+    return Value(std::make_shared<List>(list));
 }
 
-BuiltInFunctionReturn enumerate(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn enumerate(const std::vector<Value>& args, Environment& env) {
     if (args.size() < 1 || args.size() > 2) {
         throwError(ErrorType::Runtime, "enumerate() takes 1-2 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    if (args[0]->getType() != ValueType::List) {
-        throwError(ErrorType::Runtime, "enumerate() expected an argument 1 of Type:List but got " + getTypeStr(args[0]->getType()));
+    if (args[0].getType() != ValueType::List) {
+        throwError(ErrorType::Runtime, "enumerate() expected an argument 1 of Type:List but got " + getTypeStr(args[0].getType()));
     }
     int start = 0;
     if (args.size() == 2) {
-        if (args[1]->getType() != ValueType::Integer) {
-            throwError(ErrorType::Runtime, "enumerate() expected an argument 2 of Type:Integer but got " + getTypeStr(args[1]->getType()));
+        if (args[1].getType() != ValueType::Integer) {
+            throwError(ErrorType::Runtime, "enumerate() expected an argument 2 of Type:Integer but got " + getTypeStr(args[1].getType()));
         }
-        start = args[1]->get<int>();
+        start = args[1].get<int>();
     }
 
-    auto list = args[0]->get<std::shared_ptr<List>>();
+    auto list = args[0].get<std::shared_ptr<List>>();
 
     auto result = std::make_shared<List>();
     for (int i = 0; i < list->size(); i++) {
         auto group = std::make_shared<List>();
-        group->push_back(std::make_shared<Value>(i + start));
+        group->push_back(Value(i + start));
         group->push_back(list->at(i));
-        result->push_back(std::make_shared<Value>(group));
+        result->push_back(Value(group));
     }
-    return std::make_shared<Value>(result);
+    return Value(result);
 }
 
-BuiltInFunctionReturn floatConverter(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn floatConverter(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "float() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
     auto arg = args[0];
 
-    switch (arg->getType()) {
+    switch (arg.getType()) {
         case ValueType::Float:
             return arg; // Already a float
         case ValueType::Integer:
-            return std::make_shared<Value>(static_cast<double>(arg->get<int>()));
+            return Value(static_cast<double>(arg.get<int>()));
         case ValueType::String: {
             try {
-                double doubleValue = std::stod(arg->get<std::string>());
-                return std::make_shared<Value>(doubleValue);
+                double doubleValue = std::stod(arg.get<std::string>());
+                return Value(doubleValue);
             } catch (const std::invalid_argument&) {
                 throwError(ErrorType::Runtime, "Cannot convert Type:String to Type:Float");
             } catch (const std::out_of_range&) {
@@ -633,70 +655,69 @@ BuiltInFunctionReturn floatConverter(const std::vector<std::shared_ptr<Value>>&
             }
         }
         case ValueType::Boolean:
-            return std::make_shared<Value>(arg->get<bool>() ? 1.0 : 0.0);
+            return Value(arg.get<bool>() ? 1.0 : 0.0);
         default:
-            throwError(ErrorType::Runtime, "Unsupported type for float conversion: " + getTypeStr(arg->getType()));
+            throwError(ErrorType::Runtime, "Unsupported type for float conversion: " + getTypeStr(arg.getType()));
     }
 }
 
-BuiltInFunctionReturn getType(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn getType(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "type() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    return std::make_shared<Value>(args[0]->getType());
+    return Value(args[0].getType());
 }
 
-BuiltInFunctionReturn globals(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn globals(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 0) {
         throwError(ErrorType::Runtime, "globals() takes 0 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    auto global_scope = env.copyScopes().at(0);
     Dictionary dict;
-    for (const auto& pair : global_scope.getPairs()) {
-        dict[std::make_shared<Value>(pair.first)] = pair.second;
+    for (const auto& pair : env.getGlobalPairs()) {
+        dict[Value(pair.first)] = pair.second;
     }
-    return std::make_shared<Value>(std::make_shared<Dictionary>(dict));
+    return Value(std::make_shared<Dictionary>(dict));
 }
 
-BuiltInFunctionReturn input(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn input(const std::vector<Value>& args, Environment& env) {
     if (args.size() > 1) {
         throwError(ErrorType::Runtime, "input() takes 0-1 arguments. " + std::to_string(args.size()) + " were given");
     }
 
     if (args.size() == 1) {
-        if (args[0]->getType() != ValueType::String) {
+        if (args[0].getType() != ValueType::String) {
             printValue(args[0]);
         }
         else {
-            std::string s = args[0]->get<std::string>();
+            std::string s = args[0].get<std::string>();
             std::cout << s;
         }
     }
     std::string in;
     std::getline(std::cin, in);
-    return std::make_shared<Value>(in);
+    return Value(in);
 }
 
-BuiltInFunctionReturn intConverter(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn intConverter(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "int() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
     auto arg = args[0];
 
-    switch(arg->getType()) {
+    switch(arg.getType()) {
         case ValueType::Integer:
             return arg; // If it's already an int, return as is
         case ValueType::Float: {
-            int int_value = static_cast<int>(arg->get<double>());
-            return std::make_shared<Value>(int_value);
+            int int_value = static_cast<int>(arg.get<double>());
+            return Value(int_value);
         }
         case ValueType::String: {
             try {
-                int int_value = std::stoi(arg->get<std::string>());
-                return std::make_shared<Value>(int_value);
+                int int_value = std::stoi(arg.get<std::string>());
+                return Value(int_value);
             } catch (const std::invalid_argument&) {
                 throwError(ErrorType::Runtime, "Cannot convert Type:String to Type:Integer");
             } catch (const std::out_of_range&) {
@@ -704,65 +725,69 @@ BuiltInFunctionReturn intConverter(const std::vector<std::shared_ptr<Value>>& ar
             }
         }
         case ValueType::Boolean: {
-            bool bool_value = arg->get<bool>();
+            bool bool_value = arg.get<bool>();
             if (bool_value) {
-                return std::make_shared<Value>(1);
+                return Value(1);
             } else {
-                return std::make_shared<Value>(0);
+                return Value(0);
             }
         }
         default:
-            throwError(ErrorType::Runtime, "Unsupported type for int conversion: " + getTypeStr(arg->getType()));
+            throwError(ErrorType::Runtime, "Unsupported type for int conversion: " + getTypeStr(arg.getType()));
     }
 }
 
-BuiltInFunctionReturn length(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn length(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "length() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
     auto value = args[0];
-    ValueType type = value->getType();
+    ValueType type = value.getType();
     if (type == ValueType::String) {
-        return std::make_shared<Value>(static_cast<int>(value->get<std::string>().length()));
+        return Value(static_cast<int>(value.get<std::string>().length()));
     } else if (type == ValueType::List) {
-        return std::make_shared<Value>(static_cast<int>(value->get<std::shared_ptr<List>>()->size()));
+        return Value(static_cast<int>(value.get<std::shared_ptr<List>>()->size()));
     } else if (type == ValueType::Dictionary) {
-        return std::make_shared<Value>(static_cast<int>(value->get<std::shared_ptr<Dictionary>>()->size()));
+        return Value(static_cast<int>(value.get<std::shared_ptr<Dictionary>>()->size()));
+    } else if (type == ValueType::Range) {
+        return Value(value.get<Range>().size());
     } else {
-        throwError(ErrorType::Runtime, "Object of " + getTypeStr(value->getType()) + " has no length");
+        throwError(ErrorType::Runtime, "Object of " + getTypeStr(value.getType()) + " has no length");
     }
     return std::nullopt;
 }
 
-BuiltInFunctionReturn listConverter(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn listConverter(const std::vector<Value>& args, Environment& env) {
     auto list = std::make_shared<List>();
 
     if (args.size() == 0) {
-        return std::make_shared<Value>(std::make_shared<List>());
+        return Value(std::make_shared<List>());
     }
 
     auto arg = args[0];
-    switch (arg->getType()) {
+    switch (arg.getType()) {
         case ValueType::String: {
             // Split string into characters
-            const std::string& str = arg->get<std::string>();
+            const std::string& str = arg.get<std::string>();
             for (char c : str) {
-                list->push_back(std::make_shared<Value>(std::string(1, c)));
+                list->push_back(Value(std::string(1, c)));
             }
             break;
         }
         case ValueType::List: {
-            auto orig_l = arg->get<std::shared_ptr<List>>();
+            auto orig_l = arg.get<std::shared_ptr<List>>();
             for (int i = 0; i < orig_l->size(); i++) {
                 list->push_back(orig_l->at(i));
             }
-            return std::make_shared<Value>(list); // Already a list
+            return Value(list); // Already a list
         }
+        case ValueType::Range:
+            return rangeToList(arg.get<Range>());
         case ValueType::Dictionary: {
-            auto dict = arg->get<std::shared_ptr<Dictionary>>();
-            std::vector<std::shared_ptr<Value>> values;
-            values.push_back(std::make_shared<Value>(dict));
+            auto dict = arg.get<std::shared_ptr<Dictionary>>();
+            std::vector<Value> values;
+            values.push_back(Value(dict));
             return dictKeys(values, env);
         }
         default: {
@@ -772,22 +797,22 @@ BuiltInFunctionReturn listConverter(const std::vector<std::shared_ptr<Value>>& a
             break;
         }
     }
-    return std::make_shared<Value>(list);
+    return Value(list);
 }
 
-BuiltInFunctionReturn locals(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn locals(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 0) {
         throwError(ErrorType::Runtime, "locals() takes 0 arguments. " + std::to_string(args.size()) + " were given");
     }
 
     Dictionary dict;
-    for (const auto& pair : env.getScope().getPairs()) {
-        dict[std::make_shared<Value>(pair.first)] = pair.second;
+    for (const auto& pair : env.getLocalPairs()) {
+        dict[Value(pair.first)] = pair.second;
     }
-    return std::make_shared<Value>(std::make_shared<Dictionary>(dict));
+    return Value(std::make_shared<Dictionary>(dict));
 }
 
-BuiltInFunctionReturn map(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn map(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 2) {
         throwError(ErrorType::Runtime, "map() requires exactly 2 arguments. " + std::to_string(args.size()) + " were given");
     }
@@ -795,34 +820,34 @@ BuiltInFunctionReturn map(const std::vector<std::shared_ptr<Value>>& args, Envir
     auto func = args[0];
     auto list_value = args[1];
 
-    if (func->getType() != ValueType::Function && func->getType() != ValueType::BuiltInFunction) {
-        throwError(ErrorType::Runtime, "map() expected an argument 1 of Type:Function or Type:BuiltInFunction but got " + getTypeStr(func->getType()));
+    if (func.getType() != ValueType::Function && func.getType() != ValueType::BuiltInFunction) {
+        throwError(ErrorType::Runtime, "map() expected an argument 1 of Type:Function or Type:BuiltInFunction but got " + getTypeStr(func.getType()));
     }
 
-    if (list_value->getType() != ValueType::List) {
-        throwError(ErrorType::Runtime, "map() expected an argument 2 of Type:List but got " + getTypeStr(list_value->getType()));
+    if (list_value.getType() != ValueType::List) {
+        throwError(ErrorType::Runtime, "map() expected an argument 2 of Type:List but got " + getTypeStr(list_value.getType()));
     }
 
-    auto list = list_value->get<std::shared_ptr<List>>();
+    auto list = list_value.get<std::shared_ptr<List>>();
     std::shared_ptr<List> result_list = std::make_shared<List>();
 
     for (int i = 0; i < list->size(); i++) {
         const auto& element = list->at(i);
         // Prepare the argument list for the function call
-        std::vector<std::shared_ptr<Value>> func_args = { element };
+        std::vector<Value> func_args = { element };
 
         // Check if the function is a built-in function
-        if (func->getType() == ValueType::BuiltInFunction) {
-            auto built_in_func = func->get<std::shared_ptr<BuiltInFunction>>();
+        if (func.getType() == ValueType::BuiltInFunction) {
+            auto built_in_func = func.get<std::shared_ptr<BuiltInFunction>>();
             auto result = (*built_in_func)(func_args, env);
             if (result) {
                 result_list->push_back(result.value());
             }
-        } else if (func->getType() == ValueType::Function) {
-            auto func_node = std::dynamic_pointer_cast<FuncNode>(func->get<std::shared_ptr<ASTNode>>());
+        } else if (func.getType() == ValueType::Function) {
+            auto func_node = std::dynamic_pointer_cast<FuncNode>(func.get<std::shared_ptr<ASTNode>>());
 
             if (func_node) {
-                auto result = func_node->callFunc(func_args, std::map<std::string, std::shared_ptr<Value>>{}, env);
+                auto result = func_node->callFunc(func_args, std::map<std::string, Value>{}, env);
                 if (result) {
                     result_list->push_back(result.value());
                 }
@@ -832,20 +857,20 @@ BuiltInFunctionReturn map(const std::vector<std::shared_ptr<Value>>& args, Envir
         }
     }
 
-    return std::make_shared<Value>(result_list);
+    return Value(result_list);
 }
 
-BuiltInFunctionReturn max(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn max(const std::vector<Value>& args, Environment& env) {
     if (args.size() == 0) {
         throwError(ErrorType::Runtime, "max() takes 1 or more arguments. 0 were given");
     }
 
     std::shared_ptr<List> list;
     if (args.size() == 1) {
-        if (args[0]->getType() != ValueType::List) {
-            throwError(ErrorType::Runtime, "max() expected an argument of Type:List but got " + getTypeStr(args[0]->getType()));
+        if (args[0].getType() != ValueType::List) {
+            throwError(ErrorType::Runtime, "max() expected an argument of Type:List but got " + getTypeStr(args[0].getType()));
         }
-        list = args[0]->get<std::shared_ptr<List>>();
+        list = args[0].get<std::shared_ptr<List>>();
     } else {
         List arg_list;
         for (const auto& arg : args) {
@@ -857,11 +882,11 @@ BuiltInFunctionReturn max(const std::vector<std::shared_ptr<Value>>& args, Envir
     if (list->empty()) {
         throwError(ErrorType::Runtime, "max() argument is an empty sequence");
     }
-    auto first_type = list->at(0)->getType();
+    auto first_type = list->at(0).getType();
 
     // Ensure all elements are comparable
     for (const auto& item : list->getElements()) {
-        auto item_type = item->getType();
+        auto item_type = item.getType();
         if (!(item_type == first_type || 
               (item_type == ValueType::Integer && first_type == ValueType::Float) || 
               (item_type == ValueType::Float && first_type == ValueType::Integer))) {
@@ -877,30 +902,30 @@ BuiltInFunctionReturn max(const std::vector<std::shared_ptr<Value>>& args, Envir
 
         if (first_type == ValueType::Integer || first_type == ValueType::Float) {
             // Convert to double for comparison if mixing Integer and Float
-            double current_value = (current->getType() == ValueType::Integer) 
-                                   ? static_cast<double>(current->get<int>()) 
-                                   : current->get<double>();
+            double current_value = (current.getType() == ValueType::Integer) 
+                                   ? static_cast<double>(current.get<int>()) 
+                                   : current.get<double>();
 
-            double max_value_num = (max_value->getType() == ValueType::Integer) 
-                                   ? static_cast<double>(max_value->get<int>()) 
-                                   : max_value->get<double>();
+            double max_value_num = (max_value.getType() == ValueType::Integer) 
+                                   ? static_cast<double>(max_value.get<int>()) 
+                                   : max_value.get<double>();
 
             if (current_value > max_value_num) {
                 max_index = i;
             }
         } else if (first_type == ValueType::String) {
-            if (current->get<std::string>() > max_value->get<std::string>()) {
+            if (current.get<std::string>() > max_value.get<std::string>()) {
                 max_index = i;
             }
         } else if (first_type == ValueType::List) {
-            int current_size = current->get<std::shared_ptr<List>>()->size();
-            int max_size = max_value->get<std::shared_ptr<List>>()->size();
+            int current_size = current.get<std::shared_ptr<List>>()->size();
+            int max_size = max_value.get<std::shared_ptr<List>>()->size();
             if (current_size > max_size) {
                 max_index = i;
             }
         } else if (first_type == ValueType::Dictionary) {
-            int current_size = current->get<std::shared_ptr<Dictionary>>()->size();
-            int max_size = max_value->get<std::shared_ptr<Dictionary>>()->size();
+            int current_size = current.get<std::shared_ptr<Dictionary>>()->size();
+            int max_size = max_value.get<std::shared_ptr<Dictionary>>()->size();
             if (current_size > max_size) {
                 max_index = i;
             }
@@ -910,17 +935,67 @@ BuiltInFunctionReturn max(const std::vector<std::shared_ptr<Value>>& args, Envir
     return list->at(max_index);
 }
 
-BuiltInFunctionReturn min(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn memStats(const std::vector<Value>& args, Environment& env) {
+    if (args.size() != 0) {
+        throwError(ErrorType::Runtime, "memStats() takes 0 arguments. " + std::to_string(args.size()) + " were given");
+    }
+    if (inParallelTask()) {
+        // Measuring walks every container, including ones other tasks are changing
+        throwError(ErrorType::Runtime, "memStats() cannot be called inside a parallel task");
+    }
+
+    auto entry = [](const MemoryCount& memory) {
+        auto dict = std::make_shared<Dictionary>();
+        (*dict)[Value(std::string("count"))] = Value(static_cast<int>(memory.count));
+        (*dict)[Value(std::string("bytes"))] = Value(static_cast<int>(memory.bytes));
+        (*dict)[Value(std::string("peakCount"))] = Value(static_cast<int>(memory.peak_count));
+        (*dict)[Value(std::string("peakBytes"))] = Value(static_cast<int>(memory.peak_bytes));
+        return Value(dict);
+    };
+
+    // Containers grow after they're created, so their bytes are measured now
+    const GCStats& gc_stats = getGCStats();
+    std::array<MemoryCount, GC_KIND_COUNT> by_kind = gc_stats.by_kind;
+    forEachTrackedObject([&](const GCObject& object) {
+        by_kind[static_cast<size_t>(object.getKind())].bytes += object.memoryUsage();
+    });
+    std::array<size_t, GC_KIND_COUNT>& peak_bytes = activeRuntime().peak_container_bytes;
+    for (size_t i = 0; i < GC_KIND_COUNT; i++) {
+        peak_bytes[i] = std::max(peak_bytes[i], by_kind[i].bytes);
+        by_kind[i].peak_bytes = peak_bytes[i];
+    }
+
+    auto stats = std::make_shared<Dictionary>();
+    const MemoryCounts& values = activeRuntime().memory;
+    (*stats)[Value(std::string("Value"))] = entry(values.total);
+    (*stats)[Value(std::string("String"))] = entry(values.by_type[static_cast<size_t>(ValueType::String)]);
+    const std::pair<std::string, GCKind> kinds[] = {
+        {"List", GCKind::List}, {"Dictionary", GCKind::Dictionary}, {"Function", GCKind::Function},
+        {"Class", GCKind::Class}, {"Instance", GCKind::Instance}, {"Environment", GCKind::Environment}
+    };
+    for (const auto& [name, kind] : kinds) {
+        (*stats)[Value(name)] = entry(by_kind[static_cast<size_t>(kind)]);
+    }
+
+    auto gc = std::make_shared<Dictionary>();
+    (*gc)[Value(std::string("collections"))] = Value(static_cast<int>(gc_stats.collections));
+    (*gc)[Value(std::string("tracked"))] = Value(static_cast<int>(gc_stats.tracked));
+    (*gc)[Value(std::string("freed"))] = Value(static_cast<int>(gc_stats.freed));
+    (*stats)[Value(std::string("gc"))] = Value(gc);
+    return Value(stats);
+}
+
+BuiltInFunctionReturn min(const std::vector<Value>& args, Environment& env) {
     if (args.size() == 0) {
         throwError(ErrorType::Runtime, "min() takes 1 or more arguments. 0 were given");
     }
 
     std::shared_ptr<List> list;
     if (args.size() == 1) {
-        if (args[0]->getType() != ValueType::List) {
-            throwError(ErrorType::Runtime, "min() expected an argument of Type:List but got " + getTypeStr(args[0]->getType()));
+        if (args[0].getType() != ValueType::List) {
+            throwError(ErrorType::Runtime, "min() expected an argument of Type:List but got " + getTypeStr(args[0].getType()));
         }
-        list = args[0]->get<std::shared_ptr<List>>();
+        list = args[0].get<std::shared_ptr<List>>();
     } else {
         List arg_list;
         for (const auto& arg : args) {
@@ -932,11 +1007,11 @@ BuiltInFunctionReturn min(const std::vector<std::shared_ptr<Value>>& args, Envir
     if (list->empty()) {
         throwError(ErrorType::Runtime, "min() argument is an empty sequence");
     }
-    auto first_type = list->at(0)->getType();
+    auto first_type = list->at(0).getType();
 
     // Ensure all elements are comparable
     for (const auto& item : list->getElements()) {
-        auto item_type = item->getType();
+        auto item_type = item.getType();
         if (!(item_type == first_type || 
               (item_type == ValueType::Integer && first_type == ValueType::Float) || 
               (item_type == ValueType::Float && first_type == ValueType::Integer))) {
@@ -952,30 +1027,30 @@ BuiltInFunctionReturn min(const std::vector<std::shared_ptr<Value>>& args, Envir
 
         if (first_type == ValueType::Integer || first_type == ValueType::Float) {
             // Convert to double for comparison if mixing Integer and Float
-            double current_value = (current->getType() == ValueType::Integer) 
-                                   ? static_cast<double>(current->get<int>()) 
-                                   : current->get<double>();
+            double current_value = (current.getType() == ValueType::Integer) 
+                                   ? static_cast<double>(current.get<int>()) 
+                                   : current.get<double>();
 
-            double max_value_num = (max_value->getType() == ValueType::Integer) 
-                                   ? static_cast<double>(max_value->get<int>()) 
-                                   : max_value->get<double>();
+            double max_value_num = (max_value.getType() == ValueType::Integer) 
+                                   ? static_cast<double>(max_value.get<int>()) 
+                                   : max_value.get<double>();
 
             if (current_value < max_value_num) {
                 min_index = i;
             }
         } else if (first_type == ValueType::String) {
-            if (current->get<std::string>() < max_value->get<std::string>()) {
+            if (current.get<std::string>() < max_value.get<std::string>()) {
                 min_index = i;
             }
         } else if (first_type == ValueType::List) {
-            int current_size = current->get<std::shared_ptr<List>>()->size();
-            int max_size = max_value->get<std::shared_ptr<List>>()->size();
+            int current_size = current.get<std::shared_ptr<List>>()->size();
+            int max_size = max_value.get<std::shared_ptr<List>>()->size();
             if (current_size < max_size) {
                 min_index = i;
             }
         } else if (first_type == ValueType::Dictionary) {
-            int current_size = current->get<std::shared_ptr<Dictionary>>()->size();
-            int max_size = max_value->get<std::shared_ptr<Dictionary>>()->size();
+            int current_size = current.get<std::shared_ptr<Dictionary>>()->size();
+            int max_size = max_value.get<std::shared_ptr<Dictionary>>()->size();
             if (current_size < max_size) {
                 min_index = i;
             }
@@ -985,7 +1060,80 @@ BuiltInFunctionReturn min(const std::vector<std::shared_ptr<Value>>& args, Envir
     return list->at(min_index);
 }
 
-BuiltInFunctionReturn print(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn pmap(const std::vector<Value>& args, Environment& env) {
+    if (args.size() != 2 && args.size() != 3) {
+        throwError(ErrorType::Runtime, "pmap() takes 2 or 3 arguments. " + std::to_string(args.size()) + " were given");
+    }
+
+    auto func = args[0];
+    auto list_value = args[1];
+
+    if (func.getType() != ValueType::Function && func.getType() != ValueType::BuiltInFunction) {
+        throwError(ErrorType::Runtime, "pmap() expected an argument 1 of Type:Function or Type:BuiltInFunction but got " + getTypeStr(func.getType()));
+    }
+    if (list_value.getType() != ValueType::List) {
+        throwError(ErrorType::Runtime, "pmap() expected an argument 2 of Type:List but got " + getTypeStr(list_value.getType()));
+    }
+
+    std::shared_ptr<FuncNode> func_node;
+    std::shared_ptr<BuiltInFunction> built_in_func;
+    if (func.getType() == ValueType::Function) {
+        func_node = std::dynamic_pointer_cast<FuncNode>(func.get<std::shared_ptr<ASTNode>>());
+        if (!func_node) {
+            throwError(ErrorType::Runtime, "pmap() argument 1 must be a callable function");
+        }
+    } else {
+        built_in_func = func.get<std::shared_ptr<BuiltInFunction>>();
+    }
+
+    // The tasks work on a copy, so the list can't change size under them
+    std::vector<Value> elements = list_value.get<std::shared_ptr<List>>()->getElements();
+    size_t chunk_size;
+    if (args.size() == 3) {
+        if (args[2].getType() != ValueType::Integer || args[2].get<int>() < 1) {
+            throwError(ErrorType::Runtime, "pmap() expected an argument 3 of a positive Type:Int but got " + args[2].getPrintable());
+        }
+        chunk_size = args[2].get<int>();
+    } else {
+        // A few chunks per thread lets threads that finish early take work from slower ones
+        size_t chunk_count = parallelThreadCount() * 4;
+        chunk_size = std::max<size_t>(1, (elements.size() + chunk_count - 1) / chunk_count);
+    }
+    size_t chunk_count = (elements.size() + chunk_size - 1) / chunk_size;
+
+    // Tasks report errors from the caller's file and function, whichever thread runs them
+    ExecutionContextSnapshot context = captureExecutionContext();
+    std::vector<std::optional<Value>> results(elements.size());
+    parallelFor(chunk_count, [&](size_t chunk) {
+        ExecutionContextScope context_scope{context};
+        Environment task_env{env};
+        size_t end = std::min(elements.size(), (chunk + 1) * chunk_size);
+        for (size_t i = chunk * chunk_size; i < end; i++) {
+            std::vector<Value> func_args = { elements[i] };
+            if (func_node) {
+                results[i] = func_node->callFunc(func_args, std::map<std::string, Value>{}, task_env);
+            } else {
+                results[i] = (*built_in_func)(func_args, task_env);
+            }
+        }
+    });
+
+    std::shared_ptr<List> result_list = std::make_shared<List>();
+    for (auto& result : results) {
+        if (result) {
+            result_list->push_back(std::move(*result));
+        }
+    }
+    return Value(result_list);
+}
+
+BuiltInFunctionReturn print(const std::vector<Value>& args, Environment& env) {
+    // Keeps the lines tasks print whole
+    static std::mutex print_mutex;
+    std::unique_lock lock{print_mutex, std::defer_lock};
+    if (THREADS_ACTIVE.load(std::memory_order_relaxed)) {
+        lock.lock();
+    }
     for (const auto& arg : args) {
         printValue(arg);
         std::cout << " ";
@@ -994,16 +1142,16 @@ BuiltInFunctionReturn print(const std::vector<std::shared_ptr<Value>>& args, Env
     return std::nullopt;
 }
 
-BuiltInFunctionReturn randChoice(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn randChoice(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "randChoice() takes exactly 1 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    if (args[0]->getType() != ValueType::List) {
-        throwError(ErrorType::Runtime, "randChoice() expected an argument 1 of Type:List but got " + getTypeStr(args[0]->getType()));
+    if (args[0].getType() != ValueType::List) {
+        throwError(ErrorType::Runtime, "randChoice() expected an argument 1 of Type:List but got " + getTypeStr(args[0].getType()));
     }
 
-    auto list = args[0]->get<std::shared_ptr<List>>();
+    auto list = args[0].get<std::shared_ptr<List>>();
 
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -1013,84 +1161,73 @@ BuiltInFunctionReturn randChoice(const std::vector<std::shared_ptr<Value>>& args
     return list->at(index);
 }
 
-BuiltInFunctionReturn randInt(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn randInt(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 2) {
         throwError(ErrorType::Runtime, "randInt() takes exactly 2 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    if (args[0]->getType() != ValueType::Integer) {
-        throwError(ErrorType::Runtime, "randInt() expected an argument 1 of Type:Integer but got " + getTypeStr(args[0]->getType()));
+    if (args[0].getType() != ValueType::Integer) {
+        throwError(ErrorType::Runtime, "randInt() expected an argument 1 of Type:Integer but got " + getTypeStr(args[0].getType()));
     }
-    if (args[1]->getType() != ValueType::Integer) {
-        throwError(ErrorType::Runtime, "randInt() expected an argument 2 of Type:Integer but got " + getTypeStr(args[1]->getType()));
+    if (args[1].getType() != ValueType::Integer) {
+        throwError(ErrorType::Runtime, "randInt() expected an argument 2 of Type:Integer but got " + getTypeStr(args[1].getType()));
     }
 
-    int min = args[0]->get<int>();
-    int max = args[1]->get<int>();
+    int min = args[0].get<int>();
+    int max = args[1].get<int>();
 
     std::random_device rd;
     std::mt19937 gen(rd());
     std::uniform_int_distribution<> dist(min, max);
 
-    return std::make_shared<Value>(dist(gen));
+    return Value(dist(gen));
 }
 
-BuiltInFunctionReturn range(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn range(const std::vector<Value>& args, Environment& env) {
     if (args.size() < 1 || args.size() > 3) {
         throwError(ErrorType::Runtime, "range() takes 1-3 arguments. " + std::to_string(args.size()) + " were given");
     }
 
     for (int i = 0; i < args.size(); i++) {
-        if (args[i]->getType() != ValueType::Integer) {
-            throwError(ErrorType::Runtime, "range() expected an argument " + std::to_string(i) + " of Type:Integer but got " + getTypeStr(args[i]->getType()));
+        if (args[i].getType() != ValueType::Integer) {
+            throwError(ErrorType::Runtime, "range() expected an argument " + std::to_string(i) + " of Type:Integer but got " + getTypeStr(args[i].getType()));
         }
     }
 
     int start, end, step;
 
     if (args.size() == 1) {
-        end = args[0]->get<int>();
+        end = args[0].get<int>();
         start = 0;
         step = 1;
     } else if (args.size() == 2) {
-        start = args[0]->get<int>();
-        end = args[1]->get<int>();
+        start = args[0].get<int>();
+        end = args[1].get<int>();
         step = 1;
     } else if (args.size() == 3) {
-        start = args[0]->get<int>();
-        end = args[1]->get<int>();
-        step = args[2]->get<int>();
+        start = args[0].get<int>();
+        end = args[1].get<int>();
+        step = args[2].get<int>();
         if (step == 0) {
             throwError(ErrorType::Runtime, "range() does not allow argument 3 to be zero");
         }
     }
 
-    std::shared_ptr<List> nums = std::make_shared<List>();
-    if (step < 0) {
-        for (int i = start; i > end; i += step) {
-            nums->push_back(std::make_shared<Value>(i));
-        }
-    } else {
-        for (int i = start; i < end; i += step) {
-            nums->push_back(std::make_shared<Value>(i));
-        }
-    }
-
-    return std::make_shared<Value>(nums);
+    return Value(Range{start, end, step});
 }
 
-BuiltInFunctionReturn readFile(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn readFile(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "read() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    if (args[0]->getType() != ValueType::String) {
-        throwError(ErrorType::Runtime, "read() expected an argument of Type:String but got " + getTypeStr(args[0]->getType()));
+    if (args[0].getType() != ValueType::String) {
+        throwError(ErrorType::Runtime, "read() expected an argument of Type:String but got " + getTypeStr(args[0].getType()));
     }
 
     std::string new_path;
 
-    std::string file_path = args[0]->get<std::string>();
+    std::string file_path = args[0].get<std::string>();
     if (!std::filesystem::path(file_path).is_absolute()) {
         std::string path = currentExecutionContext();
         new_path = path.substr(0, path.find_last_of('/')) + "/" + file_path;
@@ -1100,65 +1237,115 @@ BuiltInFunctionReturn readFile(const std::vector<std::shared_ptr<Value>>& args,
 
     std::ifstream file(new_path);
     if (!file) {
-        return std::make_shared<Value>();
+        return Value::none();
     }
 
     std::stringstream buffer;
     buffer << file.rdbuf();
     file.close();
 
-    return std::make_shared<Value>(buffer.str());
+    return Value(buffer.str());
 }
 
-BuiltInFunctionReturn reversed(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn reversed(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "reversed() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    if (args[0]->getType() != ValueType::List) {
-        throwError(ErrorType::Runtime, "reversed() expected an argument of Type:List but got " + getTypeStr(args[0]->getType()));
+    if (args[0].getType() != ValueType::List) {
+        throwError(ErrorType::Runtime, "reversed() expected an argument of Type:List but got " + getTypeStr(args[0].getType()));
     }
 
-    auto list = args[0]->get<std::shared_ptr<List>>();
+    auto list = args[0].get<std::shared_ptr<List>>();
     List new_list;
 
     for (auto item : list->getElements()) {
         new_list.insert(0, item);
     }
 
-    return std::make_shared<Value>(std::make_shared<List>(new_list));
+    return Value(std::make_shared<List>(new_list));
 }
 
-BuiltInFunctionReturn roundVal(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn roundVal(const std::vector<Value>& args, Environment& env) {
     if (args.size() < 1 || args.size() > 2) {
         throwError(ErrorType::Runtime, "round() takes 1-2 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    if (args[0]->getType() != ValueType::Integer && args[0]->getType() != ValueType::Float) {
-        throwError(ErrorType::Runtime, "round() expected an argument 1 of Type:Integer or Type:Float but got " + getTypeStr(args[0]->getType()));
+    if (args[0].getType() != ValueType::Integer && args[0].getType() != ValueType::Float) {
+        throwError(ErrorType::Runtime, "round() expected an argument 1 of Type:Integer or Type:Float but got " + getTypeStr(args[0].getType()));
     }
 
     int precision = 0; // Default precision
     if (args.size() == 2) {
-        if (args[1]->getType() != ValueType::Integer) {
-            throwError(ErrorType::Runtime, "round() expected an argument 2 of Type:Integer but got " + getTypeStr(args[1]->getType()));
+        if (args[1].getType() != ValueType::Integer) {
+            throwError(ErrorType::Runtime, "round() expected an argument 2 of Type:Integer but got " + getTypeStr(args[1].getType()));
         }
-        precision = args[1]->get<int>();
+        precision = args[1].get<int>();
     }
 
-    if (args[0]->getType() == ValueType::Integer) {
-        int num = args[0]->get<int>();
+    if (args[0].getType() == ValueType::Integer) {
+        int num = args[0].get<int>();
         if (precision > 0) {
             throwError(ErrorType::Runtime, "round() cannot apply precision to an integer");
         }
-        return std::make_shared<Value>(num); // Integers do not require rounding
+        return Value(num); // Integers do not require rounding
     }
 
-    double num = args[0]->get<double>();
+    double num = args[0].get<double>();
     double factor = std::pow(10.0, precision);
     num = std::round(num * factor) / factor;
 
-    return std::make_shared<Value>(num);
+    return Value(num);
+}
+
+BuiltInFunctionReturn spawn(const std::vector<Value>& args, Environment& env) {
+    if (args.empty()) {
+        throwError(ErrorType::Runtime, "spawn() takes 1 or more arguments. 0 were given");
+    }
+
+    auto func = args[0];
+    std::shared_ptr<FuncNode> func_node;
+    std::shared_ptr<BuiltInFunction> built_in_func;
+    if (func.getType() == ValueType::Function) {
+        func_node = std::dynamic_pointer_cast<FuncNode>(func.get<std::shared_ptr<ASTNode>>());
+        if (!func_node) {
+            throwError(ErrorType::Runtime, "spawn() argument 1 must be a callable function");
+        }
+    } else if (func.getType() == ValueType::BuiltInFunction) {
+        built_in_func = func.get<std::shared_ptr<BuiltInFunction>>();
+    } else {
+        throwError(ErrorType::Runtime, "spawn() expected an argument 1 of Type:Function or Type:BuiltInFunction but got " + getTypeStr(func.getType()));
+    }
+
+    std::vector<Value> func_args(args.begin() + 1, args.end());
+    // The task reads the globals as they are now, assignments the program makes after don't reach it
+    auto task_env = std::make_shared<Environment>(env);
+    task_env->copyGlobals();
+    auto future = std::make_shared<Future>();
+    ExecutionContextSnapshot context = captureExecutionContext();
+    try {
+        startThread([func_node, built_in_func, func_args = std::move(func_args), task_env, future, context] {
+            ExecutionContextScope context_scope{context};
+            std::optional<Value> result;
+            std::exception_ptr error;
+            try {
+                if (func_node) {
+                    result = func_node->callFunc(func_args, std::map<std::string, Value>{}, *task_env);
+                } else {
+                    result = (*built_in_func)(func_args, *task_env);
+                }
+            }
+            catch (...) {
+                // Raised again by join()
+                error = std::current_exception();
+            }
+            future->finish(std::move(result), error);
+        });
+    }
+    catch (const std::system_error&) {
+        throwError(ErrorType::Runtime, "spawn() could not start a thread");
+    }
+    return Value(future);
 }
 
 std::string toString(double value){
@@ -1167,46 +1354,46 @@ std::string toString(double value){
     return oss.str();
 }
 
-BuiltInFunctionReturn stringConverter(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringConverter(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "string() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
     auto arg = args[0];
 
-    switch (arg->getType()) {
+    switch (arg.getType()) {
         case ValueType::String:
             return arg; // Already a string
         case ValueType::Integer:
-            return std::make_shared<Value>(std::to_string(arg->get<int>()));
+            return Value(std::to_string(arg.get<int>()));
         case ValueType::Float: {
             std::stringstream ss;
-            ss << arg->get<double>();
-            return std::make_shared<Value>(ss.str());
+            ss << arg.get<double>();
+            return Value(ss.str());
         }
         case ValueType::Boolean: {
-            auto result = std::make_shared<Value>(std::string(arg->get<bool>() ? "true" : "false"));
+            auto result = Value(std::string(arg.get<bool>() ? "true" : "false"));
             return result;
         }
         case ValueType::List: {
-            std::shared_ptr<List> list = arg->get<std::shared_ptr<List>>();
+            std::shared_ptr<List> list = arg.get<std::shared_ptr<List>>();
             std::string result = "[";
             for (size_t i = 0; i < list->size(); ++i) {
                 auto str_return = stringConverter({list->at(i)}, env).value();
-                if (list->at(i)->getType() == ValueType::String) {
-                    result += '"' + str_return->get<std::string>() + '"';
+                if (list->at(i).getType() == ValueType::String) {
+                    result += '"' + str_return.get<std::string>() + '"';
                 } else {
-                    result += str_return->get<std::string>();
+                    result += str_return.get<std::string>();
                 }
                 if (i < list->size() - 1) {
                     result += ", ";
                 }
             }
             result += "]";
-            return std::make_shared<Value>(result);
+            return Value(result);
         }
         case ValueType::Dictionary: {
-            auto dict = arg->get<std::shared_ptr<Dictionary>>();
+            auto dict = arg.get<std::shared_ptr<Dictionary>>();
             std::string result = "{";
             bool first = true;
             for (const auto& pair : *dict) {
@@ -1217,75 +1404,77 @@ BuiltInFunctionReturn stringConverter(const std::vector<std::shared_ptr<Value>>&
                 auto key_str = stringConverter({pair.first}, env).value();
                 auto value_str = stringConverter({pair.second}, env).value();
                 std::string key_representation;
-                if (pair.first->getType() == ValueType::String) {
-                    key_representation = '"' + key_str->get<std::string>() + '"';
+                if (pair.first.getType() == ValueType::String) {
+                    key_representation = '"' + key_str.get<std::string>() + '"';
                 } else {
-                    key_representation = key_str->get<std::string>();
+                    key_representation = key_str.get<std::string>();
                 }
 
                 std::string value_representation;
-                if (pair.second->getType() == ValueType::String) {
-                    value_representation = '"' + value_str->get<std::string>() + '"';
+                if (pair.second.getType() == ValueType::String) {
+                    value_representation = '"' + value_str.get<std::string>() + '"';
                 } else {
-                    value_representation = value_str->get<std::string>();
+                    value_representation = value_str.get<std::string>();
                 }
 
                 result += key_representation + ": " + value_representation;
             }
             result += "}";
-            return std::make_shared<Value>(result);
+            return Value(result);
         }
+        case ValueType::Range:
+            return Value(getRangeStr(arg.get<Range>()));
         default:
             throwError(ErrorType::Runtime, "Unsupported type for string conversion");
     }
 }
 
-BuiltInFunctionReturn sum(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn sum(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "sum() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    if (args[0]->getType() != ValueType::List) {
-        throwError(ErrorType::Runtime, "sum() expected an argument of Type:List but got " + getTypeStr(args[0]->getType()));
+    if (args[0].getType() != ValueType::List) {
+        throwError(ErrorType::Runtime, "sum() expected an argument of Type:List but got " + getTypeStr(args[0].getType()));
     }
 
-    auto list = args[0]->get<std::shared_ptr<List>>();
+    auto list = args[0].get<std::shared_ptr<List>>();
     bool not_ints = false;
     double summation = 0.0;
     for (auto num : list->getElements()) {
-        if (num->getType() == ValueType::Integer) {
-            double cast = static_cast<double>(num->get<int>());
+        if (num.getType() == ValueType::Integer) {
+            double cast = static_cast<double>(num.get<int>());
             summation += cast;
-        } else if (num->getType() == ValueType::Float) {
+        } else if (num.getType() == ValueType::Float) {
             not_ints = true;
-            summation += num->get<double>();
+            summation += num.get<double>();
         } else {
-            throwError(ErrorType::Runtime, "Unsupported operation: Type:Float '+' " + getTypeStr(num->getType()));
+            throwError(ErrorType::Runtime, "Unsupported operation: Type:Float '+' " + getTypeStr(num.getType()));
         }
     }
 
     if (not_ints) {
-        return std::make_shared<Value>(summation);
+        return Value(summation);
     } else {
-        return std::make_shared<Value>(static_cast<int>(summation));
+        return Value(static_cast<int>(summation));
     }
 }
 
-BuiltInFunctionReturn writeFile(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn writeFile(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 2) {
         throwError(ErrorType::Runtime, "writeFile() takes exactly 2 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    if (args[0]->getType() != ValueType::String) {
-        throwError(ErrorType::Runtime, "writeFile() expected an argument 1 of Type:String but got " + getTypeStr(args[0]->getType()));
+    if (args[0].getType() != ValueType::String) {
+        throwError(ErrorType::Runtime, "writeFile() expected an argument 1 of Type:String but got " + getTypeStr(args[0].getType()));
     }
-    if (args[1]->getType() != ValueType::String) {
-        throwError(ErrorType::Runtime, "writeFile() expected an argument 2 of Type:String but got " + getTypeStr(args[1]->getType()));
+    if (args[1].getType() != ValueType::String) {
+        throwError(ErrorType::Runtime, "writeFile() expected an argument 2 of Type:String but got " + getTypeStr(args[1].getType()));
     }
 
     std::string new_path;
-    std::string file_path = args[0]->get<std::string>();
-    std::string content = args[1]->get<std::string>();
+    std::string file_path = args[0].get<std::string>();
+    std::string content = args[1].get<std::string>();
 
     if (!std::filesystem::path(file_path).is_absolute()) {
         std::string path = currentExecutionContext(); // Fetch base execution context
@@ -1302,22 +1491,22 @@ BuiltInFunctionReturn writeFile(const std::vector<std::shared_ptr<Value>>& args,
     file << content;
     file.close();
 
-    return std::make_shared<Value>();
+    return Value::none();
 }
 
-BuiltInFunctionReturn zip(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn zip(const std::vector<Value>& args, Environment& env) {
     if (args.size() < 2) {
         throwError(ErrorType::Runtime, "input() takes 2 or more arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    int min_size = args[0]->get<std::shared_ptr<List>>()->size();
+    int min_size = args[0].get<std::shared_ptr<List>>()->size();
 
     int i = 0;
     for (auto arg : args) {
-        if (arg->getType() != ValueType::List) {
-            throwError(ErrorType::Runtime, "zip() expected an argument " + std::to_string(i) + " of Type:List but got " + getTypeStr(arg->getType()));
+        if (arg.getType() != ValueType::List) {
+            throwError(ErrorType::Runtime, "zip() expected an argument " + std::to_string(i) + " of Type:List but got " + getTypeStr(arg.getType()));
         }
-        int size = arg->get<std::shared_ptr<List>>()->size();
+        int size = arg.get<std::shared_ptr<List>>()->size();
         if (size < min_size) {
             min_size = size;
         }
@@ -1328,82 +1517,82 @@ BuiltInFunctionReturn zip(const std::vector<std::shared_ptr<Value>>& args, Envir
     for (int i = 0; i < min_size; i++) {
         std::shared_ptr<List> group = std::make_shared<List>();
         for (auto arg : args) {
-            group->push_back(arg->get<std::shared_ptr<List>>()->at(i));
+            group->push_back(arg.get<std::shared_ptr<List>>()->at(i));
         }
-        result->push_back(std::make_shared<Value>(group));
+        result->push_back(Value(group));
     }
-    return std::make_shared<Value>(result);
+    return Value(result);
 }
 
 
 ///  TYPE MEMBER FUNCTIONS  ///
 
 
-BuiltInFunctionReturn floatIsInt(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn floatIsInt(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "isInt() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    double num = args[0]->get<double>();
+    double num = args[0].get<double>();
     if (num == static_cast<int>(num)) {
-        return std::make_shared<Value>(true);
+        return Value(true);
     } else {
-        return std::make_shared<Value>(false);
+        return Value(false);
     }
 }
 
 
-BuiltInFunctionReturn listAppend(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn listAppend(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 2) {
         throwError(ErrorType::Runtime, "append() takes exactly 2 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    auto list = args.at(0)->get<std::shared_ptr<List>>();
+    auto list = args.at(0).get<std::shared_ptr<List>>();
     list->push_back(args[1]);
 
-    return std::make_shared<Value>();
+    return Value::none();
 }
 
 
-BuiltInFunctionReturn listClear(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn listClear(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "clear() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    auto list = args[0]->get<std::shared_ptr<List>>();
+    auto list = args[0].get<std::shared_ptr<List>>();
     list->clear();
-    return std::make_shared<Value>();
+    return Value::none();
 }
 
-BuiltInFunctionReturn listCopy(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn listCopy(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "copy() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    auto list = args[0]->get<std::shared_ptr<List>>();
-    return std::make_shared<Value>(std::make_shared<List>(list->getElements()));
+    auto list = args[0].get<std::shared_ptr<List>>();
+    return Value(std::make_shared<List>(list->getElements()));
 }
 
-BuiltInFunctionReturn listIndex(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn listIndex(const std::vector<Value>& args, Environment& env) {
     if (args.size() < 2 || args.size() > 4) {
         throwError(ErrorType::Runtime, "index() takes 2-4 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    auto list = args[0]->get<std::shared_ptr<List>>();
+    auto list = args[0].get<std::shared_ptr<List>>();
     auto value = args[1];
     auto start = 0;
     auto end = list->size();
     if (args.size() >= 3) {
-        if (args[2]->getType() != ValueType::Integer) {
-            throwError(ErrorType::Runtime, "index() expected an argument 2 of Type:Integer but got " + getTypeStr(args[2]->getType()));
+        if (args[2].getType() != ValueType::Integer) {
+            throwError(ErrorType::Runtime, "index() expected an argument 2 of Type:Integer but got " + getTypeStr(args[2].getType()));
         }
-        start = args[2]->get<int>();
+        start = args[2].get<int>();
     }
     if (args.size() == 4) {
-        if (args[3]->getType() != ValueType::Integer) {
-            throwError(ErrorType::Runtime, "index() expected an argument 3 of Type:Integer but got " + getTypeStr(args[3]->getType()));
+        if (args[3].getType() != ValueType::Integer) {
+            throwError(ErrorType::Runtime, "index() expected an argument 3 of Type:Integer but got " + getTypeStr(args[3].getType()));
         }
-        end = args[3]->get<int>();
+        end = args[3].get<int>();
     }
 
     if (start < 0) {
@@ -1423,26 +1612,26 @@ BuiltInFunctionReturn listIndex(const std::vector<std::shared_ptr<Value>>& args,
     }
 
     int index = list->index(value, start, end);
-    return std::make_shared<Value>(index);
+    return Value(index);
 }
 
-BuiltInFunctionReturn listInsert(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn listInsert(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 3) {
         throwError(ErrorType::Runtime, "insert() takes exactly 3 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    auto list = args[0]->get<std::shared_ptr<List>>();
-    if (args[1]->getType() != ValueType::Integer) {
-        throwError(ErrorType::Runtime, "insert() expected an argument 1 of Type:Integer but got " + getTypeStr(args[1]->getType()));
+    auto list = args[0].get<std::shared_ptr<List>>();
+    if (args[1].getType() != ValueType::Integer) {
+        throwError(ErrorType::Runtime, "insert() expected an argument 1 of Type:Integer but got " + getTypeStr(args[1].getType()));
     }
-    auto index = args[1]->get<int>();
+    auto index = args[1].get<int>();
     auto value = args[2];
 
     list->insert(index, value);
-    return std::make_shared<Value>();
+    return Value::none();
 }
 
-BuiltInFunctionReturn listPop(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn listPop(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1 && args.size() != 2) {
         throwError(ErrorType::Runtime, "pop() takes 1-2 argument. " + std::to_string(args.size()) + " were given");
     }
@@ -1451,13 +1640,13 @@ BuiltInFunctionReturn listPop(const std::vector<std::shared_ptr<Value>>& args, E
     if (args.size() == 1) {
         index = -1;
     } else {
-        if (args[1]->getType() != ValueType::Integer) {
+        if (args[1].getType() != ValueType::Integer) {
             throwError(ErrorType::Runtime, "pop() expected an argument of Type:Integer but got " + getValueStr(args[1]));
         }
-        index = args[1]->get<int>();
+        index = args[1].get<int>();
     }
 
-    auto list = args[0]->get<std::shared_ptr<List>>();
+    auto list = args[0].get<std::shared_ptr<List>>();
     int size = list->size();
 
     if (index >= size || index < size * -1) {
@@ -1467,73 +1656,73 @@ BuiltInFunctionReturn listPop(const std::vector<std::shared_ptr<Value>>& args, E
     }
 }
 
-BuiltInFunctionReturn listRemove(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn listRemove(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 2) {
         throwError(ErrorType::Runtime, "remove() takes exactly 2 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    auto list = args[0]->get<std::shared_ptr<List>>();
+    auto list = args[0].get<std::shared_ptr<List>>();
     auto value = args[1];
 
     
     list->erase(value);
-    return std::make_shared<Value>();
+    return Value::none();
 }
 
-BuiltInFunctionReturn listSize(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn listSize(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "size() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    auto list = args[0]->get<std::shared_ptr<List>>();
+    auto list = args[0].get<std::shared_ptr<List>>();
     int size = list->size();
-    return std::make_shared<Value>(size);
+    return Value(size);
 }
 
 
-BuiltInFunctionReturn dictClear(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn dictClear(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "clear() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    auto dict = args[0]->get<std::shared_ptr<Dictionary>>();
+    auto dict = args[0].get<std::shared_ptr<Dictionary>>();
     dict->clear();
-    return std::make_shared<Value>();
+    return Value::none();
 }
 
-BuiltInFunctionReturn dictCopy(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn dictCopy(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "clear() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    auto dict = args[0]->get<std::shared_ptr<Dictionary>>();
+    auto dict = args[0].get<std::shared_ptr<Dictionary>>();
     Dictionary copy{*dict};
-    return std::make_shared<Value>(std::make_shared<Dictionary>(copy));
+    return Value(std::make_shared<Dictionary>(copy));
 }
 
-BuiltInFunctionReturn dictValues(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn dictValues(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "values() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    auto dict = args[0]->get<std::shared_ptr<Dictionary>>();
+    auto dict = args[0].get<std::shared_ptr<Dictionary>>();
     auto result = std::make_shared<List>();
 
     for (const auto& pair : *dict) {
         result->push_back(pair.second);
     }
 
-    return std::make_shared<Value>(result);
+    return Value(result);
 }
 
-BuiltInFunctionReturn dictGet(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn dictGet(const std::vector<Value>& args, Environment& env) {
     if (args.size() < 2 || args.size() > 3) {
         throwError(ErrorType::Runtime, "get() takes 2-3 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    auto dict = args[0]->get<std::shared_ptr<Dictionary>>();
+    auto dict = args[0].get<std::shared_ptr<Dictionary>>();
     auto key = args[1];
-    std::shared_ptr<Value> default_return;
+    Value default_return;
     if (args.size() == 3) {
         default_return = args[2];
     }
@@ -1545,50 +1734,50 @@ BuiltInFunctionReturn dictGet(const std::vector<std::shared_ptr<Value>>& args, E
         if (default_return) {
             return default_return;
         } else {
-            return std::make_shared<Value>();
+            return Value::none();
         }
     }
 }
 
-BuiltInFunctionReturn dictItems(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn dictItems(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "items() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    auto dict = args[0]->get<std::shared_ptr<Dictionary>>();
+    auto dict = args[0].get<std::shared_ptr<Dictionary>>();
     auto result = std::make_shared<List>();
 
     for (const auto& pair : *dict) {
         auto key_value_pair = std::make_shared<List>();
         key_value_pair->push_back(pair.first);
         key_value_pair->push_back(pair.second);
-        result->push_back(std::make_shared<Value>(key_value_pair));
+        result->push_back(Value(key_value_pair));
     }
 
-    return std::make_shared<Value>(result);
+    return Value(result);
 }
 
-BuiltInFunctionReturn dictKeys(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn dictKeys(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "keys() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    auto dict = args[0]->get<std::shared_ptr<Dictionary>>();
+    auto dict = args[0].get<std::shared_ptr<Dictionary>>();
     auto result = std::make_shared<List>();
 
     for (const auto& pair : *dict) {
         result->push_back(pair.first);
     }
 
-    return std::make_shared<Value>(result);
+    return Value(result);
 }
 
-BuiltInFunctionReturn dictPop(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn dictPop(const std::vector<Value>& args, Environment& env) {
     if (args.size() < 2 || args.size() > 3) {
         throwError(ErrorType::Runtime, "pop() takes 2-3 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    auto dict = args[0]->get<std::shared_ptr<Dictionary>>();
+    auto dict = args[0].get<std::shared_ptr<Dictionary>>();
     auto key = args[1];
 
     auto it = dict->find(key);
@@ -1605,14 +1794,14 @@ BuiltInFunctionReturn dictPop(const std::vector<std::shared_ptr<Value>>& args, E
     }
 }
 
-BuiltInFunctionReturn dictSetDefault(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn dictSetDefault(const std::vector<Value>& args, Environment& env) {
     if (args.size() < 2 || args.size() > 3) {
         throwError(ErrorType::Runtime, "setDefault() takes 2-3 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    auto dict = args[0]->get<std::shared_ptr<Dictionary>>();
+    auto dict = args[0].get<std::shared_ptr<Dictionary>>();
     auto key = args[1];
-    std::shared_ptr<Value> default_val = std::make_shared<Value>();
+    Value default_val = Value::none();
     if (args.size() == 3) {
         default_val = args[2];
     }
@@ -1626,224 +1815,224 @@ BuiltInFunctionReturn dictSetDefault(const std::vector<std::shared_ptr<Value>>&
     }
 }
 
-BuiltInFunctionReturn dictSize(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn dictSize(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "size() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    auto dict = args[0]->get<std::shared_ptr<Dictionary>>();
+    auto dict = args[0].get<std::shared_ptr<Dictionary>>();
     int size = dict->size();
-    return std::make_shared<Value>(size);
+    return Value(size);
 }
 
-BuiltInFunctionReturn dictUpdate(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn dictUpdate(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 2) {
         throwError(ErrorType::Runtime, "update() takes exactly 2 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    auto dict = args[0]->get<std::shared_ptr<Dictionary>>();
+    auto dict = args[0].get<std::shared_ptr<Dictionary>>();
     std::shared_ptr<Dictionary> other_dict;
-    if (args[1]->getType() != ValueType::Dictionary) {
-        throwError(ErrorType::Runtime, "update() expected an argument of Type:Dictionary but got " + getTypeStr(args[1]->getType()));
+    if (args[1].getType() != ValueType::Dictionary) {
+        throwError(ErrorType::Runtime, "update() expected an argument of Type:Dictionary but got " + getTypeStr(args[1].getType()));
     }
-    other_dict = args[1]->get<std::shared_ptr<Dictionary>>();
+    other_dict = args[1].get<std::shared_ptr<Dictionary>>();
 
     for (const auto& pair : *other_dict) {
         (*dict)[pair.first] = pair.second;
     }
 
-    return std::make_shared<Value>();
+    return Value::none();
 }
 
 
-BuiltInFunctionReturn stringCapitalize(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringCapitalize(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "capitalize() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    std::string string = args[0]->get<std::string>();
+    std::string string = args[0].get<std::string>();
     if (string.empty()) {
         return args[0];
     }
     std::transform(string.begin(), string.begin() + 1, string.begin(),
                     [](unsigned char c){ return std::toupper(c); });
     if (string.length() == 1) {
-        return std::make_shared<Value>(string);
+        return Value(string);
     }
     std::transform(string.begin() + 1, string.end(), string.begin() + 1,
                     [](unsigned char c){ return std::tolower(c); });
-    return std::make_shared<Value>(string);
+    return Value(string);
 }
 
-BuiltInFunctionReturn stringEndsWith(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringEndsWith(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 2) {
         throwError(ErrorType::Runtime, "endsWith() takes exactly 2 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    std::string string = args[0]->get<std::string>();
-    if (args[1]->getType() != ValueType::String) {
-        throwError(ErrorType::Runtime, "endsWith() expects an argument 1 of Type:String but got " + getTypeStr(args[1]->getType()));
+    std::string string = args[0].get<std::string>();
+    if (args[1].getType() != ValueType::String) {
+        throwError(ErrorType::Runtime, "endsWith() expects an argument 1 of Type:String but got " + getTypeStr(args[1].getType()));
     }
-    std::string substr = args[1]->get<std::string>();
+    std::string substr = args[1].get<std::string>();
     if (string.length() < substr.length()) {
-        return std::make_shared<Value>(false);
+        return Value(false);
     }
     int string_start_index = string.length() - substr.length();
 
     for (int i = 0; i < substr.length(); i++) {
         if (string.at(string_start_index + i) != substr.at(i)) {
-            return std::make_shared<Value>(false);
+            return Value(false);
         }
     }
-    return std::make_shared<Value>(true);
+    return Value(true);
 }
 
-BuiltInFunctionReturn stringFind(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringFind(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 2) {
         throwError(ErrorType::Runtime, "find() takes exactly 2 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    std::string string = args[0]->get<std::string>();
-    if (args[1]->getType() != ValueType::String) {
-        throwError(ErrorType::Runtime, "find() expected an argument 1 of Type:String but got " + getTypeStr(args[1]->getType()));
+    std::string string = args[0].get<std::string>();
+    if (args[1].getType() != ValueType::String) {
+        throwError(ErrorType::Runtime, "find() expected an argument 1 of Type:String but got " + getTypeStr(args[1].getType()));
     }
-    std::string substr = args[1]->get<std::string>();
+    std::string substr = args[1].get<std::string>();
 
     if (substr.empty()) {
-        return std::make_shared<Value>(0);
+        return Value(0);
     }
 
     int index = string.find(substr);
     if (index == std::string::npos) {
-        return std::make_shared<Value>(-1);
+        return Value(-1);
     }
-    return std::make_shared<Value>(index);
+    return Value(index);
 }
 
-BuiltInFunctionReturn stringIsAlpha(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringIsAlpha(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "isAlpha() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    std::string string = args[0]->get<std::string>();
+    std::string string = args[0].get<std::string>();
     bool result = std::all_of(string.begin(), string.end(), [](unsigned char c){ return isalpha(c); });
-    return std::make_shared<Value>(result);
+    return Value(result);
 }
 
-BuiltInFunctionReturn stringIsAlphaNum(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringIsAlphaNum(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "isAlphaNum() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    std::string string = args[0]->get<std::string>();
+    std::string string = args[0].get<std::string>();
     bool result = std::all_of(string.begin(), string.end(), [](unsigned char c){ return isalnum(c); });
-    return std::make_shared<Value>(result);
+    return Value(result);
 }
 
-BuiltInFunctionReturn stringIsDigit(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringIsDigit(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "isDigit() requires exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    std::string string = args[0]->get<std::string>();
+    std::string string = args[0].get<std::string>();
     if (string.size() == 0) {
-        return std::make_shared<Value>(false);
+        return Value(false);
     }
 
     for (char c : string) {
         if (!std::isdigit(c)) {
-            return std::make_shared<Value>(false);
+            return Value(false);
         }
     }
-    return std::make_shared<Value>(true);
+    return Value(true);
 }
 
-BuiltInFunctionReturn stringIsSpace(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringIsSpace(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "isSpace() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    std::string string = args[0]->get<std::string>();
+    std::string string = args[0].get<std::string>();
     bool result = std::all_of(string.begin(), string.end(), [](unsigned char c){ return isspace(c); });
-    return std::make_shared<Value>(result);
+    return Value(result);
 }
 
-BuiltInFunctionReturn stringIsWhitespace(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringIsWhitespace(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "isWhitespace() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    std::string string = args[0]->get<std::string>();
+    std::string string = args[0].get<std::string>();
     bool result = std::all_of(string.begin(), string.end(), [](unsigned char c){ return iswspace(c); });
-    return std::make_shared<Value>(result);
+    return Value(result);
 }
 
-BuiltInFunctionReturn stringJoin(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringJoin(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 2) {
         throwError(ErrorType::Runtime, "join() takes exactly 2 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    std::string joiner = args[0]->get<std::string>();
+    std::string joiner = args[0].get<std::string>();
 
-    if (args[1]->getType() != ValueType::List) {
-        throwError(ErrorType::Runtime, "join() expected an argument of Type:List but got " + getTypeStr(args[1]->getType()));
+    if (args[1].getType() != ValueType::List) {
+        throwError(ErrorType::Runtime, "join() expected an argument of Type:List but got " + getTypeStr(args[1].getType()));
     }
-    auto segments = args[1]->get<std::shared_ptr<List>>();
+    auto segments = args[1].get<std::shared_ptr<List>>();
     std::string combined = "";
     for (int i = 0; i < segments->size(); i++) {
         if (i != 0) {
             combined += joiner;
         }
-        if (segments->at(i)->getType() != ValueType::String) {
+        if (segments->at(i).getType() != ValueType::String) {
             throwError(ErrorType::Runtime, "join() expected a list of string elements, but got " + getValueStr(segments->at(i)));
         }
-        combined += segments->at(i)->get<std::string>();
+        combined += segments->at(i).get<std::string>();
     }
 
-    return std::make_shared<Value>(combined);
+    return Value(combined);
 }
 
-BuiltInFunctionReturn stringLength(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringLength(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "length() requires exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    std::string string = args[0]->get<std::string>();
+    std::string string = args[0].get<std::string>();
     int length = string.length();
-    return std::make_shared<Value>(length);
+    return Value(length);
 }
 
-BuiltInFunctionReturn stringLower(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringLower(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "lower() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    std::string string = args[0]->get<std::string>();
+    std::string string = args[0].get<std::string>();
     std::transform(string.begin(), string.end(), string.begin(),
                     [](unsigned char c) { return std::tolower(c); });
     
-    return std::make_shared<Value>(string);
+    return Value(string);
 }
 
-BuiltInFunctionReturn stringReplace(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringReplace(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 3) {
         throwError(ErrorType::Runtime, "replace() takes exactly 3 arguments. " + std::to_string(args.size()) + " were given");
     }
 
     // Get the string to modify
-    std::string str = args[0]->get<std::string>();
+    std::string str = args[0].get<std::string>();
 
     // Get the substring to replace
-    if (args[1]->getType() != ValueType::String) {
-        throwError(ErrorType::Runtime, "replace() expected an argument 1 of Type:String but got " + getTypeStr(args[1]->getType()));
+    if (args[1].getType() != ValueType::String) {
+        throwError(ErrorType::Runtime, "replace() expected an argument 1 of Type:String but got " + getTypeStr(args[1].getType()));
     }
-    std::string to_replace = args[1]->get<std::string>();
+    std::string to_replace = args[1].get<std::string>();
 
     // Get the replacement substring
-    if (args[2]->getType() != ValueType::String) {
-        throwError(ErrorType::Runtime, "replace() expected an argument 2 of Type:String but got " + getTypeStr(args[2]->getType()));
+    if (args[2].getType() != ValueType::String) {
+        throwError(ErrorType::Runtime, "replace() expected an argument 2 of Type:String but got " + getTypeStr(args[2].getType()));
     }
-    std::string replacement = args[2]->get<std::string>();
+    std::string replacement = args[2].get<std::string>();
 
     // Perform the replacement
     size_t pos = 0;
@@ -1852,22 +2041,22 @@ BuiltInFunctionReturn stringReplace(const std::vector<std::shared_ptr<Value>>& a
         pos += replacement.length(); // Move past the last replacement
     }
 
-    return std::make_shared<Value>(str); // Return the modified string
+    return Value(str); // Return the modified string
 }
 
-BuiltInFunctionReturn stringSplit(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringSplit(const std::vector<Value>& args, Environment& env) {
     if (args.size() > 2) {
         throwError(ErrorType::Runtime, "split() takes 1-2 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    std::string str = args[0]->get<std::string>();
+    std::string str = args[0].get<std::string>();
 
     std::string delimiter = " "; // Default delimiter is space
     if (args.size() == 2) {
-        if (args[1]->getType() == ValueType::String) {
-            delimiter = args[1]->get<std::string>();
+        if (args[1].getType() == ValueType::String) {
+            delimiter = args[1].get<std::string>();
         } else {
-            throwError(ErrorType::Runtime, "split() expected an argument 1 of Type:String but got " + getTypeStr(args[1]->getType()));
+            throwError(ErrorType::Runtime, "split() expected an argument 1 of Type:String but got " + getTypeStr(args[1].getType()));
         }
     }
 
@@ -1877,18 +2066,18 @@ BuiltInFunctionReturn stringSplit(const std::vector<std::shared_ptr<Value>>& arg
     while ((pos = str.find(delimiter)) != std::string::npos) {
         token = str.substr(0, pos);
         if (token != "") {
-            result.push_back(std::make_shared<Value>(token));
+            result.push_back(Value(token));
         }
         str.erase(0, pos + delimiter.length());
     }
     if (str != "") {
-        result.push_back(std::make_shared<Value>(str)); // Add the last token
+        result.push_back(Value(str)); // Add the last token
     }
 
-    return std::make_shared<Value>(std::make_shared<List>(result));
+    return Value(std::make_shared<List>(result));
 }
 
-BuiltInFunctionReturn stringStrip(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringStrip(const std::vector<Value>& args, Environment& env) {
     if (args.size() > 2) {
         throwError(ErrorType::Runtime, "strip() takes 1-2 arguments. " + std::to_string(args.size()) + " were given");
     }
@@ -1907,41 +2096,59 @@ BuiltInFunctionReturn stringStrip(const std::vector<std::shared_ptr<Value>>& arg
 
     std::string strip_chars = " \t\n\r\f\v";
     if (args.size() == 2) {
-        if (args[1]->getType() == ValueType::String) {
-            strip_chars = args[1]->get<std::string>();
+        if (args[1].getType() == ValueType::String) {
+            strip_chars = args[1].get<std::string>();
         } else {
-            throwError(ErrorType::Runtime, "strip() expected an argument of Type:String but got " + getTypeStr(args[1]->getType()));
+            throwError(ErrorType::Runtime, "strip() expected an argument of Type:String but got " + getTypeStr(args[1].getType()));
         }
     }
 
-    return std::make_shared<Value>(ltrim(rtrim(args[0]->get<std::string>(), strip_chars), strip_chars));
+    return Value(ltrim(rtrim(args[0].get<std::string>(), strip_chars), strip_chars));
 }
 
-BuiltInFunctionReturn stringUpper(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringUpper(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "upper() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    std::string string = args[0]->get<std::string>();
+    std::string string = args[0].get<std::string>();
     std::transform(string.begin(), string.end(), string.begin(),
                     [](unsigned char c) { return std::toupper(c); });
     
-    return std::make_shared<Value>(string);
+    return Value(string);
 }
 
-BuiltInFunctionReturn stringToJson(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn stringToJson(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 1) {
         throwError(ErrorType::Runtime, "toJson() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    std::string string = args[0]->get<std::string>();
+    std::string string = args[0].get<std::string>();
     std::vector<Token> tokens = Lexer{string}.tokenize();
     if (tokens.size() < 3) {
         throwError(ErrorType::Runtime, "Invalid string syntax for dictionary conversion");
     }
     tokens.insert(tokens.end() - 1, Token{TokenType::_Semi, 0, 0});
+    // Positions inside the string aren't lines of the caller's file, errors in it point at the toJson() call instead
+    for (Token& token : tokens) {
+        token.line = 0;
+        token.column = 0;
+    }
+    // The arena releases back to a mark, so parallel tasks take turns parsing
+    static std::mutex parse_mutex;
+    std::unique_lock lock{parse_mutex, std::defer_lock};
+    if (THREADS_ACTIVE.load(std::memory_order_relaxed)) {
+        lock.lock();
+    }
+    // The parsed literal is only needed until it has been evaluated
+    struct ArenaRelease {
+        ASTArena::Mark mark;
+        ~ArenaRelease() {
+            active_arena->release(mark);
+        }
+    } arena_release{active_arena->mark()};
     Parser parser{tokens};
-    std::vector<std::shared_ptr<ASTNode>> statements;
+    std::vector<NodeRef<>> statements;
     try {
         statements = parser.parse();
     }
@@ -1954,13 +2161,13 @@ BuiltInFunctionReturn stringToJson(const std::vector<std::shared_ptr<Value>>& ar
         std::string problem = message.substr(index);
         throwError(ErrorType::Runtime, problem);
     }
-    if (auto dict_node = std::dynamic_pointer_cast<DictionaryNode>(statements[0])) {
+    if (auto dict_node = nodeCast<DictionaryNode>(statements[0])) {
         if (statements.size() != 1) {
             throwError(ErrorType::Runtime, "Invalid string syntax for dictionary conversion");
         }
-        Environment env = buildStartingEnvironment();
-        std::optional<std::shared_ptr<Value>> dictionary;
-        return dict_node->evaluate(env);
+        // No frame, but the program's builtins, so a literal can still call length() and the like
+        Environment literal_env{env, nullptr};
+        return dict_node->evaluate(literal_env);
     } else {
         throwError(ErrorType::Runtime, "Invalid string syntax for dictionary conversion");
         return nullptr;
@@ -1968,68 +2175,119 @@ BuiltInFunctionReturn stringToJson(const std::vector<std::shared_ptr<Value>>& ar
 }
 
 
-BuiltInFunctionReturn instanceDel(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn instanceDel(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 2) {
         throwError(ErrorType::Runtime, "delAttr() takes exactly 2 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    auto inst = args[0]->get<std::shared_ptr<Instance>>();
+    auto inst = args[0].get<std::shared_ptr<Instance>>();
     auto name_val = args[1];
-    if (name_val->getType() != ValueType::String) {
-        throwError(ErrorType::Runtime, "delAttr() expected an argument of Type:String but got " + getTypeStr(name_val->getType()));
+    if (name_val.getType() != ValueType::String) {
+        throwError(ErrorType::Runtime, "delAttr() expected an argument of Type:String but got " + getTypeStr(name_val.getType()));
     }
 
-    auto name = name_val->get<std::string>();
+    auto name = name_val.get<std::string>();
     if (inst->getEnvironment().hasMember(name)) {
         inst->getEnvironment().delMember(name);
     }
-    return std::make_shared<Value>();
+    return Value::none();
 }
 
-BuiltInFunctionReturn instanceGet(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn instanceGet(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 2) {
         throwError(ErrorType::Runtime, "getAttr() takes exactly 2 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    auto inst = args[0]->get<std::shared_ptr<Instance>>();
+    auto inst = args[0].get<std::shared_ptr<Instance>>();
     auto name_val = args[1];
-    if (name_val->getType() != ValueType::String) {
-        throwError(ErrorType::Runtime, "getAttr() expected an argument of Type:String but got " + getTypeStr(name_val->getType()));
+    if (name_val.getType() != ValueType::String) {
+        throwError(ErrorType::Runtime, "getAttr() expected an argument of Type:String but got " + getTypeStr(name_val.getType()));
     }
 
-    auto name = name_val->get<std::string>();
+    auto name = name_val.get<std::string>();
     return inst->getEnvironment().getMember(name);
 }
 
-BuiltInFunctionReturn instanceHas(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn instanceHas(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 2) {
         throwError(ErrorType::Runtime, "hasAttr() takes exactly 2 argument. " + std::to_string(args.size()) + " were given");
     }
 
-    auto inst = args[0]->get<std::shared_ptr<Instance>>();
+    auto inst = args[0].get<std::shared_ptr<Instance>>();
     auto name = args[1];
-    if (name->getType() != ValueType::String) {
-        throwError(ErrorType::Runtime, "hasAttr() expected an argument of Type:String but got " + getTypeStr(name->getType()));
+    if (name.getType() != ValueType::String) {
+        throwError(ErrorType::Runtime, "hasAttr() expected an argument of Type:String but got " + getTypeStr(name.getType()));
     }
 
-    bool has = inst->getEnvironment().hasMember(name->get<std::string>());
+    bool has = inst->getEnvironment().hasMember(name.get<std::string>());
 
-    return std::make_shared<Value>(has);
+    return Value(has);
 }
 
-BuiltInFunctionReturn instanceSet(const std::vector<std::shared_ptr<Value>>& args, Environment& env) {
+BuiltInFunctionReturn instanceSet(const std::vector<Value>& args, Environment& env) {
     if (args.size() != 3) {
         throwError(ErrorType::Runtime, "setAttr() takes exactly 3 arguments. " + std::to_string(args.size()) + " were given");
     }
 
-    auto inst = args[0]->get<std::shared_ptr<Instance>>();
+    auto inst = args[0].get<std::shared_ptr<Instance>>();
     auto name_val = args[1];
     auto value = args[2];
-    if (name_val->getType() != ValueType::String) {
-        throwError(ErrorType::Runtime, "setAttr() expected an argument of Type:String but got " + getTypeStr(name_val->getType()));
+    if (name_val.getType() != ValueType::String) {
+        throwError(ErrorType::Runtime, "setAttr() expected an argument of Type:String but got " + getTypeStr(name_val.getType()));
     }
     
-    auto name = name_val->get<std::string>();
+    auto name = name_val.get<std::string>();
     inst->getEnvironment().addMember(name, value);
-    return std::make_shared<Value>();
+    return Value::none();
+}
+
+
+BuiltInFunctionReturn futureDone(const std::vector<Value>& args, Environment& env) {
+    if (args.size() != 1) {
+        throwError(ErrorType::Runtime, "done() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
+    }
+
+    return Value(args[0].get<std::shared_ptr<Future>>()->done());
+}
+
+BuiltInFunctionReturn futureJoin(const std::vector<Value>& args, Environment& env) {
+    if (args.size() != 1) {
+        throwError(ErrorType::Runtime, "join() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
+    }
+
+    return args[0].get<std::shared_ptr<Future>>()->join();
+}
+
+
+BuiltInFunctionReturn channelClose(const std::vector<Value>& args, Environment& env) {
+    if (args.size() != 1) {
+        throwError(ErrorType::Runtime, "close() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
+    }
+
+    args[0].get<std::shared_ptr<Channel>>()->close();
+    return Value::none();
+}
+
+BuiltInFunctionReturn channelRecv(const std::vector<Value>& args, Environment& env) {
+    if (args.size() != 1) {
+        throwError(ErrorType::Runtime, "recv() takes exactly 1 argument. " + std::to_string(args.size()) + " were given");
+    }
+
+    // Null can't be sent, so it tells the receiver the channel is closed and empty
+    auto value = args[0].get<std::shared_ptr<Channel>>()->recv();
+    return value ? *value : Value::none();
+}
+
+BuiltInFunctionReturn channelSend(const std::vector<Value>& args, Environment& env) {
+    if (args.size() != 2) {
+        throwError(ErrorType::Runtime, "send() takes exactly 2 arguments. " + std::to_string(args.size()) + " were given");
+    }
+
+    if (args[1].getType() == ValueType::None) {
+        throwError(ErrorType::Runtime, "send() cannot send Null, which recv() returns once the channel is closed");
+    }
+    if (!args[0].get<std::shared_ptr<Channel>>()->send(args[1])) {
+        throwError(ErrorType::Runtime, "send() was called on a closed channel");
+    }
+    return Value::none();
 }
\ No newline at end of file
@@ -2,13 +2,16 @@
 // November 2024
 // Project: Funcy Language 2.0
 
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 #include "library.h"
 #include "lexer.h"
-#include "parser.h"
-#include "context.h"
 #include "errorDefs.h"
+#include "interpreter.h"
+#include "profiler.h"
+#include "stats.h"
+#include "threadPool.h"
 
 bool TESTING = false;
 bool DISPLAY_TOKENS = false;
@@ -26,12 +29,28 @@ void enableAnsiEscapeCodes() {
 #endif
 
 
+// Once the program has failed, spawned tasks may be blocked on a channel nothing will feed, so the
+// process ends without waiting for them
+int failProgram(const std::string& program) {
+    if (runningThreads() == 0) {
+        return 1;
+    }
+    if (COLLECT_STATS) {
+        printExecutionStats(program);
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    std::_Exit(1);
+}
+
+
 int main(int argc, char* argv[]) {
     enableAnsiEscapeCodes();
 
-    bool ignore_overflow = false;
+    InterpreterOptions options;
+    int profile_hz = 0;
     if (!TESTING && argc < 2) {
-        throwError(ErrorType::Runtime, "Program usage: Funcy <program_path> [-IgnoreOverflow]");
+        throwError(ErrorType::Runtime, "Program usage: Funcy <program_path> [-IgnoreOverflow] [--engine=tree|vm] [--no-cache] [--profile[=hz]] [--stats] [--threads=n]");
         return 0;
     }
 
@@ -42,10 +61,38 @@ int main(int argc, char* argv[]) {
         filename = argv[1];
     }
 
-    if (argc == 3) {
-        std::string flag = argv[2];
+    for (int i = 2; i < argc; i++) {
+        std::string flag = argv[i];
         if (flag == "-IgnoreOverflow") {
-            ignore_overflow = true;
+            options.detect_recursion = false; // Suppress recursion warning if flag disables it
+        } else if (flag == "--engine=vm") {
+            options.use_vm_engine = true;
+        } else if (flag == "--engine=tree") {
+            options.use_vm_engine = false;
+        } else if (flag == "--no-cache") {
+            options.use_module_cache = false;
+        } else if (flag == "--stats") {
+            COLLECT_STATS = true;
+        } else if (flag == "--profile") {
+            profile_hz = 1000;
+        } else if (flag.starts_with("--profile=")) {
+            try {
+                profile_hz = std::stoi(flag.substr(10));
+            } catch (const std::exception&) {
+                profile_hz = 0;
+            }
+            if (profile_hz < 1 || profile_hz > 100000) {
+                throwError(ErrorType::Runtime, "Program usage: --profile rate must be between 1 and 100000 samples per second");
+            }
+        } else if (flag.starts_with("--threads=")) {
+            try {
+                THREAD_COUNT = std::stoi(flag.substr(10));
+            } catch (const std::exception&) {
+                THREAD_COUNT = 0;
+            }
+            if (THREAD_COUNT < 1 || THREAD_COUNT > 256) {
+                throwError(ErrorType::Runtime, "Program usage: --threads must be between 1 and 256");
+            }
         } else {
             throwError(ErrorType::Runtime, "Program usage: Unrecognized flag " + flag);
         }
@@ -56,66 +103,47 @@ int main(int argc, char* argv[]) {
         try {
             throwError(ErrorType::Runtime, "File " + filename + " is empty or could not be read");
         }
-        catch (const std::exception& e) {
+        catch (const ErrorException& e) {
             // Throwing and then catching the error allows for proper error formating
-            std::cerr << e.what();
+            std::cerr << e.message;
             return 1;
         }
     }
 
-    pushExecutionContext(filename); // Keeps the current running code's file on top of the stack
-
-    Lexer lexer{source_code};
-    std::vector<Token> tokens;
+    // Outlives the reports below, and a failed program ends before it waits for the tasks it spawned
+    Interpreter interpreter{options};
+    std::optional<ProfileSession> profile; // Reports when main returns, however the program ended
+    struct StatsReport {
+        std::string program;
+        ~StatsReport() {
+            if (COLLECT_STATS) {
+                printExecutionStats(program);
+            }
+        }
+    } stats_report{filename};
     try {
-        tokens = lexer.tokenize();
+        PhaseTimer execute_timer{Phase::Execute}; // Lexing, parsing and compiling inside it are charged to their own phases
         if (DISPLAY_TOKENS) {
+            Lexer lexer{source_code};
+            std::vector<Token> tokens = lexer.tokenize();
             for (int i = 0; i < tokens.size(); i++) {
                 tokens[i].display();
             }
         }
 
-        pushParsingContext(filename);
-        Parser parser{tokens};
-        std::vector<std::shared_ptr<ASTNode>> statements;
-        statements = parser.parse();
-
-        Environment env = buildStartingEnvironment(); // Create environment and inject the global builtin functions
-        DETECT_RECURSION = !ignore_overflow; // Suppress recursion warning if flag disables it
-        for (auto statement : statements) {
-            try {
-                auto result = statement->evaluate(env);
-            }
-            catch (const ReturnException) {
-                throwError(ErrorType::Runtime, "Return was used outside of function");
-            }
-            catch (const BreakException) {
-                throwError(ErrorType::Runtime, "Break was used outside of loop");
-            }
-            catch (const ContinueException) {
-                throwError(ErrorType::Runtime, "Continue was used outside of loop");
-            }
-            catch (const StackOverflowException) {
-                throwError(ErrorType::StackOverflow, "Excessive recursion depth reached. (Add the -IgnoreOverflow flag to the end of \
-the program execution to ignore this warning)");
-            }
-            catch (const ErrorException& e) {
-                std::cerr << e.message;
-                return 1;
-            }
+        if (profile_hz > 0) {
+            profile.emplace(filename, profile_hz);
         }
+        interpreter.runSource(source_code, filename);
     }
     catch (const ErrorException& e) {
         std::cerr << e.message;
-        return 1;
+        return failProgram(filename);
     }
     catch (const std::exception& e) {
         std::cerr << e.what();
-        return 1;
+        return failProgram(filename);
     }
 
-    popParsingContext();
-    popExecutionContext();
-
     return 0;
 }
\ No newline at end of file
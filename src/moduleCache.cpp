@@ -0,0 +1,601 @@
+#include "moduleCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include "lexer.h"
+#include "parser.h"
+#include "context.h"
+#include "stats.h"
+
+namespace {
+
+// Bump whenever the parser's output or this encoding changes, older caches are then ignored
+constexpr uint32_t CACHE_FORMAT_VERSION = 2;
+constexpr char CACHE_MAGIC[4] = {'F', 'Y', 'C', '\0'};
+constexpr std::string_view INTERPRETER_VERSION = "Funcy 2.0";
+
+enum class NodeTag : uint8_t {
+    Null,
+    Reference, // A node that was already written, by the order it was written in
+    Atom,
+    UnaryOp,
+    BinaryOp,
+    Parenthesis,
+    Identifier,
+    Scoped,
+    For,
+    Keyword,
+    List,
+    Index,
+    Func,
+    MethodCall,
+    Dictionary,
+    Class
+};
+
+enum class AtomTag : uint8_t {
+    Integer,
+    Float,
+    Boolean,
+    String,
+    Index
+};
+
+uint64_t hashBytes(std::string_view bytes) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (char byte : bytes) {
+        hash = (hash ^ static_cast<unsigned char>(byte)) * 0x100000001b3;
+    }
+    return hash;
+}
+
+struct CacheHeader {
+    char magic[4];
+    uint32_t format_version;
+    uint64_t source_size;
+    uint64_t source_hash;
+    uint64_t body_hash;
+};
+
+// Nodes are written children first, so a reader can construct each node from ones it already has
+class CacheWriter {
+public:
+    // Every node of the module was made after first_index, which keeps the written table dense
+    explicit CacheWriter(NodeIndex first_index)
+        : first_index{first_index} {}
+
+    void writeStatements(const std::vector<NodeRef<>>& statements) {
+        writeList(statements);
+    }
+
+    std::string buffer;
+
+private:
+    template <typename T>
+    void write(T value) {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    // Counts, positions and indices are mostly small, so they take as few 7 bit groups as they need
+    void writeNumber(uint64_t number) {
+        while (number >= 0x80) {
+            buffer += static_cast<char>(number | 0x80);
+            number >>= 7;
+        }
+        buffer += static_cast<char>(number);
+    }
+    void writeSigned(int64_t number) {
+        writeNumber((static_cast<uint64_t>(number) << 1) ^ static_cast<uint64_t>(number >> 63));
+    }
+    void writeString(std::string_view string) {
+        writeNumber(string.size());
+        buffer.append(string);
+    }
+    // Names repeat constantly, each one is spelled out the first time and referred to by number after
+    void writeName(const std::string& name) {
+        auto [found, inserted] = names.try_emplace(name, static_cast<uint32_t>(names.size()));
+        if (inserted) {
+            writeNumber(0);
+            writeString(name);
+        } else {
+            writeNumber(found->second + 1);
+        }
+    }
+    void writeToken(TokenType type) {
+        writeNumber(static_cast<uint64_t>(type));
+    }
+    void writeTag(NodeTag tag) {
+        write(tag);
+    }
+    void writePosition(ASTNode* node) {
+        writeSigned(node->line() - last_line);
+        writeSigned(node->column());
+        last_line = node->line();
+    }
+    void writeList(const ASTList& list) {
+        writeNumber(list.size());
+        for (const auto& node : list) {
+            writeNode(node);
+        }
+    }
+
+    void writeNode(NodeRef<> ref);
+    void writeFields(ASTNode* node);
+
+    NodeIndex first_index;
+    std::vector<uint32_t> written; // Write order + 1 of each node, 0 until it's written
+    uint32_t written_count = 0;
+    std::unordered_map<std::string, uint32_t> names;
+    int last_line = 0;
+};
+
+void CacheWriter::writeNode(NodeRef<> ref) {
+    if (!ref) {
+        writeTag(NodeTag::Null);
+        return;
+    }
+    size_t slot = ref.getIndex() - first_index;
+    if (slot >= written.size()) {
+        written.resize(std::max(slot + 1, written.size() * 2));
+    }
+    if (written[slot] != 0) {
+        writeTag(NodeTag::Reference);
+        writeNumber(written[slot] - 1);
+        return;
+    }
+    writeFields(ref.get());
+    written[ref.getIndex() - first_index] = ++written_count;
+}
+
+void CacheWriter::writeFields(ASTNode* node) {
+    if (auto atom = dynamic_cast<AtomNode*>(node)) {
+        writeTag(NodeTag::Atom);
+        writePosition(node);
+        if (atom->isInt()) {
+            write(AtomTag::Integer);
+            writeSigned(atom->getInt());
+        } else if (atom->isFloat()) {
+            write(AtomTag::Float);
+            write(atom->getFloat());
+        } else if (atom->isBool()) {
+            write(AtomTag::Boolean);
+            write(static_cast<uint8_t>(atom->getBool()));
+        } else if (atom->isString()) {
+            write(AtomTag::String);
+            writeString(atom->getString());
+        } else {
+            write(AtomTag::Index);
+            write(static_cast<uint8_t>(atom->getIndex()));
+        }
+    }
+    else if (auto unary = dynamic_cast<UnaryOpNode*>(node)) {
+        writeTag(NodeTag::UnaryOp);
+        writePosition(node);
+        writeToken(unary->op);
+        writeNode(unary->right);
+    }
+    else if (auto binary = dynamic_cast<BinaryOpNode*>(node)) {
+        writeTag(NodeTag::BinaryOp);
+        writePosition(node);
+        writeToken(binary->op);
+        writeNode(binary->left);
+        writeNode(binary->right);
+    }
+    else if (auto parenthesis = dynamic_cast<ParenthesisOpNode*>(node)) {
+        writeTag(NodeTag::Parenthesis);
+        writePosition(node);
+        writeNode(parenthesis->expr);
+    }
+    else if (auto identifier = dynamic_cast<IdentifierNode*>(node)) {
+        writeTag(NodeTag::Identifier);
+        writePosition(node);
+        writeName(identifier->name);
+        write(static_cast<uint8_t>(identifier->member_variable));
+    }
+    else if (auto scoped = dynamic_cast<ScopedNode*>(node)) {
+        writeTag(NodeTag::Scoped);
+        writePosition(node);
+        writeToken(scoped->keyword);
+        writeNode(scoped->if_link);
+        writeNode(scoped->comparison);
+        writeList(scoped->statements_block);
+    }
+    else if (auto for_node = dynamic_cast<ForNode*>(node)) {
+        writeTag(NodeTag::For);
+        writePosition(node);
+        writeToken(for_node->keyword);
+        writeNode(for_node->initialization);
+        writeNode(for_node->condition_value);
+        writeNode(for_node->increment);
+        writeList(for_node->block);
+    }
+    else if (auto keyword = dynamic_cast<KeywordNode*>(node)) {
+        writeTag(NodeTag::Keyword);
+        writePosition(node);
+        writeToken(keyword->keyword);
+        writeNode(keyword->right);
+    }
+    else if (auto list = dynamic_cast<ListNode*>(node)) {
+        writeTag(NodeTag::List);
+        writePosition(node);
+        writeList(list->list);
+    }
+    else if (auto index = dynamic_cast<IndexNode*>(node)) {
+        writeTag(NodeTag::Index);
+        writePosition(node);
+        writeNode(index->container);
+        writeNode(index->start_index);
+        writeNode(index->end_index);
+    }
+    else if (auto func = dynamic_cast<FuncNode*>(node)) {
+        writeTag(NodeTag::Func);
+        writePosition(node);
+        write(static_cast<uint8_t>(func->member_func));
+        writeName(*func->func_name);
+        writeList(func->args);
+        writeNumber(func->default_arg_nodes.size());
+        for (const auto& [name, value] : func->default_arg_nodes) {
+            writeName(name);
+            writeNode(value);
+        }
+        writeList(func->block);
+    }
+    else if (auto call = dynamic_cast<MethodCallNode*>(node)) {
+        writeTag(NodeTag::MethodCall);
+        writePosition(node);
+        writeNode(call->stored_func);
+        writeList(call->values);
+    }
+    else if (auto dictionary = dynamic_cast<DictionaryNode*>(node)) {
+        writeTag(NodeTag::Dictionary);
+        writePosition(node);
+        writeNumber(dictionary->dictionary.size());
+        for (const auto& [key, value] : dictionary->dictionary) {
+            writeNode(key);
+            writeNode(value);
+        }
+    }
+    else if (auto class_node = dynamic_cast<ClassNode*>(node)) {
+        writeTag(NodeTag::Class);
+        writePosition(node);
+        writeName(class_node->name);
+        writeList(class_node->block);
+    }
+    else {
+        throwError(ErrorType::Runtime, "Unable to cache node " + node->getPrintable());
+    }
+}
+
+// Rebuilds the statements through the same constructors the parser uses. Any inconsistency marks the
+// read as failed instead of throwing, the caller then falls back to parsing.
+class CacheReader {
+public:
+    CacheReader(std::string_view data, std::string file_context)
+        : data{data}, file_context{file_context} {}
+
+    std::vector<NodeRef<>> readStatements() {
+        auto statements = readList();
+        if (position != data.size()) {
+            failed = true;
+        }
+        return statements;
+    }
+
+    bool failed = false;
+
+private:
+    template <typename T>
+    T read() {
+        T value{};
+        if (failed || data.size() - position < sizeof(T)) {
+            failed = true;
+            return value;
+        }
+        std::memcpy(&value, data.data() + position, sizeof(T));
+        position += sizeof(T);
+        return value;
+    }
+    uint64_t readNumber() {
+        uint64_t number = 0;
+        for (int shift = 0; shift < 64 && position < data.size(); shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(data[position++]);
+            number |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return number;
+            }
+        }
+        failed = true;
+        return 0;
+    }
+    int64_t readSigned() {
+        uint64_t number = readNumber();
+        return static_cast<int64_t>(number >> 1) ^ -static_cast<int64_t>(number & 1);
+    }
+    TokenType readToken() {
+        return static_cast<TokenType>(readNumber());
+    }
+    std::string readString() {
+        uint64_t size = readNumber();
+        if (failed || data.size() - position < size) {
+            failed = true;
+            return "";
+        }
+        std::string string{data.substr(position, size)};
+        position += size;
+        return string;
+    }
+    Symbol readName() {
+        uint64_t id = readNumber();
+        if (id == 0) {
+            names.push_back(internSymbol(readString()));
+            return names.back();
+        }
+        if (id > names.size()) {
+            failed = true;
+            return internSymbol("");
+        }
+        return names[id - 1];
+    }
+    ASTList readList() {
+        uint64_t size = readNumber();
+        ASTList list;
+        // Every node takes at least one byte, so a larger count can only come from a damaged file
+        if (size > data.size() - position) {
+            failed = true;
+            return list;
+        }
+        list.reserve(size);
+        for (uint64_t i = 0; i < size && !failed; i++) {
+            list.push_back(readNode());
+        }
+        return list;
+    }
+
+    NodeRef<> readNode();
+    NodeRef<> construct(NodeTag tag, int line, int column);
+
+    std::string_view data;
+    size_t position = 0;
+    std::string file_context;
+    std::vector<NodeRef<>> nodes;
+    std::vector<Symbol> names;
+    int last_line = 0;
+};
+
+NodeRef<> CacheReader::readNode() {
+    NodeTag tag = read<NodeTag>();
+    if (failed || tag == NodeTag::Null) {
+        return nullptr;
+    }
+    if (tag == NodeTag::Reference) {
+        uint64_t order = readNumber();
+        if (order >= nodes.size()) {
+            failed = true;
+            return nullptr;
+        }
+        return nodes[order];
+    }
+    int line = last_line + static_cast<int>(readSigned());
+    int column = static_cast<int>(readSigned());
+    last_line = line;
+    NodeRef<> node = construct(tag, line, column);
+    if (node) {
+        nodes.push_back(node);
+    }
+    return node;
+}
+
+NodeRef<> CacheReader::construct(NodeTag tag, int line, int column) {
+    switch (tag) {
+        case NodeTag::Atom: {
+            switch (read<AtomTag>()) {
+                case AtomTag::Integer: return makeNode<AtomNode>(static_cast<int>(readSigned()), line, column);
+                case AtomTag::Float: return makeNode<AtomNode>(read<double>(), line, column);
+                case AtomTag::Boolean: return makeNode<AtomNode>(read<uint8_t>() != 0, line, column);
+                case AtomTag::String: return makeNode<AtomNode>(readString(), line, column);
+                case AtomTag::Index: return makeNode<AtomNode>(static_cast<SpecialIndex>(read<uint8_t>()), line, column);
+                default: break;
+            }
+            break;
+        }
+        case NodeTag::UnaryOp: {
+            auto op = readToken();
+            auto right = readNode();
+            return makeNode<UnaryOpNode>(op, right, line, column);
+        }
+        case NodeTag::BinaryOp: {
+            auto op = readToken();
+            auto left = readNode();
+            auto right = readNode();
+            return makeNode<BinaryOpNode>(left, op, right, line, column);
+        }
+        case NodeTag::Parenthesis: {
+            auto expr = readNode();
+            return makeNode<ParenthesisOpNode>(expr, line, column);
+        }
+        case NodeTag::Identifier: {
+            Symbol name = readName();
+            bool member_variable = read<uint8_t>() != 0;
+            auto identifier = makeNode<IdentifierNode>(name, line, column);
+            identifier->member_variable = member_variable;
+            return identifier;
+        }
+        case NodeTag::Scoped: {
+            auto keyword = readToken();
+            auto if_link = readNode();
+            auto comparison = readNode();
+            auto block = readList();
+            if (if_link && !nodeCast<ScopedNode>(if_link)) {
+                break;
+            }
+            return makeNode<ScopedNode>(keyword, NodeRef<ScopedNode>{nodeCast<ScopedNode>(if_link)}, comparison,
+                                        block, line, column);
+        }
+        case NodeTag::For: {
+            auto keyword = readToken();
+            auto initialization = readNode();
+            auto condition = readNode();
+            auto increment = readNode();
+            auto block = readList();
+            return makeNode<ForNode>(keyword, initialization, condition, increment, block, line, column);
+        }
+        case NodeTag::Keyword: {
+            auto keyword = readToken();
+            auto right = readNode();
+            return makeNode<KeywordNode>(keyword, right, line, column);
+        }
+        case NodeTag::List: {
+            auto list = readList();
+            return makeNode<ListNode>(list, line, column);
+        }
+        case NodeTag::Index: {
+            auto container = readNode();
+            auto start = readNode();
+            auto end = readNode();
+            return makeNode<IndexNode>(container, start, end, line, column);
+        }
+        case NodeTag::Func: {
+            bool member_func = read<uint8_t>() != 0;
+            auto name = std::make_shared<std::string>(symbolName(readName()));
+            auto args = readList();
+            uint64_t default_count = readNumber();
+            std::vector<std::pair<std::string, NodeRef<>>> default_args;
+            for (uint64_t i = 0; i < default_count && !failed; i++) {
+                auto arg_name = symbolName(readName());
+                default_args.emplace_back(arg_name, readNode());
+            }
+            auto block = readList();
+            return makeNode<FuncNode>(member_func, name, args, default_args, block, line, column, file_context);
+        }
+        case NodeTag::MethodCall: {
+            auto stored_func = readNode();
+            auto values = readList();
+            return makeNode<MethodCallNode>(stored_func, values, line, column);
+        }
+        case NodeTag::Dictionary: {
+            uint64_t size = readNumber();
+            ASTDictionary dictionary;
+            for (uint64_t i = 0; i < size && !failed; i++) {
+                auto key = readNode();
+                dictionary.emplace_back(key, readNode());
+            }
+            return makeNode<DictionaryNode>(dictionary, line, column);
+        }
+        case NodeTag::Class: {
+            auto name = std::make_shared<std::string>(symbolName(readName()));
+            auto block = readList();
+            return makeNode<ClassNode>(name, block, line, column, file_context);
+        }
+        default:
+            break;
+    }
+    failed = true;
+    return nullptr;
+}
+
+std::string cachePath(const std::string& path) {
+    return path + "c";
+}
+
+bool loadCache(const std::string& path, const std::string& source_code, std::vector<NodeRef<>>& statements) {
+    std::ifstream file{cachePath(path), std::ios::binary | std::ios::ate};
+    if (!file) {
+        return false;
+    }
+    std::string data(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    if (!file.read(data.data(), data.size())) {
+        return false;
+    }
+
+    CacheHeader header;
+    size_t prefix = sizeof(header) + sizeof(uint32_t) + INTERPRETER_VERSION.size();
+    if (data.size() < prefix) {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    std::string_view version{data.data() + sizeof(header) + sizeof(uint32_t), INTERPRETER_VERSION.size()};
+    std::string_view body = std::string_view{data}.substr(prefix);
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.format_version != CACHE_FORMAT_VERSION ||
+        version != INTERPRETER_VERSION || header.source_size != source_code.size() ||
+        header.source_hash != hashBytes(source_code) || header.body_hash != hashBytes(body)) {
+        return false;
+    }
+
+    auto mark = active_arena->mark();
+    CacheReader reader{body, currentParsingContext()};
+    statements = reader.readStatements();
+    if (reader.failed) {
+        statements.clear();
+        active_arena->release(mark);
+        return false;
+    }
+    return true;
+}
+
+// A cache that can't be written is only a missed speed up, so failures are ignored
+void saveCache(const std::string& path, const std::string& source_code, const std::vector<NodeRef<>>& statements,
+               NodeIndex first_index) {
+    CacheWriter writer{first_index};
+    writer.writeStatements(statements);
+
+    CacheHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.format_version = CACHE_FORMAT_VERSION;
+    header.source_size = source_code.size();
+    header.source_hash = hashBytes(source_code);
+    header.body_hash = hashBytes(writer.buffer);
+    uint32_t version_size = static_cast<uint32_t>(INTERPRETER_VERSION.size());
+
+    // Written to the side and renamed into place so a reader never sees half a file. Interpreters on other
+    // threads may be saving the same module, so each writes a file of its own.
+    std::string temporary_path = cachePath(path) + "."
+                                 + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream file{temporary_path, std::ios::binary | std::ios::trunc};
+        if (!file) {
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(&version_size), sizeof(version_size));
+        file.write(INTERPRETER_VERSION.data(), INTERPRETER_VERSION.size());
+        file.write(writer.buffer.data(), writer.buffer.size());
+        if (!file) {
+            file.close();
+            std::remove(temporary_path.c_str());
+            return;
+        }
+    }
+    if (std::rename(temporary_path.c_str(), cachePath(path).c_str()) != 0) {
+        std::remove(temporary_path.c_str());
+    }
+}
+
+}
+
+std::vector<NodeRef<>> parseModule(const std::string& path, const std::string& source_code, bool use_cache) {
+    PhaseTimer timer{Phase::Parse};
+    std::vector<NodeRef<>> statements;
+    if (use_cache && loadCache(path, source_code, statements)) {
+        return statements;
+    }
+
+    NodeIndex first_index = active_arena->mark().next_index;
+    std::vector<Token> tokens;
+    {
+        PhaseTimer lex_timer{Phase::Lex};
+        Lexer lexer{source_code};
+        tokens = lexer.tokenize();
+    }
+    Parser parser{tokens};
+    statements = parser.parse();
+
+    if (use_cache) {
+        saveCache(path, source_code, statements, first_index);
+    }
+    return statements;
+}
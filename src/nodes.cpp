@@ -8,9 +8,19 @@
 #include "errorDefs.h"
 #include <functional>
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
 #include "parser.h"
 #include "context.h"
 #include "lexer.h"
+#include "compiler.h"
+#include "vm.h"
+#include "resolver.h"
+#include "moduleCache.h"
+#include "profiler.h"
+#include "stats.h"
+#include "threadPool.h"
 
 std::unordered_map<TokenType, ValueType> type_map{
     {TokenType::_IntType, ValueType::Integer},
@@ -51,31 +61,56 @@ void subTab(int tabs=1) {
 }
 
 ASTNode::ASTNode(int line, int column)
-    : line{line}, column{column} {}
+    : index{active_arena->addPosition(line, column)} {}
+
+Completion ASTNode::execute(Environment& env) {
+    return Completion{CompletionType::Normal, evaluate(env)};
+}
+
+Completion executeBlock(const ASTList& statements, Environment& env) {
+    maybeCollectGarbage();
+    // An if chain inside the block doesn't change whether the one around it was taken
+    struct IfChainRestore {
+        Environment& env;
+        bool taken;
+        ~IfChainRestore() {
+            env.if_chain_taken = taken;
+        }
+    } if_chain_restore{env, env.if_chain_taken};
+    for (const auto& statement : statements) {
+        profileSafePoint(statement.get());
+        Completion completion = statement->execute(env);
+        if (completion.type != CompletionType::Normal) {
+            return completion;
+        }
+    }
+    return {};
+}
 
 
 AtomNode::AtomNode(std::variant<int, double, bool, std::string, SpecialIndex> value, int line, int column)
     : ASTNode{line, column}, value(std::move(value)) {}
 
-std::optional<std::shared_ptr<Value>> AtomNode::evaluate(Environment& env) {
-    std::shared_ptr<Value> return_value;
+std::optional<Value> AtomNode::evaluate(Environment& env) {
+    COUNT_NODE_STAT("AtomNode");
+    Value return_value;
     if (isInt()) {
-        return_value = std::make_shared<Value>(getInt());
+        return_value = Value(getInt());
     }
     else if (isFloat()) {
-        return_value = std::make_shared<Value>(getFloat());
+        return_value = Value(getFloat());
     }
     else if (isBool()) {
-        return_value = std::make_shared<Value>(getBool());
+        return_value = Value(getBool());
     }
     else if (isString()) {
-        return_value = std::make_shared<Value>(getString());
+        return_value = Value(getString());
     }
     else if (isIndex()) {
-        return_value = std::make_shared<Value>(getIndex());
+        return_value = Value(getIndex());
     }
     else {
-        throwError(ErrorType::Runtime, "Unable to evaluate atom", line, column);
+        throwError(ErrorType::Runtime, "Unable to evaluate atom", line(), column());
         return std::nullopt;
     }
     if (debug) debugPrint(ValueList{return_value});
@@ -104,7 +139,7 @@ void AtomNode::debugPrint(ValueList values) {
             std::cout << "<index:back>";
         }
     }
-    std::cout << " -> " << values.at(0)->getPrintable() << std::endl;
+    std::cout << " -> " << values.at(0).getPrintable() << std::endl;
 }
 
 std::string AtomNode::getPrintable() {
@@ -170,119 +205,129 @@ SpecialIndex AtomNode::getIndex() {
 }
 
 
-UnaryOpNode::UnaryOpNode(TokenType op, std::shared_ptr<ASTNode> right, int line, int column)
+UnaryOpNode::UnaryOpNode(TokenType op, NodeRef<> right, int line, int column)
     : ASTNode{line, column}, op{op}, right{right} {}
 
-std::optional<std::shared_ptr<Value>> UnaryOpNode::evaluate(Environment& env) {
+std::optional<Value> UnaryOpNode::evaluate(Environment& env) {
+    COUNT_NODE_STAT("UnaryOpNode");
     if (debug) {
         std::cout << getTabs() + "Entering UnaryOp: " << getPrintable() << std::endl;
         addTab();
     }
-    std::optional<std::shared_ptr<Value>> right_value = right->evaluate(env);
+    std::optional<Value> right_value = right->evaluate(env);
     if (!right_value.has_value()) {
-        throwError(ErrorType::Runtime, std::format("Failed to evaluate unary operand with operator '{}'", getTokenTypeLabel(op)), line, column);
+        throwError(ErrorType::Runtime, std::format("Failed to evaluate unary operand with operator '{}'", getTokenTypeLabel(op)), line(), column());
     }
 
-    std::shared_ptr<Value> value = right_value.value();
+    Value value = right_value.value();
     if (debug) debugPrint(ValueList{value});
-    ValueType val_type = value->getType();
+    return applyOperation(value);
+}
+
+Value UnaryOpNode::applyOperation(Value value) {
+    ValueType val_type = value.getType();
     if (val_type == ValueType::Integer) {
-        int val = value->get<int>();
+        int val = value.get<int>();
         if (op == TokenType::_Minus) {
-            return std::make_shared<Value>(-val);
+            return Value(-val);
         }
         else if (op == TokenType::_Plus) {
             return value;
         }
         else if (op == TokenType::_Not || op == TokenType::_Exclamation) {
-            return std::make_shared<Value>(val == 0);
+            return Value(val == 0);
         }
     }
     else if (val_type == ValueType::Float) {
-        double val = value->get<double>();
+        double val = value.get<double>();
         if (op == TokenType::_Minus) {
-            return std::make_shared<Value>(-val);
+            return Value(-val);
         }
         else if (op == TokenType::_Plus) {
             return value;
         }
         else if (op == TokenType::_Not || op == TokenType::_Exclamation) {
-            return std::make_shared<Value>(val == 0.0);
+            return Value(val == 0.0);
         }
     }
     else if (val_type == ValueType::Boolean) {
-        bool val = value->get<bool>();
+        bool val = value.get<bool>();
         if (op == TokenType::_Minus) {
             if (val) {
-                return std::make_shared<Value>(-1);
+                return Value(-1);
             } else {
-                return std::make_shared<Value>(0);
+                return Value(0);
             }
         }
         else if (op == TokenType::_Plus) {
             if (val) {
-                return std::make_shared<Value>(1);
+                return Value(1);
             } else {
-                return std::make_shared<Value>(0);
+                return Value(0);
             }
         }
         else if (op == TokenType::_Not || op == TokenType::_Exclamation) {
-            return std::make_shared<Value>(!val);
+            return Value(!val);
         }
     }
     else if (val_type == ValueType::String) {
         if (op == TokenType::_Not || op == TokenType::_Exclamation) {
-            std::string val = value->get<std::string>();
-            return std::make_shared<Value>(val == "");
+            std::string val = value.get<std::string>();
+            return Value(val == "");
         }
     }
     else if (val_type == ValueType::List) {
         if (op == TokenType::_Not || op == TokenType::_Exclamation) {
-            auto list = value->get<std::shared_ptr<List>>();
-            return std::make_shared<Value>(list->empty());
+            auto list = value.get<std::shared_ptr<List>>();
+            return Value(list->empty());
         }
     }
     else if (val_type == ValueType::Dictionary) {
         if (op == TokenType::_Not || op == TokenType::_Exclamation) {
-            auto dict = value->get<std::shared_ptr<Dictionary>>();
-            return std::make_shared<Value>(dict->empty());
+            auto dict = value.get<std::shared_ptr<Dictionary>>();
+            return Value(dict->empty());
+        }
+    }
+    else if (val_type == ValueType::Range) {
+        if (op == TokenType::_Not || op == TokenType::_Exclamation) {
+            return Value(value.get<Range>().size() == 0);
         }
     }
     else if (val_type == ValueType::Function) {
         if (op == TokenType::_Not || op == TokenType::_Exclamation) {
-            return std::make_shared<Value>(false);
+            return Value(false);
         }
     }
     else if (val_type == ValueType::BuiltInFunction) {
         if (op == TokenType::_Not || op == TokenType::_Exclamation) {
-            return std::make_shared<Value>(false);
+            return Value(false);
         }
     }
     else if (val_type == ValueType::Class) {
         if (op == TokenType::_Not || op == TokenType::_Exclamation) {
-            return std::make_shared<Value>(false);
+            return Value(false);
         }
     }
     else if (val_type == ValueType::Instance) {
         if (op == TokenType::_Not || op == TokenType::_Exclamation) {
-            return std::make_shared<Value>(false);
+            return Value(false);
         }
     }
     else if (val_type == ValueType::Type) {
         if (op == TokenType::_Not || op == TokenType::_Exclamation) {
-            ValueType type_val = value->get<ValueType>();
-            return std::make_shared<Value>(type_val == ValueType::None);
+            ValueType type_val = value.get<ValueType>();
+            return Value(type_val == ValueType::None);
         }
     }
     else if (val_type == ValueType::None) {
         if (op == TokenType::_Not || op == TokenType::_Exclamation) {
-            return std::make_shared<Value>(true);
+            return Value(true);
         }
     }
 
     throwError(ErrorType::Runtime, std::format("Unsupported operand types for operation. Operation was '{}' {}",
-                                                getTokenTypeLabel(op), getValueStr(value)), line, column);
-    return std::nullopt;
+                                                getTokenTypeLabel(op), getValueStr(value)), line(), column());
+    return nullptr;
 }
 
 void UnaryOpNode::debugPrint(ValueList values) {
@@ -293,7 +338,7 @@ void UnaryOpNode::debugPrint(ValueList values) {
     if (op == TokenType::_Not) {
         std::cout << " ";
     }
-    std::cout << values.at(0)->getPrintable(debug_tabs);
+    std::cout << values.at(0).getPrintable(debug_tabs);
     std::cout << std::endl;
 }
 
@@ -307,7 +352,7 @@ std::string UnaryOpNode::getPrintable() {
 }
 
 
-BinaryOpNode::BinaryOpNode(std::shared_ptr<ASTNode> left, TokenType op, std::shared_ptr<ASTNode> right, int line, int column)
+BinaryOpNode::BinaryOpNode(NodeRef<> left, TokenType op, NodeRef<> right, int line, int column)
     : ASTNode{line, column}, left{left}, op{op}, right{right} {}
 
 // Helper function to determine the truthiness of a Value object
@@ -331,6 +376,9 @@ bool checkTruthy(const Value& value) {
         case ValueType::Dictionary: {
             return !value.get<std::shared_ptr<Dictionary>>()->empty();
         }
+        case ValueType::Range: {
+            return value.get<Range>().size() != 0;
+        }
         case ValueType::Function: {
             return true;
         }
@@ -355,518 +403,559 @@ bool checkTruthy(const Value& value) {
     }
 };
 
-std::optional<std::shared_ptr<Value>> BinaryOpNode::performOperation(std::shared_ptr<Value> left_value,
-                                                                    std::shared_ptr<Value>(right_value),
-                                                                    TokenType* custom_op) {
-    std::string left_str = getValueStr(left_value);
-    std::string right_str = getValueStr(right_value);
+// Truthiness used by if/elif/while conditions
+bool checkConditionTruthy(const Value& value) {
+    switch (value.getType()) {
+        case ValueType::Boolean:    return value.get<bool>();
+        case ValueType::Integer:    return value.get<int>() != 0;
+        case ValueType::Float:      return value.get<double>() != 0.0;
+        case ValueType::String:     return !value.get<std::string>().empty();
+        case ValueType::List:       return !value.get<std::shared_ptr<List>>()->empty();
+        case ValueType::Dictionary: return !value.get<std::shared_ptr<Dictionary>>()->empty();
+        case ValueType::Range:      return value.get<Range>().size() != 0;
+        case ValueType::None:       return false;
+        default:                    return true; // Functions, classes, instances, types -> truthy
+    }
+}
 
-    TokenType operation;
-    if (!custom_op) {
-        operation = op;
-    } else {
-        operation = *custom_op;
+namespace {
+
+using BinaryKernel = std::optional<Value> (*)(BinaryOpNode& node, const Value& left, const Value& right,
+                                                TokenType operation);
+
+bool listsEqual(const std::shared_ptr<List>& lhs_list, const std::shared_ptr<List>& rhs_list) {
+    if (lhs_list->size() != rhs_list->size()) {
+        return false;
     }
+    for (size_t i = 0; i < lhs_list->size(); ++i) {
+        auto lhs_element = lhs_list->at(i);
+        auto rhs_element = rhs_list->at(i);
 
-    // Deep comparison function for lists
-    std::function<bool(const std::shared_ptr<List>&, const std::shared_ptr<List>&)> deepCompareLists;
+        if (lhs_element.getType() != rhs_element.getType()) {
+            return false; // Types must match
+        }
 
-    deepCompareLists = [&](const std::shared_ptr<List>& lhs_list, const std::shared_ptr<List>& rhs_list) -> bool {
-        if (lhs_list->size() != rhs_list->size()) {
-            return false;
+        switch (lhs_element.getType()) {
+            case ValueType::Boolean:
+                if (lhs_element.get<bool>() != rhs_element.get<bool>()) return false;
+                break;
+            case ValueType::Integer:
+                if (lhs_element.get<int>() != rhs_element.get<int>()) return false;
+                break;
+            case ValueType::Float:
+                if (lhs_element.get<double>() != rhs_element.get<double>()) return false;
+                break;
+            case ValueType::String:
+                if (lhs_element.get<std::string>() != rhs_element.get<std::string>()) return false;
+                break;
+            case ValueType::List:
+                if (!listsEqual(lhs_element.get<std::shared_ptr<List>>(), rhs_element.get<std::shared_ptr<List>>())) {
+                    return false;
+                }
+                break;
+            case ValueType::None:
+                break; // None values are considered equal
+            default:
+                return false; // Unknown types are not equal
         }
-        for (size_t i = 0; i < lhs_list->size(); ++i) {
-            auto lhs_element = lhs_list->at(i);
-            auto rhs_element = rhs_list->at(i);
+    }
+    return true;
+}
 
-            // Compare both values recursively or directly
-            if (lhs_element->getType() != rhs_element->getType()) {
-                return false; // Types must match
+double toNumber(const Value& value) {
+    switch (value.getType()) {
+        case ValueType::Boolean: return value.get<bool>() ? 1 : 0;
+        case ValueType::Integer: return value.get<int>();
+        default: return value.get<double>();
+    }
+}
+
+// Arithmetic shared by every mix of booleans, integers and floats, integer results are truncated back to int
+std::optional<Value> numberOperation(BinaryOpNode& node, double lhs, double rhs, bool integer, TokenType operation) {
+    double result;
+    switch (operation) {
+        case TokenType::_Plus:
+        case TokenType::_PlusEquals: result = lhs + rhs; break;
+        case TokenType::_Minus:
+        case TokenType::_MinusEquals: result = lhs - rhs; break;
+        case TokenType::_Multiply:
+        case TokenType::_MultiplyEquals: result = lhs * rhs; break;
+        case TokenType::_Divide:
+        case TokenType::_DivideEquals:
+            if (rhs == 0.0) {
+                throwError(ErrorType::ZeroDivision, "Attempted division by zero", node.line(), node.column());
+            }
+            return Value(lhs / rhs);
+        case TokenType::_DoubleDivide:
+            if (rhs == 0.0) {
+                throwError(ErrorType::ZeroDivision, "Attempted division by zero", node.line(), node.column());
+            }
+            return Value(static_cast<int>(lhs / rhs));
+        case TokenType::_Caret:
+        case TokenType::_DoubleMultiply: result = pow(lhs, rhs); break;
+        case TokenType::_Mod: result = fmod(lhs, rhs); break;
+        case TokenType::_LessThan: return Value(lhs < rhs);
+        case TokenType::_LessEquals: return Value(lhs <= rhs);
+        case TokenType::_GreaterThan: return Value(lhs > rhs);
+        case TokenType::_GreaterEquals: return Value(lhs >= rhs);
+        case TokenType::_Compare: return Value(lhs == rhs);
+        case TokenType::_NotEqual: return Value(lhs != rhs);
+        default: return std::nullopt;
+    }
+    if (integer) {
+        return Value(static_cast<int>(result));
+    }
+    return Value(result);
+}
+
+std::optional<Value> integerKernel(BinaryOpNode& node, const Value& left, const Value& right, TokenType operation) {
+    int lhs = left.get<int>();
+    int rhs = right.get<int>();
+    switch (operation) {
+        case TokenType::_Plus:
+        case TokenType::_PlusEquals: return Value(static_cast<int>(int64_t{lhs} + rhs));
+        case TokenType::_Minus:
+        case TokenType::_MinusEquals: return Value(static_cast<int>(int64_t{lhs} - rhs));
+        case TokenType::_Multiply:
+        case TokenType::_MultiplyEquals: return Value(static_cast<int>(int64_t{lhs} * rhs));
+        case TokenType::_LessThan: return Value(lhs < rhs);
+        case TokenType::_LessEquals: return Value(lhs <= rhs);
+        case TokenType::_GreaterThan: return Value(lhs > rhs);
+        case TokenType::_GreaterEquals: return Value(lhs >= rhs);
+        case TokenType::_Compare: return Value(lhs == rhs);
+        case TokenType::_NotEqual: return Value(lhs != rhs);
+        default: return numberOperation(node, lhs, rhs, true, operation);
+    }
+}
+
+std::optional<Value> floatKernel(BinaryOpNode& node, const Value& left, const Value& right, TokenType operation) {
+    return numberOperation(node, left.get<double>(), right.get<double>(), false, operation);
+}
+
+std::optional<Value> mixedNumberKernel(BinaryOpNode& node, const Value& left, const Value& right, TokenType operation) {
+    bool integer = left.getType() != ValueType::Float && right.getType() != ValueType::Float;
+    return numberOperation(node, toNumber(left), toNumber(right), integer, operation);
+}
+
+std::optional<Value> stringKernel(BinaryOpNode& node, const Value& left, const Value& right, TokenType operation) {
+    const std::string& lhs = left.get<std::string>();
+    const std::string& rhs = right.get<std::string>();
+    switch (operation) {
+        case TokenType::_Plus:
+        case TokenType::_PlusEquals: return Value(lhs + rhs);
+        case TokenType::_Compare: return Value(lhs == rhs);
+        case TokenType::_NotEqual: return Value(lhs != rhs);
+        default: return std::nullopt;
+    }
+}
+
+std::optional<Value> repeatStringKernel(BinaryOpNode& node, const Value& left, const Value& right, TokenType operation) {
+    switch (operation) {
+        case TokenType::_Multiply:
+        case TokenType::_MultiplyEquals: {
+            const std::string& copying = left.get<std::string>();
+            int count = right.get<int>();
+            std::string new_str;
+            new_str.reserve(copying.size() * std::max(count, 0));
+            for (int i = 0; i < count; i++) {
+                new_str += copying;
             }
+            return Value(new_str);
+        }
+        case TokenType::_Compare: return Value(false);
+        case TokenType::_NotEqual: return Value(true);
+        default: return std::nullopt;
+    }
+}
 
-            switch (lhs_element->getType()) {
-                case ValueType::Boolean:
-                    if (lhs_element->get<bool>() != rhs_element->get<bool>()) return false;
-                    break;
-                case ValueType::Integer:
-                    if (lhs_element->get<int>() != rhs_element->get<int>()) return false;
-                    break;
-                case ValueType::Float:
-                    if (lhs_element->get<double>() != rhs_element->get<double>()) return false;
-                    break;
-                case ValueType::String:
-                    if (lhs_element->get<std::string>() != rhs_element->get<std::string>()) return false;
-                    break;
-                case ValueType::List:
-                    if (!deepCompareLists(lhs_element->get<std::shared_ptr<List>>(), 
-                                        rhs_element->get<std::shared_ptr<List>>())) {
-                        return false; // Recursive call for nested lists
-                    }
-                    break;
-                case ValueType::None:
-                    break; // None values are considered equal
-                default:
-                    return false; // Unknown types are not equal
-            }
+std::optional<Value> listKernel(BinaryOpNode& node, const Value& left, const Value& right, TokenType operation) {
+    const auto& lhs = left.get<std::shared_ptr<List>>();
+    const auto& rhs = right.get<std::shared_ptr<List>>();
+    switch (operation) {
+        case TokenType::_Plus:
+        case TokenType::_PlusEquals: {
+            auto new_list = std::make_shared<List>();
+            new_list->insert(lhs);
+            new_list->insert(rhs);
+            return Value(new_list);
         }
-        return true; // All elements match
-    };
+        case TokenType::_In:
+            for (size_t i = 0; i < rhs->size(); i++) {
+                auto item = rhs->at(i);
+                if (item.getType() == ValueType::List && listsEqual(lhs, item.get<std::shared_ptr<List>>())) {
+                    return Value(true);
+                }
+            }
+            return Value(false);
+        case TokenType::_Compare: return Value(listsEqual(lhs, rhs));
+        case TokenType::_NotEqual: return Value(!listsEqual(lhs, rhs));
+        default: return std::nullopt;
+    }
+}
 
-    // Deep comparison function for lists
-    std::function<bool(const std::shared_ptr<Dictionary>&, const std::shared_ptr<Dictionary>&)> deepCompareDictionaries;
+std::optional<Value> rangeKernel(BinaryOpNode& node, const Value& left, const Value& right, TokenType operation) {
+    switch (operation) {
+        case TokenType::_Compare: return Value(sameRange(left.get<Range>(), right.get<Range>()));
+        case TokenType::_NotEqual: return Value(!sameRange(left.get<Range>(), right.get<Range>()));
+        default: return std::nullopt;
+    }
+}
 
-    deepCompareDictionaries = [&](const std::shared_ptr<Dictionary>& lhs_dict,
-                                    const std::shared_ptr<Dictionary>& rhs_dict) -> bool {
-        if (lhs_dict->size() != rhs_dict->size()) {
+// Every key must be present in both, and each pair of values must support the operation
+bool dictionariesMatch(BinaryOpNode& node, const std::shared_ptr<Dictionary>& lhs_dict,
+                        const std::shared_ptr<Dictionary>& rhs_dict, TokenType operation) {
+    if (lhs_dict->size() != rhs_dict->size()) {
+        return false;
+    }
+    for (const auto& [key, value] : *lhs_dict) {
+        auto rhs_iter = rhs_dict->find(key);
+        if (rhs_iter == rhs_dict->end() || !node.performOperation(value, rhs_iter->second, &operation)) {
             return false;
         }
+    }
+    return true;
+}
 
-        for (const auto& lhs_pair : *lhs_dict) {
-            auto lhs_key = lhs_pair.first;
-            auto lhs_value = lhs_pair.second;
-
-            auto rhs_iter = rhs_dict->find(lhs_key);
-            if (rhs_iter == rhs_dict->end()) {
-                // Key from lhs_dict not found in rhs_dict
-                return false;
-            }
+std::optional<Value> dictionaryKernel(BinaryOpNode& node, const Value& left, const Value& right, TokenType operation) {
+    const auto& lhs = left.get<std::shared_ptr<Dictionary>>();
+    const auto& rhs = right.get<std::shared_ptr<Dictionary>>();
+    switch (operation) {
+        case TokenType::_Compare: return Value(dictionariesMatch(node, lhs, rhs, operation));
+        case TokenType::_NotEqual: return Value(!dictionariesMatch(node, lhs, rhs, operation));
+        default: return std::nullopt;
+    }
+}
 
-            auto rhs_value = rhs_iter->second;
+std::optional<Value> classKernel(BinaryOpNode& node, const Value& left, const Value& right, TokenType operation) {
+    // Classes are only ever the same when they are the exact same object
+    bool same = left.get<std::shared_ptr<Class>>() == right.get<std::shared_ptr<Class>>();
+    switch (operation) {
+        case TokenType::_Compare: return Value(same);
+        case TokenType::_NotEqual: return Value(!same);
+        default: throwError(ErrorType::Runtime, "Unsupported operation for Class types", node.line(), node.column());
+    }
+}
 
-            // Compare values
-            auto result = performOperation(lhs_value, rhs_value, &operation);
+std::optional<Value> instanceKernel(BinaryOpNode& node, const Value& left, const Value& right, TokenType operation) {
+    bool same = left.get<std::shared_ptr<Instance>>() == right.get<std::shared_ptr<Instance>>();
+    switch (operation) {
+        case TokenType::_Compare: return Value(same);
+        case TokenType::_NotEqual: return Value(!same);
+        default: throwError(ErrorType::Runtime, "Unsupported operation for Instance types", node.line(), node.column());
+    }
+}
 
-            if (!result) {
-                return false;
-            }
+// Any other combination can only be compared, and values of different types are never equal
+std::optional<Value> equalityKernel(BinaryOpNode& node, const Value& left, const Value& right, TokenType operation) {
+    if (operation != TokenType::_Compare && operation != TokenType::_NotEqual) {
+        return std::nullopt;
+    }
+    bool equal = false;
+    if (left.getType() == right.getType()) {
+        switch (left.getType()) {
+            case ValueType::Function:
+                equal = left.get<std::shared_ptr<ASTNode>>() == right.get<std::shared_ptr<ASTNode>>();
+                break;
+            case ValueType::BuiltInFunction:
+                equal = left.get<std::shared_ptr<BuiltInFunction>>() == right.get<std::shared_ptr<BuiltInFunction>>();
+                break;
+            case ValueType::Type:
+                equal = left.get<ValueType>() == right.get<ValueType>();
+                break;
+            case ValueType::Future:
+            case ValueType::Channel:
+                equal = left.getBits() == right.getBits();
+                break;
+            case ValueType::None:
+                equal = true;
+                break;
+            default:
+                break;
         }
+    }
+    return Value(operation == TokenType::_Compare ? equal : !equal);
+}
 
-        return true;
-    };
+using BinaryKernelTable = std::array<std::array<BinaryKernel, VALUE_TYPE_COUNT>, VALUE_TYPE_COUNT>;
 
-    if (operation == TokenType::_And) {
-        if (checkTruthy(*left_value)) {
-            if (checkTruthy(*right_value)) {
-                return std::make_shared<Value>(true);
-            }
-        }
-        return std::make_shared<Value>(false);
+constexpr BinaryKernelTable buildBinaryKernels() {
+    BinaryKernelTable table{};
+    for (auto& row : table) {
+        row.fill(equalityKernel);
     }
-    else if (operation == TokenType::_Or) {
-        if (checkTruthy(*left_value)) {
-            return std::make_shared<Value>(true);
-        } else if (checkTruthy(*right_value)) {
-            return std::make_shared<Value>(true);
-        } else {
-            return std::make_shared<Value>(false);
+    auto set = [&table](ValueType left, ValueType right, BinaryKernel kernel) {
+        table[static_cast<size_t>(left)][static_cast<size_t>(right)] = kernel;
+    };
+    for (ValueType left : {ValueType::Boolean, ValueType::Integer, ValueType::Float}) {
+        for (ValueType right : {ValueType::Boolean, ValueType::Integer, ValueType::Float}) {
+            set(left, right, mixedNumberKernel);
         }
     }
+    set(ValueType::Integer, ValueType::Integer, integerKernel);
+    set(ValueType::Float, ValueType::Float, floatKernel);
+    set(ValueType::String, ValueType::String, stringKernel);
+    set(ValueType::String, ValueType::Integer, repeatStringKernel);
+    set(ValueType::List, ValueType::List, listKernel);
+    set(ValueType::Range, ValueType::Range, rangeKernel);
+    set(ValueType::Dictionary, ValueType::Dictionary, dictionaryKernel);
+    set(ValueType::Class, ValueType::Class, classKernel);
+    set(ValueType::Instance, ValueType::Instance, instanceKernel);
+    return table;
+}
 
-    if (left_str == "list" && right_str == "list") {
-        // BOTH ARE LISTS
-        if (operation == TokenType::_Plus || operation == TokenType::_PlusEquals) {
-            std::shared_ptr<List> new_list = std::make_shared<List>();
-            new_list->insert(left_value->get<std::shared_ptr<List>>()); // push_back the second list
-            new_list->insert(right_value->get<std::shared_ptr<List>>()); // push_back the second list
-            return std::make_shared<Value>(new_list);
-        }
-        else if (operation == TokenType::_In) {
-            auto list = right_value->get<std::shared_ptr<List>>();
-            for (int i = 0; i < list->size(); i++) {
-                if (list->at(i)->getType() == ValueType::List) {
-                    if (deepCompareLists(left_value->get<std::shared_ptr<List>>(), list->at(i)->get<std::shared_ptr<List>>())) {
-                        return std::make_shared<Value>(true);
-                    }
-                }
-            }
-            return std::make_shared<Value>(false);
-        }
-        else if (operation == TokenType::_Compare) return std::make_shared<Value>(deepCompareLists(left_value->get<std::shared_ptr<List>>(),
-                                                                                            right_value->get<std::shared_ptr<List>>()));
-        else if (operation == TokenType::_NotEqual) return std::make_shared<Value>(!deepCompareLists(left_value->get<std::shared_ptr<List>>(), 
-                                                                                            right_value->get<std::shared_ptr<List>>()));
-    }
+// The operation for each pair of operand types, the kernel then switches on the operator
+constexpr BinaryKernelTable binary_kernels = buildBinaryKernels();
+
+}
 
-    else if (left_str == "dictionary" && right_str == "dictionary") {
-        // BOTH ARE DICTIONARIES
-        if (operation == TokenType::_Compare) return std::make_shared<Value>(deepCompareDictionaries(left_value->get<std::shared_ptr<Dictionary>>(),
-                                                                                            right_value->get<std::shared_ptr<Dictionary>>()));
-        else if (operation == TokenType::_NotEqual) return std::make_shared<Value>(!deepCompareDictionaries(left_value->get<std::shared_ptr<Dictionary>>(),
-                                                                                            right_value->get<std::shared_ptr<Dictionary>>()));
+std::optional<Value> BinaryOpNode::performOperation(const Value& left_value, const Value& right_value,
+                                                    TokenType* custom_op) {
+    TokenType operation = custom_op ? *custom_op : op;
+    if (operation == TokenType::_And) {
+        return Value(checkTruthy(left_value) && checkTruthy(right_value));
+    }
+    else if (operation == TokenType::_Or) {
+        return Value(checkTruthy(left_value) || checkTruthy(right_value));
     }
+    BinaryKernel kernel = binary_kernels[static_cast<size_t>(left_value.getType())]
+                                        [static_cast<size_t>(right_value.getType())];
+    return kernel(*this, left_value, right_value, operation);
+}
 
-    else if (left_str == "string" && right_str == "string") {
-        // BOTH STRINGS
-        std::string lhs = left_value->get<std::string>();
-        std::string rhs = right_value->get<std::string>();
-        if (operation == TokenType::_Plus || operation == TokenType::_PlusEquals) {
-            return std::make_shared<Value>(lhs + rhs);
-        }
-        else if (operation == TokenType::_Compare) {
-            return std::make_shared<Value>(lhs == rhs);
-        }
-        else if (operation == TokenType::_NotEqual) {
-            return std::make_shared<Value>(lhs != rhs);
-        }
+Value BinaryOpNode::applyOperation(const Value& left_value, const Value& right_value) {
+    auto result = performOperation(left_value, right_value);
+    if (!result) {
+        throwError(ErrorType::Runtime, std::format("Unsupported operand types for operation. Operation was {} '{}' {}",
+                                                    getValueStr(left_value), getTokenTypeLabel(op), getValueStr(right_value)), line(), column());
     }
+    return result.value();
+}
 
-    else if (left_str == "string" && right_str == "integer") {
-        // STRING AND INT
-        if (operation == TokenType::_Multiply || operation == TokenType::_MultiplyEquals) {
-            std::string new_str = "";
-            std::string copying = left_value->get<std::string>();
-            for (int i = 0; i < right_value->get<int>(); i++) {
-                new_str += copying;
+Value BinaryOpNode::containsValue(Value left_value, Value right_value) {
+    if (right_value.getType() == ValueType::Range) {
+        const Range& range = right_value.get<Range>();
+        switch (left_value.getType()) {
+            case ValueType::Integer:
+                return Value(range.contains(left_value.get<int>()));
+            case ValueType::Boolean:
+                return Value(range.contains(left_value.get<bool>()));
+            case ValueType::Float: {
+                double number = left_value.get<double>();
+                return Value(number == std::trunc(number) && std::abs(number) <= std::numeric_limits<int>::max()
+                            && range.contains(static_cast<int64_t>(number)));
             }
-            return std::make_shared<Value>(new_str);
-        }
-        else if (operation == TokenType::_Compare) {
-            return std::make_shared<Value>(false);
-        }
-        else if (operation == TokenType::_NotEqual) {
-            return std::make_shared<Value>(true);
+            default:
+                return Value(false);
         }
     }
+    else if (right_value.getType() == ValueType::List) {
+        auto list = right_value.get<std::shared_ptr<List>>();
+        for (int i = 0; i < list->size(); i++) {
+            const auto& item = list->at(i);
+            TokenType compare = TokenType::_Compare;
+            auto result = performOperation(left_value, item, &compare);
 
-    else if ((left_str == "boolean" || left_str == "integer" || left_str == "float") &&
-            (right_str == "boolean" || right_str == "integer" || right_str == "float")) {
-        
-        // Convert int/float/bool to a number to perform operation
-        std::vector<std::variant<int, double>> result_vec = transformNums(left_value, right_value);
-        std::string result_type;
-        // Int vs Float influences final type
-        double new_left, new_right;
-        if (std::holds_alternative<int>(result_vec[0])) {
-            result_type = "int";
-            new_left = std::get<int>(result_vec[0]);
-            new_right = std::get<int>(result_vec[1]);
-        } else {
-            result_type = "float";
-            new_left = std::get<double>(result_vec[0]);
-            new_right = std::get<double>(result_vec[1]);
-        }
-
-        double op_result;
-        if (operation == TokenType::_Plus || operation == TokenType::_PlusEquals) {op_result = new_left + new_right;}
-        else if (operation == TokenType::_Minus || operation == TokenType::_MinusEquals) {op_result = new_left - new_right;}
-        else if (operation == TokenType::_Multiply || operation == TokenType::_MultiplyEquals) {op_result = new_left * new_right;}
-        else if (operation == TokenType::_Divide || operation == TokenType::_DivideEquals) {
-            if (new_right == 0.0) {
-                throwError(ErrorType::ZeroDivision, "Attempted division by zero", line, column);
+            if (result && result.value().getType() == ValueType::Boolean && result.value().get<bool>()) {
+                return Value(true);
             }
-            return std::make_shared<Value>(new_left / new_right);
         }
-        else if (operation == TokenType::_DoubleDivide) {
-            if (new_right == 0.0) {
-                throwError(ErrorType::ZeroDivision, "Attempted division by zero", line, column);
-            }
-            int result = static_cast<int>(new_left / new_right);
-            return std::make_shared<Value>(result);
-        }
-        else if (operation == TokenType::_Caret) {op_result = pow(new_left, new_right);}
-        else if (operation == TokenType::_DoubleMultiply) {op_result = pow(new_left, new_right);}
-        else if (operation == TokenType::_Mod) {op_result = fmod(new_left, new_right);}
-        else if (operation == TokenType::_LessThan) {return std::make_shared<Value>(new_left < new_right);}
-        else if (operation == TokenType::_LessEquals) {return std::make_shared<Value>(new_left <= new_right);}
-        else if (operation == TokenType::_GreaterThan) {return std::make_shared<Value>(new_left > new_right);}
-        else if (operation == TokenType::_GreaterEquals) {return std::make_shared<Value>(new_left >= new_right);}
-        else if (operation == TokenType::_Compare) {
-            return std::make_shared<Value>(new_left == new_right);
-        }
-        else if (operation == TokenType::_NotEqual) {
-            return std::make_shared<Value>(new_left != new_right);
+        return Value(false);
+    }
+    else if (right_value.getType() == ValueType::Dictionary) {
+        auto dict = right_value.get<std::shared_ptr<Dictionary>>();
+        if (dict->contains(left_value)) {
+            return Value(true);
         }
-        else {
-            return std::nullopt;
+        // Keys are stored by type, but numbers and booleans compare equal by value
+        double number;
+        switch (left_value.getType()) {
+            case ValueType::Integer: number = left_value.get<int>(); break;
+            case ValueType::Float: number = left_value.get<double>(); break;
+            case ValueType::Boolean: number = left_value.get<bool>(); break;
+            default: return Value(false);
         }
-
-        if (result_type == "int") {
-            return std::make_shared<Value>(static_cast<int>(op_result));
-        } else {
-            return std::make_shared<Value>(op_result);
+        bool found = dict->contains(Value(number));
+        if (!found && number == std::trunc(number) && std::abs(number) <= std::numeric_limits<int>::max()) {
+            found = dict->contains(Value(static_cast<int>(number)));
+        }
+        if (!found && (number == 0 || number == 1)) {
+            found = dict->contains(Value(number == 1));
         }
+        return Value(found);
     }
-    else if (left_str == "class" && right_str == "class") {
-        auto left_class = left_value->get<std::shared_ptr<Class>>();
-        auto right_class = right_value->get<std::shared_ptr<Class>>();
-
-        if (operation == TokenType::_Compare) {
-            // Compare if they are the exact same class object
-            return std::make_shared<Value>(left_class == right_class);
-        } else if (operation == TokenType::_NotEqual) {
-            return std::make_shared<Value>(left_class != right_class);
-        } else {
-            throwError(ErrorType::Runtime, "Unsupported operation for Class types", line, column);
+    else if (right_value.getType() == ValueType::String) {
+        auto string = right_value.get<std::string>();
+        if (left_value.getType() != ValueType::String) {
+            return Value(false);
         }
-    } else if (left_str == "instance" && right_str == "instance") {
-        auto left_instance = left_value->get<std::shared_ptr<Instance>>();
-        auto right_instance = right_value->get<std::shared_ptr<Instance>>();
-
-        if (operation == TokenType::_Compare) {
-            // Compare if they are the exact same instance object
-            return std::make_shared<Value>(left_instance == right_instance);
-        } else if (operation == TokenType::_NotEqual) {
-            return std::make_shared<Value>(left_instance != right_instance);
-        } else {
-            throwError(ErrorType::Runtime, "Unsupported operation for Instance types", line, column);
+        std::string left = left_value.get<std::string>();
+        auto index = string.find(left);
+        if (index != std::string::npos) {
+            return Value(true);
         }
+        return Value(false);
     }
-
     else {
-        // Unknown Type Combination
-        if (operation == TokenType::_Compare || operation == TokenType::_NotEqual) {
-            // Lambda to compare values of the same type
-            auto equalityCheck = [](const Value& lhs, const Value& rhs) -> bool {
-                // Compare based on type
-                if (lhs.getType() != rhs.getType()) {
-                    return false; // Types don't match, return false
-                }
-
-                // Use switch to handle specific types
-                switch (lhs.getType()) {
-                    case ValueType::Boolean:
-                        return lhs.get<bool>() == rhs.get<bool>();
-                    case ValueType::Integer:
-                        return lhs.get<int>() == rhs.get<int>();
-                    case ValueType::Float:
-                        return lhs.get<double>() == rhs.get<double>();
-                    case ValueType::String:
-                        return lhs.get<std::string>() == rhs.get<std::string>();
-                    case ValueType::Function:
-                        return lhs.get<std::shared_ptr<ASTNode>>() == rhs.get<std::shared_ptr<ASTNode>>();
-                    case ValueType::BuiltInFunction:
-                        return lhs.get<std::shared_ptr<BuiltInFunction>>() == rhs.get<std::shared_ptr<BuiltInFunction>>();
-                    case ValueType::Type:
-                        return lhs.get<ValueType>() == rhs.get<ValueType>();
-                    case ValueType::None:
-                        return true; // Two "None" values are equal
-                    default:
-                        return false; // Fallback for unknown types
-                }
-            };
-
-            try {
-                // Perform equality comparison
-                bool result = equalityCheck(*left_value, *right_value);
-
-                if (operation == TokenType::_Compare) {
-                    return std::make_shared<Value>(result); // Return true/false
-                } else if (operation == TokenType::_NotEqual) {
-                    return std::make_shared<Value>(!result); // Negate result for "NotEqual"
-                }
-            } catch (const ErrorException& e) {
-                throwError(e.error_type, e.message);
-                return std::nullopt;
-            } catch (const std::runtime_error& e) {
-                // Handle unexpected errors (e.g., type mismatch or invalid access)
-                throwError(ErrorType::Runtime, e.what());
-                return std::nullopt;
-            }
-        }
+        throwError(ErrorType::Runtime, "Expected list or dictionary for 'in' evaluation", line(), column());
     }
+    return nullptr;
+}
 
-    return std::nullopt;
+std::optional<Value> BinaryOpNode::getMember(Environment& env, Value left_value) {
+    auto ident_node = nodeCast<IdentifierNode>(right);
+    if (!ident_node) {
+        throwError(ErrorType::Runtime, "Invalid syntax", line(), column());
+    }
+    ValueType member_type = left_value.getType();
+    Environment environment{env};
+    if (member_type == ValueType::Instance) {
+        environment = left_value.get<std::shared_ptr<Instance>>()->getEnvironment();
+    }
+    return ident_node->evaluate(environment, member_type);
 }
 
-std::optional<std::shared_ptr<Value>> BinaryOpNode::evaluate(Environment& env) {
+std::optional<Value> BinaryOpNode::evaluate(Environment& env) {
+    COUNT_NODE_STAT("BinaryOpNode");
     if (debug) {
         std::cout << getTabs() + "Entering BinaryOp: " << getPrintable() << std::endl;
         addTab();
     }
     if (op == TokenType::_Equals) {
         // An equals is a special case
-        std::optional<std::shared_ptr<Value>> right_value = right->evaluate(env);
+        std::optional<Value> right_value = right->evaluate(env);
         if (!right_value.has_value()) {
-            throwError(ErrorType::Runtime, "Failed to set variable. Operand could not be computed", line, column);
+            throwError(ErrorType::Runtime, "Failed to set variable. Operand could not be computed", line(), column());
         }
         if (debug) debugPrint(ValueList{right_value.value()});
 
         // Give it the actual left string, not the value of the variable
-        if (auto node = std::dynamic_pointer_cast<BinaryOpNode>(left)) {
+        if (auto node = nodeCast<BinaryOpNode>(left)) {
             // It's a class.member = value
-            if (auto attr_ident = std::dynamic_pointer_cast<IdentifierNode>(node->right)) {
-                if (auto instance_ident = std::dynamic_pointer_cast<IdentifierNode>(node->left)) {
-                    auto instance_value = env.get(instance_ident->name, instance_ident->member_variable);
-                    if (instance_value->getType() != ValueType::Instance) {
-                        throwError(ErrorType::Runtime, getValueStr(instance_value) + " object has no attribute " + attr_ident->name, line, column);
+            if (auto attr_ident = nodeCast<IdentifierNode>(node->right)) {
+                if (auto instance_ident = nodeCast<IdentifierNode>(node->left)) {
+                    auto instance_value = instance_ident->evaluate(env).value();
+                    if (instance_value.getType() != ValueType::Instance) {
+                        throwError(ErrorType::Runtime, getValueStr(instance_value) + " object has no attribute " + attr_ident->name, line(), column());
                     }
-                    auto instance = instance_value->get<std::shared_ptr<Instance>>();
+                    auto instance = instance_value.get<std::shared_ptr<Instance>>();
                     instance->getEnvironment().set(attr_ident->name, right_value.value(), true);
                 } else {
                     auto left_value = node->left->evaluate(env);
-                    throwError(ErrorType::Runtime, getValueStr(left_value.value()) + " object has no attribute " + attr_ident->name, line, column);
+                    throwError(ErrorType::Runtime, getValueStr(left_value.value()) + " object has no attribute " + attr_ident->name, line(), column());
                 }
             } else {
-                throwError(ErrorType::Runtime, "Invalid syntax", line, column);
+                throwError(ErrorType::Runtime, "Invalid syntax", line(), column());
             }
-        } else if (auto identifier_node = std::dynamic_pointer_cast<IdentifierNode>(left)) {
-            env.set(identifier_node->name, right_value.value(), identifier_node->member_variable);
-        } else if (auto index_node = std::dynamic_pointer_cast<IndexNode>(left)) {
+        } else if (auto identifier_node = nodeCast<IdentifierNode>(left)) {
+            identifier_node->assign(env, right_value.value());
+        } else if (auto index_node = nodeCast<IndexNode>(left)) {
             index_node->assignIndex(env, right_value.value());
-        } else if (auto list_node = std::dynamic_pointer_cast<ListNode>(left)) {
-            if (right_value.value()->getType() != ValueType::List) {
-                throwError(ErrorType::Runtime, "Expected list. Cannot unpack " + getValueStr(right_value.value()), line, column);
+        } else if (auto list_node = nodeCast<ListNode>(left)) {
+            if (right_value.value().getType() != ValueType::List) {
+                throwError(ErrorType::Runtime, "Expected list. Cannot unpack " + getValueStr(right_value.value()), line(), column());
             }
 
-            auto right_list = right_value.value()->get<std::shared_ptr<List>>();
+            auto right_list = right_value.value().get<std::shared_ptr<List>>();
             if (right_list->size() > list_node->list.size()) {
-                throwError(ErrorType::Runtime, "Too many values to unpack", line, column);
+                throwError(ErrorType::Runtime, "Too many values to unpack", line(), column());
             } else if (right_list->size() < list_node->list.size()) {
-                throwError(ErrorType::Runtime, "Too few values to unpack", line, column);
+                throwError(ErrorType::Runtime, "Too few values to unpack", line(), column());
             }
 
             for (int i = 0; i < right_list->size(); i++) {
-                if (auto identifier_node = std::dynamic_pointer_cast<IdentifierNode>(list_node->list.at(i))) {
-                    env.set(identifier_node->name, right_list->at(i), identifier_node->member_variable);
+                if (auto identifier_node = nodeCast<IdentifierNode>(list_node->list.at(i))) {
+                    identifier_node->assign(env, right_list->at(i));
                 }
                 else {
-                    throwError(ErrorType::Runtime, "Cannot assign value to literal", line, column);
+                    throwError(ErrorType::Runtime, "Cannot assign value to literal", line(), column());
                 }
             }
         }
         else {
-            throwError(ErrorType::Runtime, "The operator '=' can only be used with variables", line, column);
+            throwError(ErrorType::Runtime, "The operator '=' can only be used with variables", line(), column());
         }
         
     } else if (op == TokenType::_Dot) {
         // Handle member functions of types
-        std::optional<std::shared_ptr<Value>> left_value = left->evaluate(env);
+        std::optional<Value> left_value = left->evaluate(env);
         if (!left_value.has_value()) {
-            throwError(ErrorType::Runtime, "Failed to get member function. Identifier could not be computed", line, column);
+            throwError(ErrorType::Runtime, "Failed to get member function. Identifier could not be computed", line(), column());
         }
         if (debug) {debugPrint(ValueList{left_value.value()});}
 
-        // Get the type of the member
-        ValueType member_type = left_value.value()->getType();
-        if (auto func_node = std::dynamic_pointer_cast<MethodCallNode>(right)) {
-            // It's a member function
-            // Save the result of the member to pass into the function
-            auto saved_object = func_node->member_value; // The object node on the left of the '.' that the right side function operates on
-            func_node->member_value = left_value.value();
-            // Pass member type so evaluate knows to search for functions in that type's built-in library
-            auto returned = func_node->evaluate(env, member_type);
-            func_node->member_value = saved_object; // Restore old value so nested function calls don't overwrite it
-            return returned;
-        }
-        else if (auto ident_node = std::dynamic_pointer_cast<IdentifierNode>(right)) {
-            Environment environment{env};
-            if (member_type == ValueType::Instance) {
-                environment = left_value.value()->get<std::shared_ptr<Instance>>()->getEnvironment();
-                ident_node->member_variable = true;
-            }
-            return ident_node->evaluate(environment, member_type);
+        if (auto func_node = nodeCast<MethodCallNode>(right)) {
+            // It's a member function, the value on the left of the '.' is what it operates on
+            return func_node->evaluate(env, left_value.value());
+        }
+        else if (nodeCast<IdentifierNode>(right)) {
+            return getMember(env, left_value.value());
         }
         else {
-            throwError(ErrorType::Runtime, "Invalid syntax", line, column);
+            throwError(ErrorType::Runtime, "Invalid syntax", line(), column());
         }
     } else if (op == TokenType::_In) {
         auto left_value = left->evaluate(env);
         auto right_value = right->evaluate(env);
         if (!left_value.has_value() || !right_value.has_value()) {
-            throwError(ErrorType::Runtime, "Failed arguments of 'in'", line, column);
+            throwError(ErrorType::Runtime, "Failed arguments of 'in'", line(), column());
         }
         if (debug) {debugPrint(ValueList{left_value.value(), right_value.value()});}
 
-        if (right_value.value()->getType() == ValueType::List) {
-            auto list = right_value.value()->get<std::shared_ptr<List>>();
-            for (int i = 0; i < list->size(); i++) {
-                const auto& item = list->at(i);
-                TokenType compare = TokenType::_Compare;
-                auto result = performOperation(left_value.value(), item, &compare);
-
-                if (result && result.value()->getType() == ValueType::Boolean && result.value()->get<bool>()) {
-                    return std::make_shared<Value>(true);
-                }
-            }
-            return std::make_shared<Value>(false);
-        }
-        else if (right_value.value()->getType() == ValueType::Dictionary) {
-            auto dict = right_value.value()->get<std::shared_ptr<Dictionary>>();
-            for (const auto& pair : *dict) {
-                TokenType compare = TokenType::_Compare;
-                auto result = performOperation(left_value.value(), pair.first, &compare);
-
-                if (result && result.value()->getType() == ValueType::Boolean && result.value()->get<bool>()) {
-                    return std::make_shared<Value>(true);
-                }
-            }
-            return std::make_shared<Value>(false);
-        }
-        else if (right_value.value()->getType() == ValueType::String) {
-            auto string = right_value.value()->get<std::string>();
-            auto left_val = *left_value.value();
-            if (left_val.getType() != ValueType::String) {
-                return std::make_shared<Value>(false);
-            }
-            std::string left = left_val.get<std::string>();
-            auto index = string.find(left);
-            if (index != std::string::npos) {
-                return std::make_shared<Value>(true);
-            }
-            return std::make_shared<Value>(false);
-        }
-        else {
-            throwError(ErrorType::Runtime, "Expected list or dictionary for 'in' evaluation", line, column);
-        }
+        return containsValue(left_value.value(), right_value.value());
     } else if (op == TokenType::_And || op == TokenType::_Or) {
         auto left_value = left->evaluate(env);
         if (!left_value.has_value()) {
-            throwError(ErrorType::Runtime, "Unable to evaluate left operand for 'and' or 'or'", line, column);
+            throwError(ErrorType::Runtime, "Unable to evaluate left operand for 'and' or 'or'", line(), column());
         }
-        if (debug) {debugPrint(ValueList{left_value.value(), std::make_shared<Value>("<check_left_first>")});}
+        if (debug) {debugPrint(ValueList{left_value.value(), Value("<check_left_first>")});}
 
-        bool left_truthy = checkTruthy(*left_value.value());
+        bool left_truthy = checkTruthy(left_value.value());
 
         // Short-circuit logic for 'and' and 'or'
         if (op == TokenType::_And) {
             if (!left_truthy) {
                 // Short-circuit: if left is false, return false immediately
-                return std::make_shared<Value>(false);
+                return Value(false);
             }
         } else if (op == TokenType::_Or) {
             if (left_truthy) {
                 // Short-circuit: if left is true, return true immediately
-                return std::make_shared<Value>(true);
+                return Value(true);
             }
         }
 
         // Evaluate the right-hand side only if necessary
         auto right_value = right->evaluate(env);
         if (!right_value.has_value()) {
-            throwError(ErrorType::Runtime, "Unable to evaluate right operand for 'and' or 'or'", line, column);
+            throwError(ErrorType::Runtime, "Unable to evaluate right operand for 'and' or 'or'", line(), column());
         }
         if (debug) {debugPrint(ValueList{left_value.value(), right_value.value()});}
 
-        bool right_truthy = checkTruthy(*right_value.value());
-        return std::make_shared<Value>(right_truthy);
+        bool right_truthy = checkTruthy(right_value.value());
+        return Value(right_truthy);
     } else {
-        std::optional<std::shared_ptr<Value>> left_opt = left->evaluate(env);
-        std::optional<std::shared_ptr<Value>> right_opt = right->evaluate(env);
+        std::optional<Value> left_opt = left->evaluate(env);
+        std::optional<Value> right_opt = right->evaluate(env);
 
         if (!left_opt.has_value() || !right_opt.has_value()) {
-            throwError(ErrorType::Runtime, std::format("Unable to evaluate binary operand for operator '{}", getTokenTypeLabel(op)), line, column);
+            throwError(ErrorType::Runtime, std::format("Unable to evaluate binary operand for operator '{}", getTokenTypeLabel(op)), line(), column());
         }
         if (debug) {debugPrint(ValueList{left_opt.value(), right_opt.value()});}
 
-        auto result = performOperation(left_opt.value(), right_opt.value());
-        if (result) {
-            if (op == TokenType::_PlusEquals || op == TokenType::_MinusEquals || op == TokenType::_MultiplyEquals || op == TokenType::_DivideEquals) {
-                // Handle setting +=, -= etc.
-                if (auto identifier_node = std::dynamic_pointer_cast<IdentifierNode>(left)) {
-                    env.set(identifier_node->name, result.value(), identifier_node->member_variable);
-                } else if (auto index_node = std::dynamic_pointer_cast<IndexNode>(left)) {
-                    index_node->assignIndex(env, result.value());
-                }
-                else {
-                    throwError(ErrorType::Runtime, "The operator '=' can only be used with variables or indexes", line, column);
-                }
+        auto result = applyOperation(left_opt.value(), right_opt.value());
+        if (op == TokenType::_PlusEquals || op == TokenType::_MinusEquals || op == TokenType::_MultiplyEquals || op == TokenType::_DivideEquals) {
+            // Handle setting +=, -= etc.
+            if (auto identifier_node = nodeCast<IdentifierNode>(left)) {
+                identifier_node->assign(env, result);
+            } else if (auto index_node = nodeCast<IndexNode>(left)) {
+                index_node->assignIndex(env, result);
             }
             else {
-                return result;
+                throwError(ErrorType::Runtime, "The operator '=' can only be used with variables or indexes", line(), column());
             }
-        } else {
-            throwError(ErrorType::Runtime, std::format("Unsupported operand types for operation. Operation was {} '{}' {}",
-                                                        getValueStr(left_opt.value()), getTokenTypeLabel(op), getValueStr(right_opt.value())), line, column);
+        }
+        else {
+            return result;
         }
     }
     return std::nullopt;
@@ -879,12 +968,12 @@ void BinaryOpNode::debugPrint(ValueList values) {
     if (values.size() == 1 && op != TokenType::_Dot) {
         std::cout << left->getPrintable();
     } else {
-        std::cout << values.at(0)->getPrintable(debug_tabs);
+        std::cout << values.at(0).getPrintable(debug_tabs);
     }
 
     if (op != TokenType::_Dot) {
         std::cout << " " << getTokenTypeLabel(op) << " ";
-        std::cout << values.at(values.size() - 1)->getPrintable(debug_tabs);
+        std::cout << values.at(values.size() - 1).getPrintable(debug_tabs);
         if (values.size() == 1) {
             std::cout << " -> saving value";
         }
@@ -904,15 +993,16 @@ std::string BinaryOpNode::getPrintable() {
 }
 
 
-ParenthesisOpNode::ParenthesisOpNode(std::shared_ptr<ASTNode> expr, int line, int column)
+ParenthesisOpNode::ParenthesisOpNode(NodeRef<> expr, int line, int column)
         : ASTNode{line, column}, expr{expr} {}
 
-std::optional<std::shared_ptr<Value>> ParenthesisOpNode::evaluate(Environment& env) {
+std::optional<Value> ParenthesisOpNode::evaluate(Environment& env) {
+    COUNT_NODE_STAT("ParenthesisOpNode");
     if (debug) {
         std::cout << getTabs() + "Entering Parenthesis: " + getPrintable() << std::endl;
         addTab();
     }
-    std::optional<std::shared_ptr<Value>> expr_value = expr->evaluate(env);
+    std::optional<Value> expr_value = expr->evaluate(env);
     if (debug && expr_value) debugPrint(ValueList{expr_value.value()});
     return expr_value;
 }
@@ -921,7 +1011,7 @@ void ParenthesisOpNode::debugPrint(ValueList values) {
     subTab();
     setTabs();
     std::cout << "Evaluating Parenthesis: ";
-    std::cout << "(" + values.at(0)->getPrintable(debug_tabs) + ")" << std::endl;
+    std::cout << "(" + values.at(0).getPrintable(debug_tabs) + ")" << std::endl;
 }
 
 std::string ParenthesisOpNode::getPrintable() {
@@ -930,23 +1020,49 @@ std::string ParenthesisOpNode::getPrintable() {
 
 
 IdentifierNode::IdentifierNode(std::string name, int line, int column)
-    : ASTNode{line, column}, name{name} {}
-
-std::optional<std::shared_ptr<Value>> IdentifierNode::evaluate(Environment& env) {
-    if (env.contains(name, member_variable)) {
-        if (debug) std::cout << getTabs() + "Evaluating Identifier: " + name + " -> " + env.get(name, member_variable)->getPrintable(debug_tabs) << std::endl;
-        return env.get(name, member_variable);
-    } else if (!member_variable && env.hasFunction(name)) {
-        if (debug) std::cout << getTabs() + "Evaluating Identifier: " + name + " -> " + env.getFunction(name)->getPrintable(debug_tabs) << std::endl;
-        return env.getFunction(name);
-    } else if (!member_variable && env.isGlobal(name)) {
-        return std::nullopt;
-    } else {
-        if (member_variable) {
-            throwError(ErrorType::Runtime, "Attribute '" + name + "' is not defined", line, column);
-        } else {
-            throwError(ErrorType::Runtime, std::format("Name '{}' is not defined", name), line, column);
+    : ASTNode{line, column}, name{name}, symbol{internSymbol(name)} {}
+
+IdentifierNode::IdentifierNode(Symbol symbol, int line, int column)
+    : ASTNode{line, column}, name{symbolName(symbol)}, symbol{symbol} {}
+
+std::optional<Value> IdentifierNode::evaluate(Environment& env) {
+    COUNT_NODE_STAT("IdentifierNode");
+    if (member_variable) {
+        if (env.contains(name, true)) {
+            if (debug) std::cout << getTabs() + "Evaluating Identifier: " + name + " -> " + env.get(name, true).getPrintable(debug_tabs) << std::endl;
+            return env.get(name, true);
         }
+        throwError(ErrorType::Runtime, "Attribute '" + name + "' is not defined", line(), column());
+    }
+
+    Value value = nullptr;
+    if (depth >= 0) {
+        value = env.getLocal(depth, slot);
+        if (!value) {
+            value = env.getEnclosing(depth, symbol);
+        }
+    }
+    if (!value) {
+        // Unassigned locals fall back to the frames around them and a global of the same name, like the scope chain they replace
+        value = env.getGlobal(symbol);
+    }
+    if (!value) {
+        value = env.getFunction(symbol);
+    }
+    if (!value) {
+        throwError(ErrorType::Runtime, std::format("Name '{}' is not defined", name), line(), column());
+    }
+    if (debug) std::cout << getTabs() + "Evaluating Identifier: " + name + " -> " + value.getPrintable(debug_tabs) << std::endl;
+    return value;
+}
+
+void IdentifierNode::assign(Environment& env, Value value) {
+    if (member_variable) {
+        env.set(name, value, true);
+    } else if (depth < 0 || (!env.getLocal(depth, slot) && env.hasGlobal(symbol))) {
+        env.setGlobal(symbol, value);
+    } else {
+        env.setLocal(depth, slot, value);
     }
 }
 
@@ -954,31 +1070,32 @@ void IdentifierNode::debugPrint(ValueList values) {
     subTab();
     setTabs();
     std::cout << "Evaluating Identifier: ";
-    std::cout << values.at(0)->getPrintable(debug_tabs) << " -> finding value" << std::endl;
+    std::cout << values.at(0).getPrintable(debug_tabs) << " -> finding value" << std::endl;
 }
 
 std::string IdentifierNode::getPrintable() {
     return name;
 }
 
-std::optional<std::shared_ptr<Value>> IdentifierNode::evaluate(Environment& env, ValueType member_type) {
+std::optional<Value> IdentifierNode::evaluate(Environment& env, ValueType member_type) {
+    COUNT_NODE_STAT("IdentifierNode");
     if (env.hasMember(member_type, name)) {
-        if (debug) std::cout << getTabs() + "Evaluating Identifier: " + name + " -> " + env.getMember(member_type, name)->getPrintable(debug_tabs) << std::endl;
+        if (debug) std::cout << getTabs() + "Evaluating Identifier: " + name + " -> " + env.getMember(member_type, name).getPrintable(debug_tabs) << std::endl;
         return env.getMember(member_type, name);
     } else if (env.hasMember(name)) {
-        if (debug) std::cout << getTabs() + "Evaluating Identifier: " + name + " -> " + env.getMember(name)->getPrintable(debug_tabs) << std::endl;
+        if (debug) std::cout << getTabs() + "Evaluating Identifier: " + name + " -> " + env.getMember(name).getPrintable(debug_tabs) << std::endl;
         return env.getMember(name);
     } else {
-        throwError(ErrorType::Runtime, name + " is not defined", line, column);
+        throwError(ErrorType::Runtime, name + " is not defined", line(), column());
     }
     return std::nullopt;
 }
 
 
-ScopedNode::ScopedNode(TokenType keyword, std::shared_ptr<ScopedNode> if_link, std::shared_ptr<ASTNode> comparison,
-            std::vector<std::shared_ptr<ASTNode>> statements_block, int line, int column)
+ScopedNode::ScopedNode(TokenType keyword, NodeRef<ScopedNode> if_link, NodeRef<> comparison,
+            std::vector<NodeRef<>> statements_block, int line, int column)
     : ASTNode{line, column}, keyword{keyword}, if_link{if_link}, comparison{comparison},
-        last_comparison_result{false}, statements_block{statements_block} {}
+        statements_block{statements_block} {}
 
 bool ScopedNode::getComparisonValue(Environment& env) const {
     auto result = comparison->evaluate(env);
@@ -997,25 +1114,31 @@ bool ScopedNode::getComparisonValue(Environment& env) const {
                     return !value.get<std::shared_ptr<List>>()->empty(); // Non-empty lists are truthy
                 case ValueType::Dictionary:
                     return !value.get<std::shared_ptr<Dictionary>>()->empty();
+                case ValueType::Range:
+                    return value.get<Range>().size() != 0;
                 case ValueType::None:
                 default:
                     return false; // None or unknown types are always false
             }
         };
 
-        return check_truthy(*result.value());
+        return check_truthy(result.value());
     }
     else {
-        throwError(ErrorType::Runtime, "Missing a boolean comparison for keyword to evaluate", line, column);
+        throwError(ErrorType::Runtime, "Missing a boolean comparison for keyword to evaluate", line(), column());
         return false;
     }
 }
 
-std::optional<std::shared_ptr<Value>> ScopedNode::evaluate(Environment& env) {
+std::optional<Value> ScopedNode::evaluate(Environment& env) {
+    return execute(env).value;
+}
+
+Completion ScopedNode::execute(Environment& env) {
+    COUNT_NODE_STAT("ScopedNode");
     // If this scope is linked to a previous 'if'/'elif' and that was already true, skip this one
     if (debug && if_link) std::cout << getTabs() + "Checking if I should enter Scope: " + getPrintable() << std::endl;
-    if (if_link && if_link->last_comparison_result) {
-        last_comparison_result = true;
+    if (if_link && env.if_chain_taken) {
         return {};
     }
 
@@ -1025,32 +1148,20 @@ std::optional<std::shared_ptr<Value>> ScopedNode::evaluate(Environment& env) {
     }
 
     // Condition evaluation
-    std::shared_ptr<Value> evaluated_condition_value;
+    Value evaluated_condition_value;
     bool is_condition_truthy = true;                   // Default for blocks without a comparison (like 'else')
 
     if (comparison) {
         auto condition_value = comparison->evaluate(env);
         if (!condition_value.has_value()) {
-            throwError(ErrorType::Runtime, "Missing a boolean comparison for keyword to evaluate", line, column);
+            throwError(ErrorType::Runtime, "Missing a boolean comparison for keyword to evaluate", line(), column());
         }
 
         evaluated_condition_value = condition_value.value();
-
-        auto determineTruthy = [](const Value& value) -> bool {
-            switch (value.getType()) {
-                case ValueType::Boolean:    return value.get<bool>();
-                case ValueType::Integer:    return value.get<int>() != 0;
-                case ValueType::Float:      return value.get<double>() != 0.0;
-                case ValueType::String:     return !value.get<std::string>().empty();
-                case ValueType::List:       return !value.get<std::shared_ptr<List>>()->empty();
-                case ValueType::Dictionary: return !value.get<std::shared_ptr<Dictionary>>()->empty();
-                case ValueType::None:       return false;
-                default:                    return true; // Functions, classes, instances, types -> truthy
-            }
-        };
-
-        is_condition_truthy = determineTruthy(*evaluated_condition_value);
-        last_comparison_result = is_condition_truthy;
+        is_condition_truthy = checkConditionTruthy(evaluated_condition_value);
+        if (keyword == TokenType::_If || keyword == TokenType::_Elif) {
+            env.if_chain_taken = is_condition_truthy;
+        }
     }
 
     if (debug && comparison) {
@@ -1060,7 +1171,7 @@ std::optional<std::shared_ptr<Value>> ScopedNode::evaluate(Environment& env) {
     }
 
     if (comparison && !is_condition_truthy) {
-        return std::nullopt;
+        return {};
     }
 
     std::string keyword_string = getTokenTypeLabel(keyword);
@@ -1068,64 +1179,46 @@ std::optional<std::shared_ptr<Value>> ScopedNode::evaluate(Environment& env) {
         keyword_string == "else" || keyword_string == "while" ||
         keyword_string == "for") 
     {
-        env.addScope();
+        env.clearSlots(slots);
 
+        Completion completion;
         if (keyword_string == "while") {
             env.addLoop();
 
             while (true) {
                 auto condition_value = comparison->evaluate(env);
                 if (!condition_value) {
-                    throwError(ErrorType::Runtime, "Unable to evaluate while condition", line, column);
+                    throwError(ErrorType::Runtime, "Unable to evaluate while condition", line(), column());
                 }
 
                 if (debug) {
                     debugPrint(ValueList{ condition_value.value() });
                 }
 
-                bool loop_condition_truthy = [&] {
-                    const Value& value = *condition_value.value();
-                    switch (value.getType()) {
-                        case ValueType::Boolean:    return value.get<bool>();
-                        case ValueType::Integer:    return value.get<int>() != 0;
-                        case ValueType::Float:      return value.get<double>() != 0.0;
-                        case ValueType::String:     return !value.get<std::string>().empty();
-                        case ValueType::List:       return !value.get<std::shared_ptr<List>>()->empty();
-                        case ValueType::Dictionary: return !value.get<std::shared_ptr<Dictionary>>()->empty();
-                        case ValueType::None:       return false;
-                        default:                    return true;
-                    }
-                }();
-
-                if (!loop_condition_truthy) {
+                if (!checkConditionTruthy(condition_value.value())) {
                     break;
                 }
 
-                try {
-                    for (auto& statement : statements_block) {
-                        statement->evaluate(env);
-                    }
-                }
-                catch (const BreakException) {
+                completion = executeBlock(statements_block, env);
+                if (completion.type == CompletionType::Break || completion.type == CompletionType::Return) {
                     break;
                 }
-                catch (const ContinueException) {
-                    continue;
-                }
             }
 
             env.removeLoop();
+            if (completion.type != CompletionType::Return) {
+                completion = {};
+            }
         }
         else {
-            for (auto& statement : statements_block) {
-                statement->evaluate(env);
-            }
+            completion = executeBlock(statements_block, env);
         }
 
-        env.removeScope();
+        env.clearSlots(slots);
+        return completion;
     }
 
-    return std::nullopt;
+    return {};
 }
 
 void ScopedNode::debugPrint(ValueList values) {
@@ -1134,7 +1227,7 @@ void ScopedNode::debugPrint(ValueList values) {
     std::cout << "Evaluating Scope: ";
     std::cout << getTokenTypeLabel(keyword);
     if (values.size() == 1) {
-        std::cout << " " << values.at(0)->getPrintable(debug_tabs);
+        std::cout << " " << values.at(0).getPrintable(debug_tabs);
     }
     std::cout << " {...}" << std::endl;
 }
@@ -1148,21 +1241,27 @@ std::string ScopedNode::getPrintable() {
     return str;
 }
 
-ForNode::ForNode(TokenType keyword, std::shared_ptr<ASTNode> initialization,
-        std::shared_ptr<ASTNode> condition_value, std::shared_ptr<ASTNode> increment,
-        std::vector<std::shared_ptr<ASTNode>> block, int line, int column)
+ForNode::ForNode(TokenType keyword, NodeRef<> initialization,
+        NodeRef<> condition_value, NodeRef<> increment,
+        std::vector<NodeRef<>> block, int line, int column)
     : ASTNode{line, column}, keyword{keyword}, initialization{initialization},
         condition_value{condition_value}, increment{increment}, block{block} {}
 
-std::optional<std::shared_ptr<Value>> ForNode::evaluate(Environment& env) {
+std::optional<Value> ForNode::evaluate(Environment& env) {
+    return execute(env).value;
+}
+
+Completion ForNode::execute(Environment& env) {
+    COUNT_NODE_STAT("ForNode");
     if (debug) {
         std::cout << getTabs() + "Initializing For Loop: " + getPrintable() << std::endl;
         addTab();
     }
-    env.addScope();
+    env.clearSlots(slots);
     env.addLoop();
-    
-    auto init_node = std::dynamic_pointer_cast<BinaryOpNode>(initialization);
+    Completion completion;
+
+    auto init_node = nodeCast<BinaryOpNode>(initialization);
     if (!init_node || init_node->op != TokenType::_In) {
         // Classic for loop formatting, not using 'in'
         initialization->evaluate(env);
@@ -1176,33 +1275,26 @@ std::optional<std::shared_ptr<Value>> ForNode::evaluate(Environment& env) {
         while (true) {
             auto cond_value = condition_value->evaluate(env);
             if (!cond_value) {
-                throwError(ErrorType::Runtime, "Unable to evaluate for loop condition", line, column);
+                throwError(ErrorType::Runtime, "Unable to evaluate for loop condition", line(), column());
             }
 
-            if (cond_value.value()->getType() == ValueType::Boolean) {
+            if (cond_value.value().getType() == ValueType::Boolean) {
                 if (debug) {
                     subTab();
                     setTabs();
-                    std::cout << "Evaluating For Loop Conditional: " + cond_value.value()->getPrintable() << std::endl;
+                    std::cout << "Evaluating For Loop Conditional: " + cond_value.value().getPrintable() << std::endl;
                     addTab();
                 }
-                auto bool_value = cond_value.value()->get<bool>();
+                auto bool_value = cond_value.value().get<bool>();
                 if (!bool_value) break;
             } else {
-                throwError(ErrorType::Runtime, "For loop requires boolean condition", line, column);
+                throwError(ErrorType::Runtime, "For loop requires boolean condition", line(), column());
             }
 
-            try {
-                for (auto statement : block) {
-                    auto result = statement->evaluate(env);
-                }
-            }
-            catch (const BreakException) {
+            completion = executeBlock(block, env);
+            if (completion.type == CompletionType::Break || completion.type == CompletionType::Return) {
                 break;
             }
-            catch (const ContinueException) {
-                // Does nothing but catches exception and proceeds to increment the variable
-            }
 
             if (debug) {
                 subTab();
@@ -1224,172 +1316,156 @@ std::optional<std::shared_ptr<Value>> ForNode::evaluate(Environment& env) {
         if (debug && container_result) {
             debugPrint(ValueList{container_result.value()});
         }
-        if (container_result.value()->getType() == ValueType::List) {
-            auto list = container_result.value()->get<std::shared_ptr<List>>();
-            auto ident_node = std::dynamic_pointer_cast<IdentifierNode>(init_node->left);
+        if (container_result.value().getType() == ValueType::List) {
+            auto list = container_result.value().get<std::shared_ptr<List>>();
+            auto ident_node = nodeCast<IdentifierNode>(init_node->left);
             if (ident_node) {
-                std::string var_string = ident_node->name;
-
                 for (int i = 0; i < list->size(); i++) {
                     auto item = list->at(i);
-                    env.set(var_string, item);
+                    ident_node->assign(env, item);
                     if (debug) {
                         subTab();
                         setTabs();
-                        std::cout << "Assigning For Loop Value: " + ident_node->getPrintable() + " = " + item->getPrintable() << std::endl;
+                        std::cout << "Assigning For Loop Value: " + ident_node->getPrintable() + " = " + item.getPrintable() << std::endl;
                         addTab();
                     }
-                    try {
-                        for (auto statement : block) {
-                            auto result = statement->evaluate(env);
-                        }
-                    }
-                    catch (const BreakException) {
+                    completion = executeBlock(block, env);
+                    if (completion.type == CompletionType::Break || completion.type == CompletionType::Return) {
                         break;
                     }
-                    catch (const ContinueException) {
-                        continue;
-                    }
                 }
             } else {
-                auto list_node = std::dynamic_pointer_cast<ListNode>(init_node->left);
+                auto list_node = nodeCast<ListNode>(init_node->left);
                 if (!list_node) {
-                    throwError(ErrorType::Runtime, "For loop expected identifier or list", line, column);
+                    throwError(ErrorType::Runtime, "For loop expected identifier or list", line(), column());
                 }
 
                 for (int i = 0; i < list->size(); i++) {
                     auto list_result = list->at(i);
-                    if (list_result->getType() != ValueType::List) {
-                        throwError(ErrorType::Runtime, "Expected a list, but got " + getValueStr(list_result), line, column);
+                    if (list_result.getType() != ValueType::List) {
+                        throwError(ErrorType::Runtime, "Expected a list, but got " + getValueStr(list_result), line(), column());
                     }
-                    auto list = list_result->get<std::shared_ptr<List>>();
+                    auto list = list_result.get<std::shared_ptr<List>>();
                     if (list->size() > list_node->list.size()) {
-                        throwError(ErrorType::Runtime, "Too many arguments to unpack", line, column);
+                        throwError(ErrorType::Runtime, "Too many arguments to unpack", line(), column());
                     } else if (list->size() < list_node->list.size()) {
-                        throwError(ErrorType::Runtime, "Too few arguments to unpack", line, column);
+                        throwError(ErrorType::Runtime, "Too few arguments to unpack", line(), column());
                     }
 
                     for (int index = 0; index < list->size(); index++) {
-                        auto ident_node = std::dynamic_pointer_cast<IdentifierNode>(list_node->list.at(index));
+                        auto ident_node = nodeCast<IdentifierNode>(list_node->list.at(index));
                         if (!ident_node) {
-                            throwError(ErrorType::Runtime, "Can only assign values to identifiers", line, column);
+                            throwError(ErrorType::Runtime, "Can only assign values to identifiers", line(), column());
                         }
-                        env.set(ident_node->name, list->at(index), ident_node->member_variable);
+                        ident_node->assign(env, list->at(index));
                     }
                     
-                    try {
-                        for (auto statement : block) {
-                            auto result = statement->evaluate(env);
-                        }
-                    }
-                    catch (const BreakException) {
+                    completion = executeBlock(block, env);
+                    if (completion.type == CompletionType::Break || completion.type == CompletionType::Return) {
                         break;
                     }
-                    catch (const ContinueException) {
-                        continue;
-                    }
                 }
             }
         }
-        else if (container_result.value()->getType() == ValueType::Dictionary) {
-            auto dict = container_result.value()->get<std::shared_ptr<Dictionary>>();
-            auto ident_node = std::dynamic_pointer_cast<IdentifierNode>(init_node->left);
+        else if (container_result.value().getType() == ValueType::Dictionary) {
+            auto dict = container_result.value().get<std::shared_ptr<Dictionary>>();
+            auto ident_node = nodeCast<IdentifierNode>(init_node->left);
             if (ident_node) {
-                std::string var_string = ident_node->name;
-
                 for (const auto& pair : *dict) {
                     std::shared_ptr<List> arg_list = std::make_shared<List>();
                     arg_list->push_back(pair.first);
                     arg_list->push_back(pair.second);
-                    env.set(var_string, std::make_shared<Value>(arg_list));
-                    try {
-                        for (auto statement : block) {
-                            auto result = statement->evaluate(env);
-                        }
-                    }
-                    catch (const BreakException) {
+                    ident_node->assign(env, Value(arg_list));
+                    completion = executeBlock(block, env);
+                    if (completion.type == CompletionType::Break || completion.type == CompletionType::Return) {
                         break;
                     }
-                    catch (const ContinueException) {
-                        continue;
-                    }
                 }
             } else {
-                auto list_node = std::dynamic_pointer_cast<ListNode>(init_node->left);
+                auto list_node = nodeCast<ListNode>(init_node->left);
                 if (!list_node) {
-                    throwError(ErrorType::Runtime, "For loop expected identifier or list", line, column);
+                    throwError(ErrorType::Runtime, "For loop expected identifier or list", line(), column());
                 }
                 if (list_node->list.size() < 2) {
-                    throwError(ErrorType::Runtime, "Too many arguments to unpack", line, column);
+                    throwError(ErrorType::Runtime, "Too many arguments to unpack", line(), column());
                 } else if (list_node->list.size() > 2) {
-                    throwError(ErrorType::Runtime, "Too few arguments to unpack", line, column);
+                    throwError(ErrorType::Runtime, "Too few arguments to unpack", line(), column());
                 }
-                auto first_node = std::dynamic_pointer_cast<IdentifierNode>(list_node->list.at(0));
-                auto second_node = std::dynamic_pointer_cast<IdentifierNode>(list_node->list.at(1));
+                auto first_node = nodeCast<IdentifierNode>(list_node->list.at(0));
+                auto second_node = nodeCast<IdentifierNode>(list_node->list.at(1));
 
                 for (const auto& pair : *dict) {
-                    env.set(first_node->name, pair.first, first_node->member_variable);
-                    env.set(second_node->name, pair.second, second_node->member_variable);
-                    try {
-                        for (auto statement : block) {
-                            auto result = statement->evaluate(env);
-                        }
-                    }
-                    catch (const BreakException) {
+                    first_node->assign(env, pair.first);
+                    second_node->assign(env, pair.second);
+                    completion = executeBlock(block, env);
+                    if (completion.type == CompletionType::Break || completion.type == CompletionType::Return) {
                         break;
                     }
-                    catch (const ContinueException) {
-                        continue;
-                    }
                 }
             }
         }
-        else if (container_result.value()->getType() == ValueType::String) {
-            auto string = container_result.value()->get<std::string>();
-            auto ident_node = std::dynamic_pointer_cast<IdentifierNode>(init_node->left);
-            std::string var_string = ident_node->name;
-
-            for (char c : string) {
-                env.set(var_string, std::make_shared<Value>(std::string(1, c)));
-                try {
-                    for (auto statement : block) {
-                        auto result = statement->evaluate(env);
-                    }
+        else if (container_result.value().getType() == ValueType::Range) {
+            const Range range = container_result.value().get<Range>();
+            auto ident_node = nodeCast<IdentifierNode>(init_node->left);
+            if (!ident_node) {
+                if (!nodeCast<ListNode>(init_node->left)) {
+                    throwError(ErrorType::Runtime, "For loop expected identifier or list", line(), column());
+                }
+                if (range.size() > 0) {
+                    throwError(ErrorType::Runtime, "Expected a list, but got integer", line(), column());
                 }
-                catch (const BreakException) {
+            }
+
+            int size = range.size();
+            for (int i = 0; i < size; i++) {
+                ident_node->assign(env, Value(range.at(i)));
+                completion = executeBlock(block, env);
+                if (completion.type == CompletionType::Break || completion.type == CompletionType::Return) {
                     break;
                 }
-                catch (const ContinueException) {
-                    continue;
+            }
+        }
+        else if (container_result.value().getType() == ValueType::String) {
+            auto string = container_result.value().get<std::string>();
+            auto ident_node = nodeCast<IdentifierNode>(init_node->left);
+
+            for (char c : string) {
+                ident_node->assign(env, Value(std::string(1, c)));
+                completion = executeBlock(block, env);
+                if (completion.type == CompletionType::Break || completion.type == CompletionType::Return) {
+                    break;
                 }
             }
         }
         else {
-            throwError(ErrorType::Runtime, "For loop expected iterable container", line, column);
+            throwError(ErrorType::Runtime, "For loop expected iterable container", line(), column());
         }
     }
 
-    env.removeScope();
+    env.clearSlots(slots);
     env.removeLoop();
-    return std::nullopt;
+    if (completion.type != CompletionType::Return) {
+        completion = {};
+    }
+    return completion;
 }
 
 void ForNode::debugPrint(ValueList values) {
     subTab();
-    if (auto init_bin = std::dynamic_pointer_cast<BinaryOpNode>(initialization)) {
+    if (auto init_bin = nodeCast<BinaryOpNode>(initialization)) {
         setTabs();
         if (init_bin->op == TokenType::_In) {
             std::cout << "Evaluating For Loop: for (";
             std::cout << init_bin->left->getPrintable();
-            std::cout << " in " + values.at(0)->getPrintable() + ") {...}" << std::endl;
+            std::cout << " in " + values.at(0).getPrintable() + ") {...}" << std::endl;
         } else {
-            std::cout << "Check For Conditional: " << values.at(0)->getPrintable() << std::endl;
+            std::cout << "Check For Conditional: " << values.at(0).getPrintable() << std::endl;
         }
     }
 }
 
 std::string ForNode::getPrintable() {
-    if (auto init_bin = std::dynamic_pointer_cast<BinaryOpNode>(initialization)) {
+    if (auto init_bin = nodeCast<BinaryOpNode>(initialization)) {
         if (init_bin->op == TokenType::_In) {
             return "for (" + init_bin->left->getPrintable() +
                    " in " + init_bin->right->getPrintable() + ") {...}";
@@ -1403,9 +1479,13 @@ std::string ForNode::getPrintable() {
 }
 
 
-std::optional<std::shared_ptr<Value>> KeywordNode::evaluate(Environment& env) {
+Completion KeywordNode::execute(Environment& env) {
+    if (keyword != TokenType::_Break && keyword != TokenType::_Continue && keyword != TokenType::_Return) {
+        return Completion{CompletionType::Normal, evaluate(env)};
+    }
+    COUNT_NODE_STAT("KeywordNode");
     if (debug) {
-        if (right == nullptr || keyword == TokenType::_Global) {
+        if (right == nullptr) {
             std::cout << getTabs() + "Evaluating Keyword: " + getPrintable() << std::endl;
         } else {
             std::cout << getTabs() + "Entering Keyword: " + getPrintable() << std::endl;
@@ -1413,43 +1493,53 @@ std::optional<std::shared_ptr<Value>> KeywordNode::evaluate(Environment& env) {
         }
     }
     if (keyword == TokenType::_Break) {
-        if (env.inLoop()) {
-            throw BreakException();
-        }
-        else {
-            throwError(ErrorType::Runtime, "Break used outside of loop", line, column);
+        if (!env.inLoop()) {
+            throwError(ErrorType::Runtime, "Break used outside of loop", line(), column());
         }
+        return Completion{CompletionType::Break};
     } else if (keyword == TokenType::_Continue) {
-        if (env.inLoop()) {
-            throw ContinueException();
+        if (!env.inLoop()) {
+            throwError(ErrorType::Runtime, "Continue used outside of loop", line(), column());
         }
-        else {
-            throwError(ErrorType::Runtime, "Continue used outside of loop", line, column);
-        }
-    } else if (keyword == TokenType::_Return) {
-        if (right != nullptr) {
-            BuiltInFunctionReturn value = right->evaluate(env);
-            if (debug && value.has_value()) {
-                debugPrint(ValueList{value.value()});
-            } else if (debug) {
-                debugPrint(ValueList{});
-            }
-            throw ReturnException(value);
+        return Completion{CompletionType::Continue};
+    }
+    if (right != nullptr) {
+        BuiltInFunctionReturn value = right->evaluate(env);
+        if (debug && value.has_value()) {
+            debugPrint(ValueList{value.value()});
+        } else if (debug) {
+            debugPrint(ValueList{});
+        }
+        return Completion{CompletionType::Return, value};
+    }
+    return Completion{CompletionType::Return};
+}
+
+std::optional<Value> KeywordNode::evaluate(Environment& env) {
+    COUNT_NODE_STAT("KeywordNode");
+    if (debug) {
+        if (right == nullptr || keyword == TokenType::_Global) {
+            std::cout << getTabs() + "Evaluating Keyword: " + getPrintable() << std::endl;
         } else {
-            throw ReturnException(std::nullopt);
+            std::cout << getTabs() + "Entering Keyword: " + getPrintable() << std::endl;
+            addTab();
         }
+    }
+    if (keyword == TokenType::_Break || keyword == TokenType::_Continue || keyword == TokenType::_Return) {
+        // Control flow is only meaningful as a statement, see KeywordNode::execute
+        throwError(ErrorType::Runtime, "'" + getTokenTypeLabel(keyword) + "' cannot be used as a value", line(), column());
     } else if (keyword == TokenType::_Throw) {
         auto message = right->evaluate(env);
         if (!message) {
-            throwError(ErrorType::Runtime, "Thrown error requires a message", line, column);
+            throwError(ErrorType::Runtime, "Thrown error requires a message", line(), column());
         }
         if (debug) debugPrint(ValueList{message.value()});
-        throwError(ErrorType::Thrown, message.value()->getPrintable(0, true), line, column);
+        throwError(ErrorType::Thrown, message.value().getPrintable(0, true), line(), column());
     } else if (keyword == TokenType::_Global) {
-        if (auto ident = std::dynamic_pointer_cast<IdentifierNode>(right)) {
-            env.addGlobal(ident->name);
+        if (nodeCast<IdentifierNode>(right)) {
+            // Applied when the program is resolved, the name is bound to the global table from here on
         } else {
-            throwError(ErrorType::Runtime, "'global' expected an identifier", line, column);
+            throwError(ErrorType::Runtime, "'global' expected an identifier", line(), column());
         }
         return std::nullopt;
     } else if (keyword == TokenType::_Import) {
@@ -1460,59 +1550,81 @@ std::optional<std::shared_ptr<Value>> KeywordNode::evaluate(Environment& env) {
             new_path = path.substr(0, index);
         }
         auto right_value = right->evaluate(env);
-        if (!right_value.has_value() || right_value.value()->getType() != ValueType::String) {
-            throwError(ErrorType::Runtime, "'import' expected filename string", line, column);
+        if (!right_value.has_value() || right_value.value().getType() != ValueType::String) {
+            throwError(ErrorType::Runtime, "'import' expected filename string", line(), column());
         }
         if (debug) debugPrint(ValueList{right_value.value()});
         if (new_path != "") {
             new_path = new_path + "/";
         }
-        new_path = new_path + right_value.value()->get<std::string>();
+        new_path = new_path + right_value.value().get<std::string>();
         if (new_path == path) {
-            throwError(ErrorType::Runtime, "A file cannot import itself", line, column);
+            throwError(ErrorType::Runtime, "A file cannot import itself", line(), column());
+        }
+
+        if (inParallelTask()) {
+            throwError(ErrorType::Runtime, "Files cannot be imported inside a parallel task", line(), column());
         }
 
+        // Each file runs once per program, its globals are already visible to every later import
+        auto state = env.beginModule(new_path);
+        if (state == ModuleState::Loaded) {
+            return std::nullopt;
+        } else if (state == ModuleState::Loading) {
+            throwError(ErrorType::Runtime, "Circular import " + env.getImportChain() + new_path, line(), column());
+        }
+
+        COUNT_STAT(imports);
         std::string source_code = readSourceCodeFromFile(new_path);
 
         if (source_code.empty()) {
-            throwError(ErrorType::Runtime, "File " + new_path + " is empty or could not be read", line, column);
+            env.endModule(false);
+            throwError(ErrorType::Runtime, "File " + new_path + " is empty or could not be read", line(), column());
         }
 
         pushExecutionContext(new_path);
 
-        Lexer lexer{source_code};
-        auto tokens = lexer.tokenize();
-
         pushParsingContext(new_path);
-        Parser parser{tokens};
-        std::vector<std::shared_ptr<ASTNode>> statements;
-        statements = parser.parse();
+        std::vector<NodeRef<>> statements;
+        statements = parseModule(new_path, source_code, env.options().use_module_cache);
+        std::vector<Symbol> program_layout = resolveProgram(statements, env.options().use_vm_engine);
+        env.pushFrame(program_layout);
 
-
-        for (auto statement : statements) {
+        Chunk program;
+        if (env.options().use_vm_engine) {
+            program = compileBlock(statements);
+        }
+        for (size_t i = 0; i < (env.options().use_vm_engine ? 1 : statements.size()); i++) {
+            Completion completion;
             try {
-                auto result = statement->evaluate(env);
-            }
-            catch (const ReturnException) {
-                throwError(ErrorType::Runtime, "Return was used outside of function", line, column);
-            }
-            catch (const BreakException) {
-                throwError(ErrorType::Runtime, "Break was used outside of loop", line, column);
-            }
-            catch (const ContinueException) {
-                throwError(ErrorType::Runtime, "Continue was used outside of loop", line, column);
+                if (env.options().use_vm_engine) {
+                    executeChunk(program, env);
+                } else {
+                    completion = statements[i]->execute(env);
+                }
             }
             catch (const StackOverflowException) {
                 throwError(ErrorType::StackOverflow, "Excessive recursion depth reached. (Add the -IgnoreOverflow flag to the end of \
 the program execution to ignore this warning)");
             }
             catch (const ErrorException& e) {
+                env.popFrame();
+                env.endModule(false);
                 popParsingContext();
                 popExecutionContext();
-                throwError(e.error_type, e.message, line, column);
+                throwError(e.error_type, e.message, line(), column());
+            }
+            if (completion.type == CompletionType::Return) {
+                throwError(ErrorType::Runtime, "Return was used outside of function", line(), column());
+            } else if (completion.type == CompletionType::Break) {
+                throwError(ErrorType::Runtime, "Break was used outside of loop", line(), column());
+            } else if (completion.type == CompletionType::Continue) {
+                throwError(ErrorType::Runtime, "Continue was used outside of loop", line(), column());
             }
         }
 
+        env.popFrame();
+        env.endModule(true);
         popParsingContext();
         popExecutionContext();
         return std::nullopt;
@@ -1521,13 +1633,13 @@ the program execution to ignore this warning)");
             return env.getThis();
         }
         catch (const ErrorException& e) {
-            throwError(e.error_type, e.message, line, column);
+            throwError(e.error_type, e.message, line(), column());
         }
     } else if (type_map.contains(keyword)) {
         if (keyword == TokenType::_NullType) {
-            return std::make_shared<Value>();
+            return Value::none();
         }
-        return std::make_shared<Value>(type_map[keyword]);
+        return Value(type_map[keyword]);
     }
 
     if (right) {
@@ -1543,7 +1655,7 @@ void KeywordNode::debugPrint(ValueList values) {
     subTab();
     setTabs();
     std::cout << "Evaluating Keyword: ";
-    std::cout << getTokenTypeLabel(keyword) + " " + values.at(0)->getPrintable(debug_tabs) << std::endl;
+    std::cout << getTokenTypeLabel(keyword) + " " + values.at(0).getPrintable(debug_tabs) << std::endl;
 }
 
 std::string KeywordNode::getPrintable() {
@@ -1554,7 +1666,8 @@ std::string KeywordNode::getPrintable() {
     return keyword_str;
 }
 
-std::optional<std::shared_ptr<Value>> ListNode::evaluate(Environment& env) {
+std::optional<Value> ListNode::evaluate(Environment& env) {
+    COUNT_NODE_STAT("ListNode");
     if (debug) {
         std::cout << getTabs() + "Entering List: " + getPrintable() << std::endl;
         addTab();
@@ -1568,23 +1681,23 @@ std::optional<std::shared_ptr<Value>> ListNode::evaluate(Environment& env) {
             if (result) {
                 evaluated_list.push_back(result.value());
             } else {
-                throwError(ErrorType::Runtime, "List element was unable to be evaluated", line, column);
+                throwError(ErrorType::Runtime, "List element was unable to be evaluated", line(), column());
             }
         } else {
-            throwError(ErrorType::Runtime, "List contained a nullptr pointing to an ASTNode", line, column);
+            throwError(ErrorType::Runtime, "List contained a nullptr pointing to an ASTNode", line(), column());
         }
     }
 
-    if (debug) debugPrint(ValueList{std::make_shared<Value>(std::make_shared<List>(evaluated_list))});
+    if (debug) debugPrint(ValueList{Value(std::make_shared<List>(evaluated_list))});
 
-    return std::make_shared<Value>(std::make_shared<List>(evaluated_list));
+    return Value(std::make_shared<List>(evaluated_list));
 }
 
 void ListNode::debugPrint(ValueList values) {
     subTab();
     setTabs();
     std::cout << "Evaluating List: ";
-    std::cout << values.at(0)->getPrintable(debug_tabs) << std::endl;
+    std::cout << values.at(0).getPrintable(debug_tabs) << std::endl;
 }
 
 std::string ListNode::getPrintable() {
@@ -1600,43 +1713,41 @@ std::string ListNode::getPrintable() {
 }
 
 
-std::optional<std::shared_ptr<Value>> IndexNode::evaluate(Environment& env) {
+std::optional<Value> IndexNode::evaluate(Environment& env) {
+    COUNT_NODE_STAT("IndexNode");
     if (debug) {
         std::cout << getTabs() + "Entering Index: " + getPrintable() << std::endl;
         addTab();
     }
     if (container == nullptr) {
-        throwError(ErrorType::Runtime, "Null object is not subscriptable", line, column);
+        throwError(ErrorType::Runtime, "Null object is not subscriptable", line(), column());
     }
 
     auto eval = container->evaluate(env);
-    if (eval) {
-        if (eval.value()->getType() == ValueType::String) {
-            auto string_val = std::make_shared<std::string>(eval.value()->get<std::string>());
-            return getIndex(env, string_val);
-        }
-        else if (eval.value()->getType() == ValueType::List) {
-            auto list_val = eval.value()->get<std::shared_ptr<List>>();
-            return getIndex(env, list_val);
-        }
-        else if (eval.value()->getType() == ValueType::Dictionary) {
-            auto dict_val = eval.value()->get<std::shared_ptr<Dictionary>>();
-            return getIndex(env, dict_val);
-        }
-        else {
-            throwError(ErrorType::Runtime, "Index node container was of invalid type: " + getValueStr(eval.value()), line, column);
-        }
+    if (!eval) {
+        return std::nullopt;
     }
-    return std::nullopt;
+    ValueType container_type = eval.value().getType();
+    if (container_type != ValueType::String && container_type != ValueType::List && container_type != ValueType::Dictionary
+        && container_type != ValueType::Range) {
+        throwError(ErrorType::Runtime, "Index node container was of invalid type: " + getValueStr(eval.value()), line(), column());
+    }
+
+    auto start_result = start_index->evaluate(env);
+    std::optional<Value> end_result;
+    if (end_index) {
+        end_result = end_index->evaluate(env);
+    }
+    return getIndex(eval.value(), start_result.value_or(nullptr), end_result.value_or(nullptr));
 }
 
 void IndexNode::debugPrint(ValueList values) {
     subTab();
     setTabs();
     std::cout << "Evaluating Index: ";
-    std::cout << values.at(0)->getPrintable(debug_tabs) << "[" << values.at(1)->getPrintable(debug_tabs);
+    std::cout << values.at(0).getPrintable(debug_tabs) << "[" << values.at(1).getPrintable(debug_tabs);
     if (values.size() == 3) {
-        std::cout << ":" << values.at(2)->getPrintable(debug_tabs);
+        std::cout << ":" << values.at(2).getPrintable(debug_tabs);
     }
     std::cout << "] -> retrieving value at index" << std::endl;
 }
@@ -1650,7 +1761,7 @@ std::string IndexNode::getPrintable() {
     return str;
 }
 
-std::variant<char, std::shared_ptr<Value>> getAtIndex(std::variant<std::shared_ptr<std::string>,
+std::variant<char, Value> getAtIndex(std::variant<std::shared_ptr<std::string>,
                                                                     std::shared_ptr<List>,
                                                                     std::shared_ptr<Dictionary>> distr,
                                                         int index, int line, int column) {
@@ -1680,13 +1791,18 @@ std::variant<char, std::shared_ptr<Value>> getAtIndex(std::variant<std::shared_p
     return nullptr;
 }
 
-std::optional<std::shared_ptr<Value>> IndexNode::getIndex(Environment& env,
-                                                    std::variant<std::shared_ptr<std::string>,
-                                                                std::shared_ptr<List>,
-                                                                std::shared_ptr<Dictionary>> distr) {
+std::optional<Value> IndexNode::getIndex(Value container_value,
+                                                            Value start_value,
+                                                            Value end_value) {
+    ValueType container_type = container_value.getType();
+    if (container_type != ValueType::String && container_type != ValueType::List && container_type != ValueType::Dictionary
+        && container_type != ValueType::Range) {
+        throwError(ErrorType::Runtime, "Index node container was of invalid type: " + getValueStr(container_value), line(), column());
+    }
+
     if (end_index) {
-        if (std::holds_alternative<std::shared_ptr<Dictionary>>(distr)) {
-            throwError(ErrorType::Runtime, "Dictionary is not subscriptable", line, column);
+        if (container_type == ValueType::Dictionary) {
+            throwError(ErrorType::Runtime, "Dictionary is not subscriptable", line(), column());
             return std::nullopt;
         }
         auto resolveIndex = [&](const Value& index, int container_size) -> int {
@@ -1701,101 +1817,106 @@ std::optional<std::shared_ptr<Value>> IndexNode::getIndex(Environment& env,
                     return container_size; // Resolve "end" to container size
                 }
             }
-            throwError(ErrorType::Runtime, "Invalid index type: " + getValueStr(index), line, column);
+            throwError(ErrorType::Runtime, "Invalid index type: " + getValueStr(index), line(), column());
         };
 
-        auto start_result = start_index->evaluate(env);
-        auto end_result = end_index->evaluate(env);
+        if (!start_value || !end_value) {
+            throwError(ErrorType::Runtime, "Failed to evaluate start_index or end_index", line(), column());
+        }
+        if (debug) debugPrint(ValueList{container_value, start_value, end_value});
 
-        if (start_result && end_result) {
-            // Check if the container is a string or list
-            if (std::holds_alternative<std::shared_ptr<std::string>>(distr)) {
-                if (debug) debugPrint(ValueList{std::make_shared<Value>(*std::get<std::shared_ptr<std::string>>(distr)),
-                                        start_result.value(), end_result.value()});
-                auto str = std::get<std::shared_ptr<std::string>>(distr);
-                int size = str->size();
+        // Check if the container is a string or list
+        if (container_type == ValueType::String) {
+            const std::string& str = container_value.get<std::string>();
+            int size = str.size();
 
-                // Resolve indices
-                int start_val = resolveIndex(*start_result.value(), size);
-                int end_val = resolveIndex(*end_result.value(), size);
+            // Resolve indices
+            int start_val = resolveIndex(start_value, size);
+            int end_val = resolveIndex(end_value, size);
 
-                // Return empty string if range is invalid
-                if (start_val >= end_val) {
-                    return std::make_shared<Value>("");
-                }
+            // Return empty string if range is invalid
+            if (start_val >= end_val) {
+                return Value("");
+            }
 
-                // Extract substring
-                std::string sub_str = str->substr(start_val, end_val - start_val);
-                return std::make_shared<Value>(sub_str);
-            } else if (std::holds_alternative<std::shared_ptr<List>>(distr)) {
-                if (debug) debugPrint(ValueList{std::make_shared<Value>(std::get<std::shared_ptr<List>>(distr)),
-                                        start_result.value(), end_result.value()});
-                auto list_ptr = std::get<std::shared_ptr<List>>(distr);
-                int size = list_ptr->size();
-
-                // Resolve indices
-                int start_val = resolveIndex(*start_result.value(), size);
-                int end_val = resolveIndex(*end_result.value(), size);
-
-                // Return empty list if range is invalid
-                if (start_val >= end_val) {
-                    return std::make_shared<Value>(std::make_shared<List>());
-                }
+            // Extract substring
+            std::string sub_str = str.substr(start_val, end_val - start_val);
+            return Value(sub_str);
+        } else if (container_type == ValueType::Range) {
+            // Slicing a range is another range
+            const Range& range = container_value.get<Range>();
+            int size = range.size();
+            int start_val = resolveIndex(start_value, size);
+            int end_val = std::max(resolveIndex(end_value, size), start_val);
+            return Value(Range{range.at(start_val), range.at(end_val), range.step});
+        } else {
+            auto list_ptr = container_value.get<std::shared_ptr<List>>();
+            int size = list_ptr->size();
 
-                // Create a new list with the slice
-                auto new_list = std::make_shared<List>();
-                for (int i = start_val; i < end_val; ++i) {
-                    auto list_val = std::get<std::shared_ptr<Value>>(
-                        getAtIndex(list_ptr, i, line, column));
-                    new_list->push_back(list_val);
-                }
-                return std::make_shared<Value>(new_list);
-            } else {
-                throwError(ErrorType::Runtime, "Dictionary cannot be indexed", line, column);
+            // Resolve indices
+            int start_val = resolveIndex(start_value, size);
+            int end_val = resolveIndex(end_value, size);
+
+            // Return empty list if range is invalid
+            if (start_val >= end_val) {
+                return Value(std::make_shared<List>());
             }
-        } else {
-            throwError(ErrorType::Runtime, "Failed to evaluate start_index or end_index", line, column);
+
+            // Create a new list with the slice
+            auto new_list = std::make_shared<List>();
+            for (int i = start_val; i < end_val; ++i) {
+                auto list_val = std::get<Value>(
+                    getAtIndex(list_ptr, i, line(), column()));
+                new_list->push_back(list_val);
+            }
+            return Value(new_list);
         }
     } else {
-        if (std::holds_alternative<std::shared_ptr<Dictionary>>(distr)) {
+        if (container_type == ValueType::Dictionary) {
             // It's a dictionary, not string or list
-            auto dict = std::get<std::shared_ptr<Dictionary>>(distr);
-            auto key = start_index->evaluate(env);
-            if (key) {
-                if (debug) debugPrint(ValueList{std::make_shared<Value>(std::get<std::shared_ptr<Dictionary>>(distr)), key.value()});
-                auto it = dict->find(key.value());
-                if (it != dict->end()) {
-                    return it->second;
-                } else {
-                    throwError(ErrorType::Runtime, "Unable to find key " + key.value()->getPrintable() + " in dictionary", line, column);
-                }
+            auto dict = container_value.get<std::shared_ptr<Dictionary>>();
+            if (!start_value) {
+                throwError(ErrorType::Runtime, "Failed to evaluate key", line(), column());
+            }
+            if (debug) debugPrint(ValueList{container_value, start_value});
+            auto it = dict->find(start_value);
+            if (it != dict->end()) {
+                return it->second;
             } else {
-                throwError(ErrorType::Runtime, "Failed to evaluate key", line, column);
+                throwError(ErrorType::Runtime, "Unable to find key " + start_value.getPrintable() + " in dictionary", line(), column());
             }
         } else {
-            auto result = start_index->evaluate(env);
-            if (result) {
-                if (result.value()->getType() == ValueType::Integer) {
-                    int int_val = result.value()->get<int>();
-                    if (std::holds_alternative<std::shared_ptr<std::string>>(distr)) {
-                       if (debug) debugPrint(ValueList{std::make_shared<Value>(*std::get<std::shared_ptr<std::string>>(distr)), result.value()});
-                        auto get_char = getAtIndex(distr, int_val, line, column);
-                        if (std::holds_alternative<char>(get_char)) {
-                            auto c = std::get<char>(get_char);
-                            std::string str = std::string(1, c);
-                            return std::make_shared<Value>(str);
-                        }
-                    } else {
-                        if (debug) debugPrint(ValueList{std::make_shared<Value>(std::get<std::shared_ptr<List>>(distr)), result.value()});
-                        auto value = std::get<std::shared_ptr<Value>>(getAtIndex(distr, int_val, line, column));
-                        return value;
-                    }
-                } else {
-                    throwError(ErrorType::Runtime, "The index was not given an int", line, column);
+            if (!start_value) {
+                throwError(ErrorType::Runtime, "Failed to evaluate start_index", line(), column());
+                return std::nullopt;
+            }
+            if (start_value.getType() != ValueType::Integer) {
+                throwError(ErrorType::Runtime, "The index was not given an int", line(), column());
+            }
+            if (debug) debugPrint(ValueList{container_value, start_value});
+            int int_val = start_value.get<int>();
+            if (container_type == ValueType::String) {
+                auto string_val = std::make_shared<std::string>(container_value.get<std::string>());
+                auto get_char = getAtIndex(string_val, int_val, line(), column());
+                if (std::holds_alternative<char>(get_char)) {
+                    auto c = std::get<char>(get_char);
+                    std::string str = std::string(1, c);
+                    return Value(str);
+                }
+            } else if (container_type == ValueType::Range) {
+                const Range& range = container_value.get<Range>();
+                int size = range.size();
+                if (int_val < 0) {
+                    int_val += size;
+                }
+                if (int_val < 0 || int_val >= size) {
+                    throwError(ErrorType::Runtime, "Range index out of range", line(), column());
                 }
+                return Value(range.at(int_val));
             } else {
-                throwError(ErrorType::Runtime, "Failed to evaluate start_index", line, column);
-                return std::nullopt;
+                auto list_val = container_value.get<std::shared_ptr<List>>();
+                auto value = std::get<Value>(getAtIndex(list_val, int_val, line(), column()));
+                return value;
             }
         }
     }
@@ -1803,19 +1924,19 @@ std::optional<std::shared_ptr<Value>> IndexNode::getIndex(Environment& env,
     return std::nullopt;
 }
 
-void setAtIndex(std::variant<std::shared_ptr<List>, std::shared_ptr<Dictionary>> env_dist, std::shared_ptr<Value> index_key, std::shared_ptr<Value> value) {
+void setAtIndex(std::variant<std::shared_ptr<List>, std::shared_ptr<Dictionary>> env_dist, Value index_key, Value value) {
     if (std::holds_alternative<std::shared_ptr<List>>(env_dist)) {
         auto env_list = std::get<std::shared_ptr<List>>(env_dist);
-        int list_index = index_key->get<int>();
+        int list_index = index_key.get<int>();
         if (list_index >= 0 && list_index <= env_list->size()) {
-            if (value->getType() == ValueType::String) {
+            if (value.getType() == ValueType::String) {
                 // Assigning a string
-                auto str_val = value->get<std::string>();
+                auto str_val = value.get<std::string>();
                 std::string s = "";
                 int i = 0;
                 for (auto c : str_val) {
                     s += c;
-                    auto char_str = std::make_shared<Value>(s);
+                    auto char_str = Value(s);
                     if (list_index + i == env_list->size()) {
                         env_list->push_back(char_str);
                     } else {
@@ -1824,8 +1945,8 @@ void setAtIndex(std::variant<std::shared_ptr<List>, std::shared_ptr<Dictionary>>
                     s = "";
                     i++;
                 }
-            } else if (value->getType() == ValueType::List) {
-                auto list_val = value->get<std::shared_ptr<List>>();
+            } else if (value.getType() == ValueType::List) {
+                auto list_val = value.get<std::shared_ptr<List>>();
                 // Assigning a list
                 for (int i = list_val->size() - 1; i >= 0; i--) {
                     if (list_index == env_list->size()) {
@@ -1847,46 +1968,53 @@ void setAtIndex(std::variant<std::shared_ptr<List>, std::shared_ptr<Dictionary>>
     }
 }
 
-void IndexNode::assignIndex(Environment& env, std::shared_ptr<Value> value) {
-    auto eval = container->evaluate(env);
-    std::shared_ptr<Value> env_val;
-    if (eval) {
-        env_val = eval.value();
-    } else {
-        throwError(ErrorType::Runtime, "Index assigment unable to evaluate the container", line, column);
+void IndexNode::assignIndex(Environment& env, Value value) {
+    Value container_value = container->evaluate(env).value_or(nullptr);
+    Value start_value = nullptr;
+    Value end_value = nullptr;
+    ValueType type = container_value.getType();
+    if (type == ValueType::List || (type == ValueType::Dictionary && end_index == nullptr)) {
+        start_value = start_index->evaluate(env).value_or(nullptr);
+        if (end_index != nullptr) {
+            end_value = end_index->evaluate(env).value_or(nullptr);
+        }
+    }
+    setIndex(container_value, start_value, end_value, value);
+}
+
+void IndexNode::setIndex(Value env_val, Value start_value, Value end_value, Value value) {
+    if (!env_val) {
+        throwError(ErrorType::Runtime, "Index assigment unable to evaluate the container", line(), column());
         return;
     }
-    if (env_val->getType() == ValueType::List) {
-        std::shared_ptr<List> env_list = env_val->get<std::shared_ptr<List>>();
+    if (env_val.getType() == ValueType::List) {
+        std::shared_ptr<List> env_list = env_val.get<std::shared_ptr<List>>();
 
         if (end_index == nullptr) {
             // A single index assignment
-            auto index_eval = start_index->evaluate(env);
-            if (index_eval) {
-                if (index_eval.value()->getType() == ValueType::Integer) {
-                    int index = index_eval.value()->get<int>();
+            if (start_value) {
+                if (start_value.getType() == ValueType::Integer) {
+                    int index = start_value.get<int>();
                     if (index >= 0 && index < env_list->size()) {
                         env_list->set(index, value);
                     } else if (index < 0 && index >= env_list->size() * -1) {
                         env_list->set(env_list->size() - index, value);
                     } else {
-                        throwError(ErrorType::Runtime, "Index assigment out of range", line, column);
+                        throwError(ErrorType::Runtime, "Index assigment out of range", line(), column());
                     }
                 } else {
-                    throwError(ErrorType::Runtime, "Index assigment requires int", line, column);
+                    throwError(ErrorType::Runtime, "Index assigment requires int", line(), column());
                 }
             } else {
-                throwError(ErrorType::Runtime, "Failed to evaluate assigment index", line, column);
+                throwError(ErrorType::Runtime, "Failed to evaluate assigment index", line(), column());
             }
         } else {
             // List slice index assignment
-            auto start_eval = start_index->evaluate(env);
-            auto end_eval = end_index->evaluate(env);
-            if (start_eval && end_eval) {
-                if (start_eval.value()->getType() == ValueType::Integer) {
-                    int start_val = start_eval.value()->get<int>();
-                    if (end_eval.value()->getType() == ValueType::Integer) {
-                        int end_val = end_eval.value()->get<int>();
+            if (start_value && end_value) {
+                if (start_value.getType() == ValueType::Integer) {
+                    int start_val = start_value.get<int>();
+                    if (end_value.getType() == ValueType::Integer) {
+                        int end_val = end_value.get<int>();
                         int slice_size = std::abs(end_val - start_val);
                         // Cut out the slice section of the original list
                         for (int i = 0; i < slice_size; i++) {
@@ -1895,52 +2023,53 @@ void IndexNode::assignIndex(Environment& env, std::shared_ptr<Value> value) {
                             }
                             env_list->pop(start_val);
                         }
-                        setAtIndex(env_list, start_eval.value(), value);
+                        setAtIndex(env_list, start_value, value);
                     } else {
-                        throwError(ErrorType::Runtime, "Assigment index end value is not an int", line, column);
+                        throwError(ErrorType::Runtime, "Assigment index end value is not an int", line(), column());
                     }
                 } else {
-                    throwError(ErrorType::Runtime, "Assignment index start value is not an int", line, column);
+                    throwError(ErrorType::Runtime, "Assignment index start value is not an int", line(), column());
                 }
             } else {
-                throwError(ErrorType::Runtime, "Assigment index was unable to evaluate", line, column);
+                throwError(ErrorType::Runtime, "Assigment index was unable to evaluate", line(), column());
             }
         }
     }
-    else if (env_val->getType() == ValueType::Dictionary) {
-        std::shared_ptr<Dictionary> env_dict = env_val->get<std::shared_ptr<Dictionary>>();
+    else if (env_val.getType() == ValueType::Dictionary) {
+        std::shared_ptr<Dictionary> env_dict = env_val.get<std::shared_ptr<Dictionary>>();
 
         if (end_index == nullptr) {
-            auto key_eval = start_index->evaluate(env);
-            if (key_eval) {
-                setAtIndex(env_dict, key_eval.value(), value);
+            if (start_value) {
+                setAtIndex(env_dict, start_value, value);
             } else {
-                throwError(ErrorType::Runtime, "Failed to evaluate assigment key", line, column);
+                throwError(ErrorType::Runtime, "Failed to evaluate assigment key", line(), column());
             }
         } else {
-            throwError(ErrorType::Runtime, "Dictionary is not subscriptable", line, column);
+            throwError(ErrorType::Runtime, "Dictionary is not subscriptable", line(), column());
         }
     }
     else {
-        throwError(ErrorType::Runtime, getValueStr(env_val) + " object does not support item assigment", line, column);
+        throwError(ErrorType::Runtime, getValueStr(env_val) + " object does not support item assigment", line(), column());
         return;
     }
 }
 
-std::optional<std::shared_ptr<Value>> FuncNode::evaluate(Environment& env) {
+std::optional<Value> FuncNode::evaluate(Environment& env) {
+    COUNT_NODE_STAT("FuncNode");
     if (debug) std::cout << getTabs() + "Evaluating Function: " + getPrintable() << std::endl;
-    local_env = Environment{env};
+    // The closure and default values belong to the function made here, the definition itself stays untouched
+    auto func = std::make_shared<FuncNode>(*this);
     int i = 0;
     for (auto pair : default_arg_nodes) {
         i++;
-        auto value = pair.second->evaluate(local_env);
+        auto value = pair.second->evaluate(env);
         if (!value) {
-            std::shared_ptr<Value> func_value = std::make_shared<Value>(std::make_shared<FuncNode>(*this));
-            throwError(ErrorType::Runtime, "Unable to evaluate default argument " + std::to_string(i), line, column);
+            throwError(ErrorType::Runtime, "Unable to evaluate default argument " + std::to_string(i), line(), column());
         }
-        default_arg_values[pair.first] = value.value();
+        func->default_arg_values[pair.first] = value.value();
     }
-    std::shared_ptr<Value> func_value = std::make_shared<Value>(std::make_shared<FuncNode>(*this));
+    func->closure = env.getFrame();
+    Value func_value = Value(func);
     return func_value;
 }
 
@@ -1948,6 +2077,22 @@ void FuncNode::debugPrint(ValueList) {
     return;
 }
 
+void FuncNode::trace(GCVisitor& visitor) const {
+    visitor.visit(closure.get());
+    for (const auto& pair : default_arg_values) {
+        visitor.visit(pair.second);
+    }
+}
+
+void FuncNode::clearReferences() {
+    closure = nullptr;
+    default_arg_values.clear();
+}
+
+size_t FuncNode::memoryUsage() const {
+    return sizeof(FuncNode);
+}
+
 std::string FuncNode::getPrintable() {
     std::string str = *func_name + "(";
     for (int i = 0; i < args.size(); i++) {
@@ -1961,28 +2106,28 @@ std::string FuncNode::getPrintable() {
 }
 
 void FuncNode::setArgs(ValueList values,
-                        std::map<std::string, std::shared_ptr<Value>> pairs, Scope& local_scope) {
+                        std::map<std::string, Value> pairs, Environment& call_env) {
 
     int num_args = values.size();
 
     values.resize(args.size());
     for (auto pair : pairs) {
         std::string name = pair.first;
-        std::shared_ptr<Value> value = pair.second;
+        Value value = pair.second;
         num_args++;
         bool found_match = false;
         for (size_t i = 0; i < args.size(); i++) {
-            auto ident_node = std::dynamic_pointer_cast<IdentifierNode>(args.at(i));
+            auto ident_node = nodeCast<IdentifierNode>(args.at(i));
             if (ident_node->name == name) {
                 if (values.at(i) != nullptr) {
-                    throwError(ErrorType::Runtime, "Cannot assign mutliple values to " + name, line, column);
+                    throwError(ErrorType::Runtime, "Cannot assign mutliple values to " + name, line(), column());
                 }
                 values[i] = value;
                 found_match = true;
             }
         }
         if (!found_match) {
-            throwError(ErrorType::Runtime, "Unable to match argument name '" + name + "'", line, column);
+            throwError(ErrorType::Runtime, "Unable to match argument name '" + name + "'", line(), column());
         }
     }
 
@@ -1991,22 +2136,21 @@ void FuncNode::setArgs(ValueList values,
         if (num_args > args.size()) {
             if (default_arg_values.size() > 0) {
                 throwError(ErrorType::ArityMismatch, std::format("Function takes from {} to {} arguments but {} were given",
-                                                            args.size() - default_arg_values.size(), args.size(), num_args), line, column);
+                                                            args.size() - default_arg_values.size(), args.size(), num_args), line(), column());
             } else {
-                throwError(ErrorType::ArityMismatch, std::format("Function takes {} arguments but {} were given", args.size(), num_args), line, column);
+                throwError(ErrorType::ArityMismatch, std::format("Function takes {} arguments but {} were given", args.size(), num_args), line(), column());
             }
         } else if (num_args < args.size() - default_arg_values.size()) {
-            throwError(ErrorType::ArityMismatch, std::format("Missing {} required arguments", args.size() - default_arg_values.size() - num_args), line, column);
+            throwError(ErrorType::ArityMismatch, std::format("Missing {} required arguments", args.size() - default_arg_values.size() - num_args), line(), column());
         }
     }
 
     for (size_t i = 0; i < args.size(); i++) {
-        if (auto ident_node = std::dynamic_pointer_cast<IdentifierNode>(args.at(i))) {
-            std::string arg_string = ident_node->name;
+        if (auto ident_node = nodeCast<IdentifierNode>(args.at(i))) {
             if (values.at(i)) {
-                local_scope.set(arg_string, values.at(i));
+                call_env.setLocal(0, i, values.at(i));
             } else {
-                local_scope.set(arg_string, default_arg_values.at(arg_string));
+                call_env.setLocal(0, i, default_arg_values.at(ident_node->name));
             }
         }
     }
@@ -2014,247 +2158,288 @@ void FuncNode::setArgs(ValueList values,
     return;
 }
 
-std::optional<std::shared_ptr<Value>> FuncNode::callFunc(ValueList values,
-                                                        std::map<std::string, std::shared_ptr<Value>> pairs,
-                                                        Environment& global_env, bool member_func) {
-    Environment local_env_copy{local_env};
-    std::vector<Scope> copied_scopes = global_env.copyScopes();
-    for (const auto& pair : copied_scopes.at(0).getPairs()) {
-        local_env_copy.setGlobalValue(pair.first, pair.second);
+namespace {
+
+// Calls of each function value running on this thread, kept per thread since a value can run on several at once
+thread_local std::unordered_map<const FuncNode*, int> recursion_depths;
+
+struct RecursionDepth {
+    explicit RecursionDepth(const FuncNode* func)
+        : entry{*recursion_depths.try_emplace(func, 0).first}, depth{++entry.second} {}
+    ~RecursionDepth() {
+        if (--entry.second == 0) {
+            recursion_depths.erase(entry.first);
+        }
     }
-    Scope local_scope;
+    RecursionDepth(const RecursionDepth&) = delete;
+    RecursionDepth& operator=(const RecursionDepth&) = delete;
+
+    std::pair<const FuncNode* const, int>& entry;
+    int depth;
+};
+
+}
+
+std::optional<Value> FuncNode::callFunc(ValueList values,
+                                                        std::map<std::string, Value> pairs,
+                                                        Environment& caller_env, bool member_func) {
+    // The call shares the caller's globals and instance attributes, only the frame is new
+    COUNT_STAT(function_calls);
+    Environment call_env{caller_env, closure};
     pushFunctionContext(*func_name, file_context);
-    if (!member_func) {
-        local_scope.set(*func_name, global_env.get(*func_name, member_func));
-    }
-    setArgs(values, pairs, local_scope);
-    if (global_env.isClassEnv()) {
-        local_env_copy.setClassEnv();
-        local_env_copy.setClassAttrs(global_env.getClassAttrs());
-        local_env_copy.setThis(global_env.getThis());
-    }
-    local_env_copy.addScope(local_scope);
-    recursion += 1;
-    std::optional<std::shared_ptr<Value>> return_value = std::nullopt;
-    if (recursion > 1000 && detect_recursion_limit) {
+    call_env.pushFrame(frame_layout);
+    setArgs(values, pairs, call_env);
+    RecursionDepth recursion{this};
+    std::optional<Value> return_value = std::nullopt;
+    if (recursion.depth > 1000 && call_env.options().detect_recursion) {
+        COUNT_STAT(exceptions);
         throw StackOverflowException();
     }
     try {
-        for (auto statement : block) {
-            auto result = statement->evaluate(local_env_copy);
+        if (chunk) {
+            return_value = executeChunk(*chunk, call_env);
+        } else {
+            return_value = executeBlock(block, call_env).value;
         }
     }
-    catch (const ReturnException& e) {
-        return_value = e.value;
-    }
     catch (const ErrorException& e) {
         popFunctionContext();
         throw;
     }
 
-    if (global_env.isClassEnv()) {
-        auto attrs = local_env_copy.getClassAttrs();
-        global_env.setClassAttrs(attrs);
-    }
+    popFunctionContext();
 
-    auto scopes = local_env_copy.copyScopes();
-    for (const auto& pair : scopes.at(0).getPairs()) {
-        global_env.setGlobalValue(pair.first, pair.second);
-    }
-    recursion -= 1;
+    return return_value;
+}
 
-    local_env_copy.removeScope();
+std::optional<Value> FuncNode::callCompiled(Value* values, Environment& caller_env) {
+    COUNT_STAT(function_calls);
+    Environment call_env{caller_env, closure};
+    pushFunctionContext(*func_name, file_context);
+    call_env.pushFrame(frame_layout);
+    for (size_t i = 0; i < args.size(); i++) {
+        call_env.setLocal(0, static_cast<int>(i), std::move(values[i]));
+    }
+    RecursionDepth recursion{this};
+    if (recursion.depth > 1000 && call_env.options().detect_recursion) {
+        COUNT_STAT(exceptions);
+        throw StackOverflowException();
+    }
+    std::optional<Value> return_value;
+    try {
+        return_value = executeChunk(*chunk, call_env);
+    }
+    catch (const ErrorException& e) {
+        popFunctionContext();
+        throw;
+    }
     popFunctionContext();
-
     return return_value;
 }
 
-std::optional<std::shared_ptr<Value>> MethodCallNode::evaluate(Environment& env) {
+std::optional<Value> MethodCallNode::evaluate(Environment& env) {
+    COUNT_NODE_STAT("MethodCallNode");
     if (debug) {
         std::cout << getTabs() + "Entering Method Call: " + getPrintable() << std::endl;
         addTab();
     }
     auto mapped_value = stored_func->evaluate(env).value();
-    if (mapped_value->getType() == ValueType::Function) {
-        auto func_value = mapped_value->get<std::shared_ptr<ASTNode>>();
-        if (auto func = std::dynamic_pointer_cast<FuncNode>(func_value)) {
-            ValueList args;
-            std::map<std::string, std::shared_ptr<Value>> pairs;
-            evaluateArgs(args, pairs, env);
-            if (debug) {
-                ValueList debug_values{mapped_value};
-                for (auto value : args) {
-                    debug_values.push_back(value);
-                }
-                debugPrint(debug_values);
+    ValueType mapped_type = mapped_value.getType();
+    ValueList args;
+    std::map<std::string, Value> pairs;
+    if (mapped_type == ValueType::Function || mapped_type == ValueType::BuiltInFunction || mapped_type == ValueType::Class) {
+        evaluateArgs(args, pairs, env);
+        if (debug) {
+            ValueList debug_values{mapped_value};
+            for (auto value : args) {
+                debug_values.push_back(value);
             }
+            debugPrint(debug_values);
+        }
+    }
+    return callValue(env, mapped_value, args, pairs);
+}
+
+std::optional<Value> MethodCallNode::callValue(Environment& env, Value mapped_value,
+                                                                ValueList& args, std::map<std::string, Value>& pairs) {
+    if (mapped_value.getType() == ValueType::Function) {
+        auto func_value = mapped_value.get<std::shared_ptr<ASTNode>>();
+        if (auto func = std::dynamic_pointer_cast<FuncNode>(func_value)) {
             try {
                 auto result = func->callFunc(args, pairs, env, func->member_func);
                 return result;
             }
             catch (const ErrorException& e) {
-                throwError(e.error_type, e.message, line, column);
+                throwError(e.error_type, e.message, line(), column());
             }
         } else {
-            if (auto ident_node = std::dynamic_pointer_cast<IdentifierNode>(stored_func)) {
-                throwError(ErrorType::Runtime, "Unable to call function " + ident_node->name, line, column);
+            if (auto ident_node = nodeCast<IdentifierNode>(stored_func)) {
+                throwError(ErrorType::Runtime, "Unable to call function " + ident_node->name, line(), column());
             } else {
-                auto func_value = stored_func->evaluate(env);
-                if (func_value.has_value()) {
-                    throwError(ErrorType::Runtime, "Unable to call function " + func_value.value()->getPrintable(debug_tabs), line, column);
-                } else {
-                    throwError(ErrorType::Runtime, "Unable to call function", line, column);
-                }
+                throwError(ErrorType::Runtime, "Unable to call function " + mapped_value.getPrintable(debug_tabs), line(), column());
             }
         }
-    } else if (mapped_value->getType() == ValueType::BuiltInFunction) {
-        auto func_value = mapped_value->get<std::shared_ptr<BuiltInFunction>>();
-        ValueList args;
-        std::map<std::string, std::shared_ptr<Value>> pairs;
-        evaluateArgs(args, pairs, env);
-        if (debug) {
-            ValueList debug_values{mapped_value};
-            for (auto value : args) {
-                debug_values.push_back(value);
-            }
-            debugPrint(debug_values);
-        }
+    } else if (mapped_value.getType() == ValueType::BuiltInFunction) {
+        auto func_value = mapped_value.get<std::shared_ptr<BuiltInFunction>>();
         if (pairs.size() != 0) {
-            throwError(ErrorType::Runtime, "Builtin functions do not accept labeled arguments", line, column);
+            throwError(ErrorType::Runtime, "Builtin functions do not accept labeled arguments", line(), column());
         }
+        COUNT_STAT(builtin_calls);
         try {
-            return (*func_value)(args, env);
+            auto result = (*func_value)(args, env);
+            // Ticks that fired while the builtin ran belong to the call that ran it, not to whatever runs next
+            profileSafePoint(this);
+            return result;
         }
         catch (const ErrorException& e) {
-            throwError(e.error_type, e.message, line, column);
+            throwError(e.error_type, e.message, line(), column());
         }
-    } else if (mapped_value->getType() == ValueType::Class) {
-        auto class_value = mapped_value->get<std::shared_ptr<Class>>();
+    } else if (mapped_value.getType() == ValueType::Class) {
+        auto class_value = mapped_value.get<std::shared_ptr<Class>>();
         try {
             std::shared_ptr<Instance> instance = class_value->createInstance();
             auto constructor = instance->getConstructor(instance);
-            auto node = constructor->get<std::shared_ptr<ASTNode>>();
+            auto node = constructor.get<std::shared_ptr<ASTNode>>();
             auto func_node = std::static_pointer_cast<FuncNode>(node);
-            instance->getEnvironment().setThis(std::make_shared<Value>(instance));
-            ValueList args;
-            std::map<std::string, std::shared_ptr<Value>> pairs;
-            evaluateArgs(args, pairs, env);
-            if (debug) {
-                ValueList debug_values{mapped_value};
-                for (auto value : args) {
-                    debug_values.push_back(value);
-                }
-                debugPrint(debug_values);
-            }
+            instance->getEnvironment().setThis(Value(instance));
             func_node->callFunc(args, pairs, instance->getEnvironment(), true);
-            auto scopes = instance->getEnvironment().copyScopes();
-            for (const auto& pair : scopes.at(0).getPairs()) {
-                env.setGlobalValue(pair.first, pair.second);
-            }
-            return std::make_shared<Value>(instance);
+            return Value(instance);
         }
         catch (const ErrorException& e) {
-                throwError(e.error_type, e.message, line, column);
+                throwError(e.error_type, e.message, line(), column());
             }
     }
     else {
-        throwError(ErrorType::Runtime, "Object type " + getValueStr(mapped_value) + " is not callable", line, column);
+        throwError(ErrorType::Runtime, "Object type " + getValueStr(mapped_value) + " is not callable", line(), column());
     }
     return std::nullopt;
 }
 
-std::optional<std::shared_ptr<Value>> MethodCallNode::evaluate(Environment& env, ValueType member_type) {
+std::optional<Value> MethodCallNode::evaluate(Environment& env, const Value& receiver) {
+    COUNT_NODE_STAT("MethodCallNode");
     if (debug) {
         std::cout << getTabs() + "Entering Method Call: " + getPrintable() << std::endl;
         addTab();
     }
-    auto ident_node = std::dynamic_pointer_cast<IdentifierNode>(stored_func);
-    if (!ident_node) {
-        throwError(ErrorType::Runtime, "Unable to call function", line, column);
+    if (!debug) {
+        if (auto func = builtinMember(env, receiver.getType())) {
+            ValueList args{receiver};
+            std::map<std::string, Value> pairs;
+            evaluateArgs(args, pairs, env);
+            if (pairs.size() != 0) {
+                throwError(ErrorType::Runtime, "Builtin functions do not accept labeled arguments", line(), column());
+            }
+            return callBuiltinMember(env, func, args);
+        }
     }
     Environment environment{env};
-    if (member_value->getType() == ValueType::Instance) {
-        auto inst_node = member_value->get<std::shared_ptr<Instance>>();
+    auto mapped_value = resolveMember(receiver, environment);
+    ValueType mapped_type = mapped_value.getType();
+    ValueList args;
+    std::map<std::string, Value> pairs;
+    if (mapped_type == ValueType::Function || mapped_type == ValueType::BuiltInFunction) {
+        evaluateArgs(args, pairs, env);
+        if (debug) {
+            ValueList debug_values{mapped_value};
+            for (auto value : args) {
+                debug_values.push_back(value);
+            }
+            debugPrint(debug_values);
+        }
+    }
+    return callMember(env, environment, receiver, mapped_value, args, pairs);
+}
+
+Value MethodCallNode::resolveMember(Value receiver, Environment& environment) {
+    auto ident_node = nodeCast<IdentifierNode>(stored_func);
+    if (!ident_node) {
+        throwError(ErrorType::Runtime, "Unable to call function", line(), column());
+    }
+    if (receiver.getType() == ValueType::Instance) {
+        auto inst_node = receiver.get<std::shared_ptr<Instance>>();
         environment = inst_node->copyEnvironment();
-        ident_node->member_variable = true;
     }
-    std::shared_ptr<Value> mapped_value;
-    mapped_value = ident_node->evaluate(environment, member_type).value();
-    if (mapped_value->getType() == ValueType::Function) {
-        auto func_value = mapped_value->get<std::shared_ptr<ASTNode>>();
+    return ident_node->evaluate(environment, receiver.getType()).value();
+}
+
+std::optional<Value> MethodCallNode::callMember(Environment& env, Environment& environment,
+                                                                Value receiver, Value mapped_value,
+                                                                ValueList& args, std::map<std::string, Value>& pairs) {
+    ValueType member_type = receiver.getType();
+    if (mapped_value.getType() == ValueType::Function) {
+        auto func_value = mapped_value.get<std::shared_ptr<ASTNode>>();
         if (auto func = std::dynamic_pointer_cast<FuncNode>(func_value)) {
-            ValueList args;
-            std::map<std::string, std::shared_ptr<Value>> pairs;
-            evaluateArgs(args, pairs, env);
-            if (debug) {
-                ValueList debug_values{mapped_value};
-                for (auto value : args) {
-                    debug_values.push_back(value);
-                }
-                debugPrint(debug_values);
-            }
             try {
                 if (member_type == ValueType::Instance) {
-                    environment.setThis(member_value);
-                    auto result = func->callFunc(args, pairs, environment, true);
-                    auto inst_node = member_value->get<std::shared_ptr<Instance>>();
-                    inst_node->getEnvironment().setClassAttrs(environment.getClassAttrs());
-                    auto scopes = environment.copyScopes();
-                    for (const auto& pair : scopes.at(0).getPairs()) {
-                        env.setGlobalValue(pair.first, pair.second);
-                    }
-                    return result;
+                    environment.setThis(receiver);
+                    return func->callFunc(args, pairs, environment, true);
                 }
                 else {
-                    args.insert(args.begin(), member_value);
+                    args.insert(args.begin(), receiver);
                     return func->callFunc(args, pairs, environment);
                 }
             }
             catch (const ErrorException& e) {
-                throwError(e.error_type, e.message, line, column);
+                throwError(e.error_type, e.message, line(), column());
             }
         } else {
-            throwError(ErrorType::Runtime, "Unable to call function " + std::dynamic_pointer_cast<IdentifierNode>(stored_func)->name, line, column);
-        }
-    } else if (mapped_value->getType() == ValueType::BuiltInFunction) {
-        auto func_value = mapped_value->get<std::shared_ptr<BuiltInFunction>>();
-        ValueList args;
-        std::map<std::string, std::shared_ptr<Value>> pairs;
-        evaluateArgs(args, pairs, env);
-        if (debug) {
-            ValueList debug_values{mapped_value};
-            for (auto value : args) {
-                debug_values.push_back(value);
-            }
-            debugPrint(debug_values);
+            throwError(ErrorType::Runtime, "Unable to call function " + nodeCast<IdentifierNode>(stored_func)->name, line(), column());
         }
-        args.insert(args.begin(), member_value);
+    } else if (mapped_value.getType() == ValueType::BuiltInFunction) {
+        auto func_value = mapped_value.get<std::shared_ptr<BuiltInFunction>>();
+        args.insert(args.begin(), receiver);
         if (pairs.size() != 0) {
-            throwError(ErrorType::Runtime, "Builtin functions do not accept labeled arguments", line, column);
+            throwError(ErrorType::Runtime, "Builtin functions do not accept labeled arguments", line(), column());
         }
+        COUNT_STAT(builtin_calls);
         try {
             return (*func_value)(args, environment);
         }
         catch (const ErrorException& e) {
-            throwError(e.error_type, e.message, line, column);
+            throwError(e.error_type, e.message, line(), column());
         }
     }
     else {
-        throwError(ErrorType::Runtime, "Object type " + getTypeStr(member_type) + " has no member function " + ident_node->name, line, column);
+        throwError(ErrorType::Runtime, "Object type " + getTypeStr(member_type) + " has no member function " +
+                                        nodeCast<IdentifierNode>(stored_func)->name, line(), column());
     }
     return std::nullopt;
 }
 
+Value MethodCallNode::builtinMember(Environment& env, ValueType member_type) {
+    if (member_type == ValueType::Instance || member_symbol < 0) {
+        return nullptr;
+    }
+    Value func = env.getBuiltinMember(member_type, member_symbol);
+    if (!func || func.getType() != ValueType::BuiltInFunction) {
+        return nullptr;
+    }
+    return func;
+}
+
+// The receiver is expected as the first argument
+std::optional<Value> MethodCallNode::callBuiltinMember(Environment& env, const Value& func, const ValueList& args) {
+    COUNT_STAT(builtin_calls);
+    try {
+        auto result = (*func.get<std::shared_ptr<BuiltInFunction>>())(args, env);
+        profileSafePoint(this);
+        return result;
+    }
+    catch (const ErrorException& e) {
+        throwError(e.error_type, e.message, line(), column());
+    }
+}
+
 void MethodCallNode::debugPrint(ValueList debug_values) {
     subTab();
     setTabs();
     std::cout << "Evaluating Method Call: ";
-    std::cout << debug_values.at(0)->getPrintable(debug_tabs) + "(";
+    std::cout << debug_values.at(0).getPrintable(debug_tabs) + "(";
     for (int i = 1; i < debug_values.size(); i++) {
         if (i != 1) {
             std::cout << ", ";
         }
-        std::cout << debug_values.at(i)->getPrintable(debug_tabs);
+        std::cout << debug_values.at(i).getPrintable(debug_tabs);
     }
     std::cout << ")" << std::endl;
 }
@@ -2271,41 +2456,53 @@ std::string MethodCallNode::getPrintable() {
     return str;
 }
 
+bool MethodCallNode::hasLabeledArgs() const {
+    for (const auto& value_node : values) {
+        if (auto binary_node = nodeCast<BinaryOpNode>(value_node)) {
+            if (binary_node->op == TokenType::_Equals && nodeCast<IdentifierNode>(binary_node->left)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 void MethodCallNode::evaluateArgs(ValueList& args,
-                                std::map<std::string, std::shared_ptr<Value>>& pairs, Environment& env) {
-    std::map<std::shared_ptr<Value>, std::string> given_values;
+                                std::map<std::string, Value>& pairs, Environment& env) {
+    std::map<Value, std::string> given_values;
     bool found_default_arg = false;
     for (auto value_node : values) {
-        if (auto binary_node = std::dynamic_pointer_cast<BinaryOpNode>(value_node)) {
-            auto ident_node = std::dynamic_pointer_cast<IdentifierNode>(binary_node->left);
+        if (auto binary_node = nodeCast<BinaryOpNode>(value_node)) {
+            auto ident_node = nodeCast<IdentifierNode>(binary_node->left);
             if (ident_node && binary_node->op == TokenType::_Equals) {
                 auto value = binary_node->right->evaluate(env);
                 if (!value) {
-                    throwError(ErrorType::Runtime, "Unable to evaluate argument", line, column);
+                    throwError(ErrorType::Runtime, "Unable to evaluate argument", line(), column());
                 }
                 pairs[ident_node->name] = value.value();
                 found_default_arg = true;
             } else {
                 auto value = value_node->evaluate(env);
                 if (!value) {
-                    throwError(ErrorType::Runtime, "Unable to evaluate argument", line, column);
+                    throwError(ErrorType::Runtime, "Unable to evaluate argument", line(), column());
                 }
                 args.push_back(value.value());
             }
         } else {
             if (found_default_arg) {
-                throwError(ErrorType::Runtime, "Unlabeled argument cannot follow a labeled argument", line, column);
+                throwError(ErrorType::Runtime, "Unlabeled argument cannot follow a labeled argument", line(), column());
             }
             auto value = value_node->evaluate(env);
             if (!value) {
-                throwError(ErrorType::Runtime, "Unable to evaluate argument", line, column);
+                throwError(ErrorType::Runtime, "Unable to evaluate argument", line(), column());
             }
             args.push_back(value.value());
         }
     }
 }
 
-std::optional<std::shared_ptr<Value>> DictionaryNode::evaluate(Environment& env) {
+std::optional<Value> DictionaryNode::evaluate(Environment& env) {
+    COUNT_NODE_STAT("DictionaryNode");
     if (debug) {
         std::cout << getTabs() + "Entering Dictionary: " + getPrintable() << std::endl;
         addTab();
@@ -2318,21 +2515,21 @@ std::optional<std::shared_ptr<Value>> DictionaryNode::evaluate(Environment& env)
         if (key && value) {
             evaluated_dict->insert({key.value(), value.value()});
         } else {
-            throwError(ErrorType::Runtime, "Dictionary key or value was unable to be evaluated", line, column);
+            throwError(ErrorType::Runtime, "Dictionary key or value was unable to be evaluated", line(), column());
         }
     }
-    if (debug) debugPrint(ValueList{std::make_shared<Value>(evaluated_dict)});
+    if (debug) debugPrint(ValueList{Value(evaluated_dict)});
 
-    return std::make_shared<Value>(evaluated_dict);
+    return Value(evaluated_dict);
 }
 
 void DictionaryNode::debugPrint(ValueList values) {
     subTab();
     setTabs();
-    const auto& dict_ptr = values.at(0)->get<std::shared_ptr<Dictionary>>();
+    const auto& dict_ptr = values.at(0).get<std::shared_ptr<Dictionary>>();
     std::cout << "Evaluating Dictionary: {\n";
     for (const auto& [key, val] : *dict_ptr) {
-        std::cout << getTabs() << key->getPrintable(debug_tabs) << " : " << val->getPrintable(debug_tabs) << '\n';
+        std::cout << getTabs() << key.getPrintable(debug_tabs) << " : " << val.getPrintable(debug_tabs) << '\n';
     }
     std::cout << getTabs() + "}" << std::endl;
 }
@@ -2346,46 +2543,46 @@ std::string DictionaryNode::getPrintable() {
     return str;
 }
 
-std::optional<std::shared_ptr<Value>> ClassNode::evaluate(Environment& env) {
+std::optional<Value> ClassNode::evaluate(Environment& env) {
+    COUNT_NODE_STAT("ClassNode");
     if (debug) {
         std::cout << getTabs() + "Entering Class: " + getPrintable() << std::endl;
         addTab();
     }
     // Prevent the constructor overwriting the class name in the env
-    Scope prev_attrs = env.getClassAttrs();
+    auto prev_attrs = env.getClassAttrs();
     env.addClassScope();
+    env.pushFrame(frame_layout);
+    Completion completion;
     try {
-        for (auto statement : block) {
-            statement->evaluate(env);
-        }
-    }
-    catch (const ReturnException) {
-        throwError(ErrorType::Runtime, "Return was used outside of function", line, column);
-    }
-    catch (const BreakException) {
-        throwError(ErrorType::Runtime, "Break was used outside of loop", line, column);
-    }
-    catch (const ContinueException) {
-        throwError(ErrorType::Runtime, "Continue was used outside of loop", line, column);
+        completion = executeBlock(block, env);
     }
     catch (const StackOverflowException) {
         throwError(ErrorType::StackOverflow, "Excessive recursion depth reached. (Add the -IgnoreOverflow flag to the end of \
 the program execution to ignore this warning)");
     }
     catch (const ErrorException& e) {
-        throwError(e.error_type, e.message, line, column);
+        throwError(e.error_type, e.message, line(), column());
+    }
+    if (completion.type == CompletionType::Return) {
+        throwError(ErrorType::Runtime, "Return was used outside of function", line(), column());
+    } else if (completion.type == CompletionType::Break) {
+        throwError(ErrorType::Runtime, "Break was used outside of loop", line(), column());
+    } else if (completion.type == CompletionType::Continue) {
+        throwError(ErrorType::Runtime, "Continue was used outside of loop", line(), column());
     }
 
     Environment class_env{env};
+    env.popFrame();
     env.removeClassScope(prev_attrs);
 
     class_env.setClassEnv();
     if (!class_env.contains(name, true)) {
-        throwError(ErrorType::Runtime, "Class " + name + " is missing a constructor", line, column);
+        throwError(ErrorType::Runtime, "Class " + name + " is missing a constructor", line(), column());
     }
     if (debug) subTab();
 
-    return std::make_shared<Value>(std::make_shared<Class>(name, class_env));
+    return Value(std::make_shared<Class>(name, class_env));
 }
 
 void ClassNode::debugPrint(ValueList) {
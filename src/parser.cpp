@@ -1,5 +1,6 @@
 #include "parser.h"
 #include "token.h"
+#include "lexer.h"
 #include <format>
 #include "library.h"
 #include <iostream>
@@ -43,26 +44,100 @@ std::string Parser::getTokenStr() const {
     return getTokenTypeLabel(getToken().type);
 }
 
-bool Parser::tokenIs(std::string str) const {
-    if (str == "ident") {
-        throwError(ErrorType::Runtime, "Found ident instead of identifier");
-    }
-    return str == getTokenStr();
+bool Parser::tokenIs(TokenType type) const {
+    return getToken().type == type;
 }
 
-bool Parser::nextTokenIs(std::string str, int ahead) const {
-    return str == getTokenTypeLabel(peekToken(ahead).value()->type);
+bool Parser::nextTokenIs(TokenType type, int ahead) const {
+    return peekToken(ahead).value()->type == type;
 }
 
-void Parser::expect(std::string expected) const {
+void Parser::expect(TokenType expected) const {
     if (!tokenIs(expected)) {
-        parsingError("Expected " + expected + " but got " + getTokenStr(), getToken().line, getToken().column);
+        parsingError("Expected " + getTokenTypeLabel(expected) + " but got " + getTokenStr(), getToken().line, getToken().column);
+    }
+}
+
+// Keywords that begin a statement of their own instead of an expression
+static bool isStatementKeyword(TokenType type) {
+    switch (type) {
+        case TokenType::_And:
+        case TokenType::_Or:
+        case TokenType::_Not:
+        case TokenType::_If:
+        case TokenType::_Elif:
+        case TokenType::_Else:
+        case TokenType::_While:
+        case TokenType::_For:
+        case TokenType::_Break:
+        case TokenType::_Continue:
+        case TokenType::_Func:
+        case TokenType::_Return:
+        case TokenType::_In:
+        case TokenType::_Import:
+        case TokenType::_Global:
+        case TokenType::_Class:
+        case TokenType::_Instance:
+        case TokenType::_This:
+        case TokenType::_Throw:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool isTypeKeyword(TokenType type) {
+    switch (type) {
+        case TokenType::_NullType:
+        case TokenType::_IntType:
+        case TokenType::_FloatType:
+        case TokenType::_BoolType:
+        case TokenType::_StrType:
+        case TokenType::_ListType:
+        case TokenType::_DictType:
+        case TokenType::_FuncType:
+        case TokenType::_BuiltInType:
+        case TokenType::_ClassType:
+        case TokenType::_InstanceType:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// How tightly each binary operator binds, operators that aren't binary get Precedence::None
+static Parser::Precedence binaryPrecedence(TokenType type) {
+    using Precedence = Parser::Precedence;
+    switch (type) {
+        case TokenType::_Or:
+            return Precedence::Or;
+        case TokenType::_And:
+            return Precedence::And;
+        case TokenType::_Compare:
+        case TokenType::_NotEqual:
+            return Precedence::Equality;
+        case TokenType::_LessThan:
+        case TokenType::_LessEquals:
+        case TokenType::_GreaterThan:
+        case TokenType::_GreaterEquals:
+        case TokenType::_In:
+            return Precedence::Relation;
+        case TokenType::_Plus:
+        case TokenType::_Minus:
+            return Precedence::Sum;
+        case TokenType::_Multiply:
+        case TokenType::_Divide:
+        case TokenType::_DoubleDivide:
+        case TokenType::_Mod:
+            return Precedence::Product;
+        default:
+            return Precedence::None;
     }
 }
 
 
-std::vector<std::shared_ptr<ASTNode>> Parser::parse() {
-    std::vector<std::shared_ptr<ASTNode>> statements;
+std::vector<NodeRef<>> Parser::parse() {
+    std::vector<NodeRef<>> statements;
     while (getToken().type != TokenType::_EOF) {
         statements.push_back(parseFoundation());
     }
@@ -79,105 +154,89 @@ void Parser::removeIfElseScope() {
 }
 
 
-std::shared_ptr<ASTNode> Parser::parseFoundation() {
+NodeRef<> Parser::parseFoundation() {
     if (debug) std::cout << "Parse Foundation " << getTokenStr() << std::endl;
-    if (keyword_tokens.contains(getTokenStr())) {
+    if (isStatementKeyword(getToken().type)) {
         return parseControlFlowStatement();
     }
     else {
         auto statement = parseStatement();
-        expect(";");
+        expect(TokenType::_Semi);
         consumeToken();
         return statement;
     }
 }
 
-std::shared_ptr<ASTNode> Parser::parseControlFlowStatement() {
+NodeRef<> Parser::parseControlFlowStatement() {
     if (debug) std::cout << "Parse Control Flow " << getTokenStr() << std::endl;
     if (peekToken() && peekToken().value()->type == TokenType::_Equals) {
         // Make sure they're not trying to use a keyword as a variable
         parsingError(getTokenStr() + " is a keyword and is not allowed to be redefined", getToken().line, getToken().column);
     }
 
-    std::unordered_map<std::string, TokenType> scoped_keyword_tokens {
-        {"if", TokenType::_If},
-        {"elif", TokenType::_Elif},
-        {"else", TokenType::_Else},
-        {"while", TokenType::_While},
-        {"for", TokenType::_For},
-        {"func", TokenType::_Func},
-        {"class", TokenType::_Class}
-    };
-
-    std::string t_str = getTokenStr();
-    if (scoped_keyword_tokens.contains(t_str)) {
+    TokenType keyword_type = getToken().type;
+    if (keyword_type == TokenType::_If || keyword_type == TokenType::_Elif || keyword_type == TokenType::_Else ||
+        keyword_type == TokenType::_While || keyword_type == TokenType::_For || keyword_type == TokenType::_Func ||
+        keyword_type == TokenType::_Class) {
         const Token& keyword = consumeToken();
-        std::shared_ptr<ASTNode> comparison_expr = nullptr;
-        std::shared_ptr<ASTNode> for_initialization;
-        std::shared_ptr<ASTNode> for_increment;
-        std::vector<std::shared_ptr<ASTNode>> func_args;
-        std::shared_ptr<ASTNode> func_name;
-        std::map<std::string, std::shared_ptr<ASTNode>> default_arg_values;
+        NodeRef<> comparison_expr = nullptr;
+        NodeRef<> for_initialization;
+        NodeRef<> for_increment;
+        std::vector<NodeRef<>> func_args;
+        NodeRef<> func_name;
+        std::vector<std::pair<std::string, NodeRef<>>> default_arg_values;
         auto name_str = std::make_shared<std::string>("");
-        if (t_str == "if" || t_str == "elif" || t_str == "while") {
-            if (tokenIs("{")) {
+        if (keyword_type == TokenType::_If || keyword_type == TokenType::_Elif || keyword_type == TokenType::_While) {
+            if (tokenIs(TokenType::_CurlyOpen)) {
                 parsingError("Missing boolean expression ", getToken().line, getToken().column);
             }
 
-            comparison_expr = parseLogicalOr();
-        } else if (t_str == "for") {
-            if (tokenIs("{")) {
+            comparison_expr = parseExpression();
+        } else if (keyword_type == TokenType::_For) {
+            if (tokenIs(TokenType::_CurlyOpen)) {
                 parsingError("Missing for loop expression", getToken().line, getToken().column);
             }
             for_initialization = parseStatement();
-            auto in_node = std::dynamic_pointer_cast<BinaryOpNode>(for_initialization);
+            auto in_node = nodeCast<BinaryOpNode>(for_initialization);
             if (in_node && in_node->op == TokenType::_In) {
-                if (tokenIs(",")) {
+                if (tokenIs(TokenType::_Comma)) {
                     parsingError("For loop requires [] surrounding unpacking variables", getToken().line, getToken().column);
                 }
             }
             else {
-                if (!tokenIs(",")) {
+                if (!tokenIs(TokenType::_Comma)) {
                     parsingError("Invalid for loop syntax: expected ',' after first expression", getToken().line, getToken().column);
                 }
                 consumeToken();
-                comparison_expr = parseLogicalOr();
-                if (!tokenIs(",")) {
+                comparison_expr = parseExpression();
+                if (!tokenIs(TokenType::_Comma)) {
                     parsingError("Invalid for loop syntax: expected ',' after first expression", getToken().line, getToken().column);
                 }
                 consumeToken();
                 for_increment = parseStatement();
             }
-        } else if (t_str == "func") {
-            if (!tokenIs("identifier") && !(tokenIs("&") && nextTokenIs("identifier"))) {
+        } else if (keyword_type == TokenType::_Func) {
+            if (!tokenIs(TokenType::_Identifier) && !(tokenIs(TokenType::_Ampersand) && nextTokenIs(TokenType::_Identifier))) {
                 parsingError("Expected identifier but got " + getTokenStr(), getToken().line, getToken().column);
             }
             func_name = parseIdentifier(name_str);
-            expect("(");
+            expect(TokenType::_ParenOpen);
             consumeToken();
             auto arg_name = std::make_shared<std::string>("");
             std::vector<std::string> arg_strings;
             bool found_default_arg = false;
-            while (!tokenIs(")") && !tokenIs("EndOfFile") && !tokenIs("{")) {
-                if (!tokenIs("identifier")) {
+            while (!tokenIs(TokenType::_ParenClose) && !tokenIs(TokenType::_EOF) && !tokenIs(TokenType::_CurlyOpen)) {
+                if (!tokenIs(TokenType::_Identifier)) {
                     parsingError("Expected argument but got " + getTokenStr(), getToken().line, getToken().column);
                 }
-                if (nextTokenIs("=")) {
+                func_args.push_back(parseIdentifier(arg_name));
+                if (tokenIs(TokenType::_Equals)) {
                     // It's a default argument assignment
-                    auto default_statement = parseStatement(arg_name);
-                    auto assign_node = std::dynamic_pointer_cast<BinaryOpNode>(default_statement);
-                    if (!assign_node) {
-                        parsingError("Invalid default argument assignment", getToken().line, getToken().column);
-                    }
-                    func_args.push_back(assign_node->left);
-                    default_arg_values[*arg_name] = assign_node->right;
+                    consumeToken();
+                    default_arg_values.emplace_back(*arg_name, parseExpression());
                     found_default_arg = true;
-                } else {
-                    if (found_default_arg) {
-                        parsingError("Parameter without default cannot follow a default parameter", getToken().line, getToken().column);
-                    }
-                    // It's a regular argument
-                    func_args.push_back(parseIdentifier(arg_name));
+                } else if (found_default_arg) {
+                    parsingError("Parameter without default cannot follow a default parameter", getToken().line, getToken().column);
                 }
                 if (std::find(arg_strings.begin(), arg_strings.end(), *arg_name) == arg_strings.end()) {
                     arg_strings.push_back(*arg_name);
@@ -186,87 +245,87 @@ std::shared_ptr<ASTNode> Parser::parseControlFlowStatement() {
                     parsingError("Duplicate argument names found in function creation", getToken().line, getToken().column);
                 }
 
-                if (tokenIs("identifier")) {
+                if (tokenIs(TokenType::_Identifier)) {
                     parsingError("Expected ',' but got argument", getToken().line, getToken().column);
-                } else if (tokenIs(",")) {
+                } else if (tokenIs(TokenType::_Comma)) {
                     consumeToken();
-                    if (!tokenIs("identifier")) {
+                    if (!tokenIs(TokenType::_Identifier)) {
                         parsingError("Expected argument but got " + getTokenStr(), getToken().line, getToken().column);
                     }
                 }
             }
-            if (tokenIs("EndOfFile")) {
+            if (tokenIs(TokenType::_EOF)) {
                 parsingError("Missing ')'", getToken().line, getToken().column);
-            } else if (tokenIs("{")) {
+            } else if (tokenIs(TokenType::_CurlyOpen)) {
                 parsingError("Missing ')' before '{'", getToken().line, getToken().column);
             } else {
                 consumeToken();
             }
-        } else if (t_str == "class") {
-            if (!tokenIs("identifier")) {
-                if (tokenIs("&")) {
+        } else if (keyword_type == TokenType::_Class) {
+            if (!tokenIs(TokenType::_Identifier)) {
+                if (tokenIs(TokenType::_Ampersand)) {
                     parsingError("Cannot directly set class as a member. Must be referenced indirectly through another variable.",
                                     getToken().line, getToken().column);
                 } else {
-                    expect("identifier");
+                    expect(TokenType::_Identifier);
                 }
             }
             func_name = parseIdentifier(name_str);
         }
 
-        expect("{");
+        expect(TokenType::_CurlyOpen);
         consumeToken();
 
         // Prevent connected elif to if outside of scope
         addIfElseScope();
 
-        std::vector<std::shared_ptr<ASTNode>> block;
-        while (!tokenIs("EndOfFile") && !tokenIs("}")) {
+        std::vector<NodeRef<>> block;
+        while (!tokenIs(TokenType::_EOF) && !tokenIs(TokenType::_CurlyClose)) {
             block.push_back(parseFoundation());
         }
 
-        if (tokenIs("EndOfFile")) {
+        if (tokenIs(TokenType::_EOF)) {
             parsingError("Expected '}'", getToken().line, getToken().column);
         }
         consumeToken();
 
         removeIfElseScope();
 
-        if (t_str == "if") {
-            std::shared_ptr<ScopedNode> keyword_node = std::make_shared<ScopedNode>(keyword.type, nullptr, comparison_expr, block, keyword.line, keyword.column);
+        if (keyword_type == TokenType::_If) {
+            NodeRef<ScopedNode> keyword_node = makeNode<ScopedNode>(keyword.type, nullptr, comparison_expr, block, keyword.line, keyword.column);
             last_if_else.back() = keyword_node;
             return keyword_node;
-        } else if (t_str == "elif") {
+        } else if (keyword_type == TokenType::_Elif) {
             if (last_if_else.back() == nullptr) {
                 parsingError("Missing 'if' before 'elif'", getToken().line, getToken().column);
             }
 
-            std::shared_ptr<ScopedNode> keyword_node = std::make_shared<ScopedNode>(keyword.type, last_if_else.back(), comparison_expr, block, keyword.line, keyword.column);
+            NodeRef<ScopedNode> keyword_node = makeNode<ScopedNode>(keyword.type, last_if_else.back(), comparison_expr, block, keyword.line, keyword.column);
             last_if_else.back() = keyword_node;
             return keyword_node;
-        } else if (t_str == "else") {
+        } else if (keyword_type == TokenType::_Else) {
             if (last_if_else.back() == nullptr) {
                 parsingError("Missing 'if' before 'else'", getToken().line, getToken().column);
             }
 
-            std::shared_ptr<ScopedNode> keyword_node = std::make_shared<ScopedNode>(keyword.type, last_if_else.back(), comparison_expr, block, keyword.line, keyword.column);
+            NodeRef<ScopedNode> keyword_node = makeNode<ScopedNode>(keyword.type, last_if_else.back(), comparison_expr, block, keyword.line, keyword.column);
             last_if_else.back() = nullptr;
             return keyword_node;
-        } else if (t_str == "for") {
+        } else if (keyword_type == TokenType::_For) {
             // If 'in' was used, only for_initialization will not be nullptr and will contain the variable and list
-            return std::make_shared<ForNode>(keyword.type, for_initialization, comparison_expr, for_increment, block, keyword.line, keyword.column);
-        } else if (t_str == "func") {
-            bool member_func = std::static_pointer_cast<IdentifierNode>(func_name)->member_variable;
-            return std::make_shared<BinaryOpNode>(func_name, TokenType::_Equals, std::make_shared<FuncNode>(member_func, name_str, func_args, default_arg_values, block, keyword.line, keyword.column, currentParsingContext()), keyword.line, keyword.column);
-        } else if (t_str == "class") {
-            return std::make_shared<BinaryOpNode>(func_name, TokenType::_Equals, std::make_shared<ClassNode>(name_str, block, keyword.line, keyword.column, currentParsingContext()), keyword.line, keyword.column);
+            return makeNode<ForNode>(keyword.type, for_initialization, comparison_expr, for_increment, block, keyword.line, keyword.column);
+        } else if (keyword_type == TokenType::_Func) {
+            bool member_func = static_cast<IdentifierNode*>(func_name.get())->member_variable;
+            return makeNode<BinaryOpNode>(func_name, TokenType::_Equals, makeNode<FuncNode>(member_func, name_str, func_args, default_arg_values, block, keyword.line, keyword.column, currentParsingContext()), keyword.line, keyword.column);
+        } else if (keyword_type == TokenType::_Class) {
+            return makeNode<BinaryOpNode>(func_name, TokenType::_Equals, makeNode<ClassNode>(name_str, block, keyword.line, keyword.column, currentParsingContext()), keyword.line, keyword.column);
         } else {
-            return std::make_shared<ScopedNode>(keyword.type, nullptr, comparison_expr, block, keyword.line, keyword.column);
+            return makeNode<ScopedNode>(keyword.type, nullptr, comparison_expr, block, keyword.line, keyword.column);
         }
     }
     else {
         auto node = parseKeyword();
-        if (tokenIs(";")) {
+        if (tokenIs(TokenType::_Semi)) {
             consumeToken();
             return node;
         }
@@ -279,38 +338,37 @@ std::shared_ptr<ASTNode> Parser::parseControlFlowStatement() {
     return nullptr;
 }
 
-std::shared_ptr<ASTNode> Parser::parseKeyword() {
+NodeRef<> Parser::parseKeyword() {
     // Token not, and, or
-    std::string t_str = getTokenStr();
-    if (t_str == "not" || t_str == "and" || t_str == "or") {
-        return parseLogicalOr();
+    if (tokenIs(TokenType::_Not) || tokenIs(TokenType::_And) || tokenIs(TokenType::_Or)) {
+        return parseExpression();
     }
     else {
         const Token& token = getToken();
-        std::shared_ptr<KeywordNode> node;
-        if (tokenIs("return") && !nextTokenIs(";")) {
+        NodeRef<KeywordNode> node;
+        if (tokenIs(TokenType::_Return) && !nextTokenIs(TokenType::_Semi)) {
             consumeToken();
-            auto right = parseLogicalOr();
-            node = std::make_shared<KeywordNode>(TokenType::_Return, right, token.line, token.column);
+            auto right = parseExpression();
+            node = makeNode<KeywordNode>(TokenType::_Return, right, token.line, token.column);
         }
-        else if (tokenIs("import")) {
+        else if (tokenIs(TokenType::_Import)) {
             consumeToken();
             auto right = parseAtom();
-            node = std::make_shared<KeywordNode>(TokenType::_Import, right, token.line, token.column);
+            node = makeNode<KeywordNode>(TokenType::_Import, right, token.line, token.column);
         }
-        else if (tokenIs("global")) {
+        else if (tokenIs(TokenType::_Global)) {
             consumeToken();
             auto right = parseIdentifier();
-            node = std::make_shared<KeywordNode>(TokenType::_Global, right, token.line, token.column);
+            node = makeNode<KeywordNode>(TokenType::_Global, right, token.line, token.column);
         }
-        else if (tokenIs("throw")) {
+        else if (tokenIs(TokenType::_Throw)) {
             consumeToken();
-            auto right = parseLogicalOr();
-            node = std::make_shared<KeywordNode>(TokenType::_Throw, right, token.line, token.column);
+            auto right = parseExpression();
+            node = makeNode<KeywordNode>(TokenType::_Throw, right, token.line, token.column);
         }
 
         else {
-            node = std::make_shared<KeywordNode>(getToken().type, nullptr, token.line, token.column);
+            node = makeNode<KeywordNode>(getToken().type, nullptr, token.line, token.column);
             consumeToken();
         }
         return node;
@@ -319,35 +377,35 @@ std::shared_ptr<ASTNode> Parser::parseKeyword() {
     return nullptr;
 }
 
-std::shared_ptr<ASTNode> Parser::parseStatement(std::shared_ptr<std::string> varString) {
+NodeRef<> Parser::parseStatement(std::shared_ptr<std::string> varString) {
     if (debug) std::cout << "Parse Statement " << getTokenStr() << std::endl;
 
     // Preserve leading '&' behavior for member-variable context
     bool member = false;
-    if (tokenIs("&")) {
+    if (tokenIs(TokenType::_Ampersand)) {
         consumeToken();
         member = true;
     }
 
     // Start with an identifier: parse full member/index/call chain as potential LHS
-    if (tokenIs("identifier")) {
+    if (tokenIs(TokenType::_Identifier)) {
         if (member) {
             backUp();  // include '&' in identifier parsing
         }
         auto left = parseMemberAccess(varString);
 
         // Assignment & aug-assign
-        if (tokenIs("=") || tokenIs("+=") || tokenIs("-=") || tokenIs("*=") || tokenIs("/=")) {
+        if (tokenIs(TokenType::_Equals) || tokenIs(TokenType::_PlusEquals) || tokenIs(TokenType::_MinusEquals) || tokenIs(TokenType::_MultiplyEquals) || tokenIs(TokenType::_DivideEquals)) {
             const Token& op = consumeToken();
-            auto right = parseLogicalOr();
-            return std::make_shared<BinaryOpNode>(left, op.type, right, op.line, op.column);
+            auto right = parseExpression();
+            return makeNode<BinaryOpNode>(left, op.type, right, op.line, op.column);
         }
 
         // FOREACH form support: e.g. "for r in rooms { ... }"
-        if (tokenIs("in")) {
+        if (tokenIs(TokenType::_In)) {
             const Token& inTok = consumeToken();           // TokenType::_In
-            auto right = parseLogicalOr();                 // the iterable
-            return std::make_shared<BinaryOpNode>(left, inTok.type, right, inTok.line, inTok.column);
+            auto right = parseExpression();                 // the iterable
+            return makeNode<BinaryOpNode>(left, inTok.type, right, inTok.line, inTok.column);
         }
 
         // Otherwise, it's an expression statement
@@ -358,160 +416,101 @@ std::shared_ptr<ASTNode> Parser::parseStatement(std::shared_ptr<std::string> var
     if (member) {
         backUp();
     }
-    auto left = parseLogicalOr();
-
-    if (auto left_list = std::dynamic_pointer_cast<ListNode>(left)) {
-        if (tokenIs("=")) {
-            const Token& op = consumeToken();
-            auto right = parseLogicalOr();
-            return std::make_shared<BinaryOpNode>(left, op.type, right, op.line, op.column);
-        }
-        return left;
-    }
-
-    return left;
-}
-
-std::shared_ptr<ASTNode> Parser::parseLogicalOr() {
-    if (debug) std::cout << "Parse Logical Or " << getTokenStr() << std::endl;
-    auto left = parseLogicalAnd();
-    while (tokenIs("or")) {
-        const Token& op = consumeToken();
-        auto right = parseLogicalAnd();
-        left = std::make_shared<BinaryOpNode>(left, op.type, right, op.line, op.column);
-    }
-    return left;
-}
-
-std::shared_ptr<ASTNode> Parser::parseLogicalAnd() {
-    if (debug) std::cout << "Parse Logical And " << getTokenStr() << std::endl;
-    auto left = parseEquality();
-    while (tokenIs("and")) {
-        const Token& op = consumeToken();
-        auto right = parseEquality();
-        left = std::make_shared<BinaryOpNode>(left, op.type, right, op.line, op.column);
-    }
-    return left;
-}
-
-std::shared_ptr<ASTNode> Parser::parseEquality() {
-    if (debug) std::cout << "Parse Equality " << getTokenStr() << std::endl;
-    auto left = parseRelation();
-
-    while (tokenIs("==") || tokenIs("!=")) {
-        const Token& op = getToken();
-        consumeToken();
-        auto right = parseRelation();
-        left = std::make_shared<BinaryOpNode>(left, op.type, right, op.line, op.column);
-    }
-
-    return left;
-}
-
-std::shared_ptr<ASTNode> Parser::parseRelation() {
-    if (debug) std::cout << "Parse Relation " << getTokenStr() << std::endl;
     auto left = parseExpression();
 
-    while (tokenIs("<") || tokenIs("<=") || tokenIs(">") || tokenIs(">=") || tokenIs("in") || (tokenIs("not") && nextTokenIs("in"))) {
-        if (tokenIs("not")) {
-            const Token& token = consumeToken();
-            const Token& op = consumeToken();
-            auto right = parseExpression();
-            left = std::make_shared<BinaryOpNode>(left, op.type, right, op.line, op.column);
-            left = std::make_shared<UnaryOpNode>(TokenType::_Not, left, token.line, token.column);
-        } else {
+    if (auto left_list = nodeCast<ListNode>(left)) {
+        if (tokenIs(TokenType::_Equals)) {
             const Token& op = consumeToken();
             auto right = parseExpression();
-            left = std::make_shared<BinaryOpNode>(left, op.type, right, op.line, op.column);
+            return makeNode<BinaryOpNode>(left, op.type, right, op.line, op.column);
         }
+        return left;
     }
 
     return left;
 }
 
-std::shared_ptr<ASTNode> Parser::parseExpression() {
+NodeRef<> Parser::parseExpression(Precedence min_precedence) {
     if (debug) std::cout << "Parse Expression " << getTokenStr() << std::endl;
-    auto left = parseTerm();
-
-    while (tokenIs("+") || tokenIs("-")) {
-        const Token& op = consumeToken();
-        auto right = parseTerm();
-        left = std::make_shared<BinaryOpNode>(left, op.type, right, op.line, op.column);
-    }
-
-    return left;
-}
-
-std::shared_ptr<ASTNode> Parser::parseTerm() {
-    if (debug) std::cout << "Parse Term " << getTokenStr() << std::endl;
     auto left = parseFactor();
 
-    while (tokenIs("*") || tokenIs("/") || tokenIs("//") || tokenIs("%")) {
+    while (true) {
+        // 'not in' is the only operator spelled with two tokens
+        bool negated = tokenIs(TokenType::_Not) && nextTokenIs(TokenType::_In);
+        Precedence precedence = negated ? Precedence::Relation : binaryPrecedence(getToken().type);
+        if (precedence == Precedence::None || precedence < min_precedence) {
+            break;
+        }
+        const Token* not_token = negated ? &consumeToken() : nullptr;
         const Token& op = consumeToken();
-        auto right = parseFactor();
-        left = std::make_shared<BinaryOpNode>(left, op.type, right, op.line, op.column);
+        // Operators are left associative, so the right side only takes operators that bind tighter
+        auto right = parseExpression(static_cast<Precedence>(static_cast<int>(precedence) + 1));
+        left = makeNode<BinaryOpNode>(left, op.type, right, op.line, op.column);
+        if (not_token) {
+            left = makeNode<UnaryOpNode>(TokenType::_Not, left, not_token->line, not_token->column);
+        }
     }
 
     return left;
 }
 
-std::shared_ptr<ASTNode> Parser::parseFactor() {
+NodeRef<> Parser::parseFactor() {
     if (debug) std::cout << "Parse Factor " << getTokenStr() << std::endl;
-    if (tokenIs("+") || tokenIs("-")) {
+    if (tokenIs(TokenType::_Plus) || tokenIs(TokenType::_Minus)) {
         const Token& op = consumeToken();
         auto right = parsePower();
-        return std::make_shared<UnaryOpNode>(op.type, right, op.line, op.column);
+        return makeNode<UnaryOpNode>(op.type, right, op.line, op.column);
     }
     else {
         return parsePower();
     }
 }
 
-std::shared_ptr<ASTNode> Parser::parsePower() {
+NodeRef<> Parser::parsePower() {
     if (debug) std::cout << "Parse Power " << getTokenStr() << std::endl;
     auto left = parseLogicalNot();
 
-    if (tokenIs("^") || tokenIs("**")) {
+    if (tokenIs(TokenType::_Caret) || tokenIs(TokenType::_DoubleMultiply)) {
         const Token& op = consumeToken();
         auto right = parseFactor();
-        return std::make_shared<BinaryOpNode>(left, op.type, right, op.line, op.column);
+        return makeNode<BinaryOpNode>(left, op.type, right, op.line, op.column);
     }
     else {
         return left;
     }
 }
 
-std::shared_ptr<ASTNode> Parser::parseLogicalNot() {
+NodeRef<> Parser::parseLogicalNot() {
     if (debug) std::cout << "Parse Not " << getTokenStr() << std::endl;
-    if (tokenIs("not") || tokenIs("!")) {
+    if (tokenIs(TokenType::_Not) || tokenIs(TokenType::_Exclamation)) {
         const Token& k_word = consumeToken();
         auto right = parseMemberAccess();
-        return std::make_shared<UnaryOpNode>(k_word.type, right, k_word.line, k_word.column);
+        return makeNode<UnaryOpNode>(k_word.type, right, k_word.line, k_word.column);
     }
     else {
         return parseMemberAccess();
     }
 }
 
-std::shared_ptr<ASTNode> Parser::parseMemberAccess(std::shared_ptr<std::string> var_string) {
+NodeRef<> Parser::parseMemberAccess(std::shared_ptr<std::string> var_string) {
     if (debug) std::cout << "Parse Member " << getTokenStr() << std::endl;
-    std::shared_ptr<ASTNode> node = parseIndexing();
+    NodeRef<> node = parseIndexing();
 
     while (true) {
-        if (tokenIs(".")) {
+        if (tokenIs(TokenType::_Dot)) {
             const Token& token = consumeToken();
-            if (tokenIs("identifier")) {
-                std::shared_ptr<ASTNode> right;
-                if (nextTokenIs("(")) {
+            if (tokenIs(TokenType::_Identifier)) {
+                NodeRef<> right;
+                if (nextTokenIs(TokenType::_ParenOpen)) {
                     right = parseFuncCall();
                 } else {
                     right = parseIdentifier(var_string);
                 }
-                node = std::make_shared<BinaryOpNode>(node, TokenType::_Dot, right, token.line, token.column);
+                node = makeNode<BinaryOpNode>(node, TokenType::_Dot, right, token.line, token.column);
             }
-        } else if (tokenIs("[")) {
+        } else if (tokenIs(TokenType::_SquareOpen)) {
             node = parseIndexing(node);
-        } else if (tokenIs("(")) {
+        } else if (tokenIs(TokenType::_ParenOpen)) {
             node = parseFuncCall(node);
         } else {
             break;
@@ -521,128 +520,128 @@ std::shared_ptr<ASTNode> Parser::parseMemberAccess(std::shared_ptr<std::string>
     return node;
 }
 
-std::shared_ptr<ASTNode> Parser::parseIndexing(std::shared_ptr<ASTNode> left) {
+NodeRef<> Parser::parseIndexing(NodeRef<> left) {
     if (debug) std::cout << "Parse Indexing " << getTokenStr() << std::endl;
     if (!left) {
         left = parseCollection();
     }
-    while (tokenIs("[")) {
+    while (tokenIs(TokenType::_SquareOpen)) {
         const Token& token = consumeToken();
-        std::shared_ptr<ASTNode> start;
-        if (tokenIs(":")) {
-            start = std::make_shared<AtomNode>(0, token.line, token.column);
+        NodeRef<> start;
+        if (tokenIs(TokenType::_Colon)) {
+            start = makeNode<AtomNode>(0, token.line, token.column);
         } else {
-            start = parseExpression(); // Assuming it ends up as an int
+            start = parseExpression(Precedence::Sum); // Assuming it ends up as an int
         }
-        if (tokenIs("]")) {
+        if (tokenIs(TokenType::_SquareClose)) {
             consumeToken();
-            left = std::make_shared<IndexNode>(left, start, nullptr, token.line, token.column);
-        } else if (!tokenIs(":")) {
+            left = makeNode<IndexNode>(left, start, nullptr, token.line, token.column);
+        } else if (!tokenIs(TokenType::_Colon)) {
             parsingError("Expected either ']' or ':'", getToken().line, getToken().column);
         } else {
             // Is :
             consumeToken();
-            std::shared_ptr<ASTNode> end;
-            if (tokenIs("]")) {
-                end = std::make_shared<AtomNode>(SpecialIndex::Back, token.line, token.column);
+            NodeRef<> end;
+            if (tokenIs(TokenType::_SquareClose)) {
+                end = makeNode<AtomNode>(SpecialIndex::Back, token.line, token.column);
             } else {
-                end = parseExpression();
+                end = parseExpression(Precedence::Sum);
             }
-            if (!tokenIs("]")) {
+            if (!tokenIs(TokenType::_SquareClose)) {
                 parsingError("Expected ']'", getToken().line, getToken().column);
             }
             consumeToken();
-            left = std::make_shared<IndexNode>(left, start, end, token.line, token.column);
+            left = makeNode<IndexNode>(left, start, end, token.line, token.column);
         }
     }
 
     return left;
 }
 
-std::shared_ptr<ASTNode> Parser::parseCollection() {
+NodeRef<> Parser::parseCollection() {
     if (debug) std::cout << "Parse Collection " << getTokenStr() << std::endl;
-    if (tokenIs("[")) {
+    if (tokenIs(TokenType::_SquareOpen)) {
         const Token& token = consumeToken();
         ASTList list;
-        while (!tokenIs("]") && !tokenIs("EndOfFile") && !tokenIs(";")) {
-            auto element = parseLogicalOr();
+        while (!tokenIs(TokenType::_SquareClose) && !tokenIs(TokenType::_EOF) && !tokenIs(TokenType::_Semi)) {
+            auto element = parseExpression();
             list.push_back(element);
-            if (tokenIs(",") && !nextTokenIs("]")) {
+            if (tokenIs(TokenType::_Comma) && !nextTokenIs(TokenType::_SquareClose)) {
                 consumeToken();
-            } else if (tokenIs(",")) {
+            } else if (tokenIs(TokenType::_Comma)) {
                 parsingError("Expected more values", getToken().line, getToken().column);
             }
         }
-        if (tokenIs("EndOfFile") || tokenIs(";")) {
+        if (tokenIs(TokenType::_EOF) || tokenIs(TokenType::_Semi)) {
             parsingError("Expected ']'", getToken().line, getToken().column);
         }
         consumeToken();
-        return std::make_shared<ListNode>(list, token.line, token.column);
+        return makeNode<ListNode>(list, token.line, token.column);
     }
-    else if (tokenIs("{")) {
+    else if (tokenIs(TokenType::_CurlyOpen)) {
         const Token& token = consumeToken();
         ASTDictionary dict;
-        while (!tokenIs("}") && !tokenIs("EndOfFile") && !tokenIs(";")) {
-            auto key = parseLogicalOr();
-            expect(":");
+        while (!tokenIs(TokenType::_CurlyClose) && !tokenIs(TokenType::_EOF) && !tokenIs(TokenType::_Semi)) {
+            auto key = parseExpression();
+            expect(TokenType::_Colon);
             consumeToken();
-            auto value = parseLogicalOr();
+            auto value = parseExpression();
             dict.push_back(std::make_pair(key, value));
-            if (tokenIs(",") && !nextTokenIs("}")) {
+            if (tokenIs(TokenType::_Comma) && !nextTokenIs(TokenType::_CurlyClose)) {
                 consumeToken();
-            } else if (tokenIs(",")) {
+            } else if (tokenIs(TokenType::_Comma)) {
                 parsingError("Expected more values", getToken().line, getToken().column);
             }
         }
-        if (tokenIs("EndOfFile") || tokenIs(";")) {
+        if (tokenIs(TokenType::_EOF) || tokenIs(TokenType::_Semi)) {
             parsingError("Expected '}'", getToken().line, getToken().column);
         }
         consumeToken();
-        return std::make_shared<DictionaryNode>(dict, token.line, token.column);
+        return makeNode<DictionaryNode>(dict, token.line, token.column);
     }
-    else if (tokenIs("(")) {
+    else if (tokenIs(TokenType::_ParenOpen)) {
         const Token& token = consumeToken();
-        auto parse_or = parseLogicalOr();
-        if (!tokenIs(")")) {
+        auto parse_or = parseExpression();
+        if (!tokenIs(TokenType::_ParenClose)) {
             parsingError("Expected ')' but got " + getTokenStr(), getToken().line, getToken().column);
         }
         consumeToken();
-        return std::make_shared<ParenthesisOpNode>(parse_or, token.line, token.column);
+        return makeNode<ParenthesisOpNode>(parse_or, token.line, token.column);
     }
     else {
         return parseAtom();
     }
 }
 
-std::shared_ptr<ASTNode> Parser::parseAtom() {
+NodeRef<> Parser::parseAtom() {
     if (debug) std::cout << "Parse Atom " << getTokenStr() << std::endl;
-    if (tokenIs("integer") || tokenIs("float") || tokenIs("boolean") || tokenIs("string")) {
+    if (tokenIs(TokenType::_Integer) || tokenIs(TokenType::_Float) || tokenIs(TokenType::_Boolean) || tokenIs(TokenType::_String)) {
         const Token& token = consumeToken();
         if (std::holds_alternative<int>(token.value)) {
             auto int_value = std::get<int>(token.value);
-            return std::make_shared<AtomNode>(int_value, token.line, token.column);
+            return makeNode<AtomNode>(int_value, token.line, token.column);
         }
         else if (std::holds_alternative<double>(token.value)) {
             auto float_value = std::get<double>(token.value);
-            return std::make_shared<AtomNode>(float_value, token.line, token.column);
+            return makeNode<AtomNode>(float_value, token.line, token.column);
         }
         else if (std::holds_alternative<bool>(token.value)) {
             auto bool_value = std::get<bool>(token.value);
-            return std::make_shared<AtomNode>(bool_value, token.line, token.column);
+            return makeNode<AtomNode>(bool_value, token.line, token.column);
         }
-        else if (std::holds_alternative<std::string>(token.value)) {
-            auto string_value = std::get<std::string>(token.value);
-            return std::make_shared<AtomNode>(string_value, token.line, token.column);
+        else if (std::holds_alternative<std::string_view>(token.value)) {
+            auto string_value = unescapeString(std::get<std::string_view>(token.value));
+            return makeNode<AtomNode>(string_value, token.line, token.column);
         }
-    } else if (tokenIs("identifier") || tokenIs("&")) {
-        if (nextTokenIs("(")) {
+    } else if (tokenIs(TokenType::_Identifier) || tokenIs(TokenType::_Ampersand)) {
+        if (nextTokenIs(TokenType::_ParenOpen)) {
             return parseFuncCall();
         } else {
             return parseIdentifier();
         }
-    } else if (getTokenStr().find("type:") != std::string::npos) {
+    } else if (isTypeKeyword(getToken().type)) {
         return parseKeyword();
-    } else if (tokenIs("this")) {
+    } else if (tokenIs(TokenType::_This)) {
         return parseKeyword();
     }
     else {
@@ -651,64 +650,62 @@ std::shared_ptr<ASTNode> Parser::parseAtom() {
     return nullptr;
 }
 
-std::shared_ptr<ASTNode> Parser::parseFuncCall(std::shared_ptr<ASTNode> identifier) {
+NodeRef<> Parser::parseFuncCall(NodeRef<> identifier) {
     if (debug) std::cout << "Parse Func Call " << getTokenStr() << std::endl;
     if (!identifier) {
-        if (!tokenIs("identifier") && !(tokenIs("(") && nextTokenIs("identifier"))) {
+        if (!tokenIs(TokenType::_Identifier) && !(tokenIs(TokenType::_ParenOpen) && nextTokenIs(TokenType::_Identifier))) {
             parsingError("Expected function name but got " + getTokenStr(), getToken().line, getToken().column);
         }
         identifier = parseIdentifier(nullptr);
     }
-    expect("(");
+    expect(TokenType::_ParenOpen);
     consumeToken();
-    std::vector<std::shared_ptr<ASTNode>> arguments;
-    while (!tokenIs(")") && !tokenIs("EndOfFile") && !tokenIs(";")) {
-        if (tokenIs("identifier") && peekToken() && nextTokenIs("=")) {
+    std::vector<NodeRef<>> arguments;
+    while (!tokenIs(TokenType::_ParenClose) && !tokenIs(TokenType::_EOF) && !tokenIs(TokenType::_Semi)) {
+        if (tokenIs(TokenType::_Identifier) && peekToken() && nextTokenIs(TokenType::_Equals)) {
             arguments.push_back(parseStatement());
         } else {
-            arguments.push_back(parseLogicalOr());
+            arguments.push_back(parseExpression());
         }
-        if (!tokenIs(")") && !tokenIs(",")) {
+        if (!tokenIs(TokenType::_ParenClose) && !tokenIs(TokenType::_Comma)) {
             parsingError("Expected ','", getToken().line, getToken().column);
-        } else if (tokenIs(",")) {
+        } else if (tokenIs(TokenType::_Comma)) {
             consumeToken();
-            if (tokenIs(")")) {
+            if (tokenIs(TokenType::_ParenClose)) {
                 parsingError("Expected another argument", getToken().line, getToken().column);
             }
         }
     }
-    if (tokenIs("EndOfFile") || tokenIs(";")) {
+    if (tokenIs(TokenType::_EOF) || tokenIs(TokenType::_Semi)) {
         parsingError("Expected ')'", getToken().line, getToken().column);
     }
     consumeToken();
-    return std::make_shared<MethodCallNode>(identifier, arguments, identifier->line, identifier->column);
+    return makeNode<MethodCallNode>(identifier, arguments, identifier->line(), identifier->column());
 }
 
-std::shared_ptr<ASTNode> Parser::parseIdentifier(std::shared_ptr<std::string> varString) {
+NodeRef<> Parser::parseIdentifier(std::shared_ptr<std::string> varString) {
     if (debug) std::cout << "Parse Identifier " << getTokenStr() << std::endl;
-    if (tokenIs("&") && nextTokenIs("identifier")) {
+    if (tokenIs(TokenType::_Ampersand) && nextTokenIs(TokenType::_Identifier)) {
         const Token& location = consumeToken();
         const Token& token = consumeToken();
-        if (std::holds_alternative<std::string>(token.value)) {
-            auto ident_value = std::get<std::string>(token.value);
+        if (token.symbol != -1) {
             if (varString != nullptr) {
-                *varString = ident_value;
+                *varString = symbolName(token.symbol);
             }
-            auto ident_node = std::make_shared<IdentifierNode>(ident_value, token.line, token.column);
+            auto ident_node = makeNode<IdentifierNode>(token.symbol, token.line, token.column);
             ident_node->member_variable = true;
             return ident_node;
         } else {
             parsingError("Identifier was not a string??", token.line, token.column);
         }
     }
-    else if (tokenIs("identifier")) {
+    else if (tokenIs(TokenType::_Identifier)) {
         const Token& token = consumeToken();
-        if (std::holds_alternative<std::string>(token.value)) {
-            auto ident_value = std::get<std::string>(token.value);
+        if (token.symbol != -1) {
             if (varString != nullptr) {
-                *varString = ident_value;
+                *varString = symbolName(token.symbol);
             }
-            return std::make_shared<IdentifierNode>(ident_value, token.line, token.column);
+            return makeNode<IdentifierNode>(token.symbol, token.line, token.column);
         } else {
             parsingError("Identifier was not a string??", token.line, token.column);
         }
@@ -0,0 +1,110 @@
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "context.h"
+#include "nodes.h"
+
+std::atomic<size_t> profile_samples_due{0};
+
+namespace {
+
+struct FunctionSamples {
+    size_t self = 0;
+    size_t total = 0; // Samples with the function anywhere on the stack, counted once however deep it recursed
+};
+
+struct ProfileData {
+    std::mutex mutex;
+    std::string root; // Stands for the top level of the program
+    std::map<std::string, size_t> stacks; // Folded stack to the number of samples that hit it
+    std::map<std::string, FunctionSamples> functions;
+    size_t samples = 0;
+};
+
+ProfileData profile_data;
+
+}
+
+void recordProfileSample(const ASTNode* node) {
+    size_t ticks = profile_samples_due.exchange(0, std::memory_order_relaxed);
+    if (ticks == 0) {
+        return;
+    }
+    int line = node ? node->line() : 0;
+
+    std::vector<std::string> frames{profile_data.root};
+    for (const auto& [function, file] : function_context) {
+        frames.push_back(function + " (" + file + ")");
+    }
+
+    std::string folded;
+    for (size_t i = 0; i + 1 < frames.size(); i++) {
+        folded += frames[i] + ";";
+    }
+    // The leaf carries the line that was running, so a flamegraph splits a function's own time by line
+    const std::string& leaf = frames.back();
+    if (frames.size() == 1) {
+        folded += leaf + ":" + std::to_string(line);
+    } else {
+        folded += leaf.substr(0, leaf.size() - 1) + ":" + std::to_string(line) + ")";
+    }
+
+    std::lock_guard lock{profile_data.mutex};
+    profile_data.samples += ticks;
+    profile_data.stacks[folded] += ticks;
+    profile_data.functions[leaf].self += ticks;
+    for (size_t i = 0; i < frames.size(); i++) {
+        if (std::find(frames.begin(), frames.begin() + i, frames[i]) == frames.begin() + i) {
+            profile_data.functions[frames[i]].total += ticks;
+        }
+    }
+}
+
+ProfileSession::ProfileSession(const std::string& program, int hz)
+    : program{program}, hz{hz} {
+    profile_data.root = program;
+    sampler = std::thread([this]() {
+        auto interval = std::chrono::nanoseconds{1'000'000'000 / this->hz};
+        auto next = std::chrono::steady_clock::now() + interval;
+        while (running.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_until(next);
+            next += interval;
+            profile_samples_due.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+}
+
+ProfileSession::~ProfileSession() {
+    running.store(false, std::memory_order_relaxed);
+    sampler.join();
+    profile_samples_due.store(0, std::memory_order_relaxed);
+
+    std::lock_guard lock{profile_data.mutex};
+    std::string folded_path = program + ".folded";
+    std::ofstream folded{folded_path};
+    for (const auto& [stack, count] : profile_data.stacks) {
+        folded << stack << " " << count << "\n";
+    }
+
+    std::vector<std::pair<std::string, FunctionSamples>> functions(profile_data.functions.begin(), profile_data.functions.end());
+    std::sort(functions.begin(), functions.end(), [](const auto& a, const auto& b) {
+        return a.second.self != b.second.self ? a.second.self > b.second.self : a.second.total > b.second.total;
+    });
+
+    double sample_ms = 1000.0 / hz;
+    double samples = static_cast<double>(std::max<size_t>(profile_data.samples, 1));
+    std::cerr << std::format("\nProfile of {}: {} samples at {} Hz, folded stacks written to {}\n",
+                             program, profile_data.samples, hz, folded_path);
+    std::cerr << std::format("{:>10} {:>7} {:>10} {:>7}  {}\n", "Self ms", "Self %", "Total ms", "Total %", "Function");
+    for (const auto& [function, counts] : functions) {
+        std::cerr << std::format("{:>10.1f} {:>6.1f}% {:>10.1f} {:>6.1f}%  {}\n",
+                                 counts.self * sample_ms, 100.0 * counts.self / samples,
+                                 counts.total * sample_ms, 100.0 * counts.total / samples, function);
+    }
+}
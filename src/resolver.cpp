@@ -0,0 +1,291 @@
+#include "resolver.h"
+#include "compiler.h"
+#include "stats.h"
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+class Resolver {
+public:
+    Resolver(std::vector<Symbol>& program_layout, bool compile_functions);
+
+    void resolveBody(const ASTList& statements);
+
+private:
+    struct Block {
+        bool global_names = false; // Names declared in this block are globals rather than slots
+        std::unordered_map<std::string, int> slots;
+        std::unordered_set<std::string> globals;
+    };
+
+    struct FrameScope {
+        std::vector<Symbol>* layout;
+        std::vector<Block> blocks;
+    };
+
+    std::vector<FrameScope> frames;
+    bool compile_functions;
+
+    bool lookup(const std::string& name, int& depth, int& slot) const;
+    bool assignable(const std::string& name) const;
+    void declare(const std::string& name, bool shadow = false);
+    void collectTargets(ASTNode* statement, std::vector<std::string>& names) const;
+    void pushFrame(std::vector<Symbol>& layout);
+    void resolveBlock(const ASTList& statements, SlotRange& range, ForNode* loop = nullptr);
+    void resolveArgs(MethodCallNode* node);
+    void resolve(ASTNode* node);
+};
+
+Resolver::Resolver(std::vector<Symbol>& program_layout, bool compile_functions)
+    : compile_functions{compile_functions} {
+    pushFrame(program_layout);
+    frames.back().blocks.back().global_names = true;
+}
+
+void Resolver::pushFrame(std::vector<Symbol>& layout) {
+    layout.clear();
+    frames.push_back(FrameScope{&layout, {}});
+    frames.back().blocks.emplace_back();
+}
+
+bool Resolver::lookup(const std::string& name, int& depth, int& slot) const {
+    for (int f = static_cast<int>(frames.size()) - 1; f >= 0; f--) {
+        const auto& blocks = frames[f].blocks;
+        for (int b = static_cast<int>(blocks.size()) - 1; b >= 0; b--) {
+            if (blocks[b].globals.contains(name)) {
+                depth = -1;
+                return true;
+            }
+            auto found = blocks[b].slots.find(name);
+            if (found != blocks[b].slots.end()) {
+                depth = found->second < 0 ? -1 : static_cast<int>(frames.size()) - 1 - f;
+                slot = found->second;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Resolver::assignable(const std::string& name) const {
+    for (const auto& block : frames.back().blocks) {
+        if (block.globals.contains(name) || block.slots.contains(name)) {
+            return true;
+        }
+    }
+    // A function can assign the globals but not the locals of the functions it is nested in
+    for (const auto& frame : frames) {
+        for (const auto& block : frame.blocks) {
+            auto found = block.slots.find(name);
+            if (block.globals.contains(name) || (found != block.slots.end() && found->second < 0)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void Resolver::declare(const std::string& name, bool shadow) {
+    if (!shadow && assignable(name)) {
+        // Assigning to a name already declared updates it rather than creating a new variable
+        return;
+    }
+    Block& block = frames.back().blocks.back();
+    if (block.global_names) {
+        block.slots[name] = -1;
+        return;
+    }
+    auto layout = frames.back().layout;
+    block.slots[name] = static_cast<int>(layout->size());
+    layout->push_back(internSymbol(name));
+}
+
+void Resolver::collectTargets(ASTNode* statement, std::vector<std::string>& names) const {
+    // A compound assignment to a name only the frames around it have reads theirs, but assigns a local
+    auto binary = dynamic_cast<BinaryOpNode*>(statement);
+    if (!binary || (binary->op != TokenType::_Equals && binary->op != TokenType::_PlusEquals && binary->op != TokenType::_MinusEquals &&
+                    binary->op != TokenType::_MultiplyEquals && binary->op != TokenType::_DivideEquals)) {
+        return;
+    }
+    if (auto ident = dynamic_cast<IdentifierNode*>(binary->left.get())) {
+        if (!ident->member_variable) {
+            names.push_back(ident->name);
+        }
+    } else if (auto list = dynamic_cast<ListNode*>(binary->left.get())) {
+        for (const auto& element : list->list) {
+            auto ident = dynamic_cast<IdentifierNode*>(element.get());
+            if (ident && !ident->member_variable) {
+                names.push_back(ident->name);
+            }
+        }
+    }
+}
+
+void Resolver::resolveBody(const ASTList& statements) {
+    // Every name assigned directly in the block is declared up front, so a use earlier in a loop body
+    // refers to the same variable as the assignment further down
+    Block& block = frames.back().blocks.back();
+    for (const auto& statement : statements) {
+        auto keyword = dynamic_cast<KeywordNode*>(statement.get());
+        if (keyword && keyword->keyword == TokenType::_Global) {
+            if (auto ident = dynamic_cast<IdentifierNode*>(keyword->right.get())) {
+                block.globals.insert(ident->name);
+            }
+        }
+    }
+    std::vector<std::string> names;
+    for (const auto& statement : statements) {
+        collectTargets(statement.get(), names);
+    }
+    for (const auto& name : names) {
+        declare(name);
+    }
+    for (const auto& statement : statements) {
+        resolve(statement.get());
+    }
+}
+
+void Resolver::resolveBlock(const ASTList& statements, SlotRange& range, ForNode* loop) {
+    auto& layout = *frames.back().layout;
+    frames.back().blocks.emplace_back();
+    range.begin = static_cast<int>(layout.size());
+
+    if (loop) {
+        auto init_node = dynamic_cast<BinaryOpNode*>(loop->initialization.get());
+        std::vector<std::string> names;
+        if (init_node && init_node->op == TokenType::_In) {
+            if (auto ident = dynamic_cast<IdentifierNode*>(init_node->left.get())) {
+                names.push_back(ident->name);
+            } else if (auto list = dynamic_cast<ListNode*>(init_node->left.get())) {
+                for (const auto& element : list->list) {
+                    if (auto ident = dynamic_cast<IdentifierNode*>(element.get())) {
+                        names.push_back(ident->name);
+                    }
+                }
+            }
+            for (const auto& name : names) {
+                declare(name);
+            }
+            resolve(init_node->left.get());
+        } else {
+            collectTargets(loop->initialization.get(), names);
+            for (const auto& name : names) {
+                declare(name);
+            }
+            resolve(loop->initialization.get());
+            resolve(loop->condition_value.get());
+            resolve(loop->increment.get());
+        }
+    }
+    resolveBody(statements);
+
+    range.end = static_cast<int>(layout.size());
+    frames.back().blocks.pop_back();
+}
+
+void Resolver::resolveArgs(MethodCallNode* node) {
+    for (const auto& value : node->values) {
+        auto binary = dynamic_cast<BinaryOpNode*>(value.get());
+        if (binary && binary->op == TokenType::_Equals && dynamic_cast<IdentifierNode*>(binary->left.get())) {
+            // Labeled argument, the label is matched against the parameter names at call time
+            resolve(binary->right.get());
+        } else {
+            resolve(value.get());
+        }
+    }
+}
+
+void Resolver::resolve(ASTNode* node) {
+    if (!node) {
+        return;
+    }
+    if (auto ident = dynamic_cast<IdentifierNode*>(node)) {
+        if (ident->member_variable) {
+            return;
+        }
+        int depth = -1, slot = -1;
+        if (lookup(ident->name, depth, slot)) {
+            ident->depth = depth;
+            ident->slot = slot;
+        } else {
+            ident->depth = -1;
+            ident->slot = -1;
+        }
+    } else if (auto unary = dynamic_cast<UnaryOpNode*>(node)) {
+        resolve(unary->right.get());
+    } else if (auto binary = dynamic_cast<BinaryOpNode*>(node)) {
+        resolve(binary->left.get());
+        if (binary->op == TokenType::_Dot) {
+            // The right side names a member, only a method call's arguments are variables
+            if (auto call = dynamic_cast<MethodCallNode*>(binary->right.get())) {
+                resolveArgs(call);
+            }
+        } else {
+            resolve(binary->right.get());
+        }
+    } else if (auto parenthesis = dynamic_cast<ParenthesisOpNode*>(node)) {
+        resolve(parenthesis->expr.get());
+    } else if (auto call = dynamic_cast<MethodCallNode*>(node)) {
+        resolve(call->stored_func.get());
+        resolveArgs(call);
+    } else if (auto list = dynamic_cast<ListNode*>(node)) {
+        for (const auto& element : list->list) {
+            resolve(element.get());
+        }
+    } else if (auto dict = dynamic_cast<DictionaryNode*>(node)) {
+        for (const auto& pair : dict->dictionary) {
+            resolve(pair.first.get());
+            resolve(pair.second.get());
+        }
+    } else if (auto index = dynamic_cast<IndexNode*>(node)) {
+        resolve(index->container.get());
+        resolve(index->start_index.get());
+        resolve(index->end_index.get());
+    } else if (auto keyword = dynamic_cast<KeywordNode*>(node)) {
+        if (keyword->keyword != TokenType::_Global) {
+            resolve(keyword->right.get());
+        }
+    } else if (auto scoped = dynamic_cast<ScopedNode*>(node)) {
+        resolve(scoped->comparison.get());
+        resolveBlock(scoped->statements_block, scoped->slots);
+    } else if (auto for_node = dynamic_cast<ForNode*>(node)) {
+        auto init_node = dynamic_cast<BinaryOpNode*>(for_node->initialization.get());
+        if (init_node && init_node->op == TokenType::_In) {
+            // The container is evaluated before the loop variables exist
+            resolve(init_node->right.get());
+        }
+        resolveBlock(for_node->block, for_node->slots, for_node);
+    } else if (auto func = dynamic_cast<FuncNode*>(node)) {
+        for (const auto& pair : func->default_arg_nodes) {
+            resolve(pair.second.get());
+        }
+        pushFrame(func->frame_layout);
+        for (const auto& arg : func->args) {
+            if (auto ident = dynamic_cast<IdentifierNode*>(arg.get())) {
+                declare(ident->name, true);
+                resolve(ident);
+            }
+        }
+        resolveBody(func->block);
+        frames.pop_back();
+        if (compile_functions) {
+            // Every closure made from the definition shares it, nothing changes the node once it runs
+            func->chunk = std::make_shared<Chunk>(compileBlock(func->block, true));
+        }
+    } else if (auto class_node = dynamic_cast<ClassNode*>(node)) {
+        pushFrame(class_node->frame_layout);
+        resolveBody(class_node->block);
+        frames.pop_back();
+    }
+}
+
+}
+
+std::vector<Symbol> resolveProgram(const std::vector<NodeRef<>>& statements, bool compile_functions) {
+    PhaseTimer timer{Phase::Compile};
+    std::vector<Symbol> program_layout;
+    Resolver resolver{program_layout, compile_functions};
+    resolver.resolveBody(statements);
+    return program_layout;
+}
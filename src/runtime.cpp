@@ -0,0 +1,57 @@
+#include "runtime.h"
+
+namespace {
+
+constinit Runtime process_runtime;
+thread_local constinit Runtime* bound_runtime = &process_runtime;
+
+void bindRuntime(Runtime* runtime) {
+    bound_runtime = runtime;
+    active_arena = &runtime->arena;
+    active_collector = &runtime->collector;
+    active_memory_counts = &runtime->memory;
+}
+
+}
+
+thread_local constinit ASTArena* active_arena = &process_runtime.arena;
+thread_local constinit GarbageCollector* active_collector = &process_runtime.collector;
+thread_local constinit MemoryCounts* active_memory_counts = &process_runtime.memory;
+
+Runtime& processRuntime() {
+    return process_runtime;
+}
+
+Runtime& activeRuntime() {
+    return *bound_runtime;
+}
+
+RuntimeScope::RuntimeScope(Runtime& runtime)
+    : previous{bound_runtime} {
+    bindRuntime(&runtime);
+}
+
+RuntimeScope::~RuntimeScope() {
+    bindRuntime(previous);
+}
+
+void Runtime::addSource(const std::string& name, const std::string& source_code) {
+    std::lock_guard lock{sources_mutex};
+    for (auto& [source_name, code] : sources) {
+        if (source_name == name) {
+            code = source_code;
+            return;
+        }
+    }
+    sources.emplace_back(name, source_code);
+}
+
+std::optional<std::string> Runtime::findSource(const std::string& name) {
+    std::lock_guard lock{sources_mutex};
+    for (const auto& [source_name, code] : sources) {
+        if (source_name == name) {
+            return code;
+        }
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,146 @@
+#include "stats.h"
+#include "valueDefs.h"
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+bool COLLECT_STATS = false;
+thread_local ExecutionStats execution_stats;
+
+namespace {
+
+std::mutex merged_mutex;
+ExecutionStats merged_stats; // Counters merged from every thread
+
+Phase current_phase = Phase::Execute;
+bool phase_running = false;
+std::chrono::steady_clock::time_point phase_start;
+
+void addStats(ExecutionStats& total, const ExecutionStats& stats) {
+    for (const auto& [name, count] : stats.node_evaluations) {
+        total.node_evaluations[name] += count;
+    }
+    total.vm_instructions += stats.vm_instructions;
+    total.function_calls += stats.function_calls;
+    total.builtin_calls += stats.builtin_calls;
+    total.environment_copies += stats.environment_copies;
+    total.value_allocations += stats.value_allocations;
+    total.exceptions += stats.exceptions;
+    total.dictionary_lookups += stats.dictionary_lookups;
+    total.imports += stats.imports;
+    for (int i = 0; i < 4; i++) {
+        total.phase_times[i] += stats.phase_times[i];
+    }
+}
+
+void chargeCurrentPhase(std::chrono::steady_clock::time_point now) {
+    if (phase_running) {
+        execution_stats.phase_times[static_cast<int>(current_phase)] += now - phase_start;
+    }
+    phase_start = now;
+}
+
+long peakResidentKilobytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS memory{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory))) {
+        return static_cast<long>(memory.PeakWorkingSetSize / 1024);
+    }
+    return 0;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // Bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+}
+
+// Phases are only timed while the program runs on one thread
+PhaseTimer::PhaseTimer(Phase phase)
+    : active{COLLECT_STATS && !THREADS_ACTIVE} {
+    if (active) {
+        previous = current_phase;
+        chargeCurrentPhase(std::chrono::steady_clock::now());
+        current_phase = phase;
+        phase_running = true;
+    }
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (active) {
+        chargeCurrentPhase(std::chrono::steady_clock::now());
+        current_phase = previous;
+    }
+}
+
+void mergeThreadStats() {
+    std::lock_guard lock{merged_mutex};
+    addStats(merged_stats, execution_stats);
+    execution_stats = ExecutionStats{};
+}
+
+void printExecutionStats(const std::string& program) {
+#ifndef FUNCY_STATS
+    std::cerr << "\nStatistics of " << program << ": counters were not compiled in, build with FUNCY_STATS\n";
+#else
+    mergeThreadStats();
+    const ExecutionStats& stats = merged_stats;
+    auto milliseconds = [](std::chrono::steady_clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+
+    std::cerr << std::format("\nStatistics of {}:\n", program);
+    std::cerr << std::format("  Time: lex {:.1f} ms, parse {:.1f} ms, compile {:.1f} ms, execute {:.1f} ms\n",
+                             milliseconds(stats.phase_times[static_cast<int>(Phase::Lex)]),
+                             milliseconds(stats.phase_times[static_cast<int>(Phase::Parse)]),
+                             milliseconds(stats.phase_times[static_cast<int>(Phase::Compile)]),
+                             milliseconds(stats.phase_times[static_cast<int>(Phase::Execute)]));
+    std::cerr << std::format("  Peak memory: {} KB\n", peakResidentKilobytes());
+
+    std::vector<std::pair<std::string, uint64_t>> counters{
+        {"Function calls", stats.function_calls},
+        {"Built-in function calls", stats.builtin_calls},
+        {"Environment copies", stats.environment_copies},
+        {"Value allocations", stats.value_allocations},
+        {"Dictionary lookups", stats.dictionary_lookups},
+        {"Exceptions thrown", stats.exceptions},
+        {"Imports", stats.imports},
+        {"VM instructions", stats.vm_instructions}
+    };
+    for (const auto& [name, count] : counters) {
+        std::cerr << std::format("  {:<26}{:>14}\n", name + ":", count);
+    }
+
+    // The same name from different translation units may have different addresses
+    std::map<std::string, uint64_t> nodes;
+    uint64_t total_nodes = 0;
+    for (const auto& [name, count] : stats.node_evaluations) {
+        nodes[name] += count;
+        total_nodes += count;
+    }
+    std::vector<std::pair<std::string, uint64_t>> sorted_nodes(nodes.begin(), nodes.end());
+    std::stable_sort(sorted_nodes.begin(), sorted_nodes.end(), [](const auto& a, const auto& b) {
+        return a.second > b.second;
+    });
+    std::cerr << std::format("  {:<26}{:>14}\n", "Nodes evaluated:", total_nodes);
+    for (const auto& [name, count] : sorted_nodes) {
+        std::cerr << std::format("    {:<24}{:>14}\n", name, count);
+    }
+#endif
+}
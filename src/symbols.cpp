@@ -0,0 +1,48 @@
+#include "symbols.h"
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+// Lets the table be searched with a string_view without building a string first
+struct NameHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view name) const {
+        return std::hash<std::string_view>{}(name);
+    }
+};
+
+std::unordered_map<std::string, Symbol, NameHash, std::equal_to<>>& symbolTable() {
+    static std::unordered_map<std::string, Symbol, NameHash, std::equal_to<>> table;
+    return table;
+}
+
+// A deque so the names handed out stay put as more are added
+std::deque<std::string>& symbolNames() {
+    static std::deque<std::string> names;
+    return names;
+}
+
+// Code running in parallel can still look up names that were never interned
+std::mutex symbol_mutex;
+
+}
+
+Symbol internSymbol(std::string_view name) {
+    std::lock_guard lock{symbol_mutex};
+    auto& table = symbolTable();
+    auto found = table.find(name);
+    if (found != table.end()) {
+        return found->second;
+    }
+    Symbol symbol = static_cast<Symbol>(symbolNames().size());
+    symbolNames().emplace_back(name);
+    table.emplace(name, symbol);
+    return symbol;
+}
+
+const std::string& symbolName(Symbol symbol) {
+    std::lock_guard lock{symbol_mutex};
+    return symbolNames().at(symbol);
+}
@@ -0,0 +1,82 @@
+#include "tasks.h"
+#include <iostream>
+
+Future::~Future() {
+    if (!error || joined) {
+        return;
+    }
+    try {
+        std::rethrow_exception(error);
+    }
+    catch (const ErrorException& e) {
+        std::cerr << e.message << std::endl;
+    }
+    catch (...) {}
+}
+
+void Future::finish(std::optional<Value> value, std::exception_ptr exception) {
+    {
+        std::lock_guard lock{mutex};
+        if (value) {
+            result = std::move(*value);
+        }
+        error = exception;
+        is_done = true;
+    }
+    finished.notify_all();
+}
+
+Value Future::join() {
+    std::unique_lock lock{mutex};
+    finished.wait(lock, [this] { return is_done; });
+    joined = true;
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return result;
+}
+
+bool Future::done() {
+    std::lock_guard lock{mutex};
+    return is_done;
+}
+
+Channel::Channel(size_t capacity)
+    : capacity{capacity} {}
+
+bool Channel::send(Value value) {
+    {
+        std::unique_lock lock{mutex};
+        not_full.wait(lock, [this] { return closed || buffer.size() < capacity; });
+        if (closed) {
+            return false;
+        }
+        buffer.push_back(std::move(value));
+    }
+    not_empty.notify_one();
+    return true;
+}
+
+std::optional<Value> Channel::recv() {
+    std::optional<Value> value;
+    {
+        std::unique_lock lock{mutex};
+        not_empty.wait(lock, [this] { return closed || !buffer.empty(); });
+        if (buffer.empty()) {
+            return std::nullopt;
+        }
+        value = std::move(buffer.front());
+        buffer.pop_front();
+    }
+    not_full.notify_one();
+    return value;
+}
+
+void Channel::close() {
+    {
+        std::lock_guard lock{mutex};
+        closed = true;
+    }
+    not_full.notify_all();
+    not_empty.notify_all();
+}
@@ -0,0 +1,292 @@
+#include "threadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "valueDefs.h"
+#include "runtime.h"
+#include "stats.h"
+
+int THREAD_COUNT = 0;
+std::atomic<bool> THREADS_ACTIVE{false};
+
+namespace {
+
+thread_local size_t home_queue = 0; // Threads outside the pool share queue 0
+thread_local bool running_task = false;
+
+std::mutex threads_mutex;
+std::condition_variable threads_finished;
+size_t threaded_work = 0; // Batches spread over workers and spawned threads running, guarded by threads_mutex
+size_t spawned_threads = 0; // Of every runtime, guarded by threads_mutex
+
+// Called with threads_mutex held
+void beginThreadedWork(Runtime& runtime) {
+    if (threaded_work++ == 0) {
+        THREADS_ACTIVE = true;
+    }
+    runtime.collector.threaded_work++;
+}
+
+void endThreadedWork(Runtime& runtime) {
+    runtime.collector.threaded_work--;
+    if (--threaded_work == 0) {
+        THREADS_ACTIVE = false;
+    }
+}
+
+// One call of parallelFor, which lives on the stack of the thread that waits for it
+struct Batch {
+    Batch(const std::function<void(size_t)>& task, size_t count)
+        : task{task}, runtime{activeRuntime()}, remaining{count} {}
+
+    const std::function<void(size_t)>& task;
+    Runtime& runtime; // The tasks run in the runtime of the thread that submitted them
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t remaining; // Tasks not finished or skipped yet
+    std::atomic<size_t> failed_index{SIZE_MAX};
+    std::exception_ptr error;
+};
+
+struct Job {
+    Batch* batch;
+    size_t index;
+};
+
+struct Queue {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+};
+
+class ThreadPool {
+public:
+    static ThreadPool& get();
+
+    void run(size_t count, const std::function<void(size_t)>& task);
+    size_t size() const;
+
+private:
+    explicit ThreadPool(size_t threads);
+    void work(size_t index);
+    bool runQueuedJob(size_t home);
+    static void runJob(const Job& job);
+
+    std::vector<std::unique_ptr<Queue>> queues; // One per thread, the queue of the waiting thread first
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued{0};
+    std::mutex sleep_mutex;
+    std::condition_variable work_available;
+};
+
+ThreadPool& ThreadPool::get() {
+    // Never destroyed, the workers sleep until the process exits
+    static ThreadPool* pool = new ThreadPool(THREAD_COUNT > 0 ? THREAD_COUNT
+                                                              : std::max(1u, std::thread::hardware_concurrency()));
+    return *pool;
+}
+
+ThreadPool::ThreadPool(size_t threads) {
+    for (size_t i = 0; i < threads; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 1; i < threads; i++) {
+        workers.emplace_back([this, i] { work(i); });
+    }
+}
+
+size_t ThreadPool::size() const {
+    return queues.size();
+}
+
+void ThreadPool::work(size_t index) {
+    home_queue = index;
+    while (true) {
+        if (runQueuedJob(index)) {
+            continue;
+        }
+        std::unique_lock lock{sleep_mutex};
+        work_available.wait(lock, [this] { return queued.load() > 0; });
+    }
+}
+
+// Takes the oldest job of the thread's own queue, or steals the newest of another
+bool ThreadPool::runQueuedJob(size_t home) {
+    std::optional<Job> job;
+    for (size_t offset = 0; offset < queues.size() && !job; offset++) {
+        Queue& queue = *queues[(home + offset) % queues.size()];
+        std::lock_guard lock{queue.mutex};
+        if (queue.jobs.empty()) {
+            continue;
+        }
+        if (offset == 0) {
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+        } else {
+            job = queue.jobs.back();
+            queue.jobs.pop_back();
+        }
+    }
+    if (!job) {
+        return false;
+    }
+    queued--;
+    runJob(*job);
+    return true;
+}
+
+void ThreadPool::runJob(const Job& job) {
+    Batch& batch = *job.batch;
+    if (job.index < batch.failed_index.load()) {
+        bool was_running = running_task;
+        running_task = true;
+        RuntimeScope scope{batch.runtime};
+        try {
+            batch.task(job.index);
+        }
+        catch (...) {
+            std::lock_guard lock{batch.mutex};
+            if (job.index < batch.failed_index.load()) {
+                batch.failed_index = job.index;
+                batch.error = std::current_exception();
+            }
+        }
+        running_task = was_running;
+        if (COLLECT_STATS) {
+            mergeThreadStats();
+        }
+    }
+
+    // The waiting thread may return as soon as the count reaches zero, so the batch isn't touched after
+    std::lock_guard lock{batch.mutex};
+    if (--batch.remaining == 0) {
+        batch.done.notify_all();
+    }
+}
+
+void ThreadPool::run(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    Batch batch{task, count};
+    if (workers.empty()) {
+        // Queued jobs could be taken by a thread of another interpreter waiting on its own batch
+        for (size_t index = 0; index < count; index++) {
+            runJob(Job{&batch, index});
+        }
+        if (batch.error) {
+            std::rethrow_exception(batch.error);
+        }
+        return;
+    }
+    {
+        std::lock_guard lock{threads_mutex};
+        beginThreadedWork(batch.runtime);
+    }
+    {
+        std::lock_guard lock{sleep_mutex};
+        queued += count;
+    }
+
+    // Contiguous runs of indexes for each queue, the lowest for the waiting thread
+    size_t home = home_queue;
+    for (size_t i = 0; i < queues.size(); i++) {
+        size_t begin = count * i / queues.size();
+        size_t end = count * (i + 1) / queues.size();
+        Queue& queue = *queues[(home + i) % queues.size()];
+        std::lock_guard lock{queue.mutex};
+        for (size_t index = begin; index < end; index++) {
+            queue.jobs.push_back(Job{&batch, index});
+        }
+    }
+    work_available.notify_all();
+
+    while (true) {
+        {
+            std::lock_guard lock{batch.mutex};
+            if (batch.remaining == 0) {
+                break;
+            }
+        }
+        if (!runQueuedJob(home)) {
+            // Every job of the batch has been taken, wait for the ones other threads are running
+            std::unique_lock lock{batch.mutex};
+            batch.done.wait(lock, [&batch] { return batch.remaining == 0; });
+            break;
+        }
+    }
+
+    {
+        std::lock_guard lock{threads_mutex};
+        endThreadedWork(batch.runtime);
+    }
+    if (batch.error) {
+        std::rethrow_exception(batch.error);
+    }
+}
+
+}
+
+void parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    ThreadPool::get().run(count, task);
+}
+
+size_t parallelThreadCount() {
+    return ThreadPool::get().size();
+}
+
+bool inParallelTask() {
+    return running_task;
+}
+
+void startThread(std::function<void()> task) {
+    Runtime& runtime = activeRuntime();
+    {
+        std::lock_guard lock{threads_mutex};
+        spawned_threads++;
+        runtime.spawned_threads++;
+        beginThreadedWork(runtime);
+    }
+    auto finishThread = [&runtime] {
+        std::lock_guard lock{threads_mutex};
+        spawned_threads--;
+        runtime.spawned_threads--;
+        endThreadedWork(runtime);
+        threads_finished.notify_all();
+    };
+    try {
+        std::thread([task = std::move(task), &runtime, finishThread]() mutable {
+            running_task = true;
+            RuntimeScope scope{runtime};
+            task();
+            task = nullptr; // Releases what it captured while reference counts are still atomic
+            if (COLLECT_STATS) {
+                mergeThreadStats();
+            }
+            finishThread();
+        }).detach();
+    }
+    catch (const std::system_error&) {
+        finishThread();
+        throw;
+    }
+}
+
+void waitForThreads() {
+    Runtime& runtime = activeRuntime();
+    std::unique_lock lock{threads_mutex};
+    threads_finished.wait(lock, [&runtime] { return runtime.spawned_threads == 0; });
+}
+
+size_t runningThreads() {
+    std::lock_guard lock{threads_mutex};
+    return spawned_threads;
+}
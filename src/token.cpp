@@ -1,6 +1,7 @@
 #include "token.h"
 #include <unordered_map>
 #include <iostream>
+#include <iterator>
 
 
 std::unordered_map<TokenType, std::string> token_labels{
@@ -84,31 +85,41 @@ std::string getTokenTypeLabel(TokenType type) {
     }
 }
 
-std::unordered_map<char, TokenType> char_tokens {
-    {';', TokenType::_Semi},
-    {'+', TokenType::_Plus},
-    {'-', TokenType::_Minus},
-    {'*', TokenType::_Multiply},
-    {'/', TokenType::_Divide},
-    {'^', TokenType::_Caret},
-    {'(', TokenType::_ParenOpen},
-    {')', TokenType::_ParenClose},
-    {'=', TokenType::_Equals},
-    {'!', TokenType::_Exclamation},
-    {'{', TokenType::_CurlyOpen},
-    {'}', TokenType::_CurlyClose},
-    {'<', TokenType::_LessThan},
-    {'>', TokenType::_GreaterThan},
-    {',', TokenType::_Comma},
-    {'[', TokenType::_SquareOpen},
-    {']', TokenType::_SquareClose},
-    {':', TokenType::_Colon},
-    {'.', TokenType::_Dot},
-    {'%', TokenType::_Mod},
-    {'&', TokenType::_Ampersand}
+std::optional<TokenType> findCharToken(char character) {
+    switch (character) {
+        case ';': return TokenType::_Semi;
+        case '+': return TokenType::_Plus;
+        case '-': return TokenType::_Minus;
+        case '*': return TokenType::_Multiply;
+        case '/': return TokenType::_Divide;
+        case '^': return TokenType::_Caret;
+        case '(': return TokenType::_ParenOpen;
+        case ')': return TokenType::_ParenClose;
+        case '=': return TokenType::_Equals;
+        case '!': return TokenType::_Exclamation;
+        case '{': return TokenType::_CurlyOpen;
+        case '}': return TokenType::_CurlyClose;
+        case '<': return TokenType::_LessThan;
+        case '>': return TokenType::_GreaterThan;
+        case ',': return TokenType::_Comma;
+        case '[': return TokenType::_SquareOpen;
+        case ']': return TokenType::_SquareClose;
+        case ':': return TokenType::_Colon;
+        case '.': return TokenType::_Dot;
+        case '%': return TokenType::_Mod;
+        case '&': return TokenType::_Ampersand;
+        default: return std::nullopt;
+    }
+}
+
+namespace {
+
+struct Keyword {
+    std::string_view word;
+    TokenType type;
 };
 
-std::unordered_map<std::string, TokenType> keyword_tokens {
+constexpr Keyword keywords[] = {
     {"and", TokenType::_And},
     {"or", TokenType::_Or},
     {"not", TokenType::_Not},
@@ -138,20 +149,55 @@ std::unordered_map<std::string, TokenType> keyword_tokens {
     {"class", TokenType::_Class},
     {"instance", TokenType::_Instance},
     {"this", TokenType::_This},
-    {"throw", TokenType::_Throw}
+    {"throw", TokenType::_Throw},
+    {"true", TokenType::_Boolean},
+    {"false", TokenType::_Boolean}
 };
 
-std::unordered_map<std::string, TokenType> scoped_keyword_tokens {
-    {"if", TokenType::_If},
-    {"elif", TokenType::_Elif},
-    {"else", TokenType::_Else},
-    {"while", TokenType::_While},
-    {"for", TokenType::_For},
-    {"func", TokenType::_Func},
-    {"class", TokenType::_Class}
-    // Also change in parser.cpp
+// A perfect hash over the keywords above, so a word needs one slot check and one comparison
+constexpr size_t KEYWORD_SLOTS = 64;
+
+constexpr size_t keywordHash(std::string_view word) {
+    return (word.size() * 14 + static_cast<unsigned char>(word.front()) * 25
+            + static_cast<unsigned char>(word.back()) * 10) % KEYWORD_SLOTS;
+}
+
+struct KeywordTable {
+    int slots[KEYWORD_SLOTS];
+    bool perfect;
 };
 
+constexpr KeywordTable buildKeywordTable() {
+    KeywordTable table{{}, true};
+    for (int& slot : table.slots) {
+        slot = -1;
+    }
+    for (int i = 0; i < static_cast<int>(std::size(keywords)); i++) {
+        int& slot = table.slots[keywordHash(keywords[i].word)];
+        if (slot != -1) {
+            table.perfect = false;
+        }
+        slot = i;
+    }
+    return table;
+}
+
+constexpr KeywordTable keyword_table = buildKeywordTable();
+static_assert(keyword_table.perfect, "Keywords collide in keywordHash, change its multipliers");
+
+}
+
+std::optional<TokenType> findKeyword(std::string_view word) {
+    if (word.empty()) {
+        return std::nullopt;
+    }
+    int index = keyword_table.slots[keywordHash(word)];
+    if (index != -1 && keywords[index].word == word) {
+        return keywords[index].type;
+    }
+    return std::nullopt;
+}
+
 
 Token::Token(TokenType type, TokenValue value, int line, int column)
     : type{type}, value{value}, line{line}, column{column} {}
@@ -163,8 +209,8 @@ const void Token::display() {
     std::cout << getTokenTypeLabel(type);
     if (type == TokenType::_Integer || !std::holds_alternative<int>(value)) {
         std::cout << " : ";
-        if (std::holds_alternative<std::string>(value)) {
-            std::cout << std::get<std::string>(value) << std::endl;
+        if (std::holds_alternative<std::string_view>(value)) {
+            std::cout << std::get<std::string_view>(value) << std::endl;
         }
         else if (std::holds_alternative<bool>(value)) {
             std::cout << std::boolalpha << std::get<bool>(value) << std::endl;
@@ -1,104 +1,320 @@
 #include "values.h"
 #include <vector>
+#include <limits>
+#include <cstring>
 #include "errorDefs.h"
+#include "stats.h"
+#include "tasks.h"
 
 class FuncNode;
 
-bool ValueCompare::operator()(const std::shared_ptr<Value>& lhs, const std::shared_ptr<Value>& rhs) const {
-    // Handle null pointers
-    if (!lhs || !rhs) {
-        return lhs < rhs; // Compare pointers directly if either is null
+namespace {
+
+size_t mixHash(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return static_cast<size_t>(x);
+}
+
+// The object a function, class or instance value refers to
+const void* identity(const Value& value) {
+    switch (value.getType()) {
+        case ValueType::Function:
+            return value.get<std::shared_ptr<ASTNode>>().get();
+        case ValueType::BuiltInFunction:
+            return value.get<std::shared_ptr<BuiltInFunction>>().get();
+        case ValueType::Class:
+            return value.get<std::shared_ptr<Class>>().get();
+        case ValueType::Instance:
+            return value.get<std::shared_ptr<Instance>>().get();
+        default:
+            return nullptr;
     }
+}
 
-    // Compare ValueTypes first to establish ordering based on type
-    if (lhs->getType() != rhs->getType()) {
-        return lhs->getType() < rhs->getType();
+}
+
+bool sameRange(const Range& lhs, const Range& rhs) {
+    int size = lhs.size();
+    if (size != rhs.size()) {
+        return false;
     }
+    return size == 0 || (lhs.start == rhs.start && (size == 1 || lhs.step == rhs.step));
+}
 
-    // If the types are the same, compare the actual values
-    switch (lhs->getType()) {
+size_t ValueHash::operator()(const Value& value) const {
+    switch (value.getType()) {
         case ValueType::Integer:
-            return lhs->get<int>() < rhs->get<int>();
-        case ValueType::Float:
-            return lhs->get<double>() < rhs->get<double>();
-        case ValueType::Boolean:
-            return lhs->get<bool>() < rhs->get<bool>();
+            return mixHash(static_cast<uint32_t>(value.get<int>()));
+        case ValueType::Float: {
+            double number = value.get<double>();
+            if (number == 0) {
+                number = 0; // -0.0 and 0.0 are the same key
+            }
+            uint64_t bits;
+            std::memcpy(&bits, &number, sizeof(bits));
+            return mixHash(bits);
+        }
         case ValueType::String:
-            return lhs->get<std::string>() < rhs->get<std::string>();
+            return std::hash<std::string>{}(value.get<std::string>());
         case ValueType::List: {
-            auto lhs_list = lhs->get<std::shared_ptr<List>>();
-            auto rhs_list = rhs->get<std::shared_ptr<List>>();
+            const auto& list = value.get<std::shared_ptr<List>>();
+            size_t hash = mixHash(list->size());
+            for (size_t i = 0; i < list->size(); i++) {
+                hash = mixHash(hash ^ (*this)(list->at(i)));
+            }
+            return hash;
+        }
+        case ValueType::Dictionary: {
+            // Order independent, equal dictionaries may have been filled in a different order
+            const auto& dict = value.get<std::shared_ptr<Dictionary>>();
+            size_t hash = mixHash(dict->size());
+            for (const auto& pair : *dict) {
+                hash += mixHash((*this)(pair.first) * 31 + (*this)(pair.second));
+            }
+            return hash;
+        }
+        case ValueType::Range: {
+            // Ranges with the same elements are the same key
+            const Range& range = value.get<Range>();
+            int size = range.size();
+            size_t hash = mixHash(size);
+            if (size > 0) {
+                hash = mixHash(hash ^ static_cast<uint32_t>(range.start));
+            }
+            if (size > 1) {
+                hash = mixHash(hash ^ static_cast<uint32_t>(range.step));
+            }
+            return hash;
+        }
+        case ValueType::Function:
+        case ValueType::BuiltInFunction:
+        case ValueType::Class:
+        case ValueType::Instance:
+            return mixHash(reinterpret_cast<uintptr_t>(identity(value)));
+        default:
+            return mixHash(value.getBits());
+    }
+}
 
-            // Compare sizes first
+bool ValueEqual::operator()(const Value& lhs, const Value& rhs) const {
+    if (lhs.getType() != rhs.getType()) {
+        return false;
+    }
+    switch (lhs.getType()) {
+        case ValueType::Integer:
+            return lhs.get<int>() == rhs.get<int>();
+        case ValueType::Float: {
+            double left = lhs.get<double>();
+            double right = rhs.get<double>();
+            return left == right || (left != left && right != right);
+        }
+        case ValueType::String:
+            return lhs.get<std::string>() == rhs.get<std::string>();
+        case ValueType::List: {
+            const auto& lhs_list = lhs.get<std::shared_ptr<List>>();
+            const auto& rhs_list = rhs.get<std::shared_ptr<List>>();
             if (lhs_list->size() != rhs_list->size()) {
-                return lhs_list->size() < rhs_list->size();
+                return false;
             }
-
-            // Compare element-by-element if sizes are equal
-            for (size_t i = 0; i < lhs_list->size(); ++i) {
-                if (ValueCompare{}(lhs_list->at(i), rhs_list->at(i))) {
-                    return true; // lhs[i] < rhs[i]
-                }
-                if (ValueCompare{}(rhs_list->at(i), lhs_list->at(i))) {
-                    return false; // rhs[i] < lhs[i]
+            for (size_t i = 0; i < lhs_list->size(); i++) {
+                if (!(*this)(lhs_list->at(i), rhs_list->at(i))) {
+                    return false;
                 }
             }
-
-            // Lists are equal if all elements are equal
-            return false;
+            return true;
         }
         case ValueType::Dictionary: {
-            auto lhs_dict = lhs->get<std::shared_ptr<Dictionary>>();
-            auto rhs_dict = rhs->get<std::shared_ptr<Dictionary>>();
-
-            // Compare sizes first
+            const auto& lhs_dict = lhs.get<std::shared_ptr<Dictionary>>();
+            const auto& rhs_dict = rhs.get<std::shared_ptr<Dictionary>>();
             if (lhs_dict->size() != rhs_dict->size()) {
-                return lhs_dict->size() < rhs_dict->size();
+                return false;
             }
-
-            // Compare key-value pairs lexicographically
-            auto lhs_iter = lhs_dict->begin();
-            auto rhs_iter = rhs_dict->begin();
-            while (lhs_iter != lhs_dict->end() && rhs_iter != rhs_dict->end()) {
-                // Compare keys
-                if (ValueCompare{}(lhs_iter->first, rhs_iter->first)) {
-                    return true; // lhs_key < rhs_key
-                }
-                if (ValueCompare{}(rhs_iter->first, lhs_iter->first)) {
-                    return false; // rhs_key < lhs_key
+            for (const auto& pair : *lhs_dict) {
+                auto found = rhs_dict->find(pair.first);
+                if (found == rhs_dict->end() || !(*this)(pair.second, found->second)) {
+                    return false;
                 }
+            }
+            return true;
+        }
+        case ValueType::Range:
+            return sameRange(lhs.get<Range>(), rhs.get<Range>());
+        case ValueType::Function:
+        case ValueType::BuiltInFunction:
+        case ValueType::Class:
+        case ValueType::Instance:
+            return identity(lhs) == identity(rhs);
+        default:
+            return lhs.getBits() == rhs.getBits();
+    }
+}
 
-                // Compare values
-                if (ValueCompare{}(lhs_iter->second, rhs_iter->second)) {
-                    return true; // lhs_value < rhs_value
-                }
-                if (ValueCompare{}(rhs_iter->second, lhs_iter->second)) {
-                    return false; // rhs_value < lhs_value
-                }
+List::List(std::vector<Value> elements)
+    : GCObject{GCKind::List}, elements{elements} {}
+
+void List::trace(GCVisitor& visitor) const {
+    for (const auto& element : elements) {
+        visitor.visit(element);
+    }
+}
+
+void List::clearReferences() {
+    elements.clear();
+}
+
+size_t List::memoryUsage() const {
+    return sizeof(List) + elements.capacity() * sizeof(Value);
+}
+
+void Dictionary::trace(GCVisitor& visitor) const {
+    for (const auto& pair : *this) {
+        visitor.visit(pair.first);
+        visitor.visit(pair.second);
+    }
+}
 
-                ++lhs_iter;
-                ++rhs_iter;
+void Dictionary::clearReferences() {
+    clear();
+}
+
+size_t Dictionary::memoryUsage() const {
+    return sizeof(Dictionary) + entries.capacity() * sizeof(value_type) + hashes.capacity() * sizeof(size_t)
+           + slots.capacity() * sizeof(uint32_t);
+}
+
+void Dictionary::clear() {
+    entries.clear();
+    hashes.clear();
+    slots.clear();
+    count = 0;
+}
+
+size_t Dictionary::findIndex(const Value& key, size_t hash) const {
+    COUNT_STAT(dictionary_lookups);
+    if (slots.empty()) {
+        return NOT_FOUND;
+    }
+    size_t mask = slots.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        uint32_t index = slots[slot];
+        if (index == EMPTY_SLOT) {
+            return NOT_FOUND;
+        }
+        if (hashes[index] == hash && entries[index].first && ValueEqual{}(entries[index].first, key)) {
+            return index;
+        }
+    }
+}
+
+size_t Dictionary::insertIndex(const Value& key, bool& inserted) {
+    size_t hash = ValueHash{}(key);
+    size_t index = findIndex(key, hash);
+    if (index != NOT_FOUND) {
+        inserted = false;
+        return index;
+    }
+    // Holes still occupy their slots, so they count towards the load
+    if ((entries.size() + 1) * 4 > slots.size() * 3) {
+        rehash();
+    }
+    index = entries.size();
+    entries.emplace_back(key, Value());
+    hashes.push_back(hash);
+    size_t mask = slots.size() - 1;
+    size_t slot = hash & mask;
+    while (slots[slot] != EMPTY_SLOT) {
+        slot = (slot + 1) & mask;
+    }
+    slots[slot] = static_cast<uint32_t>(index);
+    count++;
+    inserted = true;
+    return index;
+}
+
+void Dictionary::rehash() {
+    if (count != entries.size()) {
+        size_t kept = 0;
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].first) {
+                if (kept != i) {
+                    entries[kept] = std::move(entries[i]);
+                    hashes[kept] = hashes[i];
+                }
+                kept++;
             }
+        }
+        entries.resize(kept);
+        hashes.resize(kept);
+    }
 
-            // Dictionaries are equal if all key-value pairs are equal
-            return false;
+    size_t capacity = 8;
+    while (capacity < (count + 1) * 2) {
+        capacity *= 2;
+    }
+    slots.assign(capacity, EMPTY_SLOT);
+    size_t mask = capacity - 1;
+    for (size_t index = 0; index < entries.size(); index++) {
+        size_t slot = hashes[index] & mask;
+        while (slots[slot] != EMPTY_SLOT) {
+            slot = (slot + 1) & mask;
         }
-        default:
-            // For unsupported types, use address comparison as a fallback
-            return lhs < rhs;
+        slots[slot] = static_cast<uint32_t>(index);
     }
 }
 
+Dictionary::iterator Dictionary::find(const Value& key) {
+    size_t index = findIndex(key, ValueHash{}(key));
+    return index == NOT_FOUND ? end() : iterator{this, index};
+}
 
+Dictionary::const_iterator Dictionary::find(const Value& key) const {
+    size_t index = findIndex(key, ValueHash{}(key));
+    return index == NOT_FOUND ? end() : const_iterator{this, index};
+}
+
+bool Dictionary::contains(const Value& key) const {
+    return findIndex(key, ValueHash{}(key)) != NOT_FOUND;
+}
 
-List::List(std::vector<std::shared_ptr<Value>> elements)
-    : elements{elements} {}
+std::pair<Dictionary::iterator, bool> Dictionary::insert(const value_type& pair) {
+    bool inserted;
+    size_t index = insertIndex(pair.first, inserted);
+    if (inserted) {
+        entries[index].second = pair.second;
+    }
+    return {iterator{this, index}, inserted};
+}
+
+Value& Dictionary::operator[](const Value& key) {
+    bool inserted;
+    return entries[insertIndex(key, inserted)].second;
+}
+
+Dictionary::iterator Dictionary::erase(const_iterator position) {
+    size_t index = position.getPosition();
+    entries[index] = value_type{};
+    count--;
+    return iterator{this, index + 1};
+}
+
+size_t Dictionary::erase(const Value& key) {
+    auto found = find(key);
+    if (found == end()) {
+        return 0;
+    }
+    erase(found);
+    return 1;
+}
 
-void List::push_back(std::shared_ptr<Value> value) {
+void List::push_back(Value value) {
         elements.push_back(value);
     }
 
-std::shared_ptr<Value> List::pop(int index) {
+Value List::pop(int index) {
     if (index < 0) {
         auto value = elements.at(elements.size() - -index);
         elements.erase(elements.end() - -index);
@@ -110,7 +326,7 @@ std::shared_ptr<Value> List::pop(int index) {
     }
 }
 
-void List::insert(size_t index, std::shared_ptr<Value> value) {
+void List::insert(size_t index, Value value) {
     if (index >= elements.size() + 1 || index < 0) {
         throw std::out_of_range("Index out of range");
     }
@@ -125,28 +341,28 @@ void List::insert(const std::shared_ptr<List>& other) {
     elements.insert(elements.end(), other->elements.begin(), other->elements.end());
 }
 
-void List::set(size_t index, std::shared_ptr<Value> value) {
+void List::set(size_t index, Value value) {
     if (index >= elements.size()) {
         throw std::out_of_range("Index out of range");
     }
     elements[index] = value;
 }
 
-bool compareValues(std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
-    if (left->getType() == right->getType()) {
-        ValueType type = left->getType();
+bool compareValues(Value left, Value right) {
+    if (left.getType() == right.getType()) {
+        ValueType type = left.getType();
         switch (type) {
             case ValueType::Integer:
-                return left->get<int>() == right->get<int>();
+                return left.get<int>() == right.get<int>();
             case ValueType::Float:
-                return left->get<double>() == right->get<double>();
+                return left.get<double>() == right.get<double>();
             case ValueType::Boolean:
-                return left->get<bool>() == right->get<bool>();
+                return left.get<bool>() == right.get<bool>();
             case ValueType::String:
-                return left->get<std::string>() == right->get<std::string>();
+                return left.get<std::string>() == right.get<std::string>();
             case ValueType::List: {
-                auto l_list = left->get<std::shared_ptr<List>>();
-                auto r_list = right->get<std::shared_ptr<List>>();
+                auto l_list = left.get<std::shared_ptr<List>>();
+                auto r_list = right.get<std::shared_ptr<List>>();
                 if (l_list->size() == r_list->size()) {
                     for (int i = 0; i < l_list->size(); i++) {
                         if (!compareValues(l_list->at(i), r_list->at(i))) {
@@ -158,15 +374,14 @@ bool compareValues(std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
                 }
             }
             case ValueType::Dictionary: {
-                auto l_dict = left->get<std::shared_ptr<Dictionary>>();
-                auto r_dict = right->get<std::shared_ptr<Dictionary>>();
+                auto l_dict = left.get<std::shared_ptr<Dictionary>>();
+                auto r_dict = right.get<std::shared_ptr<Dictionary>>();
                 if (l_dict->size() == r_dict->size()) {
-                    for (int i = 0; i < l_dict->size(); i++) {
-                        auto l_index_pair = std::next(l_dict->begin(), i);
-                        auto r_index_pair = std::next(r_dict->begin(), i);
-                        if (!compareValues(l_index_pair->first, r_index_pair->first)) {
+                    for (const auto& l_pair : *l_dict) {
+                        auto r_pair = r_dict->find(l_pair.first);
+                        if (r_pair == r_dict->end()) {
                             return false;
-                        } else if (!compareValues(l_index_pair->second, r_index_pair->second)) {
+                        } else if (!compareValues(l_pair.second, r_pair->second)) {
                             return false;
                         }
                     }
@@ -178,27 +393,33 @@ bool compareValues(std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
             case ValueType::None:
                 return true;
             case ValueType::Function:
-                return left->get<std::shared_ptr<ASTNode>>() == right->get<std::shared_ptr<ASTNode>>();
+                return left.get<std::shared_ptr<ASTNode>>() == right.get<std::shared_ptr<ASTNode>>();
             case ValueType::BuiltInFunction:
-                return left->get<std::shared_ptr<BuiltInFunction>>() == right->get<std::shared_ptr<BuiltInFunction>>();
+                return left.get<std::shared_ptr<BuiltInFunction>>() == right.get<std::shared_ptr<BuiltInFunction>>();
             case ValueType::Class:
-                return left->get<std::shared_ptr<Class>>() == right->get<std::shared_ptr<Class>>();
+                return left.get<std::shared_ptr<Class>>() == right.get<std::shared_ptr<Class>>();
             case ValueType::Instance:
-                return left->get<std::shared_ptr<Instance>>() == right->get<std::shared_ptr<Instance>>();
+                return left.get<std::shared_ptr<Instance>>() == right.get<std::shared_ptr<Instance>>();
             case ValueType::Type:
-                return left->get<ValueType>() == right->get<ValueType>();
+                return left.get<ValueType>() == right.get<ValueType>();
+            case ValueType::Range:
+                return sameRange(left.get<Range>(), right.get<Range>());
+            case ValueType::Future:
+                return left.get<std::shared_ptr<Future>>() == right.get<std::shared_ptr<Future>>();
+            case ValueType::Channel:
+                return left.get<std::shared_ptr<Channel>>() == right.get<std::shared_ptr<Channel>>();
             default:
                 throwError(ErrorType::Runtime, "Comparing unknown types");
         }
-    } else if ((left->getType() == ValueType::Integer && right->getType() == ValueType::Float) ||
-                (left->getType() == ValueType::Float && right->getType() == ValueType::Integer)) {
+    } else if ((left.getType() == ValueType::Integer && right.getType() == ValueType::Float) ||
+                (left.getType() == ValueType::Float && right.getType() == ValueType::Integer)) {
         double l_float, r_float;
-        if (left->getType() == ValueType::Integer) {
-            l_float = static_cast<double>(left->get<int>());
-            r_float = right->get<double>();
+        if (left.getType() == ValueType::Integer) {
+            l_float = static_cast<double>(left.get<int>());
+            r_float = right.get<double>();
         } else {
-            l_float = left->get<double>();
-            r_float = static_cast<double>(right->get<int>());
+            l_float = left.get<double>();
+            r_float = static_cast<double>(right.get<int>());
         }
 
         return l_float == r_float;
@@ -207,7 +428,7 @@ bool compareValues(std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
     }
 }
 
-void List::erase(const std::shared_ptr<Value> value) {
+void List::erase(const Value value) {
     for (auto it = elements.begin(); it != elements.end(); it++) {
         if (compareValues(*it, value)) {
             elements.erase(it);
@@ -217,7 +438,7 @@ void List::erase(const std::shared_ptr<Value> value) {
     throwError(ErrorType::Runtime, getValueStr(value) + " is not in list");
 }
 
-int List::index(const std::shared_ptr<Value> value, int start, int end) const {
+int List::index(const Value value, int start, int end) const {
     for (int i = start; i < end; i++) {
         if (elements.begin() + i == elements.end()) {
             throw std::out_of_range("Index out of range");
@@ -230,14 +451,14 @@ int List::index(const std::shared_ptr<Value> value, int start, int end) const {
     throwError(ErrorType::Runtime, getValueStr(value) + " is not in list");
 }
 
-std::shared_ptr<Value> List::at(size_t index) const {
+Value List::at(size_t index) const {
     if (index >= elements.size() || index < 0) {
         throw std::out_of_range("Index out of range");
     }
     return elements.at(index);
 }
 
-std::vector<std::shared_ptr<Value>> List::getElements() {
+std::vector<Value> List::getElements() {
     return elements;
 }
 
@@ -255,10 +476,25 @@ void List::clear() {
 
 
 Class::Class(std::string name, Environment& class_env)
-        : name{name}, class_env{class_env} {}
+        : GCObject{GCKind::Class}, name{name}, class_env{class_env} {}
+
+void Class::trace(GCVisitor& visitor) const {
+    class_env.trace(visitor);
+}
+
+void Class::clearReferences() {
+    class_env.clearReferences();
+}
+
+size_t Class::memoryUsage() const {
+    return sizeof(Class) + name.capacity();
+}
 
 std::shared_ptr<Instance> Class::createInstance() {
-    return std::make_shared<Instance>(name, class_env);
+    auto instance = std::make_shared<Instance>(name, class_env);
+    instance->getEnvironment().copyClassAttrs();
+    instance->getEnvironment().copyClassFrame();
+    return instance;
 }
 
 std::string Class::getName() const {
@@ -266,9 +502,21 @@ std::string Class::getName() const {
 }
 
 
-std::shared_ptr<Value> Instance::getConstructor(std::shared_ptr<Instance> this_reference) {
+void Instance::trace(GCVisitor& visitor) const {
+    instance_env.trace(visitor);
+}
+
+void Instance::clearReferences() {
+    instance_env.clearReferences();
+}
+
+size_t Instance::memoryUsage() const {
+    return sizeof(Instance) + class_name.capacity();
+}
+
+Value Instance::getConstructor(std::shared_ptr<Instance> this_reference) {
     auto constructor = instance_env.get(class_name, true);
-    if (constructor->getType() != ValueType::Function) {
+    if (constructor.getType() != ValueType::Function) {
         throwError(ErrorType::Runtime, class_name + " Class constructor does not exist");
     }
     return constructor;
@@ -287,99 +535,124 @@ std::string Instance::getClassName() const {
 }
 
 
-Value::Value()  // Defaults to monostate (NONE)
-    : value_type{ValueType::None} {}
-
-Value::Value(int v)
-    : value{v}, value_type{ValueType::Integer} {}
-
-Value::Value(double v)
-    : value{v}, value_type{ValueType::Float} {}
+Value::Value(double v) {
+    if (v != v) {
+        // Every NaN shares one bit pattern so it can't collide with the tagged ranges
+        v = std::numeric_limits<double>::quiet_NaN();
+    }
+    uint64_t raw;
+    std::memcpy(&raw, &v, sizeof(raw));
+    bits = raw + DOUBLE_OFFSET;
+}
 
-Value::Value(bool v)
-    : value{v}, value_type{ValueType::Boolean} {}
+size_t HeapObject::memoryUsage() const {
+    size_t size = sizeof(HeapObject);
+    auto text = std::get_if<std::string>(&value);
+    if (text && text->capacity() > std::string{}.capacity()) {
+        size += text->capacity() + 1;
+    }
+    return size;
+}
 
-Value::Value(const std::string& v)
-    : value{v}, value_type{ValueType::String} {}
+Value::Value(const std::string& v) {
+    COUNT_STAT(value_allocations);
+    setHeap(new HeapObject(ValueType::String, v));
+}
 
-Value::Value(std::shared_ptr<List> v)
-    : value{v}, value_type{ValueType::List} {}
+Value::Value(std::shared_ptr<List> v) {
+    COUNT_STAT(value_allocations);
+    setHeap(new HeapObject(ValueType::List, std::move(v)));
+}
 
-Value::Value(SpecialIndex v)
-    : value{v}, value_type{ValueType::Index} {}
+Value::Value(std::shared_ptr<ASTNode> v) {
+    COUNT_STAT(value_allocations);
+    setHeap(new HeapObject(ValueType::Function, std::move(v)));
+}
 
-Value::Value(std::shared_ptr<ASTNode> v)
-    : value{v}, value_type{ValueType::Function} {}
+Value::Value(std::shared_ptr<BuiltInFunction> v) {
+    COUNT_STAT(value_allocations);
+    setHeap(new HeapObject(ValueType::BuiltInFunction, std::move(v)));
+}
 
-Value::Value(std::shared_ptr<BuiltInFunction> v)
-    : value{v}, value_type{ValueType::BuiltInFunction} {}
+Value::Value(std::shared_ptr<Dictionary> v) {
+    COUNT_STAT(value_allocations);
+    setHeap(new HeapObject(ValueType::Dictionary, std::move(v)));
+}
 
-Value::Value(ValueType v)
-    : value{v}, value_type{ValueType::Type} {}
+Value::Value(std::shared_ptr<Class> v) {
+    COUNT_STAT(value_allocations);
+    setHeap(new HeapObject(ValueType::Class, std::move(v)));
+}
 
-Value::Value(std::shared_ptr<Dictionary> v)
-    : value{v}, value_type{ValueType::Dictionary} {}
+Value::Value(std::shared_ptr<Instance> v) {
+    COUNT_STAT(value_allocations);
+    setHeap(new HeapObject(ValueType::Instance, std::move(v)));
+}
 
-Value::Value(std::shared_ptr<Class> v)
-    : value{v}, value_type{ValueType::Class} {}
+Value::Value(Range v) {
+    COUNT_STAT(value_allocations);
+    setHeap(new HeapObject(ValueType::Range, v));
+}
 
-Value::Value(std::shared_ptr<Instance> v)
-    : value{v}, value_type{ValueType::Instance} {}
+Value::Value(std::shared_ptr<Future> v) {
+    COUNT_STAT(value_allocations);
+    setHeap(new HeapObject(ValueType::Future, std::move(v)));
+}
 
-// Get the current type of the Value
-ValueType Value::getType() const {
-    return value_type;
+Value::Value(std::shared_ptr<Channel> v) {
+    COUNT_STAT(value_allocations);
+    setHeap(new HeapObject(ValueType::Channel, std::move(v)));
 }
 
-std::string Value::getPrintable(int tabs, bool error) {
+std::string Value::getPrintable(int tabs, bool error) const {
     Style style{}; // assumes fields like .light_blue, .purple, .green, .blue, .orange, .reset
 
-    switch (value_type) {
+    switch (getType()) {
         case ValueType::Integer: {
-            auto s = std::to_string(std::get<int>(value));
+            auto s = std::to_string(get<int>());
             return error ? style.orange + s + style.reset
                         : style.light_blue + s + style.reset;
         }
 
         case ValueType::Float: {
-            auto s = std::to_string(std::get<double>(value));
+            auto s = std::to_string(get<double>());
             return error ? style.orange + s + style.reset
                         : style.light_blue + s + style.reset;
         }
 
         case ValueType::Boolean: {
-            const bool b = std::get<bool>(value);
+            const bool b = get<bool>();
             auto s = b ? "true" : "false";
             return error ? style.orange + s + style.reset
                         : style.purple + s + style.reset;
         }
 
         case ValueType::String: {
-            const auto& s = std::get<std::string>(value);
+            const auto& s = get<std::string>();
             auto quoted = "'" + s + "'";
             return error ? style.orange + quoted + style.reset
                         : style.green + quoted + style.reset;
         }
 
         case ValueType::List: {
-            auto list = std::get<std::shared_ptr<List>>(value);
+            auto list = get<std::shared_ptr<List>>();
             std::string str = "[";
             for (int i = 0; i < list->size(); ++i) {
                 if (i != 0) str += ", ";
-                str += list->at(i)->getPrintable();
+                str += list->at(i).getPrintable();
             }
             str += "]";
             return error ? style.orange + str + style.reset : str;
         }
 
         case ValueType::Dictionary: {
-            auto dict = std::get<std::shared_ptr<Dictionary>>(value);
+            auto dict = get<std::shared_ptr<Dictionary>>();
             std::string str = "{\n";
             for (const auto& pair : *dict) {
                 for (int i = 0; i < tabs; i++) str += "|   ";
-                str += pair.first->getPrintable()
+                str += pair.first.getPrintable()
                     + " : "
-                    + pair.second->getPrintable()
+                    + pair.second.getPrintable()
                     + "\n";
             }
             str += std::string(tabs, ' ') + "}";
@@ -395,7 +668,7 @@ std::string Value::getPrintable(int tabs, bool error) {
                         : style.blue + "<builtin_function>" + style.reset;
 
         case ValueType::Type: {
-            auto s = getTypeStr(std::get<ValueType>(value));
+            auto s = getTypeStr(get<ValueType>());
             return error ? style.orange + s + style.reset
                         : style.blue + s + style.reset;
         }
@@ -408,12 +681,26 @@ std::string Value::getPrintable(int tabs, bool error) {
             return error ? style.orange + "<instance>" + style.reset
                         : style.blue + "<instance>" + style.reset;
 
+        case ValueType::Future:
+            return error ? style.orange + "<future>" + style.reset
+                        : style.blue + "<future>" + style.reset;
+
+        case ValueType::Channel:
+            return error ? style.orange + "<channel>" + style.reset
+                        : style.blue + "<channel>" + style.reset;
+
         case ValueType::None:
             return error ? style.orange + "null" + style.reset
                         : style.blue + "null" + style.reset;
 
+        case ValueType::Range: {
+            auto s = getRangeStr(get<Range>());
+            return error ? style.orange + s + style.reset
+                        : style.blue + s + style.reset;
+        }
+
         case ValueType::Index: {
-            auto index_value = std::get<SpecialIndex>(value);
+            auto index_value = get<SpecialIndex>();
             auto s = (index_value == SpecialIndex::Front)
                         ? "<index:front>"
                         : "<index:back>";
@@ -452,6 +739,12 @@ std::string getValueStr(Value value) {
             return "class";
         case ValueType::Instance:
             return "instance";
+        case ValueType::Range:
+            return "range";
+        case ValueType::Future:
+            return "future";
+        case ValueType::Channel:
+            return "channel";
         case ValueType::None:
             return "null";
         default:
@@ -459,8 +752,13 @@ std::string getValueStr(Value value) {
     }
 }
 
-std::string getValueStr(std::shared_ptr<Value> value) {
-    return getValueStr(*value);
+
+std::string getRangeStr(const Range& range) {
+    std::string str = "range(" + std::to_string(range.start) + ", " + std::to_string(range.stop);
+    if (range.step != 1) {
+        str += ", " + std::to_string(range.step);
+    }
+    return str + ")";
 }
 
 std::string getTypeStr(ValueType type) {
@@ -476,6 +774,9 @@ std::string getTypeStr(ValueType type) {
         {ValueType::Dictionary, "Type:Dictionary"},
         {ValueType::Class, "Type:Class"},
         {ValueType::Instance, "Type:Instance"},
+        {ValueType::Range, "Type:Range"},
+        {ValueType::Future, "Type:Future"},
+        {ValueType::Channel, "Type:Channel"},
         {ValueType::None, "Null"}
     };
     if (types.count(type) != 0) {
@@ -0,0 +1,550 @@
+#include "vm.h"
+#include "values.h"
+#include "errorDefs.h"
+#include "profiler.h"
+#include "stats.h"
+
+
+namespace {
+
+struct Iterator {
+    Value container;
+    size_t index = 0;
+    Dictionary::iterator entry;
+};
+
+void startIteration(ForNode* node, Value container, std::vector<Iterator>& iterators) {
+    if (!container) {
+        throwError(ErrorType::Runtime, "For loop expected iterable container", node->line(), node->column());
+    }
+    auto init_node = static_cast<BinaryOpNode*>(node->initialization.get());
+    bool single = static_cast<bool>(nodeCast<IdentifierNode>(init_node->left));
+    auto list_node = nodeCast<ListNode>(init_node->left);
+
+    Iterator iterator;
+    switch (container.getType()) {
+        case ValueType::List:
+        case ValueType::Range:
+            if (!single && !list_node) {
+                throwError(ErrorType::Runtime, "For loop expected identifier or list", node->line(), node->column());
+            }
+            break;
+        case ValueType::Dictionary:
+            if (!single) {
+                if (!list_node) {
+                    throwError(ErrorType::Runtime, "For loop expected identifier or list", node->line(), node->column());
+                }
+                if (list_node->list.size() < 2) {
+                    throwError(ErrorType::Runtime, "Too many arguments to unpack", node->line(), node->column());
+                } else if (list_node->list.size() > 2) {
+                    throwError(ErrorType::Runtime, "Too few arguments to unpack", node->line(), node->column());
+                }
+            }
+            iterator.entry = container.get<std::shared_ptr<Dictionary>>()->begin();
+            break;
+        case ValueType::String:
+            if (!single) {
+                throwError(ErrorType::Runtime, "For loop expected identifier or list", node->line(), node->column());
+            }
+            break;
+        default:
+            throwError(ErrorType::Runtime, "For loop expected iterable container", node->line(), node->column());
+    }
+    iterator.container = std::move(container);
+    iterators.push_back(std::move(iterator));
+}
+
+// Assigns the next item to the loop variables, returning false once the container is exhausted
+bool nextIteration(ForNode* node, Iterator& iterator, Environment& env) {
+    auto init_node = static_cast<BinaryOpNode*>(node->initialization.get());
+    auto ident_node = nodeCast<IdentifierNode>(init_node->left);
+
+    switch (iterator.container.getType()) {
+        case ValueType::List: {
+            const auto& list = iterator.container.get<std::shared_ptr<List>>();
+            if (iterator.index >= list->size()) {
+                return false;
+            }
+            auto item = list->at(iterator.index++);
+            if (ident_node) {
+                ident_node->assign(env, item);
+                return true;
+            }
+
+            auto list_node = static_cast<ListNode*>(init_node->left.get());
+            if (item.getType() != ValueType::List) {
+                throwError(ErrorType::Runtime, "Expected a list, but got " + getValueStr(item), node->line(), node->column());
+            }
+            auto values = item.get<std::shared_ptr<List>>();
+            if (values->size() > list_node->list.size()) {
+                throwError(ErrorType::Runtime, "Too many arguments to unpack", node->line(), node->column());
+            } else if (values->size() < list_node->list.size()) {
+                throwError(ErrorType::Runtime, "Too few arguments to unpack", node->line(), node->column());
+            }
+            for (size_t i = 0; i < values->size(); i++) {
+                auto target = nodeCast<IdentifierNode>(list_node->list.at(i));
+                if (!target) {
+                    throwError(ErrorType::Runtime, "Can only assign values to identifiers", node->line(), node->column());
+                }
+                target->assign(env, values->at(i));
+            }
+            return true;
+        }
+        case ValueType::Range: {
+            const Range& range = iterator.container.get<Range>();
+            if (iterator.index >= static_cast<size_t>(range.size())) {
+                return false;
+            }
+            if (!ident_node) {
+                throwError(ErrorType::Runtime, "Expected a list, but got integer", node->line(), node->column());
+            }
+            ident_node->assign(env, Value(range.at(static_cast<int>(iterator.index++))));
+            return true;
+        }
+        case ValueType::Dictionary: {
+            const auto& dict = iterator.container.get<std::shared_ptr<Dictionary>>();
+            if (iterator.entry == dict->end()) {
+                return false;
+            }
+            const auto& pair = *iterator.entry++;
+            if (ident_node) {
+                std::shared_ptr<List> arg_list = std::make_shared<List>();
+                arg_list->push_back(pair.first);
+                arg_list->push_back(pair.second);
+                ident_node->assign(env, Value(arg_list));
+                return true;
+            }
+            auto list_node = static_cast<ListNode*>(init_node->left.get());
+            auto first_node = nodeCast<IdentifierNode>(list_node->list.at(0));
+            auto second_node = nodeCast<IdentifierNode>(list_node->list.at(1));
+            first_node->assign(env, pair.first);
+            second_node->assign(env, pair.second);
+            return true;
+        }
+        default: {
+            const std::string& string = iterator.container.get<std::string>();
+            if (iterator.index >= string.size()) {
+                return false;
+            }
+            ident_node->assign(env, Value(std::string(1, string[iterator.index++])));
+            return true;
+        }
+    }
+}
+
+// The message is only made into a string once it's needed, this runs for most instructions
+void requireValue(const Value& value, const char* message, ASTNode* node) {
+    if (!value) {
+        throwError(ErrorType::Runtime, message, node->line(), node->column());
+    }
+}
+
+// The integer arithmetic and comparisons loops spend most of their time on, anything else is left to the
+// operation's kernel. Matches what the kernel computes for two integers.
+std::optional<Value> integerOperation(TokenType operation, const Value& left, const Value& right) {
+    if (left.getType() != ValueType::Integer || right.getType() != ValueType::Integer) {
+        return std::nullopt;
+    }
+    int64_t lhs = left.get<int>();
+    int64_t rhs = right.get<int>();
+    switch (operation) {
+        case TokenType::_Plus:
+        case TokenType::_PlusEquals: return Value(static_cast<int>(lhs + rhs));
+        case TokenType::_Minus:
+        case TokenType::_MinusEquals: return Value(static_cast<int>(lhs - rhs));
+        case TokenType::_Multiply:
+        case TokenType::_MultiplyEquals: return Value(static_cast<int>(lhs * rhs));
+        case TokenType::_LessThan: return Value(lhs < rhs);
+        case TokenType::_LessEquals: return Value(lhs <= rhs);
+        case TokenType::_GreaterThan: return Value(lhs > rhs);
+        case TokenType::_GreaterEquals: return Value(lhs >= rhs);
+        case TokenType::_Compare: return Value(lhs == rhs);
+        case TokenType::_NotEqual: return Value(lhs != rhs);
+        default: return std::nullopt;
+    }
+}
+
+// A compiled function the arguments can be bound to one for one, which the VM calls without the tree walker
+FuncNode* compiledFunction(const Value& callee, size_t arg_count) {
+    if (callee.getType() != ValueType::Function) {
+        return nullptr;
+    }
+    auto func = dynamic_cast<FuncNode*>(callee.get<std::shared_ptr<ASTNode>>().get());
+    if (!func || !func->chunk || func->args.size() != arg_count) {
+        return nullptr;
+    }
+    return func;
+}
+
+// Shared by every chunk running on the thread, a call works above what its callers left on them
+thread_local std::vector<Value> operand_stack;
+thread_local std::vector<Iterator> iterator_stack;
+
+// Gives the stacks back to the caller however the chunk exits
+struct ChunkFrame {
+    ChunkFrame()
+        : stack_base{operand_stack.size()}, iterator_base{iterator_stack.size()} {}
+    ~ChunkFrame() {
+        operand_stack.erase(operand_stack.begin() + stack_base, operand_stack.end());
+        iterator_stack.erase(iterator_stack.begin() + iterator_base, iterator_stack.end());
+        ADD_STAT(vm_instructions, instructions);
+    }
+    ChunkFrame(const ChunkFrame&) = delete;
+    ChunkFrame& operator=(const ChunkFrame&) = delete;
+
+    size_t stack_base;
+    size_t iterator_base;
+    uint64_t instructions = 0;
+};
+
+}
+
+std::optional<Value> executeChunk(const Chunk& chunk, Environment& env) {
+    std::vector<Value>& stack = operand_stack;
+    std::vector<Iterator>& iterators = iterator_stack;
+    ChunkFrame frame;
+    const Instruction* code = chunk.code.data();
+    const size_t code_size = chunk.code.size();
+    size_t ip = 0;
+
+    auto pop = [&stack]() {
+        auto value = std::move(stack.back());
+        stack.pop_back();
+        return value;
+    };
+    // Only ever shrinks the stack, so nothing is written past what the arguments occupied
+    auto popArgs = [&stack](size_t count) {
+        auto first = stack.end() - count;
+        ValueList args;
+        args.reserve(count);
+        for (auto it = first; it != stack.end(); ++it) {
+            args.push_back(std::move(*it));
+        }
+        stack.erase(first, stack.end());
+        return args;
+    };
+
+    if (code_size > 0) {
+        profileSafePoint(code[0].node);
+    }
+    while (ip < code_size) {
+        const Instruction& instruction = code[ip++];
+        frame.instructions++;
+        switch (instruction.op) {
+            case OpCode::LoadConst: {
+                stack.push_back(chunk.constants[instruction.operand]);
+                break;
+            }
+            case OpCode::LoadName: {
+                auto ident = static_cast<IdentifierNode*>(instruction.node);
+                stack.push_back(ident->evaluate(env).value_or(nullptr));
+                break;
+            }
+            case OpCode::StoreName: {
+                auto assign = static_cast<BinaryOpNode*>(instruction.node);
+                auto ident = static_cast<IdentifierNode*>(assign->left.get());
+                auto value = pop();
+                requireValue(value, "Failed to set variable. Operand could not be computed", assign);
+                ident->assign(env, value);
+                break;
+            }
+            case OpCode::LoadLocal: {
+                Value value = env.getLocal(instruction.depth, instruction.operand);
+                if (!value) [[unlikely]] {
+                    value = static_cast<IdentifierNode*>(instruction.node)->evaluate(env).value_or(nullptr);
+                }
+                stack.push_back(std::move(value));
+                break;
+            }
+            case OpCode::StoreLocal: {
+                auto assign = static_cast<BinaryOpNode*>(instruction.node);
+                auto value = pop();
+                requireValue(value, "Failed to set variable. Operand could not be computed", assign);
+                if (env.getLocal(instruction.depth, instruction.operand)) [[likely]] {
+                    env.setLocal(instruction.depth, instruction.operand, std::move(value));
+                } else {
+                    static_cast<IdentifierNode*>(assign->left.get())->assign(env, std::move(value));
+                }
+                break;
+            }
+            case OpCode::LoadGlobal: {
+                Value value = env.getGlobal(instruction.operand);
+                if (!value) [[unlikely]] {
+                    value = static_cast<IdentifierNode*>(instruction.node)->evaluate(env).value_or(nullptr);
+                }
+                stack.push_back(std::move(value));
+                break;
+            }
+            case OpCode::StoreGlobal: {
+                auto value = pop();
+                requireValue(value, "Failed to set variable. Operand could not be computed", instruction.node);
+                env.setGlobal(instruction.operand, std::move(value));
+                break;
+            }
+            case OpCode::Pop: {
+                stack.pop_back();
+                break;
+            }
+            case OpCode::UnaryOp: {
+                auto unary = static_cast<UnaryOpNode*>(instruction.node);
+                auto value = pop();
+                if (!value) {
+                    throwError(ErrorType::Runtime, "Failed to evaluate unary operand with operator '" +
+                                                    getTokenTypeLabel(unary->op) + "'", unary->line(), unary->column());
+                }
+                stack.push_back(unary->applyOperation(value));
+                break;
+            }
+            case OpCode::BinaryOp: {
+                auto binary = static_cast<BinaryOpNode*>(instruction.node);
+                // The result replaces the left operand where it is on the stack
+                Value& left = stack[stack.size() - 2];
+                const Value& right = stack.back();
+                if (!left || !right) {
+                    throwError(ErrorType::Runtime, "Unable to evaluate binary operand for operator '" +
+                                                    getTokenTypeLabel(binary->op), binary->line(), binary->column());
+                }
+                if (std::optional<Value> result = integerOperation(binary->op, left, right)) [[likely]] {
+                    left = *result;
+                } else {
+                    left = binary->applyOperation(left, right);
+                }
+                stack.pop_back();
+                break;
+            }
+            case OpCode::In: {
+                auto binary = static_cast<BinaryOpNode*>(instruction.node);
+                auto right = pop();
+                auto left = pop();
+                if (!left || !right) {
+                    throwError(ErrorType::Runtime, "Failed arguments of 'in'", binary->line(), binary->column());
+                }
+                stack.push_back(binary->containsValue(left, right));
+                break;
+            }
+            case OpCode::And:
+            case OpCode::Or: {
+                auto left = pop();
+                requireValue(left, "Unable to evaluate left operand for 'and' or 'or'", instruction.node);
+                bool truthy = checkTruthy(left);
+                if (instruction.op == OpCode::And && !truthy) {
+                    stack.push_back(Value(false));
+                    ip = instruction.operand;
+                } else if (instruction.op == OpCode::Or && truthy) {
+                    stack.push_back(Value(true));
+                    ip = instruction.operand;
+                }
+                break;
+            }
+            case OpCode::ToBool: {
+                auto value = pop();
+                requireValue(value, "Unable to evaluate right operand for 'and' or 'or'", instruction.node);
+                stack.push_back(Value(checkTruthy(value)));
+                break;
+            }
+            case OpCode::Jump: {
+                if (static_cast<size_t>(instruction.operand) < ip) {
+                    // Loop back edge
+                    maybeCollectGarbage();
+                    profileSafePoint(instruction.node);
+                }
+                ip = instruction.operand;
+                break;
+            }
+            case OpCode::JumpIfFalse: {
+                auto condition = pop();
+                requireValue(condition, "Missing a boolean comparison for keyword to evaluate", instruction.node);
+                if (!checkConditionTruthy(condition)) {
+                    ip = instruction.operand;
+                }
+                break;
+            }
+            case OpCode::ForCondition: {
+                auto condition = pop();
+                requireValue(condition, "Unable to evaluate for loop condition", instruction.node);
+                if (condition.getType() != ValueType::Boolean) {
+                    throwError(ErrorType::Runtime, "For loop requires boolean condition", instruction.node->line(), instruction.node->column());
+                }
+                if (!condition.get<bool>()) {
+                    ip = instruction.operand;
+                }
+                break;
+            }
+            case OpCode::PushScope:
+            case OpCode::PopScope: {
+                env.clearSlots(chunk.scopes[instruction.operand]);
+                break;
+            }
+            case OpCode::EnterLoop: {
+                env.addLoop();
+                break;
+            }
+            case OpCode::ExitLoop: {
+                env.removeLoop();
+                break;
+            }
+            case OpCode::IterStart: {
+                startIteration(static_cast<ForNode*>(instruction.node), pop(), iterators);
+                break;
+            }
+            case OpCode::IterNext: {
+                if (!nextIteration(static_cast<ForNode*>(instruction.node), iterators.back(), env)) {
+                    ip = instruction.operand;
+                }
+                break;
+            }
+            case OpCode::IterEnd: {
+                iterators.pop_back();
+                break;
+            }
+            case OpCode::Call: {
+                auto call = static_cast<MethodCallNode*>(instruction.node);
+                profileSafePoint(call);
+                size_t arg_count = instruction.operand;
+                size_t args_begin = stack.size() - arg_count;
+                if (FuncNode* func = compiledFunction(stack[args_begin - 1], arg_count)) {
+                    for (size_t i = args_begin; i < stack.size(); i++) {
+                        requireValue(stack[i], "Unable to evaluate argument", call);
+                    }
+                    std::optional<Value> result;
+                    try {
+                        result = func->callCompiled(&stack[args_begin], env);
+                    }
+                    catch (const ErrorException& e) {
+                        throwError(e.error_type, e.message, call->line(), call->column());
+                    }
+                    // The callee stays on the stack until the call returns, keeping the function alive
+                    stack.erase(stack.begin() + (args_begin - 1), stack.end());
+                    stack.push_back(result.value_or(nullptr));
+                    break;
+                }
+                ValueList args = popArgs(instruction.operand);
+                auto callee = pop();
+                requireValue(callee, "Unable to call function", call);
+                for (const auto& arg : args) {
+                    requireValue(arg, "Unable to evaluate argument", call);
+                }
+                std::map<std::string, Value> pairs;
+                stack.push_back(call->callValue(env, callee, args, pairs).value_or(nullptr));
+                break;
+            }
+            case OpCode::CallMember: {
+                auto call = static_cast<MethodCallNode*>(instruction.node);
+                profileSafePoint(call);
+                ValueList args = popArgs(instruction.operand);
+                auto receiver = pop();
+                requireValue(receiver, "Failed to get member function. Identifier could not be computed", call);
+                for (const auto& arg : args) {
+                    requireValue(arg, "Unable to evaluate argument", call);
+                }
+                if (auto func = call->builtinMember(env, receiver.getType())) {
+                    args.insert(args.begin(), receiver);
+                    stack.push_back(call->callBuiltinMember(env, func, args).value_or(nullptr));
+                    break;
+                }
+                Environment environment{env};
+                auto mapped_value = call->resolveMember(receiver, environment);
+                std::map<std::string, Value> pairs;
+                stack.push_back(call->callMember(env, environment, receiver, mapped_value, args, pairs).value_or(nullptr));
+                break;
+            }
+            case OpCode::GetMember: {
+                auto binary = static_cast<BinaryOpNode*>(instruction.node);
+                auto receiver = pop();
+                requireValue(receiver, "Failed to get member function. Identifier could not be computed", binary);
+                stack.push_back(binary->getMember(env, receiver).value_or(nullptr));
+                break;
+            }
+            case OpCode::Index: {
+                auto index = static_cast<IndexNode*>(instruction.node);
+                if (!index->end_index) {
+                    // An element of a list read in range, getIndex handles everything else
+                    Value& container = stack[stack.size() - 2];
+                    const Value& start_value = stack.back();
+                    if (container.getType() == ValueType::List && start_value.getType() == ValueType::Integer) {
+                        const auto& list = container.get<std::shared_ptr<List>>();
+                        int position = start_value.get<int>();
+                        if (position >= 0 && static_cast<size_t>(position) < list->size()) {
+                            container = list->at(position);
+                            stack.pop_back();
+                            break;
+                        }
+                    }
+                }
+                Value end_value = index->end_index ? pop() : nullptr;
+                auto start_value = pop();
+                auto container = pop();
+                if (!container) {
+                    stack.push_back(nullptr);
+                    break;
+                }
+                stack.push_back(index->getIndex(container, start_value, end_value).value_or(nullptr));
+                break;
+            }
+            case OpCode::StoreIndex: {
+                auto assign = static_cast<BinaryOpNode*>(instruction.node);
+                auto index = static_cast<IndexNode*>(assign->left.get());
+                Value end_value = index->end_index ? pop() : nullptr;
+                auto start_value = pop();
+                auto container = pop();
+                auto value = pop();
+                requireValue(value, "Failed to set variable. Operand could not be computed", assign);
+                index->setIndex(std::move(container), std::move(start_value), std::move(end_value), std::move(value));
+                break;
+            }
+            case OpCode::BuildList: {
+                ValueList elements = popArgs(instruction.operand);
+                for (const auto& element : elements) {
+                    requireValue(element, "List element was unable to be evaluated", instruction.node);
+                }
+                stack.push_back(Value(std::make_shared<List>(std::move(elements))));
+                break;
+            }
+            case OpCode::BuildDictionary: {
+                ValueList entries = popArgs(instruction.operand * 2);
+                std::shared_ptr<Dictionary> dict = std::make_shared<Dictionary>();
+                for (size_t i = 0; i < entries.size(); i += 2) {
+                    if (!entries[i] || !entries[i + 1]) {
+                        throwError(ErrorType::Runtime, "Dictionary key or value was unable to be evaluated",
+                                    instruction.node->line(), instruction.node->column());
+                    }
+                    dict->insert({entries[i], entries[i + 1]});
+                }
+                stack.push_back(Value(dict));
+                break;
+            }
+            case OpCode::Return: {
+                if (!chunk.function_body) {
+                    throwError(ErrorType::Runtime, "Return was used outside of function");
+                }
+                if (instruction.operand == 0) {
+                    return std::nullopt;
+                }
+                auto value = pop();
+                if (!value) {
+                    return std::nullopt;
+                }
+                return value;
+            }
+            case OpCode::Evaluate: {
+                Completion completion = instruction.node->execute(env);
+                if (completion.type == CompletionType::Normal) {
+                    stack.push_back(completion.value.value_or(nullptr));
+                } else if (completion.type == CompletionType::Return) {
+                    if (!chunk.function_body) {
+                        throwError(ErrorType::Runtime, "Return was used outside of function");
+                    }
+                    return completion.value;
+                } else if (instruction.operand < 0) {
+                    throwError(ErrorType::Runtime, completion.type == CompletionType::Break ?
+                                "Break was used outside of loop" : "Continue was used outside of loop");
+                } else {
+                    const LoopInfo& loop = chunk.loops[instruction.operand];
+                    ip = completion.type == CompletionType::Break ? loop.break_target : loop.continue_target;
+                }
+                break;
+            }
+        }
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,89 @@
+// A builtin that runs for most of the program should get most of the samples, not the function run after it
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "funcy.h"
+#include "profiler.h"
+
+namespace {
+
+const char* SOURCE = R"(
+func waitLong() {
+    pause();
+    return 0;
+}
+
+func slowLoop() {
+    total = 0;
+    for i = 0, i < 200000, i += 1 {
+        total += i % 7;
+    }
+    return total;
+}
+)";
+
+// Samples of the folded stacks with the function anywhere on them
+size_t samplesIn(const std::string& folded_path, const std::string& function) {
+    std::ifstream folded{folded_path};
+    size_t samples = 0;
+    std::string line;
+    while (std::getline(folded, line)) {
+        size_t count_start = line.rfind(' ');
+        if (line.find(function + " (") != std::string::npos) {
+            samples += std::stoul(line.substr(count_start + 1));
+        }
+    }
+    return samples;
+}
+
+bool runEngine(bool use_vm_engine) {
+    std::string program = (std::filesystem::temp_directory_path() / "funcy_profiler_test.fy").string();
+    std::string folded_path = program + ".folded";
+    double wait_seconds = 0;
+    double loop_seconds = 0;
+    {
+        ProfileSession profile{program, 1000};
+        Funcy funcy{FuncyOptions{use_vm_engine}};
+        funcy.registerFunction("pause", [](const std::vector<NativeValue>&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(600));
+            return NativeValue{};
+        });
+        funcy.loadString(SOURCE, program);
+
+        auto start = std::chrono::steady_clock::now();
+        funcy.call("waitLong");
+        auto middle = std::chrono::steady_clock::now();
+        funcy.call("slowLoop");
+        auto end = std::chrono::steady_clock::now();
+        wait_seconds = std::chrono::duration<double>(middle - start).count();
+        loop_seconds = std::chrono::duration<double>(end - middle).count();
+    }
+
+    size_t wait_samples = samplesIn(folded_path, "waitLong");
+    size_t loop_samples = samplesIn(folded_path, "slowLoop");
+    std::filesystem::remove(folded_path);
+
+    double measured = wait_seconds / (wait_seconds + loop_seconds);
+    double sampled = static_cast<double>(wait_samples) / std::max<size_t>(wait_samples + loop_samples, 1);
+    std::cout << (use_vm_engine ? "vm" : "tree") << ": waitLong ran " << measured * 100 << "% of the time and got "
+              << sampled * 100 << "% of " << wait_samples + loop_samples << " samples" << std::endl;
+    // The sampler wakes late on a busy machine, so only a share far off the measured one is a failure
+    return wait_samples + loop_samples > 0 && std::abs(sampled - measured) < 0.15;
+}
+
+}
+
+int main() {
+    bool passed = runEngine(false);
+    passed = runEngine(true) && passed;
+    if (!passed) {
+        std::cerr << "FAILED: the samples don't follow the time spent in each function" << std::endl;
+        return 1;
+    }
+    return 0;
+}